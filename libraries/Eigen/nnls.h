@@ -110,6 +110,14 @@ namespace Eigen {
 		* by the @c x method. */
 		bool solve(const ColVectorType &b, Heuristic heuristic = MAX_DESCENT);
 
+		/** \brief Solves the NNLS problem given a precomputed \f$A^Tb\f$ (e.g. from one product for
+		* several right hand sides), starting from the passive set of a guess of the solution.
+		* The coefficients of @c x0 that are greater than zero form the initial passive set. If the LS
+		* solution on that set is feasible, the algorithm continues from it, otherwise it starts from
+		* an empty passive set like solve(b). A good guess, e.g. the unconstrained solution, saves the
+		* iterations that build up the passive set; a zero guess is a cold start. */
+		bool solve(const ColVectorType &b, const RowVectorType &Atb, const RowVectorType &x0, Heuristic heuristic = MAX_DESCENT);
+
 		/** \brief Returns the solution if a problem was solved.
 		* If not, an uninitialized vector may be returned. */
 		inline const RowVectorType &x() const { return _x; }
@@ -189,10 +197,16 @@ namespace Eigen {
 		/** Solves the LS problem \f$\left\Vert y-A^Px\right\Vert_2^2\f$. */
 		void _solveLS_P(const ColVectorType &b);
 
+		/** Runs the outer and inner loops from the current feasible solution @c _x and passive set. */
+		bool _iterate(const ColVectorType &b, Heuristic heuristic);
+
 		/** Updates the gradient \c _w using the current partial solution \c _x. */
 		void _updateGradient() {
-			// w <- A^T b - A^TA x
-			_w = _Atb - *_AtA*_x;
+			// w <- A^T b - A^TA x, where x is zero outside of the (usually small) passive set
+			_w = _Atb;
+			for (Index i = 0; i<_A.cols(); i++) {
+				if (_x(i) != 0) { _w.noalias() -= _x(i) * _AtA->col(i); }
+			}
 #ifdef EIGEN3_NNLS_DEBUG
 			std::cerr << "NNLS(): Gradient at (" << _x.transpose()
 				<< ") = (" << _w.transpose() << ")" << std::endl;
@@ -325,6 +339,44 @@ namespace Eigen {
 		// Precompute A^T*b
 		_Atb = _A.transpose() * b;
 
+		return _iterate(b, heuristic);
+	}
+
+
+	template<typename MatrixType>
+	bool NNLS<MatrixType>::solve(const ColVectorType &b, const RowVectorType &Atb, const RowVectorType &x0, Heuristic heuristic)
+	{
+		// Initialize solver
+		_num_ls = 0; _x.setZero();
+		_P.setIdentity(); _Np = 0;
+		_Atb = Atb;
+
+		// Add the positive coefficients of the guess to P
+		IndicesType &idxs = _P.indices();
+		for (Index i = _Np; i<_A.cols(); i++) {
+			if (x0(idxs(i)) > 0) { _addToP(i); }
+		}
+
+		if (_Np > 0) {
+			_solveLS_P(b);
+			bool feasable = true;
+			for (Index i = 0; i<_Np && feasable; i++) {
+				Index idx = idxs(i);
+				feasable = _y(idx) > 0; // also false for NaN
+			}
+
+			// Continue from the feasible solution, or start over from an empty passive set
+			if (feasable) { _x = _y; }
+			else { _P.setIdentity(); _Np = 0; }
+		}
+
+		return _iterate(b, heuristic);
+	}
+
+
+	template<typename MatrixType>
+	bool NNLS<MatrixType>::_iterate(const ColVectorType &b, Heuristic heuristic)
+	{
 		// OUTER LOOP
 		while (true)
 		{
@@ -0,0 +1,390 @@
+//
+// $Id$
+//
+//
+// Original author: agent <agent@local>
+//
+// Copyright 2026
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#define PWIZ_SOURCE
+
+
+#include "pwiz/utility/misc/Std.hpp"
+#include "ChromatogramList_XICExtractor.hpp"
+#include "pwiz/data/msdata/SpectrumWorkerThreads.hpp"
+#include "pwiz/utility/misc/WorkerPool.hpp"
+
+
+namespace pwiz {
+namespace analysis {
+
+
+using namespace msdata;
+using namespace chemistry;
+
+
+PWIZ_API_DECL ChromatogramList_XICExtractor::Target::Target()
+:   mzLow(0), mzHigh(0),
+    rtLow(0), rtHigh(numeric_limits<double>::max()),
+    msLevel(1),
+    precursorMzLow(0), precursorMzHigh(0)
+{
+}
+
+
+PWIZ_API_DECL ChromatogramList_XICExtractor::Target::Target(const string& id, double mzLow, double mzHigh, int msLevel)
+:   id(id), mzLow(mzLow), mzHigh(mzHigh),
+    rtLow(0), rtHigh(numeric_limits<double>::max()),
+    msLevel(msLevel),
+    precursorMzLow(0), precursorMzHigh(0)
+{
+}
+
+
+namespace {
+
+
+typedef ChromatogramList_XICExtractor::Target Target;
+
+
+// a point of one target's chromatogram
+struct XICPoint
+{
+    XICPoint(size_t target, double time, double intensity) : target(target), time(time), intensity(intensity) {}
+    size_t target;
+    double time;
+    double intensity;
+};
+
+
+// the spectra of a contiguous range of indices and the points extracted from them, in spectrum order
+struct Chunk
+{
+    size_t begin, end;
+    vector<XICPoint> points;
+};
+
+
+// Targets are sorted by mzLow, so that each spectrum is matched to all of them in one sweep
+// over its (sorted) m/z array. Each worker keeps the set of targets whose scan time range
+// includes the current spectrum; since its chunks are handed out in index order, it only
+// needs to add the targets that start and drop the ones that end as the scan time advances.
+class Extractor
+{
+    public:
+
+    Extractor(const SpectrumList& sl, const vector<Target>& targets)
+    :   sl_(sl), targets_(targets), mzOrder_(targets.size()), rtOrder_(targets.size())
+    {
+        for (size_t i=0; i < targets.size(); ++i)
+            mzOrder_[i] = rtOrder_[i] = i;
+        sort(mzOrder_.begin(), mzOrder_.end(), LessThanMZLow(targets_));
+        sort(rtOrder_.begin(), rtOrder_.end(), LessThanRTLow(targets_, mzOrder_));
+
+        BOOST_FOREACH(const Target& target, targets_)
+            msLevels_.insert(target.msLevel);
+    }
+
+    // per-thread state of the scan time sweep
+    struct Sweep
+    {
+        Sweep() : nextRT(0), lastTime(-numeric_limits<double>::max()) {}
+        size_t nextRT; // the next target (in rtOrder_) that is not active yet
+        vector<size_t> active; // positions in mzOrder_ of the active targets, sorted
+        double lastTime;
+    };
+
+    void extract(Chunk& chunk, Sweep& sweep) const
+    {
+        for (size_t i=chunk.begin; i < chunk.end; ++i)
+        {
+            SpectrumPtr s = sl_.spectrum(i, false);
+            if (s->scanList.scans.empty()) continue;
+
+            int msLevel = s->cvParam(MS_ms_level).valueAs<int>();
+            if (!msLevels_.count(msLevel)) continue;
+
+            double time = s->scanList.scans[0].cvParam(MS_scan_start_time).timeInSeconds();
+            advance(sweep, time);
+            if (sweep.active.empty()) continue;
+
+            double isolationLow = 0, isolationHigh = 0;
+            if (msLevel > 1)
+                getIsolationWindow(*s, isolationLow, isolationHigh);
+
+            // get the binary data only if some target can use this spectrum
+            bool used = false;
+            BOOST_FOREACH(size_t a, sweep.active)
+                if (accepts(targets_[mzOrder_[a]], msLevel, isolationLow, isolationHigh)) {used = true; break;}
+            if (!used) continue;
+
+            s = sl_.spectrum(s, true);
+            BinaryDataArrayPtr mzArray = s->getMZArray();
+            BinaryDataArrayPtr intensityArray = s->getIntensityArray();
+            if (!mzArray.get() || !intensityArray.get()) continue;
+
+            vector<double> mz, intensity;
+            getSortedPeaks(*mzArray, *intensityArray, mz, intensity);
+
+            // sweep the targets in mzLow order over the m/z array
+            vector<double>::iterator begin = mz.begin();
+            BOOST_FOREACH(size_t a, sweep.active)
+            {
+                size_t t = mzOrder_[a];
+                const Target& target = targets_[t];
+                if (!accepts(target, msLevel, isolationLow, isolationHigh)) continue;
+
+                begin = lower_bound(begin, mz.end(), target.mzLow);
+                double sum = 0;
+                for (vector<double>::iterator itr = begin; itr != mz.end() && *itr <= target.mzHigh; ++itr)
+                    sum += intensity[itr - mz.begin()];
+                chunk.points.push_back(XICPoint(t, time, sum));
+            }
+        }
+    }
+
+    private:
+
+    struct LessThanMZLow
+    {
+        LessThanMZLow(const vector<Target>& targets) : targets(targets) {}
+        bool operator() (size_t lhs, size_t rhs) const {return targets[lhs].mzLow < targets[rhs].mzLow;}
+        const vector<Target>& targets;
+    };
+
+    // orders the positions in mzOrder by the rtLow of their targets
+    struct LessThanRTLow
+    {
+        LessThanRTLow(const vector<Target>& targets, const vector<size_t>& mzOrder) : targets(targets), mzOrder(mzOrder) {}
+        bool operator() (size_t lhs, size_t rhs) const {return targets[mzOrder[lhs]].rtLow < targets[mzOrder[rhs]].rtLow;}
+        const vector<Target>& targets;
+        const vector<size_t>& mzOrder;
+    };
+
+    void advance(Sweep& sweep, double time) const
+    {
+        // scan times normally only increase; if not, start the sweep over
+        if (time < sweep.lastTime)
+            sweep = Sweep();
+        sweep.lastTime = time;
+
+        size_t activeCount = sweep.active.size();
+        for (; sweep.nextRT < rtOrder_.size() && targets_[mzOrder_[rtOrder_[sweep.nextRT]]].rtLow <= time; ++sweep.nextRT)
+            sweep.active.push_back(rtOrder_[sweep.nextRT]);
+        if (sweep.active.size() > activeCount)
+            sort(sweep.active.begin(), sweep.active.end());
+
+        sweep.active.erase(remove_if(sweep.active.begin(), sweep.active.end(), EndsBefore(targets_, mzOrder_, time)), sweep.active.end());
+    }
+
+    struct EndsBefore
+    {
+        EndsBefore(const vector<Target>& targets, const vector<size_t>& mzOrder, double time) : targets(targets), mzOrder(mzOrder), time(time) {}
+        bool operator() (size_t a) const {return targets[mzOrder[a]].rtHigh < time;}
+        const vector<Target>& targets;
+        const vector<size_t>& mzOrder;
+        double time;
+    };
+
+    static bool accepts(const Target& target, int msLevel, double isolationLow, double isolationHigh)
+    {
+        if (target.msLevel != msLevel)
+            return false;
+        if (msLevel == 1 || (target.precursorMzLow == 0 && target.precursorMzHigh == 0))
+            return true;
+        return target.precursorMzLow <= isolationHigh && isolationLow <= target.precursorMzHigh;
+    }
+
+    static void getIsolationWindow(const Spectrum& s, double& low, double& high)
+    {
+        if (s.precursors.empty())
+            return;
+
+        const Precursor& precursor = s.precursors[0];
+        double target = precursor.isolationWindow.cvParam(MS_isolation_window_target_m_z).valueAs<double>();
+        if (target == 0 && !precursor.selectedIons.empty())
+            target = precursor.selectedIons[0].cvParam(MS_selected_ion_m_z).valueAs<double>();
+
+        low = target - precursor.isolationWindow.cvParam(MS_isolation_window_lower_offset).valueAs<double>();
+        high = target + precursor.isolationWindow.cvParam(MS_isolation_window_upper_offset).valueAs<double>();
+    }
+
+    static void getSortedPeaks(const BinaryDataArray& mzArray, const BinaryDataArray& intensityArray,
+                               vector<double>& mz, vector<double>& intensity)
+    {
+        size_t size = min(mzArray.size(), intensityArray.size());
+        mz.resize(size);
+        intensity.resize(size);
+        for (size_t i=0; i < size; ++i)
+        {
+            mz[i] = mzArray.value(i);
+            intensity[i] = intensityArray.value(i);
+        }
+
+        if (is_sorted(mz.begin(), mz.end()))
+            return;
+
+        vector<pair<double, double> > peaks(size);
+        for (size_t i=0; i < size; ++i)
+            peaks[i] = make_pair(mz[i], intensity[i]);
+        sort(peaks.begin(), peaks.end());
+        for (size_t i=0; i < size; ++i)
+        {
+            mz[i] = peaks[i].first;
+            intensity[i] = peaks[i].second;
+        }
+    }
+
+    const SpectrumList& sl_;
+    const vector<Target>& targets_;
+    vector<size_t> mzOrder_; // target indices sorted by mzLow
+    vector<size_t> rtOrder_; // positions in mzOrder_ sorted by rtLow
+    set<int> msLevels_;
+};
+
+
+} // namespace
+
+
+PWIZ_API_DECL ChromatogramList_XICExtractor::ChromatogramList_XICExtractor(const SpectrumListPtr& spectrumList,
+                                                                         const vector<Target>& targets,
+                                                                         size_t threadCount)
+{
+    if (!spectrumList.get()) throw runtime_error("[ChromatogramList_XICExtractor] Null pointer");
+
+    const SpectrumList& sl = *spectrumList;
+    Extractor extractor(sl, targets);
+
+    const size_t chunkSize = 64;
+    vector<Chunk> chunks((sl.size() + chunkSize - 1) / chunkSize);
+    for (size_t i=0; i < chunks.size(); ++i)
+    {
+        chunks[i].begin = i * chunkSize;
+        chunks[i].end = min(sl.size(), chunks[i].begin + chunkSize);
+    }
+
+    if (threadCount == 0)
+        threadCount = SpectrumWorkerThreads::defaultThreadCount();
+    threadCount = max((size_t) 1, min(threadCount, chunks.size()));
+    if (threadCount > 1 && !SpectrumWorkerThreads::isThreadSafe(sl))
+        threadCount = 1;
+
+    // the chunks are handed out in index order so each worker's scan times mostly increase
+    vector<Extractor::Sweep> sweeps(threadCount);
+    util::parallelFor(chunks.size(), [&](size_t c, size_t worker)
+    {
+        extractor.extract(chunks[c], sweeps[worker]);
+    }, threadCount);
+
+    // gather the points of each target in spectrum order
+    vector<vector<double> > times(targets.size()), intensities(targets.size());
+    BOOST_FOREACH(const Chunk& chunk, chunks)
+        BOOST_FOREACH(const XICPoint& point, chunk.points)
+        {
+            times[point.target].push_back(point.time);
+            intensities[point.target].push_back(point.intensity);
+        }
+
+    chromatograms_.reserve(targets.size());
+    for (size_t i=0; i < targets.size(); ++i)
+    {
+        const Target& target = targets[i];
+        ChromatogramPtr c(new Chromatogram);
+        c->index = i;
+        c->id = target.id;
+
+        if (target.msLevel > 1 && (target.precursorMzLow != 0 || target.precursorMzHigh != 0))
+        {
+            c->set(MS_selected_reaction_monitoring_chromatogram);
+            c->precursor.isolationWindow.set(MS_isolation_window_target_m_z, (target.precursorMzLow + target.precursorMzHigh) / 2, MS_m_z);
+        }
+        else
+            c->set(MS_selected_ion_current_chromatogram);
+        c->set(MS_ms_level, target.msLevel);
+
+        double mz = (target.mzLow + target.mzHigh) / 2;
+        c->product.isolationWindow.set(MS_isolation_window_target_m_z, mz, MS_m_z);
+        c->product.isolationWindow.set(MS_isolation_window_lower_offset, mz - target.mzLow, MS_m_z);
+        c->product.isolationWindow.set(MS_isolation_window_upper_offset, target.mzHigh - mz, MS_m_z);
+
+        c->setTimeIntensityArrays(times[i], intensities[i], UO_second, MS_number_of_detector_counts);
+        vector<double>().swap(times[i]);
+        vector<double>().swap(intensities[i]);
+        chromatograms_.push_back(c);
+    }
+}
+
+
+PWIZ_API_DECL vector<ChromatogramList_XICExtractor::Target>
+ChromatogramList_XICExtractor::targetsFromTraML(const tradata::TraData& td,
+                                                const MZTolerance& productTolerance,
+                                                const MZTolerance& precursorTolerance)
+{
+    vector<Target> targets;
+    BOOST_FOREACH(const tradata::Transition& transition, td.transitions)
+    {
+        double productMz = transition.product.cvParam(MS_isolation_window_target_m_z).valueAs<double>();
+        double precursorMz = transition.precursor.cvParam(MS_isolation_window_target_m_z).valueAs<double>();
+
+        Target target(transition.id, productMz - productTolerance, productMz + productTolerance, 2);
+        target.precursorMzLow = precursorMz - precursorTolerance;
+        target.precursorMzHigh = precursorMz + precursorTolerance;
+
+        CVParam rt = transition.retentionTime.cvParam(MS_local_retention_time);
+        CVParam rtLowerOffset = transition.retentionTime.cvParam(MS_retention_time_window_lower_offset);
+        CVParam rtUpperOffset = transition.retentionTime.cvParam(MS_retention_time_window_upper_offset);
+        if (!rt.empty() && !rtLowerOffset.empty() && !rtUpperOffset.empty())
+        {
+            target.rtLow = rt.timeInSeconds() - rtLowerOffset.timeInSeconds();
+            target.rtHigh = rt.timeInSeconds() + rtUpperOffset.timeInSeconds();
+        }
+
+        targets.push_back(target);
+    }
+    return targets;
+}
+
+
+PWIZ_API_DECL size_t ChromatogramList_XICExtractor::size() const
+{
+    return chromatograms_.size();
+}
+
+
+PWIZ_API_DECL const ChromatogramIdentity& ChromatogramList_XICExtractor::chromatogramIdentity(size_t index) const
+{
+    if (index >= size())
+        throw runtime_error("[ChromatogramList_XICExtractor::chromatogramIdentity()] Index out of bounds.");
+    return *chromatograms_[index];
+}
+
+
+PWIZ_API_DECL ChromatogramPtr ChromatogramList_XICExtractor::chromatogram(size_t index, bool getBinaryData) const
+{
+    if (index >= size())
+        throw runtime_error("[ChromatogramList_XICExtractor::chromatogram()] Index out of bounds.");
+    if (getBinaryData)
+        return chromatograms_[index];
+
+    ChromatogramPtr result(new Chromatogram(*chromatograms_[index]));
+    result->binaryDataArrayPtrs.clear();
+    return result;
+}
+
+
+} // namespace analysis
+} // namespace pwiz
@@ -0,0 +1,91 @@
+//
+// $Id$
+//
+//
+// Original author: agent <agent@local>
+//
+// Copyright 2026
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef _CHROMATOGRAMLIST_XICEXTRACTOR_HPP_
+#define _CHROMATOGRAMLIST_XICEXTRACTOR_HPP_
+
+
+#include "pwiz/utility/misc/Export.hpp"
+#include "pwiz/data/msdata/ChromatogramListBase.hpp"
+#include "pwiz/data/tradata/TraData.hpp"
+#include "pwiz/utility/chemistry/MZTolerance.hpp"
+
+
+namespace pwiz {
+namespace analysis {
+
+
+/// ChromatogramList of extracted ion chromatograms for a list of targets, computed from any
+/// SpectrumList in one pass over its spectra (split among several threads if the list allows it)
+class PWIZ_API_DECL ChromatogramList_XICExtractor : public msdata::ChromatogramListBase
+{
+    public:
+
+    /// an m/z range to extract from the spectra of one MS level in a scan time range
+    struct PWIZ_API_DECL Target
+    {
+        Target();
+        Target(const std::string& id, double mzLow, double mzHigh, int msLevel = 1);
+
+        /// the id of the resulting chromatogram
+        std::string id;
+
+        /// the intensities of the peaks in [mzLow, mzHigh] are summed
+        double mzLow, mzHigh;
+
+        /// only spectra with scan start times in [rtLow, rtHigh] (in seconds) are used
+        double rtLow, rtHigh;
+
+        int msLevel;
+
+        /// for msLevel > 1: if not both 0, only spectra whose precursor isolation window overlaps
+        /// [precursorMzLow, precursorMzHigh] are used
+        double precursorMzLow, precursorMzHigh;
+    };
+
+    /// extracts the chromatograms of the targets from spectrumList (in the order of targets);
+    /// threadCount 0 means SpectrumWorkerThreads::defaultThreadCount()
+    ChromatogramList_XICExtractor(const msdata::SpectrumListPtr& spectrumList,
+                                  const std::vector<Target>& targets,
+                                  size_t threadCount = 0);
+
+    /// returns one target per transition: its product m/z, precursor m/z and retention time window
+    /// (the whole run if the transition has no local retention time with window offsets)
+    static std::vector<Target> targetsFromTraML(const tradata::TraData& td,
+                                                const chemistry::MZTolerance& productTolerance,
+                                                const chemistry::MZTolerance& precursorTolerance);
+
+    /// implementation of ChromatogramList
+    virtual size_t size() const;
+    virtual const msdata::ChromatogramIdentity& chromatogramIdentity(size_t index) const;
+    virtual msdata::ChromatogramPtr chromatogram(size_t index, bool getBinaryData = false) const;
+
+    private:
+    std::vector<msdata::ChromatogramPtr> chromatograms_;
+};
+
+
+} // namespace analysis
+} // namespace pwiz
+
+
+#endif // _CHROMATOGRAMLIST_XICEXTRACTOR_HPP_
@@ -0,0 +1,215 @@
+//
+// $Id$
+//
+//
+// Original author: agent <agent@local>
+//
+// Copyright 2026
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "ChromatogramList_XICExtractor.hpp"
+#include "pwiz/utility/misc/unit.hpp"
+#include "pwiz/utility/misc/Std.hpp"
+#include "pwiz/data/tradata/examples.hpp"
+#include <cstring>
+
+
+using namespace pwiz;
+using namespace pwiz::msdata;
+using namespace pwiz::analysis;
+using namespace pwiz::util;
+using namespace pwiz::chemistry;
+
+typedef ChromatogramList_XICExtractor::Target XICTarget;
+
+
+ostream* os_ = 0;
+
+
+// a cycle of one MS1 and two MS2 spectra (precursors 500 and 600) every 3 seconds;
+// every spectrum has peaks at 100, 101, ..., 109 with intensity = index * 10 + peak
+SpectrumListPtr createSpectrumList(size_t cycleCount)
+{
+    SpectrumListSimplePtr sl(new SpectrumListSimple);
+
+    for (size_t i=0; i < cycleCount * 3; ++i)
+    {
+        SpectrumPtr spectrum(new Spectrum);
+        spectrum->index = i;
+        spectrum->id = "scan=" + lexical_cast<string>(i+1);
+        spectrum->scanList.scans.push_back(Scan());
+        spectrum->scanList.scans[0].set(MS_scan_start_time, (double) i, UO_second);
+
+        int msLevel = i % 3 == 0 ? 1 : 2;
+        spectrum->set(MS_ms_level, msLevel);
+        if (msLevel == 2)
+        {
+            spectrum->precursors.push_back(Precursor());
+            spectrum->precursors[0].isolationWindow.set(MS_isolation_window_target_m_z, i % 3 == 1 ? 500 : 600, MS_m_z);
+            spectrum->precursors[0].isolationWindow.set(MS_isolation_window_lower_offset, 10, MS_m_z);
+            spectrum->precursors[0].isolationWindow.set(MS_isolation_window_upper_offset, 10, MS_m_z);
+        }
+
+        vector<double> mz, intensity;
+        for (size_t j=0; j < 10; ++j)
+        {
+            mz.push_back(100 + j);
+            intensity.push_back(i * 10 + j);
+        }
+        spectrum->setMZIntensityArrays(mz, intensity, MS_number_of_detector_counts);
+        sl->spectra.push_back(spectrum);
+    }
+
+    return sl;
+}
+
+
+vector<XICTarget> createTargets()
+{
+    vector<XICTarget> targets;
+
+    targets.push_back(XICTarget("MS1 101.5-103.5", 101.5, 103.5)); // peaks 102, 103
+
+    targets.push_back(XICTarget("MS1 105-105 RT 10-20", 105, 105)); // peak 105
+    targets.back().rtLow = 10;
+    targets.back().rtHigh = 20;
+
+    targets.push_back(XICTarget("MS2 500 100-100.5", 100, 100.5, 2)); // peak 100
+    targets.back().precursorMzLow = targets.back().precursorMzHigh = 495;
+
+    targets.push_back(XICTarget("MS2 any 109-120", 109, 120, 2)); // peak 109
+
+    targets.push_back(XICTarget("MS1 200-300", 200, 300)); // no peaks
+
+    return targets;
+}
+
+
+void testExtraction(size_t threadCount)
+{
+    if (os_) *os_ << "testExtraction: " << threadCount << " threads" << endl;
+
+    const size_t cycleCount = 500; // enough for several chunks per thread
+    SpectrumListPtr sl = createSpectrumList(cycleCount);
+    vector<XICTarget> targets = createTargets();
+
+    ChromatogramList_XICExtractor cl(sl, targets, threadCount);
+    unit_assert_operator_equal(targets.size(), cl.size());
+
+    for (size_t i=0; i < cl.size(); ++i)
+    {
+        unit_assert_operator_equal(targets[i].id, cl.chromatogramIdentity(i).id);
+        unit_assert_operator_equal(i, cl.chromatogramIdentity(i).index);
+        unit_assert(cl.chromatogram(i, false)->binaryDataArrayPtrs.empty());
+    }
+
+    vector<TimeIntensityPair> points;
+
+    cl.chromatogram(0, true)->getTimeIntensityPairs(points);
+    unit_assert_operator_equal(cycleCount, points.size());
+    for (size_t j=0; j < points.size(); ++j)
+    {
+        size_t index = j * 3;
+        unit_assert_operator_equal((double) index, points[j].time);
+        unit_assert_operator_equal(index * 10 + 2 + index * 10 + 3, points[j].intensity);
+    }
+    unit_assert(cl.chromatogram(0, false)->hasCVParam(MS_selected_ion_current_chromatogram));
+
+    cl.chromatogram(1, true)->getTimeIntensityPairs(points);
+    unit_assert_operator_equal(3, points.size()); // MS1 scans at 12, 15 and 18
+    unit_assert_operator_equal(12, points[0].time);
+    unit_assert_operator_equal(18 * 10 + 5, points.back().intensity);
+
+    ChromatogramPtr c = cl.chromatogram(2, true);
+    c->getTimeIntensityPairs(points);
+    unit_assert_operator_equal(cycleCount, points.size());
+    unit_assert_operator_equal(1, points[0].time);
+    unit_assert_operator_equal(4 * 10, points[1].intensity);
+    unit_assert(c->hasCVParam(MS_selected_reaction_monitoring_chromatogram));
+    unit_assert_operator_equal(495, c->precursor.isolationWindow.cvParam(MS_isolation_window_target_m_z).valueAs<double>());
+
+    cl.chromatogram(3, true)->getTimeIntensityPairs(points);
+    unit_assert_operator_equal(cycleCount * 2, points.size());
+    unit_assert_operator_equal(2, points[1].time);
+    unit_assert_operator_equal(2 * 10 + 9, points[1].intensity);
+
+    cl.chromatogram(4, true)->getTimeIntensityPairs(points);
+    unit_assert_operator_equal(cycleCount, points.size());
+    unit_assert_operator_equal(0, points.back().intensity);
+}
+
+
+void testTraML()
+{
+    if (os_) *os_ << "testTraML" << endl;
+
+    tradata::TraData td;
+    tradata::examples::initializeTiny(td);
+
+    vector<XICTarget> targets = ChromatogramList_XICExtractor::targetsFromTraML(td, MZTolerance(0.5), MZTolerance(10, MZTolerance::PPM));
+    unit_assert_operator_equal(td.transitions.size(), targets.size());
+
+    for (size_t i=0; i < targets.size(); ++i)
+    {
+        const tradata::Transition& transition = td.transitions[i];
+        double productMz = transition.product.cvParam(MS_isolation_window_target_m_z).valueAs<double>();
+        double precursorMz = transition.precursor.cvParam(MS_isolation_window_target_m_z).valueAs<double>();
+
+        unit_assert_operator_equal(transition.id, targets[i].id);
+        unit_assert_operator_equal(2, targets[i].msLevel);
+        unit_assert_equal(productMz - 0.5, targets[i].mzLow, 1e-8);
+        unit_assert_equal(productMz + 0.5, targets[i].mzHigh, 1e-8);
+        unit_assert(targets[i].precursorMzLow < precursorMz && precursorMz < targets[i].precursorMzHigh);
+
+        if (transition.retentionTime.hasCVParam(MS_retention_time_window_lower_offset))
+        {
+            double rt = transition.retentionTime.cvParam(MS_local_retention_time).timeInSeconds();
+            unit_assert(targets[i].rtLow < rt && rt < targets[i].rtHigh);
+        }
+        else
+            unit_assert_operator_equal(0, targets[i].rtLow);
+    }
+}
+
+
+void test()
+{
+    testExtraction(1);
+    testExtraction(4);
+    testTraML();
+}
+
+
+int main(int argc, char* argv[])
+{
+    TEST_PROLOG(argc, argv)
+
+    try
+    {
+        if (argc>1 && !strcmp(argv[1],"-v")) os_ = &cout;
+        test();
+    }
+    catch (exception& e)
+    {
+        TEST_FAILED(e.what())
+    }
+    catch (...)
+    {
+        TEST_FAILED("Caught unknown exception.")
+    }
+
+    TEST_EPILOG
+}
@@ -23,6 +23,7 @@
 
 #include "CwtPeakDetector.hpp"
 #include "pwiz/utility/misc/Std.hpp"
+#include <boost/thread/tss.hpp>
 
 // Predicate for sorting vectors of ridgeLines 
 bool sortFinalCol (ridgeLine i, ridgeLine j) { return (i.Col<j.Col); } 
@@ -30,6 +31,34 @@ bool sortFinalCol (ridgeLine i, ridgeLine j) { return (i.Col<j.Col); }
 namespace pwiz {
 namespace analysis {
 
+namespace {
+
+// The arrays detect() needs for a spectrum. They are kept per thread and only grow, so picking spectra
+// (e.g. on SpectrumWorkerThreads) doesn't allocate and page in several MB per spectrum.
+struct CwtWorkspace
+{
+    vector < vector<double> > corrMatrix; // correlation matrix
+    vector <double> widths;
+    vector < vector< vector<int> > > waveletPoints;
+};
+
+boost::thread_specific_ptr<CwtWorkspace> workspace_;
+
+// spectra longer than this don't keep their workspace (about 250 bytes per point), so one huge
+// spectrum doesn't pin its memory for the life of the thread
+const int maxRetainedWorkspaceLength = 1 << 17;
+
+// the ricker (mexican hat) wavelet at distance t=vec from its center: A * (1 - t^2/w^2) * exp(-t^2 / (2*w^2)), with wsq = w^2
+inline double ricker(const double vec, const double A, const double wsq)
+{
+    double tsq = vec * vec;
+    double mod = 1.0 - tsq / wsq;
+    double gauss = exp( -1.0 * tsq / (2.0 * wsq) );
+    return A * mod * gauss;
+}
+
+} // namespace
+
 PWIZ_API_DECL
 CwtPeakDetector::CwtPeakDetector(double minSnr, int fixedPeaksKeep, double mzTol )
 : minSnr_(minSnr), fixedPeaksKeep_(fixedPeaksKeep), mzTol_(mzTol)
@@ -67,11 +96,23 @@ void CwtPeakDetector::detect(const vector<double>& x, const vector<double>& y,
     if ( mzLength <= 2 ) return;
     int corrMatrixLength = 2*mzLength-1; // number of data points in a row of the correlation matrix
 
-    // Data arrays
-    vector < vector<double> > corrMatrix(nScales, vector<double>(corrMatrixLength,0.0)); // correlation matrix
-    vector < vector<bool> > locMaxs(nScales, vector<bool>(corrMatrixLength,false)); // local maxima matrix
-    vector <double> widths(mzLength,0.0);
-    vector < vector< vector<int> > > waveletPoints(2, vector<vector<int> >(nScales,vector<int>(mzLength,0)));
+    // Data arrays, reusing this thread's memory
+    if (!workspace_.get())
+        workspace_.reset(new CwtWorkspace);
+    vector < vector<double> >& corrMatrix = workspace_->corrMatrix;
+    corrMatrix.resize(nScales);
+    for (int i = 0; i < nScales; ++i)
+        corrMatrix[i].assign(corrMatrixLength, 0.0); // calcCorrelation skips points, which must read as 0
+    vector <double>& widths = workspace_->widths;
+    widths.assign(mzLength, 0.0);
+    vector < vector< vector<int> > >& waveletPoints = workspace_->waveletPoints;
+    waveletPoints.resize(2);
+    for (int i = 0; i < 2; ++i)
+    {
+        waveletPoints[i].resize(nScales);
+        for (int j = 0; j < nScales; ++j)
+            waveletPoints[i][j].assign(mzLength, 0);
+    }
     
     getScales( x, y, waveletPoints, widths );
 
@@ -88,6 +129,9 @@ void CwtPeakDetector::detect(const vector<double>& x, const vector<double>& y,
     xPeakValues.resize(allLines.size()), yPeakValues.resize(allLines.size());
     refinePeaks( x, y, allLines, widths, xPeakValues, yPeakValues, snrs );
 
+    if (mzLength > maxRetainedWorkspaceLength)
+        workspace_.reset();
+
 }
 
 // Function for determining the scales we want to sample for the CWT calculation
@@ -152,22 +196,23 @@ void CwtPeakDetector::getScales( const vector <double> & mzData, const vector <d
         double sum = accumulate( Xspacing.begin() + windowLow, Xspacing.begin() + windowHigh, 0.0);
         widths[i] = sum / double(nTot);
 
-        // figure out the number of wavelet points you'll need to sample for each m/z point
+        // figure out the number of wavelet points you'll need to sample for each m/z point;
+        // the scalings increase, so each scale's window extends the previous scale's window
+        int nPointsLeft = 0;
+        int nPointsRight = 0;
         for (int j=0; j<scalesToInclude; ++j)
         {
 
             double maxMZwindow = widths[i] * scalings[j] * 3.0; // this returns the max possible m/z away from the current point where a wavelet may still contribute to the correlation
 
-            int nPointsLeft = 0;
-            int counter = i;
+            int counter = i - nPointsLeft;
             while ( --counter >= 0  )
             {
                 if ( mzData[i] - mzData[counter] > maxMZwindow ) break;
                 nPointsLeft++;
             }
 
-            int nPointsRight = 0;
-            counter = i;
+            counter = i + nPointsRight;
             while ( ++counter < mzLength  )
             {
                 if ( mzData[counter] - mzData[i] > maxMZwindow ) break;
@@ -192,25 +237,14 @@ void CwtPeakDetector::calcCorrelation( const vector <double> & mz, const vector
                         const vector <double> & widths, vector < vector <double> > & matrix) const
 {
 
-    int mzLength = mz.size();
-
-    // setup padded arrays for facilitating the wavelet computation
-    int paddingPoints = 500; // should be more than sufficient
-    vector <double> PadMz(mzLength+2*paddingPoints,0.0); // x array with padding on the front and back
-    vector <double> PadIntensity(mzLength+2*paddingPoints,0.0); // y array with padding on the front and back
-    for (int j = paddingPoints; j < mzLength + paddingPoints; j++)
-    {
-        PadMz[j] = mz[j-paddingPoints];
-        PadIntensity[j] = intensity[j-paddingPoints];
-    }
-    vector <double> waveletData(paddingPoints,0.0);
-
+    int mzLength = mz.size();
+
     // calculate correlation between wavelet and spectrum data, populate correlation matrix
     for (int i = 0; i<nScales ; i++)
     {
 
         double currentScaling = scalings[i];
-        int matrixIndex = 2; // This depends on the starting index in the loop immediately below!!
+        vector <double> & row = matrix[i];
 
         for (int j = 1; j < mzLength-1; j++)
         { 
@@ -219,43 +253,31 @@ void CwtPeakDetector::calcCorrelation( const vector <double> & mz, const vector
             if ( i > 0 ) // calculate first row no matter what, as this is important for the noise calculation
             {
                 if ( intensity[j] < 0.75*intensity[j-1] || intensity[j] < 0.75*intensity[j+1] )
-                {
-                    matrixIndex += 2;
                     continue;
-                }
             }
 
             int nPointsLeft = waveletPoints[0][i][j];
             int nPointsRight = waveletPoints[1][i][j];
-            
 
-            int paddedCol = j + paddingPoints;
             double width = widths[j]*currentScaling;
             double param1 = 2.0 / ( sqrt(3.0 * width) * (sqrt( sqrt(3.141519) ) ) ); // ricker wavelet parameter
             double param2 = width * width; // ricker wavelet parameter
 
-
-            ricker2d(PadMz, paddedCol, nPointsLeft, nPointsRight, param1, param2, PadMz[paddedCol], waveletData);
-
-
-            int startPoint = paddedCol - nPointsLeft;
-            for (int k = 0; k < nPointsLeft+nPointsRight+1 ; k++)
-                matrix[i][matrixIndex] += waveletData[k] * PadIntensity[startPoint+k]; 
-
-            matrixIndex++;
-
-            if ( j == mzLength-1 ) break; // jump out before final iteration
-
-            double moverzShift = ( PadMz[ paddedCol ] + PadMz[ paddedCol + 1 ] ) / 2.0;
-
             // calculate the correlation at the midpoint between two m/z points, as well. This is why
             // the length of the correlation matrix is (almost) twice that of the number of m/z points.
-            ricker2d(PadMz, paddedCol, nPointsLeft, nPointsRight, param1, param2, moverzShift, waveletData);
+            double moverzShift = ( mz[j] + mz[j+1] ) / 2.0;
 
-            for (int k = 0; k < nPointsLeft+nPointsRight+1 ; k++)
-                matrix[i][matrixIndex] += waveletData[k] * PadIntensity[startPoint+k];
+            // both wavelets are sampled at the same points in one pass; points without intensity don't contribute
+            double correlation = 0.0, shiftedCorrelation = 0.0;
+            for (int k = j - nPointsLeft, end = j + nPointsRight; k <= end; k++)
+            {
+                if ( intensity[k] == 0.0 ) continue;
+                correlation += ricker( mz[k] - mz[j], param1, param2 ) * intensity[k];
+                shiftedCorrelation += ricker( mz[k] - moverzShift, param1, param2 ) * intensity[k];
+            }
 
-            matrixIndex++;
+            row[2*j] += correlation;
+            row[2*j+1] += shiftedCorrelation;
 
         } // end for over mzPoints
 
@@ -507,26 +529,6 @@ void CwtPeakDetector::refinePeaks( const vector <double> & noisyX, const vector
 } // namespace msdata
 
 
-// helper function that calculates the ricker (mexican hat) wavelet.
-// Designed to handle irregularly spaced data.
-void ricker2d(const vector <double> & Pad_mz, const int col, const int rickerPointsLeft, const int rickerPointsRight, 
-                const double A, const double wsq, const double centralMZ, vector <double> & total)
-{
-	if (rickerPointsRight - rickerPointsLeft >= (int) total.size())
-		throw runtime_error("[CwtPeakDetector::ricker2d] invalid input parameters");
-
-    for (int i = col-rickerPointsLeft, cnt=0, end = col+rickerPointsRight; i <= end; i++, cnt++) 
-    {
-            double vec = Pad_mz[i] - centralMZ;
-            double tsq = vec * vec;
-            double mod = 1.0 - tsq / wsq;
-            double gauss = exp( -1.0 * tsq / (2.0 * wsq) );
-            total[cnt] = A * mod * gauss;
-    }
-
-}
-// end of function ricker2d
-
 // want first point to the right of target
 int getColLowBound(const vector <double> & mzs,const double target)
 {
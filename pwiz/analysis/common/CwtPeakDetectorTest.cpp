@@ -24,6 +24,7 @@
 #include "CwtPeakDetector.hpp"
 #include "pwiz/utility/misc/unit.hpp"
 #include "pwiz/utility/misc/Std.hpp"
+#include <boost/thread/thread.hpp>
 
 using namespace pwiz::util;
 using namespace pwiz::analysis;
@@ -141,6 +142,86 @@ void test()
 }
 
 
+struct PeakValues
+{
+    vector<double> x, y;
+};
+
+
+// picks the test spectra in an order that depends on the thread, so each thread's workspace is reused
+// by spectra of different lengths, and counts the results that differ from the serial ones
+void detectTestData(CwtPeakDetector* peakDetector, const vector<PeakValues>* rawData, const vector<PeakValues>* serialPeaks,
+                    size_t threadIndex, size_t* mismatches)
+{
+    for (size_t repeat=0; repeat < 5; ++repeat)
+        for (size_t i=0; i < rawData->size(); ++i)
+        {
+            size_t index = (i + threadIndex + repeat) % rawData->size();
+            PeakValues peaks;
+            peakDetector->detect((*rawData)[index].x, (*rawData)[index].y, peaks.x, peaks.y);
+            if (peaks.x != (*serialPeaks)[index].x || peaks.y != (*serialPeaks)[index].y)
+                ++*mismatches;
+        }
+}
+
+
+void testThreads()
+{
+    // a detector is shared by the threads of SpectrumList_PeakPicker
+    CwtPeakDetector peakDetector(1.0,0,0.01);
+
+    vector<PeakValues> rawData(testDataSize), serialPeaks(testDataSize);
+    for (size_t i=0; i < testDataSize; ++i)
+    {
+        rawData[i].x = parseDoubleArray(testData[i].xRaw);
+        rawData[i].y = parseDoubleArray(testData[i].yRaw);
+        peakDetector.detect(rawData[i].x, rawData[i].y, serialPeaks[i].x, serialPeaks[i].y);
+    }
+
+    const size_t threadCount = 4;
+    vector<size_t> mismatches(threadCount, 0);
+    boost::thread_group threads;
+    for (size_t i=0; i < threadCount; ++i)
+        threads.add_thread(new boost::thread(detectTestData, &peakDetector, &rawData, &serialPeaks, i, &mismatches[i]));
+    threads.join_all();
+
+    for (size_t i=0; i < threadCount; ++i)
+        unit_assert_operator_equal(0, mismatches[i]);
+}
+
+
+void testLargeSpectrum()
+{
+    // a spectrum too large for its workspace to be kept must not change the picking of the ones after it
+    CwtPeakDetector peakDetector(1.0,0,0.01);
+
+    vector<PeakValues> rawData(testDataSize), peaks(testDataSize);
+    for (size_t i=0; i < testDataSize; ++i)
+    {
+        rawData[i].x = parseDoubleArray(testData[i].xRaw);
+        rawData[i].y = parseDoubleArray(testData[i].yRaw);
+        peakDetector.detect(rawData[i].x, rawData[i].y, peaks[i].x, peaks[i].y);
+    }
+
+    PeakValues large, largePeaks;
+    for (size_t i=0; i < 150000; ++i)
+    {
+        large.x.push_back(200 + i * 0.01);
+        large.y.push_back(100 + 1e5 * exp(-pow((int(i % 200) - 100) / 3.0, 2)));
+    }
+    peakDetector.detect(large.x, large.y, largePeaks.x, largePeaks.y);
+    unit_assert(largePeaks.x.size() > 100);
+
+    for (size_t i=0; i < testDataSize; ++i)
+    {
+        PeakValues after;
+        peakDetector.detect(rawData[i].x, rawData[i].y, after.x, after.y);
+        unit_assert(after.x == peaks[i].x);
+        unit_assert(after.y == peaks[i].y);
+    }
+}
+
+
 int main(int argc, char* argv[])
 {
     TEST_PROLOG(argc, argv)
@@ -149,6 +230,8 @@ int main(int argc, char* argv[])
     {
         if (argc>1 && !strcmp(argv[1],"-v")) os_ = &cout;
         test();
+        testThreads();
+        testLargeSpectrum();
     }
     catch (exception& e)
     {
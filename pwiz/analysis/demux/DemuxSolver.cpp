@@ -21,18 +21,135 @@
 
 #include "DemuxSolver.hpp"
 #include "nnls.h"
+#include "pwiz/utility/misc/mru_list.hpp"
+#include <boost/make_shared.hpp>
+#include <boost/functional/hash.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
+#include <cstring>
+#include <utility>
 
 namespace pwiz{
 namespace analysis{
     typedef NNLS<DemuxTypes::MatrixType> NNLSType;
-    void NNLSSolver::Solve(const MatrixPtr& masks, const MatrixPtr& signal, MatrixPtr& solution)
+
+    namespace {
+
+    /// Number of designs whose factorizations are kept; a run repeats about one design per spectrum in its cycle,
+    /// and each takes a few times the size of its mask matrix
+    const size_t kMaxCachedDesigns = 128;
+
+    /// The dimensions and coefficients of a design matrix, with their hash computed once; the cache's
+    /// invariant checking rehashes its keys on every insert, which would be slow for the coefficients themselves
+    struct DesignKey
+    {
+        explicit DesignKey(const MatrixType& masks) : bytes(2 * sizeof(MatrixType::Index) + masks.size() * sizeof(DemuxScalar), '\0')
+        {
+            MatrixType::Index dimensions[] = { masks.rows(), masks.cols() };
+            memcpy(&bytes[0], dimensions, sizeof(dimensions));
+            memcpy(&bytes[sizeof(dimensions)], masks.data(), masks.size() * sizeof(DemuxScalar));
+            hash = boost::hash<std::string>()(bytes);
+        }
+
+        bool operator==(const DesignKey& rhs) const { return hash == rhs.hash && bytes == rhs.bytes; }
+
+        std::string bytes;
+        size_t hash;
+    };
+
+    size_t hash_value(const DesignKey& key) { return key.hash; }
+
+    /// Quantities of a design matrix that are reused by every solve with that design
+    struct DesignFactorization
+    {
+        explicit DesignFactorization(DesignKey&& key) : key(std::move(key)), isInjective(false) {}
+
+        const DesignKey key;
+        NNLSType::MatrixAtAPtr AtA; ///< masks^T * masks, shared by the NNLS solvers of the design
+        ColPivHouseholderQR<MatrixType> qr; ///< for the unconstrained solve of all columns at once
+        bool isInjective; ///< true if the unconstrained solution is unique
+        boost::mutex mutex; ///< held while factorizing
+    };
+
+    typedef boost::shared_ptr<DesignFactorization> DesignFactorizationPtr;
+
+    } // namespace
+
+    class NNLSSolver::DesignCache
+    {
+    public:
+
+        DesignCache() : designs_(kMaxCachedDesigns) {}
+
+        /// Returns the factorization of masks from the cache, factorizing it if it isn't cached. A solution only depends on
+        /// the design, not on whether it was cached, so results don't depend on the order spectra are demultiplexed in.
+        DesignFactorizationPtr Get(const MatrixType& masks)
+        {
+            DesignKey key(masks);
+
+            DesignFactorizationPtr design;
+            {
+                // a cached design is looked up by its key; a new entry is only made when it is missing. Either way the mru is its entry
+                boost::lock_guard<boost::mutex> lock(mutex_);
+                if (!designs_.touch(key))
+                    designs_.insert(boost::make_shared<DesignFactorization>(std::move(key)));
+                design = designs_.mru();
+            }
+
+            boost::lock_guard<boost::mutex> lock(design->mutex);
+            if (!design->AtA)
+            {
+                design->qr.compute(masks);
+                design->isInjective = design->qr.isInjective();
+                design->AtA = boost::make_shared<NNLSType::MatrixAtAType>(masks.transpose() * masks);
+            }
+            return design;
+        }
+
+    private:
+
+        util::mru_list<DesignFactorizationPtr, BOOST_MULTI_INDEX_MEMBER(DesignFactorization, const DesignKey, key)> designs_;
+        boost::mutex mutex_;
+    };
+
+    NNLSSolver::NNLSSolver(int numIters, double eps) : numIters_(numIters), eps_(eps), designs_(new DesignCache)
+    {
+    }
+
+    void NNLSSolver::Solve(const MatrixPtr& masks, const MatrixPtr& signal, MatrixPtr& solution) const
     {
-        NNLSType solver(*masks, numIters_, eps_);
-        int numCols = static_cast<int>(signal->cols()); // OpenMP 2.0 only allows signed index variables in for loops
+        DesignFactorizationPtr design = designs_->Get(*masks);
+
+        // Solve all columns without the non-negativity constraint at once. A column whose unconstrained solution is non-negative
+        // already solves the NNLS problem; the others are solved by NNLS, starting from the unconstrained solution's passive set.
+        std::vector<int> constrainedCols;
+        if (design->isInjective)
+        {
+            *solution = design->qr.solve(*signal);
+            for (int fragIndex = 0; fragIndex < static_cast<int>(signal->cols()); ++fragIndex)
+                if ((solution->col(fragIndex).array() < 0).any())
+                    constrainedCols.push_back(fragIndex);
+        }
+        else
+        {
+            solution->setZero(); // cold start
+            for (int fragIndex = 0; fragIndex < static_cast<int>(signal->cols()); ++fragIndex)
+                constrainedCols.push_back(fragIndex);
+        }
+
+        if (constrainedCols.empty())
+            return;
+
+        // A^T * b of every column in one product
+        MatrixType Atb = masks->transpose() * *signal;
+
+        NNLSType solver(*masks, numIters_, eps_, design->AtA);
+        int numCols = static_cast<int>(constrainedCols.size()); // OpenMP 2.0 only allows signed index variables in for loops
 #pragma omp parallel for firstprivate(solver) schedule(dynamic)
-        for (int fragIndex = 0; fragIndex < numCols; ++fragIndex)
+        for (int i = 0; i < numCols; ++i)
         {
-            solver.solve(signal->col(fragIndex));
+            int fragIndex = constrainedCols[i];
+            solver.solve(signal->col(fragIndex), Atb.col(fragIndex), solution->col(fragIndex));
             solution->col(fragIndex).noalias() = solver.x();
         }
     }
@@ -44,7 +44,8 @@ namespace analysis {
         /// @param[in] signal Response matrix describing the signal of each transition in each multiplexed spectrum.
         /// @param[out] solution Matrix describing the independent spectrum of each isolation window. These are the demultiplexed spectra.
         ///
-        virtual void Solve(const MatrixPtr& masks, const MatrixPtr& signal, MatrixPtr& solution) = 0;
+        /// Solvers keep their workspace for the duration of a call, so several threads may solve with the same solver at once.
+        virtual void Solve(const MatrixPtr& masks, const MatrixPtr& signal, MatrixPtr& solution) const = 0;
 
         virtual ~DemuxSolver(){}
     };
@@ -52,6 +53,10 @@ namespace analysis {
     /// Implementation of the DemuxSolver interface as a non-negative least squares (NNLS) problem.
     /// That is, the least squares is problem is constrained such that the solution is not negative, or
     /// \f[ \min \left\Vert Ax-b\right\Vert_2^2\quad s.t.\, x\ge 0 \f]
+    ///
+    /// A run repeats the same few designs (one per position in the cycle), so the solver caches a factorization of each design.
+    /// All columns of the signal are first solved without the constraint in one blocked solve; only the columns whose unconstrained
+    /// solution has negative coefficients are solved by NNLS, starting from the passive set of their unconstrained solution.
     class NNLSSolver : public DemuxSolver
     {
     public:
@@ -59,16 +64,19 @@ namespace analysis {
         /// Constructor for non-negative least squares solver
         /// @param[in] numIters The maximum number of iterations allowed for convergence
         /// @param[in] eps Epsilon value for convergence criterion of NNLS solver
-         NNLSSolver(int numIters = 50, double eps = 1e-10) : numIters_(numIters), eps_(eps) {}
+        NNLSSolver(int numIters = 50, double eps = 1e-10);
         
         /// Implementation of DemuxSolver interface
-        void Solve(const MatrixPtr& masks, const MatrixPtr& signal, MatrixPtr& solution) override;
+        void Solve(const MatrixPtr& masks, const MatrixPtr& signal, MatrixPtr& solution) const override;
 
     private:
      
         int numIters_; ///< maximum number of iterations allowed for convergence
          
         double eps_; ///< tolerance for convergence
+
+        class DesignCache;
+        boost::shared_ptr<DesignCache> designs_; ///< factorizations of the most recently solved designs, shared by all threads
     };
 
 } // namespace analysis 
@@ -20,6 +20,7 @@
 #include "pwiz/analysis/demux/DemuxSolver.hpp"
 #include "pwiz/utility/misc/Std.hpp"
 #include "pwiz/utility/misc/unit.hpp"
+#include "nnls.h"
 
 using namespace pwiz::util;
 using namespace pwiz::analysis;
@@ -31,6 +32,7 @@ public:
     {
         SetUp();
         NNLSSolverTest();
+        BlockedSolveTest();
         TearDown();
     }
 
@@ -76,6 +78,69 @@ protected:
         TestNNLSGivenSolution(expectedSolution, trailingWindowIntensity);
     }
 
+    void BlockedSolveTest()
+    {
+        srand(1);
+        NNLSSolver solver;
+        int numSpectra = 20;
+        int numDemuxWindows = 10;
+        int numTransitions = 50;
+
+        // MSX-like designs with three windows per spectrum
+        MatrixPtr masks(new MatrixType(MatrixType::Zero(numSpectra, numDemuxWindows)));
+        for (int i = 0; i < numSpectra; ++i)
+            for (int k = 0; k < 3; ++k)
+                (*masks)(i, (i + k * (1 + rand() % 3)) % numDemuxWindows) = 1.0;
+
+        // Non-negative signals whose unconstrained solutions are mostly not, and an empty one
+        MatrixPtr signal(new MatrixType(numSpectra, numTransitions));
+        for (int i = 0; i < numSpectra; ++i)
+            for (int j = 0; j < numTransitions; ++j)
+                (*signal)(i, j) = rand() % 100;
+        signal->col(numTransitions - 1).setZero();
+
+        // The second solve uses the cached factorization of the design; both must match column-wise NNLS
+        for (int repeat = 0; repeat < 2; ++repeat)
+        {
+            MatrixPtr solution(new MatrixType(numDemuxWindows, numTransitions));
+            solver.Solve(masks, signal, solution);
+            TestBlockedSolution(*masks, *signal, *solution);
+        }
+
+        // A design with two identical windows has no unique unconstrained solution
+        masks->col(1) = masks->col(0);
+        for (int repeat = 0; repeat < 2; ++repeat)
+        {
+            MatrixPtr solution(new MatrixType(numDemuxWindows, numTransitions));
+            solver.Solve(masks, signal, solution);
+            TestBlockedSolution(*masks, *signal, *solution);
+        }
+
+        // A warm start from any guess converges to the same solution as a cold start
+        typedef NNLS<MatrixType> NNLSType;
+        NNLSType nnls(*masks);
+        NNLSType::ColVectorType b = signal->col(0);
+        NNLSType::RowVectorType Atb = masks->transpose() * b;
+        NNLSType::RowVectorType guess = NNLSType::RowVectorType::Constant(numDemuxWindows, 1.0);
+        unit_assert(nnls.solve(b, Atb, guess));
+        NNLSType::RowVectorType warm = nnls.x();
+        unit_assert(nnls.solve(b));
+        unit_assert_equal(0.0, (*masks * (warm - nnls.x())).norm(), 1e-8);
+    }
+
+    void TestBlockedSolution(const MatrixType& masks, const MatrixType& signal, const MatrixType& solution)
+    {
+        for (int j = 0; j < signal.cols(); ++j)
+        {
+            NNLS<MatrixType>::RowVectorType expected;
+            unit_assert(NNLS<MatrixType>::solve(masks, signal.col(j), expected, 50, 1e-10));
+            unit_assert((solution.col(j).array() >= 0).all());
+
+            // the fitted signal is unique even when the solution isn't
+            unit_assert_equal(0.0, (masks * (solution.col(j) - expected)).norm(), 1e-8 * (1 + signal.col(j).norm()));
+        }
+    }
+
     void TestNNLSGivenSolution(const vector<double>& expectedSolution, double trailingWindowIntensity)
     {
         NNLSSolver solver;
@@ -38,6 +38,6 @@ namespace DemuxTypes
     typedef Matrix<DemuxScalar, Dynamic, Dynamic> MatrixType;
     typedef boost::shared_ptr<MatrixType> MatrixPtr;
 
-    static const std::string kDEMUX_NAME = "Demultiplexing"; ///< This is a flag used by SpectrumWorkerThreads to handle demultiplexing
+    static const std::string kDEMUX_NAME = "Demultiplexing"; ///< Name recorded in the processing method of demultiplexed data
 } // namespace DemuxTypes
 #endif
\ No newline at end of file
@@ -26,6 +26,7 @@ namespace pwiz{
 namespace analysis{
 
     /// Interface for calculating demultiplexing scheme.
+    /// Implementations keep no state between calls to BuildDeconvBlock(), so blocks for several spectra may be built at once.
     class IDemultiplexer
     {
     public:
@@ -46,10 +47,13 @@ namespace analysis{
         /// @param[out] masks The design matrix with rows corresponding to individual spectra and columns corresponding to MS1 isolation windows
         /// @param[out] signal A transition (MS1 isolation -> MS2 point/centroid) to be deconvolved formatted as a column vector
         ///                   (or a set of transitions formatted as a matrix)
+        /// @param[out] spectrumIndices The indices to the demultiplexed windows in the solution matrix corresponding to the windows extracted
+        ///                   from the spectrum to demultiplex
         virtual void BuildDeconvBlock(size_t index,
             const std::vector<size_t>& muxIndices,
             DemuxTypes::MatrixPtr& masks,
-            DemuxTypes::MatrixPtr& signal) = 0;
+            DemuxTypes::MatrixPtr& signal,
+            std::vector<size_t>& spectrumIndices) const = 0;
 
         /// Figures out which spectra to include in the system of equations to demux. This skips over MS1 spectra and returns the indices
         /// of a range of MS2 spectra that can be used to demultiplex the chosen spectrum. This handles the case where the chosen spectrum
@@ -61,11 +65,6 @@ namespace analysis{
         /// @param[in] demuxBlockExtra Amount to pad the block size by
         virtual void GetMatrixBlockIndices(size_t indexToDemux, std::vector<size_t> &muxIndices, double demuxBlockExtra=0.0) const = 0;
 
-        /// Returns the indices to the demultiplexed windows in the solution matrix corresponding to the windows extracted from the spectrum
-        /// whose index was provided to BuildDeconvBlock()
-        /// @return Returns the demux indices for the solved spectrum
-        virtual const std::vector<size_t>& SpectrumIndices() const = 0;
-
         virtual ~IDemultiplexer() {}
     };
 } // namespace analysis
@@ -47,7 +47,7 @@ namespace analysis {
         pmc_ = pmc;
     }
 
-    void MSXDemultiplexer::BuildDeconvBlock(size_t index, const vector<size_t>& muxIndices, MatrixPtr& masks, MatrixPtr& signal)
+    void MSXDemultiplexer::BuildDeconvBlock(size_t index, const vector<size_t>& muxIndices, MatrixPtr& masks, MatrixPtr& signal, vector<size_t>& spectrumIndices) const
     {
         assert(sl_);
         assert(pmc_);
@@ -55,12 +55,13 @@ namespace analysis {
             throw runtime_error("Null pointer to SpectrumList and/or IPrecursorMaskCodec, MSXDemultiplexer may not have been initialized.");
 
         // get the list of peaks to demultiplex
-        BinaryDataArrayPtr mzsToDemux = sl_->spectrum(index, true)->getMZArray();
-        SpectrumPeakExtractor peakExtractor(mzsToDemux->data, params_.massError);
+        Spectrum_const_ptr deconvSpectrum = sl_->spectrum(index, true);
+        BinaryDataArrayPtr mzsToDemux = deconvSpectrum->getMZArray();
+        SpectrumPeakExtractor peakExtractor(*mzsToDemux, params_.massError);
 
         // initialize mask and intensities matrices
         masks.reset(new MatrixType(muxIndices.size(), pmc_->GetDemuxBlockSize()));
-        signal.reset(new MatrixType(muxIndices.size(), mzsToDemux->data.size()));
+        signal.reset(new MatrixType(muxIndices.size(), mzsToDemux->size()));
         
         int specPerCycle = pmc_->GetSpectraPerCycle();
         for (int matrixRow = 0; matrixRow < muxIndices.size(); ++matrixRow)
@@ -100,9 +101,8 @@ namespace analysis {
             peakExtractor(s, *signal, matrixRow, weight);
         }
 
-        // cache the spectrum indices
-        Spectrum_const_ptr sPtr = sl_->spectrum(index, true);
-        pmc_->SpectrumToIndices(sPtr, spectrumIndices_);
+        // get the indices of the spectrum's windows
+        pmc_->SpectrumToIndices(deconvSpectrum, spectrumIndices);
     }
 
     void MSXDemultiplexer::GetMatrixBlockIndices(size_t indexToDemux, std::vector<size_t>& muxIndices, double demuxBlockExtra) const
@@ -112,10 +112,5 @@ namespace analysis {
         if (!FindNearbySpectra(muxIndices, sl_, indexToDemux, numSpectraToFind))
             throw runtime_error("GetMatrixBlockIndices() Not enough spectra to demultiplex this block");
     }
-
-    const std::vector<size_t>& MSXDemultiplexer::SpectrumIndices() const
-    {
-        return spectrumIndices_;
-    }
 } // namespace analysis
 } // namespace pwiz
\ No newline at end of file
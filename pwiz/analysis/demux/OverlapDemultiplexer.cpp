@@ -51,7 +51,7 @@ namespace analysis {
         pmc_ = pmc;
     }
 
-    void OverlapDemultiplexer::BuildDeconvBlock(size_t index, const vector<size_t>& muxIndices, MatrixPtr& masks, MatrixPtr& signal)
+    void OverlapDemultiplexer::BuildDeconvBlock(size_t index, const vector<size_t>& muxIndices, MatrixPtr& masks, MatrixPtr& signal, vector<size_t>& spectrumIndices) const
     {
         assert(sl_);
         assert(pmc_);
@@ -61,12 +61,12 @@ namespace analysis {
         // get the list of peaks to demultiplex
         Spectrum_const_ptr deconvSpectrum = sl_->spectrum(index, true);
         BinaryDataArrayPtr mzsToDemux = deconvSpectrum->getMZArray();
-        SpectrumPeakExtractor peakExtractor(mzsToDemux->data, params_.massError);
+        SpectrumPeakExtractor peakExtractor(*mzsToDemux, params_.massError);
 
         // initialize mask and intensities matrices.
         size_t numMuxSpectra = overlapRegionsInApprox_; // m
         size_t numDemuxSpectra = overlapRegionsInApprox_; // n
-        size_t numTransitions = mzsToDemux->data.size(); // k
+        size_t numTransitions = mzsToDemux->size(); // k
         masks = boost::make_shared<MatrixType>(numMuxSpectra, numDemuxSpectra);
         signal = boost::make_shared<MatrixType>(numMuxSpectra, numTransitions);
         
@@ -188,12 +188,12 @@ namespace analysis {
         }
 #endif
 
-        // Cache the indices for the spectrum
-        spectrumIndices_.clear();
+        // Get the indices for the spectrum
+        spectrumIndices.clear();
         for (auto demuxIndex : deconvIndices)
         {
             assert(demuxIndex >= lowerMZBound);
-            spectrumIndices_.push_back(demuxIndex - lowerMZBound);
+            spectrumIndices.push_back(demuxIndex - lowerMZBound);
         }
     }
 
@@ -205,11 +205,6 @@ namespace analysis {
             throw runtime_error("GetMatrixBlockIndices() Not enough spectra to demultiplex this block");
     }
 
-    const std::vector<size_t>& OverlapDemultiplexer::SpectrumIndices() const
-    {
-        return spectrumIndices_;
-    }
-
     void OverlapDemultiplexer::InterpolateMuxRegion(Ref<MatrixXd, 0, Stride<Dynamic, Dynamic> > interpolatedIntensities, double timeToInterpolate,
         Eigen::Ref<const Eigen::MatrixXd> intensities, Ref<const VectorXd> scanTimes)
     {
@@ -64,9 +64,9 @@ namespace analysis {
         void BuildDeconvBlock(size_t index,
             const std::vector<size_t>& muxIndices,
             DemuxTypes::MatrixPtr& masks,
-            DemuxTypes::MatrixPtr& signal) override;
+            DemuxTypes::MatrixPtr& signal,
+            std::vector<size_t>& spectrumIndices) const override;
         void GetMatrixBlockIndices(size_t indexToDemux, std::vector<size_t>& muxIndices, double demuxBlockExtra) const override;
-        const std::vector<size_t>& SpectrumIndices() const override;
         ///@}
 
     protected:
@@ -109,9 +109,6 @@ namespace analysis {
         
         /// A set of user-defined options
         Params params_;
-        
-        /// A cache of the indices provided by SpectrumIndices()
-        std::vector<size_t> spectrumIndices_;
     };
 } // namespace analysis
 } // namespace pwiz
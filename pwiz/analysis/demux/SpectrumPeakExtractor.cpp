@@ -25,12 +25,22 @@ namespace pwiz {
 namespace analysis {
     SpectrumPeakExtractor::SpectrumPeakExtractor(const std::vector<double>& peakMzList, const pwiz::chemistry::MZTolerance& massError)
     {
-        _numPeakBins = peakMzList.size();
+        initialize(peakMzList.size(), [&](size_t i) { return peakMzList[i]; }, massError);
+    }
+
+    SpectrumPeakExtractor::SpectrumPeakExtractor(const msdata::BinaryDataArray& peakMzs, const pwiz::chemistry::MZTolerance& massError)
+    {
+        initialize(peakMzs.size(), [&](size_t i) { return peakMzs.value(i); }, massError);
+    }
+
+    void SpectrumPeakExtractor::initialize(size_t numPeaks, const std::function<double(size_t)>& peakMzAt, const pwiz::chemistry::MZTolerance& massError)
+    {
+        _numPeakBins = numPeaks;
         _ranges = boost::shared_array< std::pair<double, double> >(new std::pair<double, double>[_numPeakBins]);
         _maxDelta = 0.0;
-        for (size_t i = 0; i < peakMzList.size(); ++i)
+        for (size_t i = 0; i < _numPeakBins; ++i)
         {
-            double peakMz = peakMzList[i];
+            double peakMz = peakMzAt(i);
             double deltaMz = peakMz - (peakMz - massError);
             if (deltaMz > _maxDelta) _maxDelta = deltaMz;
             _ranges[i].first = peakMz - deltaMz;
@@ -67,10 +77,10 @@ namespace analysis {
         m.row(rowNum).setZero();
 
         size_t binStartIndex = 0;
-        for (size_t queryIndex = 0; queryIndex < mzArray->data.size(); ++queryIndex)
+        for (size_t queryIndex = 0, numQueries = mzArray->size(); queryIndex < numQueries; ++queryIndex)
         {
             // iterating through each "query" peak in the MS/MS spectrum to be filtered
-            double query = mzArray->data[queryIndex];
+            double query = mzArray->value(queryIndex);
             if (query < _minValue) continue;
             if (query > _maxValue) break;
             double minStart = query - _maxDelta;
@@ -87,7 +97,7 @@ namespace analysis {
                 if (_ranges[binIndex].first > query) break;
                 if (_ranges[binIndex].first <= query && query <= _ranges[binIndex].second)
                 {
-                    m.row(rowNum)[binIndex] += intensityArray->data[queryIndex];
+                    m.row(rowNum)[binIndex] += intensityArray->value(queryIndex);
                 }
             }
         }
@@ -21,6 +21,7 @@
 #define _SPECTRUMPEAKEXTRACTOR_HPP
 
 #include <vector>
+#include <functional>
 #include "pwiz/data/msdata/MSData.hpp"
 #include <boost/smart_ptr/shared_array.hpp>
 #include "DemuxSolver.hpp"
@@ -41,6 +42,9 @@ namespace analysis{
         /// \pre The peakMzList must be sorted from smallest to largest mz values with no duplicates.
         SpectrumPeakExtractor(const std::vector<double>& peakMzList, const pwiz::chemistry::MZTolerance& massError);
 
+        /// Generates a SpectrumPeakExtractor from a binary data array, at whichever precision it is stored
+        SpectrumPeakExtractor(const msdata::BinaryDataArray& peakMzs, const pwiz::chemistry::MZTolerance& massError);
+
         /// Extracts centroided peaks from an input spectrum.
         /// The peaks extracted are chosen from the peakMzList provided during initialization of the SpectrumPeakExtractor.
         /// Peaks are extracted to a user-defined row of a user-provided matrix.
@@ -55,6 +59,8 @@ namespace analysis{
         size_t numPeaks() const;
     
     private:
+
+        void initialize(size_t numPeaks, const std::function<double(size_t)>& peakMzAt, const pwiz::chemistry::MZTolerance& massError);
         
         boost::shared_array< std::pair<double, double> > _ranges; ///< defines the set of m/z windows to search, one for each peak in the search list.
         
@@ -24,6 +24,8 @@
 #define PWIZ_SOURCE
 
 #include "MSDataAnalyzer.hpp"
+#include "pwiz/data/msdata/SpectrumWorkerThreads.hpp"
+#include "pwiz/utility/misc/WorkerPool.hpp"
 #include "pwiz/utility/misc/Std.hpp"
 
 
@@ -91,11 +93,173 @@ PWIZ_API_DECL void MSDataAnalyzerContainer::close(const DataInfo& dataInfo)
 //
 
 
-PWIZ_API_DECL MSDataAnalyzerDriver::MSDataAnalyzerDriver(MSDataAnalyzer& analyzer)
-:   analyzer_(analyzer)
+PWIZ_API_DECL MSDataAnalyzerDriver::MSDataAnalyzerDriver(MSDataAnalyzer& analyzer, size_t threadCount)
+:   analyzer_(analyzer), threadCount_(threadCount)
 {}
 
 
+namespace {
+
+
+typedef MSDataAnalyzerDriver::Status Status;
+typedef MSDataAnalyzerDriver::ProgressCallback ProgressCallback;
+
+
+Status analyzeSerially(MSDataAnalyzer& analyzer,
+                       const MSDataAnalyzer::DataInfo& dataInfo,
+                       ProgressCallback* progressCallback,
+                       size_t iterationsPerCallback)
+{
+    const SpectrumList& spectrumList = *dataInfo.msd.run.spectrumListPtr;
+    const size_t size = spectrumList.size();
+
+    for (size_t i=0; i<size; ++i)
+    {
+        if (progressCallback && 
+            (i%iterationsPerCallback)==0 &&
+            progressCallback->progress(i, size)==MSDataAnalyzerDriver::Status_Cancel)
+            return MSDataAnalyzerDriver::Status_Cancel;
+
+        // only send request if analyzer really wants it (more than UpdateRequest_Ok) 
+
+        MSDataAnalyzer::UpdateRequest request = 
+            analyzer.updateRequested(dataInfo, spectrumList.spectrumIdentity(i));
+
+        if (request < MSDataAnalyzer::UpdateRequest_NoBinary) 
+            continue;
+
+        // retrieve the spectrum and update the analyzer
+
+        bool getBinaryData = (request == MSDataAnalyzer::UpdateRequest_Full);
+        SpectrumPtr spectrum = spectrumList.spectrum(i, getBinaryData);
+        analyzer.update(dataInfo, *spectrum);
+    }
+
+    return MSDataAnalyzerDriver::Status_Ok;
+}
+
+
+Status analyzeConcurrently(MSDataAnalyzer& analyzer,
+                           const MSDataAnalyzer::DataInfo& dataInfo,
+                           ProgressCallback* progressCallback,
+                           size_t iterationsPerCallback,
+                           size_t threadCount)
+{
+    const SpectrumList& spectrumList = *dataInfo.msd.run.spectrumListPtr;
+    const size_t size = spectrumList.size();
+
+    // the children of a container are handled separately, so that the mergeable ones
+    // can be updated by the worker threads
+    vector<MSDataAnalyzer*> analyzers;
+    MSDataAnalyzerContainer* container = dynamic_cast<MSDataAnalyzerContainer*>(&analyzer);
+    if (container)
+    {
+        for (MSDataAnalyzerContainer::const_iterator it=container->begin(); it!=container->end(); ++it)
+            if (it->get())
+                analyzers.push_back(it->get());
+    }
+    else
+        analyzers.push_back(&analyzer);
+
+    // partials[a][t] is the partial of analyzer a updated by worker t
+    // (empty if analyzer a must be updated in order)
+    vector<vector<MSDataAnalyzerPtr> > partials(analyzers.size());
+    bool hasOrderedAnalyzers = false;
+    for (size_t a=0; a < analyzers.size(); ++a)
+    {
+        for (size_t t=0; t < threadCount; ++t)
+        {
+            MSDataAnalyzerPtr partial = analyzers[a]->createPartial(dataInfo);
+            if (!partial.get()) break;
+            partials[a].push_back(partial);
+        }
+
+        if (partials[a].size() < threadCount)
+        {
+            partials[a].clear();
+            hasOrderedAnalyzers = true;
+        }
+    }
+
+    // iterate through the spectra a chunk at a time: the analyzers are asked which spectra
+    // they want, in order; then the wanted spectra are retrieved by several workers, which
+    // update the partials; finally the ordered analyzers are updated in spectrum order
+    const size_t chunkSize = 16 * threadCount;
+    vector<MSDataAnalyzer::UpdateRequest> requests; // [spectrum in chunk][analyzer]
+    vector<size_t> indices; // the spectra to retrieve
+    vector<bool> getBinaryData;
+    vector<SpectrumPtr> spectra;
+    size_t chunkBegin = 0;
+
+    auto analyzeSpectrum = [&](size_t j, size_t t)
+    {
+        SpectrumPtr spectrum = spectrumList.spectrum(indices[j], getBinaryData[j]);
+
+        for (size_t a=0; a < analyzers.size(); ++a)
+            if (!partials[a].empty() &&
+                requests[(indices[j] - chunkBegin) * analyzers.size() + a] >= MSDataAnalyzer::UpdateRequest_Ok)
+                partials[a][t]->update(dataInfo, *spectrum);
+
+        if (hasOrderedAnalyzers)
+            spectra[j] = spectrum;
+    };
+
+    for (; chunkBegin<size; chunkBegin+=chunkSize)
+    {
+        size_t chunkEnd = min(size, chunkBegin + chunkSize);
+        requests.assign((chunkEnd - chunkBegin) * analyzers.size(), MSDataAnalyzer::UpdateRequest_None);
+        indices.clear();
+        getBinaryData.clear();
+
+        for (size_t i=chunkBegin; i<chunkEnd; ++i)
+        {
+            if (progressCallback && 
+                (i%iterationsPerCallback)==0 &&
+                progressCallback->progress(i, size)==MSDataAnalyzerDriver::Status_Cancel)
+                return MSDataAnalyzerDriver::Status_Cancel;
+
+            const SpectrumIdentity& spectrumIdentity = spectrumList.spectrumIdentity(i);
+            MSDataAnalyzer::UpdateRequest request = MSDataAnalyzer::UpdateRequest_None;
+            for (size_t a=0; a < analyzers.size(); ++a)
+            {
+                MSDataAnalyzer::UpdateRequest& analyzerRequest = requests[(i - chunkBegin) * analyzers.size() + a];
+                analyzerRequest = analyzers[a]->updateRequested(dataInfo, spectrumIdentity);
+                request = max(request, analyzerRequest);
+            }
+
+            // only retrieve the spectrum if some analyzer really wants it (more than UpdateRequest_Ok)
+            if (request < MSDataAnalyzer::UpdateRequest_NoBinary)
+                continue;
+
+            indices.push_back(i);
+            getBinaryData.push_back(request == MSDataAnalyzer::UpdateRequest_Full);
+        }
+
+        spectra.assign(indices.size(), SpectrumPtr());
+        util::parallelFor(indices.size(), analyzeSpectrum, threadCount);
+
+        // send each spectrum only to the ordered analyzers who are ok with it, as the container does
+        for (size_t j=0; j < spectra.size() && hasOrderedAnalyzers; ++j)
+        {
+            for (size_t a=0; a < analyzers.size(); ++a)
+                if (partials[a].empty() &&
+                    analyzers[a]->updateRequested(dataInfo, *spectra[j]) >= MSDataAnalyzer::UpdateRequest_Ok)
+                    analyzers[a]->update(dataInfo, *spectra[j]);
+            spectra[j].reset();
+        }
+    }
+
+    for (size_t a=0; a < analyzers.size(); ++a)
+        BOOST_FOREACH(const MSDataAnalyzerPtr& partial, partials[a])
+            analyzers[a]->merge(dataInfo, *partial);
+
+    return MSDataAnalyzerDriver::Status_Ok;
+}
+
+
+} // namespace
+
+
 PWIZ_API_DECL
 MSDataAnalyzerDriver::Status 
 MSDataAnalyzerDriver::analyze(const MSDataAnalyzer::DataInfo& dataInfo,
@@ -112,27 +276,12 @@ MSDataAnalyzerDriver::analyze(const MSDataAnalyzer::DataInfo& dataInfo,
         const SpectrumList& spectrumList = *dataInfo.msd.run.spectrumListPtr;
         const size_t size = spectrumList.size();
 
-        for (size_t i=0; i<size; ++i)
-        {
-            if (progressCallback && 
-                (i%iterationsPerCallback)==0 &&
-                progressCallback->progress(i, size)==Status_Cancel)
-                return Status_Cancel;
-
-            // only send request if analyzer really wants it (more than UpdateRequest_Ok) 
-
-            MSDataAnalyzer::UpdateRequest request = 
-                analyzer_.updateRequested(dataInfo, spectrumList.spectrumIdentity(i));
-
-            if (request < MSDataAnalyzer::UpdateRequest_NoBinary) 
-                continue;
-
-            // retrieve the spectrum and update the analyzer
-
-            bool getBinaryData = (request == MSDataAnalyzer::UpdateRequest_Full);
-            SpectrumPtr spectrum = spectrumList.spectrum(i, getBinaryData);
-            analyzer_.update(dataInfo, *spectrum);
-        }
+        size_t threadCount = threadCount_ > 0 ? threadCount_ : SpectrumWorkerThreads::defaultThreadCount();
+        Status status = threadCount > 1 && size > 1 && SpectrumWorkerThreads::isThreadSafe(spectrumList)
+                        ? analyzeConcurrently(analyzer_, dataInfo, progressCallback, iterationsPerCallback, threadCount)
+                        : analyzeSerially(analyzer_, dataInfo, progressCallback, iterationsPerCallback);
+        if (status == Status_Cancel)
+            return Status_Cancel;
 
         if (progressCallback && progressCallback->progress(size, size)==Status_Cancel)
             return Status_Cancel;
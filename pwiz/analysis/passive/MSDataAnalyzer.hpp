@@ -53,6 +53,9 @@ using namespace msdata;
 ///     - update
 ///   - close
 ///
+/// A parallel driver may instead send the updates of some spectra to partial analyzers
+/// (see createPartial()), which it then merges into this one before close.
+///
 /// UpdateRequest_Ok handles the following use case: a spectrum cache wants to cache 
 /// only those spectra that are requested by other MSDataAnalyzers; it won't request 
 /// any updates, but it needs to see any update requested by someone else.
@@ -101,6 +104,24 @@ class PWIZ_API_DECL MSDataAnalyzer
     virtual void close(const DataInfo& dataInfo) {} 
     //@}
 
+    /// \name Parallel Analysis
+    //@{
+
+    /// returns a new analyzer that accumulates the updates of one worker thread, which may
+    /// be called concurrently with other partials; it receives a subset of the spectra
+    /// (in increasing index order) for which this analyzer requested an update, and is
+    /// never opened or closed; since update() of this analyzer is not called, a partial
+    /// should tell it when no more updates are wanted (e.g. past the end of a range);
+    /// returns a null pointer (the default) if this analyzer needs all updates in order
+    virtual boost::shared_ptr<MSDataAnalyzer> createPartial(const DataInfo& dataInfo) const
+    {
+        return boost::shared_ptr<MSDataAnalyzer>();
+    }
+
+    /// combines the state of a partial created by createPartial() into this analyzer
+    virtual void merge(const DataInfo& dataInfo, const MSDataAnalyzer& partial) {}
+    //@}
+
     virtual ~MSDataAnalyzer() {}
 };
 
@@ -158,8 +179,10 @@ class PWIZ_API_DECL MSDataAnalyzerDriver
 {
     public:
 
-    /// instantiate with an MSDataAnalyzer
-    MSDataAnalyzerDriver(MSDataAnalyzer& analyzer);
+    /// instantiate with an MSDataAnalyzer;
+    /// threadCount 1 (the default) analyzes serially;
+    /// threadCount 0 means SpectrumWorkerThreads::defaultThreadCount()
+    MSDataAnalyzerDriver(MSDataAnalyzer& analyzer, size_t threadCount = 1);
 
     enum PWIZ_API_DECL Status {Status_Ok, Status_Cancel};
 
@@ -178,11 +201,17 @@ class PWIZ_API_DECL MSDataAnalyzerDriver
     /// If progressCallback->progress() returns Status_Cancel, analysis
     /// is canceled and Status_Cancel is returned.
     ///
+    /// With more than one thread (and a thread-safe SpectrumList), spectra are
+    /// retrieved by several threads of the shared util::WorkerPool; analyzers (or the analyzers in an
+    /// MSDataAnalyzerContainer) that create partials are updated by those threads
+    /// and merged before close, while the others are updated in spectrum order.
+    ///
     Status analyze(const MSDataAnalyzer::DataInfo& dataInfo,
                    ProgressCallback* progressCallback = 0) const;
 
     private:
     MSDataAnalyzer& analyzer_;
+    size_t threadCount_;
 };
 
 // helper function for argument parsing
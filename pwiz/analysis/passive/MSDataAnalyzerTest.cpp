@@ -178,6 +178,83 @@ void test()
 }
 
 
+// sums the indices of the spectra it is updated with, by partials if mergeable
+struct SumAnalyzer : public MSDataAnalyzer
+{
+    bool mergeable;
+    size_t sum;
+    size_t partialCount;
+    vector<size_t> order;
+
+    SumAnalyzer(bool _mergeable) : mergeable(_mergeable), sum(0), partialCount(0) {}
+
+    virtual void open(const DataInfo& dataInfo) {sum = partialCount = 0; order.clear();}
+
+    virtual UpdateRequest updateRequested(const DataInfo& dataInfo, 
+                                          const SpectrumIdentity& entry) const 
+    {
+        return entry.index % 2 == 0 ? UpdateRequest_Full : UpdateRequest_None;
+    }
+
+    virtual void update(const DataInfo& dataInfo, 
+                        const Spectrum& spectrum) 
+    {
+        sum += spectrum.index;
+        order.push_back(spectrum.index);
+    }
+
+    virtual MSDataAnalyzerPtr createPartial(const DataInfo& dataInfo) const
+    {
+        return mergeable ? MSDataAnalyzerPtr(new SumAnalyzer(true)) : MSDataAnalyzerPtr();
+    }
+
+    virtual void merge(const DataInfo& dataInfo, const MSDataAnalyzer& partial)
+    {
+        sum += dynamic_cast<const SumAnalyzer&>(partial).sum;
+        ++partialCount;
+    }
+};
+
+
+void testParallel()
+{
+    if (os_) *os_ << "testParallel()\n"; 
+
+    MSData dummy;
+    SpectrumListSimplePtr sl(new SpectrumListSimple);
+    const size_t spectrumCount = 1000;
+    for (size_t i=0; i<spectrumCount; i++) 
+    {
+        sl->spectra.push_back(SpectrumPtr(new Spectrum));
+        sl->spectra.back()->index = i;
+    }
+    dummy.run.spectrumListPtr = sl; 
+
+    shared_ptr<SumAnalyzer> ordered(new SumAnalyzer(false));
+    shared_ptr<SumAnalyzer> mergeable(new SumAnalyzer(true));
+    MSDataAnalyzerContainer analyzers;
+    analyzers.push_back(ordered);
+    analyzers.push_back(mergeable);
+
+    MSDataAnalyzerDriver driver(analyzers, 4);
+    unit_assert(driver.analyze(dummy) == MSDataAnalyzerDriver::Status_Ok);
+
+    const size_t expectedSum = (spectrumCount/2) * (spectrumCount/2 - 1); // 0 + 2 + ... + 998
+
+    // the ordered analyzer gets every requested spectrum, in order
+    unit_assert_operator_equal(expectedSum, ordered->sum);
+    unit_assert_operator_equal(spectrumCount/2, ordered->order.size());
+    for (size_t i=0; i < ordered->order.size(); ++i)
+        unit_assert_operator_equal(i*2, ordered->order[i]);
+    unit_assert_operator_equal(0, ordered->partialCount);
+
+    // the mergeable analyzer gets them through its partials
+    unit_assert_operator_equal(expectedSum, mergeable->sum);
+    unit_assert(mergeable->order.empty());
+    unit_assert_operator_equal(4, mergeable->partialCount);
+}
+
+
 int main(int argc, char* argv[])
 {
     TEST_PROLOG(argc, argv)
@@ -186,6 +263,7 @@ int main(int argc, char* argv[])
     {
         if (argc>1 && !strcmp(argv[1],"-v")) os_ = &cout;
         test();
+        testParallel();
     }
     catch (exception& e)
     {
@@ -29,6 +29,7 @@
 #include "boost/filesystem/fstream.hpp"
 #include "pwiz/utility/misc/Std.hpp"
 #include <cmath>
+#include <atomic>
 
 
 namespace pwiz {
@@ -82,8 +83,9 @@ struct RegionAnalyzer::Impl
     const MSDataCache& cache;
     vector<SpectrumStats> spectrumStats;
     Stats stats;
-    bool done;
+    std::atomic<bool> done; // set by update() or a partial once past the region
     bool osDumpNeedsClosing; // true iff osDump was not passed to us
+    vector< pair<size_t, string> > mergedRegionData; // dumped samples of each spectrum, from partials
 
     Impl(const Config& _config, const MSDataCache& _cache)
     :   config(_config), cache(_cache), done(false)
@@ -125,11 +127,16 @@ const size_t width_intensity_ = 17;
 } // namespace
 
 
+#define DELIMWRITE(w,txt) if (delimiter) {osDump << txt << delimiter ;} else { osDump << setw(w) << txt;}
+#define DELIMWRITE_EOL(w,txt) if (delimiter) {osDump << txt << endl ;} else { osDump << setw(w) << txt << endl;}
+
+
 PWIZ_API_DECL void RegionAnalyzer::open(const DataInfo& dataInfo)
 {
     impl_->spectrumStats.clear();
     impl_->stats = Stats();
     impl_->done = false;
+    impl_->mergedRegionData.clear();
 
     if (dataInfo.msd.run.spectrumListPtr.get())
         impl_->spectrumStats.resize(dataInfo.msd.run.spectrumListPtr->size());
@@ -142,14 +149,13 @@ PWIZ_API_DECL void RegionAnalyzer::open(const DataInfo& dataInfo)
         if (dataInfo.log) 
             *dataInfo.log << "[RegionAnalyzer] Writing file " << outputFilename.string() << endl;
 
-#define DELIMWRITE(w,txt) if (delimiter) {*(impl_->config.osDump) << txt << delimiter ;} else { *(impl_->config.osDump) << setw(w) << txt;}
-#define DELIMWRITE_EOL(w,txt) if (delimiter) {*(impl_->config.osDump) << txt << endl ;} else { *(impl_->config.osDump) << setw(w) << txt << endl;}
         char delimiter = impl_->config.getDelimiterChar();
 
         if (impl_->osDumpNeedsClosing = (impl_->config.osDump==NULL))
             impl_->config.osDump = new bfs::ofstream(outputFilename);
+        ostream& osDump = *impl_->config.osDump;
 
-        *(impl_->config.osDump) << "# " << dataInfo.sourceFilename << endl;
+        osDump << "# " << dataInfo.sourceFilename << endl;
         DELIMWRITE(width_index_,"# index");
         DELIMWRITE(width_id_,"id");
         DELIMWRITE(width_scanEvent_,"event");
@@ -167,10 +173,16 @@ MSDataAnalyzer::UpdateRequest
 RegionAnalyzer::updateRequested(const DataInfo& dataInfo,
                                 const SpectrumIdentity& spectrumIdentity) const
 {
+    if (spectrumIdentity.index > impl_->config.indexRange.second)
+        return UpdateRequest_None;
+
     return impl_->done ? UpdateRequest_None : UpdateRequest_Full;
 }
 
 
+namespace {
+
+
 struct HasLowerMZ
 {
     bool operator()(const MZIntensityPair& a, const MZIntensityPair& b) {return a.mz<b.mz;}
@@ -195,47 +207,49 @@ MZIntensityPair interpolatedPeak(vector<MZIntensityPair>::const_iterator begin,
 }
 
 
-PWIZ_API_DECL
-void RegionAnalyzer::update(const DataInfo& dataInfo, 
-                            const Spectrum& spectrum)
+// returns <0 if the spectrum is before the region, >0 if it is after, 0 if it is inside
+int regionPosition(const RegionAnalyzer::Config& config, const SpectrumInfo& info)
 {
-    const SpectrumInfo& info = impl_->cache[spectrum.index];
+    if (info.index < config.indexRange.first ||
+        info.scanNumber < config.scanNumberRange.first ||
+        info.retentionTime < config.rtRange.first)
+        return -1;
 
-    // make sure we're in the region
+    if (info.index > config.indexRange.second ||
+        info.scanNumber > config.scanNumberRange.second ||
+        info.retentionTime > config.rtRange.second)
+        return 1;
 
-    if (info.index < impl_->config.indexRange.first ||
-        info.scanNumber < impl_->config.scanNumberRange.first ||
-        info.retentionTime < impl_->config.rtRange.first)
-        return;
+    return 0;
+}
 
-    if (info.index > impl_->config.indexRange.second ||
-        info.scanNumber > impl_->config.scanNumberRange.second ||
-        info.retentionTime > impl_->config.rtRange.second)
-    {
-        impl_->done = true;
-        return;
-    }
 
+// analyzes the part of a spectrum in the region, dumping its samples to osDump if not null
+RegionAnalyzer::SpectrumStats analyzeRegion(const RegionAnalyzer::Config& config, 
+                                            const SpectrumInfo& info,
+                                            ostream* osDumpPtr)
+{
     // find m/z range via binary search 
 
     vector<MZIntensityPair>::const_iterator begin = 
-        lower_bound(info.data.begin(), info.data.end(), MZIntensityPair(impl_->config.mzRange.first, 0), HasLowerMZ());
+        lower_bound(info.data.begin(), info.data.end(), MZIntensityPair(config.mzRange.first, 0), HasLowerMZ());
 
     vector<MZIntensityPair>::const_iterator end = 
-        upper_bound(info.data.begin(), info.data.end(), MZIntensityPair(impl_->config.mzRange.second, 0), HasLowerMZ());
+        upper_bound(info.data.begin(), info.data.end(), MZIntensityPair(config.mzRange.second, 0), HasLowerMZ());
 
     // calculate
 
     double sumIntensity = 0;
     vector<MZIntensityPair>::const_iterator max = begin;
-    char delimiter =impl_->config.getDelimiterChar();
+    char delimiter = config.getDelimiterChar();
     for (vector<MZIntensityPair>::const_iterator it=begin; it!=end; ++it)
     {
         sumIntensity += it->intensity;
         if (max->intensity < it->intensity) max = it;
 
-        if (impl_->config.osDump)
+        if (osDumpPtr)
         {
+            ostream& osDump = *osDumpPtr;
             DELIMWRITE(width_index_,info.index);
             DELIMWRITE(width_id_,info.id);
             DELIMWRITE(width_scanEvent_,info.scanEvent);
@@ -250,13 +264,91 @@ void RegionAnalyzer::update(const DataInfo& dataInfo,
 
     // fill in SpectrumStats
 
-    SpectrumStats& spectrumStats = impl_->spectrumStats[spectrum.index];
+    RegionAnalyzer::SpectrumStats spectrumStats;
     spectrumStats.sumIntensity = sumIntensity;    
     if (begin != end)
     {
         spectrumStats.max = *max;
         spectrumStats.peak = interpolatedPeak(begin, end, max);
     }
+    return spectrumStats;
+}
+
+
+// analyzes the spectra of one thread of a parallel driver, keeping its own SpectrumInfo
+// (the shared MSDataCache is updated in order by the driver) and buffering the dumped samples;
+// like RegionAnalyzer::update(), it sets done once past the region
+class RegionAnalyzerPartial : public MSDataAnalyzer
+{
+    public:
+
+    RegionAnalyzerPartial(const RegionAnalyzer::Config& config, std::atomic<bool>& done) : config_(config), done_(done) {}
+
+    virtual void update(const DataInfo& dataInfo, 
+                        const Spectrum& spectrum)
+    {
+        info_.update(spectrum, true);
+        int position = regionPosition(config_, info_);
+        if (position > 0)
+            done_ = true;
+        if (position != 0)
+            return;
+
+        ostringstream osDump;
+        spectrumStats.push_back(make_pair(spectrum.index, analyzeRegion(config_, info_, config_.osDump ? &osDump : 0)));
+        if (config_.osDump)
+            regionData.push_back(make_pair(spectrum.index, osDump.str()));
+    }
+
+    vector< pair<size_t, RegionAnalyzer::SpectrumStats> > spectrumStats;
+    vector< pair<size_t, string> > regionData;
+
+    private:
+    RegionAnalyzer::Config config_;
+    std::atomic<bool>& done_;
+    SpectrumInfo info_;
+};
+
+
+} // namespace
+
+
+PWIZ_API_DECL
+void RegionAnalyzer::update(const DataInfo& dataInfo, 
+                            const Spectrum& spectrum)
+{
+    const SpectrumInfo& info = impl_->cache[spectrum.index];
+
+    // make sure we're in the region
+
+    int position = regionPosition(impl_->config, info);
+    if (position < 0)
+        return;
+
+    if (position > 0)
+    {
+        impl_->done = true;
+        return;
+    }
+
+    impl_->spectrumStats[spectrum.index] = analyzeRegion(impl_->config, info, impl_->config.osDump);
+}
+
+
+PWIZ_API_DECL MSDataAnalyzerPtr RegionAnalyzer::createPartial(const DataInfo& dataInfo) const
+{
+    return MSDataAnalyzerPtr(new RegionAnalyzerPartial(impl_->config, impl_->done));
+}
+
+
+PWIZ_API_DECL void RegionAnalyzer::merge(const DataInfo& dataInfo, const MSDataAnalyzer& partial)
+{
+    const RegionAnalyzerPartial& regionPartial = dynamic_cast<const RegionAnalyzerPartial&>(partial);
+
+    for (size_t i=0; i < regionPartial.spectrumStats.size(); ++i)
+        impl_->spectrumStats[regionPartial.spectrumStats[i].first] = regionPartial.spectrumStats[i].second;
+
+    impl_->mergedRegionData.insert(impl_->mergedRegionData.end(), regionPartial.regionData.begin(), regionPartial.regionData.end());
 }
 
 
@@ -298,6 +390,15 @@ PWIZ_API_DECL void RegionAnalyzer::close(const DataInfo& dataInfo)
     impl_->stats.sd_peak_mz = sd_peak_mz;
     impl_->stats.indexApex = indexApex;
 
+    // samples dumped by partials are written in spectrum order
+    if (!impl_->mergedRegionData.empty())
+    {
+        sort(impl_->mergedRegionData.begin(), impl_->mergedRegionData.end());
+        for (size_t i=0; i < impl_->mergedRegionData.size(); ++i)
+            *impl_->config.osDump << impl_->mergedRegionData[i].second;
+        impl_->mergedRegionData.clear();
+    }
+
     if (impl_->osDumpNeedsClosing)
     {
         delete impl_->config.osDump;
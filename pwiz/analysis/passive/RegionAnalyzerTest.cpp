@@ -27,6 +27,7 @@
 #include "pwiz/utility/misc/Std.hpp"
 #include <cstring>
 #include <boost/algorithm/string/split.hpp>
+#include <boost/atomic.hpp>
 
 
 using namespace pwiz;
@@ -97,7 +98,7 @@ ostream& operator<<(ostream& os, const RegionAnalyzer::Stats& stats)
 }
 
  
-void testConfig(const RegionAnalyzer::Config& config)
+void testConfig(const RegionAnalyzer::Config& config, size_t threadCount)
 {
     MSData msd;
     initialize(msd);
@@ -109,7 +110,7 @@ void testConfig(const RegionAnalyzer::Config& config)
     analyzers.push_back(cache);
     analyzers.push_back(regionAnalyzer);
 
-    MSDataAnalyzerDriver driver(analyzers);
+    MSDataAnalyzerDriver driver(analyzers, threadCount);
     driver.analyze(msd);
 
     unit_assert(regionAnalyzer->spectrumStats().size() == 5);
@@ -171,6 +172,82 @@ void testConfig(const RegionAnalyzer::Config& config)
 }
 
 
+void testConfig(const RegionAnalyzer::Config& config)
+{
+    // the parallel driver (updating partials of the RegionAnalyzer) must dump the same data as the serial one
+    ostringstream serialDump, parallelDump;
+    RegionAnalyzer::Config serialConfig(config), parallelConfig(config);
+    if (config.osDump)
+    {
+        serialConfig.osDump = &serialDump;
+        parallelConfig.osDump = &parallelDump;
+    }
+
+    testConfig(serialConfig, 1);
+    testConfig(parallelConfig, 4);
+    unit_assert_operator_equal(serialDump.str(), parallelDump.str());
+
+    if (config.osDump)
+        *config.osDump << serialDump.str();
+}
+
+
+// a list that counts the spectra retrieved
+class CountingSpectrumList : public SpectrumListSimple
+{
+    public:
+
+    CountingSpectrumList() : retrievalCount(0) {}
+
+    virtual const SpectrumIdentity& spectrumIdentity(size_t index) const {return *spectra.at(index);}
+
+    virtual SpectrumPtr spectrum(size_t index, bool getBinaryData = false) const
+    {
+        ++retrievalCount;
+        return SpectrumListSimple::spectrum(index, getBinaryData);
+    }
+
+    mutable boost::atomic<size_t> retrievalCount;
+};
+
+
+void testDone(size_t threadCount)
+{
+    if (os_) *os_ << "testDone: " << threadCount << endl;
+
+    // once past the rt range, the analyzer stops asking for spectra, whether it is
+    // updated directly or through its partials
+    MSData msd;
+    boost::shared_ptr<CountingSpectrumList> sl(new CountingSpectrumList);
+    msd.run.spectrumListPtr = sl;
+    for (size_t i=0; i < 1000; ++i)
+    {
+        SpectrumPtr spectrum(new Spectrum);
+        sl->spectra.push_back(spectrum);
+        spectrum->index = i;
+        spectrum->id = "scan=" + lexical_cast<string>(i+1);
+        spectrum->scanList.scans.push_back(Scan());
+        spectrum->scanList.scans.back().cvParams.push_back(CVParam(MS_scan_start_time, int(i), UO_second));
+        spectrum->setMZIntensityPairs((MZIntensityPair*)data_[1], 7, MS_number_of_detector_counts);
+    }
+
+    shared_ptr<MSDataCache> cache(new MSDataCache);
+    RegionAnalyzer::Config config;
+    config.rtRange = make_pair(10, 20);
+    shared_ptr<RegionAnalyzer> regionAnalyzer(new RegionAnalyzer(config, *cache));
+
+    MSDataAnalyzerContainer analyzers;
+    analyzers.push_back(cache);
+    analyzers.push_back(regionAnalyzer);
+
+    MSDataAnalyzerDriver driver(analyzers, threadCount);
+    driver.analyze(msd);
+
+    unit_assert_operator_equal(11, regionAnalyzer->stats().nonzeroCount);
+    unit_assert(sl->retrievalCount < 100);
+}
+
+
 // verify that changes to unify args for various configs retain backward compatiblity
 #include "RegionSIC.hpp"
 #include "RegionTIC.hpp"
@@ -292,6 +369,9 @@ void test()
 
     // verify that changes to text based configs retains backward compatiblity
     testAnalyzerFamilyArgumentBackwardCompatibility();
+
+    testDone(1);
+    testDone(4);
 }
 
 
@@ -129,6 +129,18 @@ void RegionSIC::update(const DataInfo& dataInfo,
 }
 
 
+PWIZ_API_DECL MSDataAnalyzerPtr RegionSIC::createPartial(const DataInfo& dataInfo) const
+{
+    return regionAnalyzer_->createPartial(dataInfo);
+}
+
+
+PWIZ_API_DECL void RegionSIC::merge(const DataInfo& dataInfo, const MSDataAnalyzer& partial)
+{
+    regionAnalyzer_->merge(dataInfo, partial);
+}
+
+
 PWIZ_API_DECL void RegionSIC::close(const DataInfo& dataInfo)
 {
     regionAnalyzer_->close(dataInfo);
@@ -72,6 +72,10 @@ class PWIZ_API_DECL RegionSIC : public MSDataAnalyzer
                         const Spectrum& spectrum);
 
     virtual void close(const DataInfo& dataInfo);
+
+    virtual MSDataAnalyzerPtr createPartial(const DataInfo& dataInfo) const;
+
+    virtual void merge(const DataInfo& dataInfo, const MSDataAnalyzer& partial);
     //@}
 
     private:
@@ -111,6 +111,18 @@ void RegionSlice::update(const DataInfo& dataInfo,
 }
 
 
+PWIZ_API_DECL MSDataAnalyzerPtr RegionSlice::createPartial(const DataInfo& dataInfo) const
+{
+    return regionAnalyzer_->createPartial(dataInfo);
+}
+
+
+PWIZ_API_DECL void RegionSlice::merge(const DataInfo& dataInfo, const MSDataAnalyzer& partial)
+{
+    regionAnalyzer_->merge(dataInfo, partial);
+}
+
+
 PWIZ_API_DECL void RegionSlice::close(const DataInfo& dataInfo)
 {
     regionAnalyzer_->close(dataInfo);
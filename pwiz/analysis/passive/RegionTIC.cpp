@@ -102,6 +102,18 @@ void RegionTIC::update(const DataInfo& dataInfo,
 }
 
 
+PWIZ_API_DECL MSDataAnalyzerPtr RegionTIC::createPartial(const DataInfo& dataInfo) const
+{
+    return regionAnalyzer_->createPartial(dataInfo);
+}
+
+
+PWIZ_API_DECL void RegionTIC::merge(const DataInfo& dataInfo, const MSDataAnalyzer& partial)
+{
+    regionAnalyzer_->merge(dataInfo, partial);
+}
+
+
 PWIZ_API_DECL void RegionTIC::close(const DataInfo& dataInfo)
 {
     regionAnalyzer_->close(dataInfo);
@@ -31,8 +31,9 @@
 #include "boost/shared_ptr.hpp"
 #include "boost/concept/assert.hpp"
 #include "boost/concept/usage.hpp"
-#include <set>
 #include <vector>
+#include <algorithm>
+#include <stdexcept>
 
 
 namespace pwiz {
@@ -87,15 +88,103 @@ struct HasMZRT
 
 
 ///
-/// MZRTField is a std::set of boost::shared_ptrs, stored as a binary tree 
-/// ordered by LessThan_MZRT
+/// MZRTField is an ordered collection of boost::shared_ptrs, ordered by LessThan_MZRT
+/// and holding at most one object for each m/z and retention time, like a std::set.
+///
+/// The objects are stored in a sorted sequence of small contiguous blocks, and the m/z
+/// values of each block are kept in their own array, so that lookups binary search
+/// arrays of doubles instead of walking tree nodes through shared_ptrs.  Inserting or
+/// removing an object invalidates iterators (unlike std::set).
 ///
 template <typename T>
-struct MZRTField : public std::set< boost::shared_ptr<T>, LessThan_MZRT<T> >
+class MZRTField
 {
     //BOOST_CONCEPT_ASSERT((HasMZRT<T>));
 
+    public:
+
     typedef boost::shared_ptr<T> TPtr;
+    typedef TPtr value_type;
+    typedef const TPtr& reference;
+    typedef const TPtr& const_reference;
+    typedef std::size_t size_type;
+
+    /// forward iterator over the objects, in LessThan_MZRT order; like std::set, only const
+    /// access to the shared_ptrs is allowed, but the objects themselves may be modified
+    /// (as long as their m/z and retention time do not change)
+    class const_iterator
+    {
+        public:
+
+        typedef std::forward_iterator_tag iterator_category;
+        typedef TPtr value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const TPtr* pointer;
+        typedef const TPtr& reference;
+
+        const_iterator() : field_(0), block_(0), position_(0) {}
+
+        reference operator*() const {return field_->blocks_[block_].items[position_];}
+        pointer operator->() const {return &**this;}
+
+        const_iterator& operator++()
+        {
+            if (++position_ == field_->blocks_[block_].items.size())
+            {
+                ++block_;
+                position_ = 0;
+            }
+            return *this;
+        }
+
+        const_iterator operator++(int) {const_iterator result(*this); ++*this; return result;}
+
+        bool operator==(const const_iterator& that) const {return block_==that.block_ && position_==that.position_;}
+        bool operator!=(const const_iterator& that) const {return !(*this == that);}
+
+        private:
+        const_iterator(const MZRTField* field, size_t block, size_t position)
+        :   field_(field), block_(block), position_(position)
+        {}
+
+        const MZRTField* field_;
+        size_t block_; // blocks_.size() for end()
+        size_t position_;
+        friend class MZRTField;
+    };
+
+    typedef const_iterator iterator;
+
+    MZRTField() : size_(0) {}
+
+    template <typename InputIterator>
+    MZRTField(InputIterator first, InputIterator last) : size_(0) {insert(first, last);}
+
+    const_iterator begin() const {return const_iterator(this, 0, 0);}
+    const_iterator end() const {return const_iterator(this, blocks_.size(), 0);}
+    size_type size() const {return size_;}
+    bool empty() const {return size_ == 0;}
+    void clear() {blocks_.clear(); blockMZ_.clear(); size_ = 0;}
+
+    /// inserts an object, unless there already is one with the same m/z and retention time;
+    /// returns its position and whether it was inserted
+    std::pair<iterator, bool> insert(const TPtr& p);
+
+    /// inserts a range of objects, rebuilding the field in one sorting pass
+    template <typename InputIterator>
+    void insert(InputIterator first, InputIterator last);
+
+    /// removes the object at it, returning the position of the next object
+    iterator erase(iterator it);
+
+    /// remove an object via a shared reference, rather than an iterator
+    void remove(const TPtr& p); 
+
+    /// first object not less than p (LessThan_MZRT)
+    iterator lower_bound(const TPtr& p) const {return lowerBound(*p);}
+
+    /// first object greater than p (LessThan_MZRT)
+    iterator upper_bound(const TPtr& p) const {return upperBound(*p);}
 
     /// find all objects with a given m/z, within a given m/z tolerance,
     /// satisfying the 'matches' predicate
@@ -103,8 +192,33 @@ struct MZRTField : public std::set< boost::shared_ptr<T>, LessThan_MZRT<T> >
     std::vector<TPtr> 
     find(double mz, MZTolerance mzTolerance, RTMatches matches) const;
 
-    /// remove an object via a shared reference, rather than an iterator into the set
-    void remove(const TPtr& p); 
+    /// find() for several m/z values, given in increasing order, in one pass over the field;
+    /// result[i] is set to the objects found for mzs[i]
+    template <typename RTMatches>
+    void find(const std::vector<double>& mzs, MZTolerance mzTolerance, RTMatches matches,
+              std::vector< std::vector<TPtr> >& result) const;
+
+    private:
+
+    enum {MaxBlockSize = 256}; // a block that grows to this size is split in two, so blocks hold at most MaxBlockSize-1 objects
+
+    struct Block
+    {
+        std::vector<double> mz;
+        std::vector<TPtr> items;
+    };
+
+    std::vector<Block> blocks_; // empty when the field is; no block is ever empty
+    std::vector<double> blockMZ_; // the greatest m/z of each block
+    size_type size_;
+
+    iterator lowerBound(const T& t) const;
+    iterator upperBound(const T& t) const;
+    iterator lowerBoundMZ(double mz, iterator hint) const;
+    void splitBlock(size_t block);
+
+    template <typename RTMatches>
+    iterator findRange(double mz, MZTolerance mzTolerance, RTMatches matches, iterator hint, std::vector<TPtr>& result) const;
 };
 
 
@@ -163,44 +277,226 @@ struct RTMatches_IsContainedIn
 
 
 template <typename T>
-template <typename RTMatches>
-std::vector< boost::shared_ptr<T> > 
-MZRTField<T>::find(double mz, MZTolerance mzTolerance, RTMatches matches) const
+std::pair<typename MZRTField<T>::iterator, bool> MZRTField<T>::insert(const TPtr& p)
 {
-    TPtr target(new T);
+    LessThan_MZRT<T> lessThan;
 
-    // use binary search to get a std::set iterator range
+    if (blocks_.empty())
+    {
+        blocks_.push_back(Block());
+        blocks_.back().mz.push_back(p->mz);
+        blocks_.back().items.push_back(p);
+        blockMZ_.push_back(p->mz);
+        size_ = 1;
+        return std::make_pair(begin(), true);
+    }
 
-    target->mz = mz - mzTolerance;
-    typename MZRTField<T>::const_iterator begin = this->lower_bound(target);
+    iterator it = lowerBound(*p);
+    if (it != end() && !lessThan(p, *it))
+        return std::make_pair(it, false);
 
-    target->mz = mz + mzTolerance;
-    typename MZRTField<T>::const_iterator end = this->upper_bound(target);
+    // an object greater than all others goes at the end of the last block
+    if (it == end())
+        it = iterator(this, blocks_.size()-1, blocks_.back().items.size());
 
-    // linear copy_if within range 
+    Block& block = blocks_[it.block_];
+    block.mz.insert(block.mz.begin() + it.position_, p->mz);
+    block.items.insert(block.items.begin() + it.position_, p);
+    blockMZ_[it.block_] = block.mz.back();
+    ++size_;
 
-    std::vector<TPtr> result;
+    if (block.items.size() >= MaxBlockSize)
+    {
+        splitBlock(it.block_);
+        if (it.position_ >= blocks_[it.block_].items.size())
+        {
+            it.position_ -= blocks_[it.block_].items.size();
+            ++it.block_;
+        }
+    }
+
+    return std::make_pair(it, true);
+}
 
-    for (typename MZRTField<T>::const_iterator it=begin; it!=end; ++it)
-        if (matches(**it))
-            result.push_back(*it);
 
-    return result;
+template <typename T>
+template <typename InputIterator>
+void MZRTField<T>::insert(InputIterator first, InputIterator last)
+{
+    std::vector<TPtr> items(begin(), end());
+    items.insert(items.end(), first, last);
+
+    // like std::set, keep the first of several objects with the same m/z and retention time
+    LessThan_MZRT<T> lessThan;
+    std::stable_sort(items.begin(), items.end(), lessThan);
+    std::vector<TPtr> unique;
+    unique.reserve(items.size());
+    for (size_t i=0; i < items.size(); ++i)
+        if (unique.empty() || lessThan(unique.back(), items[i]))
+            unique.push_back(items[i]);
+
+    // fill the blocks halfway, leaving room for inserts
+    clear();
+    for (size_t i=0; i < unique.size(); i += MaxBlockSize/2)
+    {
+        blocks_.push_back(Block());
+        Block& block = blocks_.back();
+        block.items.assign(unique.begin() + i, unique.begin() + std::min(unique.size(), i + MaxBlockSize/2));
+        for (size_t j=0; j < block.items.size(); ++j)
+            block.mz.push_back(block.items[j]->mz);
+        blockMZ_.push_back(block.mz.back());
+    }
+    size_ = unique.size();
+}
+
+
+template <typename T>
+typename MZRTField<T>::iterator MZRTField<T>::erase(iterator it)
+{
+    Block& block = blocks_[it.block_];
+    block.mz.erase(block.mz.begin() + it.position_);
+    block.items.erase(block.items.begin() + it.position_);
+    --size_;
+
+    if (block.items.empty())
+    {
+        blocks_.erase(blocks_.begin() + it.block_);
+        blockMZ_.erase(blockMZ_.begin() + it.block_);
+        return iterator(this, it.block_, 0);
+    }
+
+    blockMZ_[it.block_] = block.mz.back();
+    if (it.position_ == block.items.size())
+        return iterator(this, it.block_+1, 0);
+    return it;
 }
 
 
 template <typename T>
 void MZRTField<T>::remove(const boost::shared_ptr<T>& p)
 {
-    std::pair<typename MZRTField<T>::iterator, typename MZRTField<T>::iterator> 
-        range = this->equal_range(p); // uses LessThan_MZRT
-    
-    typename MZRTField<T>::iterator 
-        found = std::find(range.first, range.second, p); // uses shared_ptr::operator==
+    iterator found = lowerBound(*p); // uses LessThan_MZRT
+
+    if (found == end() || *found != p) // uses shared_ptr::operator!=
+        throw std::runtime_error("[MZRTField::remove()] TPtr not found.");
+
+    erase(found);
+}
+
+
+template <typename T>
+typename MZRTField<T>::iterator MZRTField<T>::lowerBound(const T& t) const
+{
+    LessThan_MZRT<T> lessThan;
+
+    // find the block by m/z, then step past objects of the same m/z with lower retention time
+    size_t b = std::lower_bound(blockMZ_.begin(), blockMZ_.end(), t.mz) - blockMZ_.begin();
+    while (b < blocks_.size() && lessThan(*blocks_[b].items.back(), t)) ++b;
+    if (b == blocks_.size()) return end();
+
+    const Block& block = blocks_[b];
+    size_t p = std::lower_bound(block.mz.begin(), block.mz.end(), t.mz) - block.mz.begin();
+    while (lessThan(*block.items[p], t)) ++p;
+    return iterator(this, b, p);
+}
+
+
+template <typename T>
+typename MZRTField<T>::iterator MZRTField<T>::upperBound(const T& t) const
+{
+    LessThan_MZRT<T> lessThan;
+
+    size_t b = std::lower_bound(blockMZ_.begin(), blockMZ_.end(), t.mz) - blockMZ_.begin();
+    while (b < blocks_.size() && !lessThan(t, *blocks_[b].items.back())) ++b;
+    if (b == blocks_.size()) return end();
+
+    const Block& block = blocks_[b];
+    size_t p = std::lower_bound(block.mz.begin(), block.mz.end(), t.mz) - block.mz.begin();
+    while (!lessThan(t, *block.items[p])) ++p;
+    return iterator(this, b, p);
+}
+
+
+// first object with m/z not less than mz, searching from hint (which must not be past it)
+template <typename T>
+typename MZRTField<T>::iterator MZRTField<T>::lowerBoundMZ(double mz, iterator hint) const
+{
+    size_t b = std::lower_bound(blockMZ_.begin() + hint.block_, blockMZ_.end(), mz) - blockMZ_.begin();
+    if (b == blocks_.size()) return end();
+
+    const Block& block = blocks_[b];
+    size_t first = b == hint.block_ ? hint.position_ : 0;
+    size_t p = std::lower_bound(block.mz.begin() + first, block.mz.end(), mz) - block.mz.begin();
+    return iterator(this, b, p);
+}
+
 
-    if (found == range.second) throw std::runtime_error("[MZRTField::remove()] TPtr not found.");
+template <typename T>
+void MZRTField<T>::splitBlock(size_t b)
+{
+    blocks_.insert(blocks_.begin() + b + 1, Block());
+    blockMZ_.insert(blockMZ_.begin() + b + 1, blockMZ_[b]);
+
+    Block& block = blocks_[b];
+    Block& next = blocks_[b+1];
+    size_t half = block.items.size() / 2;
+    next.mz.assign(block.mz.begin() + half, block.mz.end());
+    next.items.assign(block.items.begin() + half, block.items.end());
+    block.mz.resize(half);
+    block.items.resize(half);
+    blockMZ_[b] = block.mz.back();
+}
 
-    this->erase(found);
+
+// appends the objects within mzTolerance of mz satisfying matches to result, starting the
+// search at hint; returns the position of the first object in the m/z range
+template <typename T>
+template <typename RTMatches>
+typename MZRTField<T>::iterator
+MZRTField<T>::findRange(double mz, MZTolerance mzTolerance, RTMatches matches, iterator hint, std::vector<TPtr>& result) const
+{
+    double mzHigh = mz + mzTolerance;
+    iterator first = lowerBoundMZ(mz - mzTolerance, hint);
+
+    // linear copy_if within range, reading the objects only for their retention times
+    for (size_t b=first.block_, p=first.position_; b < blocks_.size(); ++b, p=0)
+    {
+        const Block& block = blocks_[b];
+        for (; p < block.mz.size() && block.mz[p] <= mzHigh; ++p)
+            if (matches(*block.items[p]))
+                result.push_back(block.items[p]);
+        if (p < block.mz.size()) break;
+    }
+
+    return first;
+}
+
+
+template <typename T>
+template <typename RTMatches>
+std::vector< boost::shared_ptr<T> > 
+MZRTField<T>::find(double mz, MZTolerance mzTolerance, RTMatches matches) const
+{
+    std::vector<TPtr> result;
+    findRange(mz, mzTolerance, matches, begin(), result);
+    return result;
+}
+
+
+template <typename T>
+template <typename RTMatches>
+void MZRTField<T>::find(const std::vector<double>& mzs, MZTolerance mzTolerance, RTMatches matches,
+                        std::vector< std::vector<TPtr> >& result) const
+{
+    result.resize(mzs.size());
+
+    // each search starts where the previous m/z range started
+    iterator hint = begin();
+    for (size_t i=0; i < mzs.size(); ++i)
+    {
+        result[i].clear();
+        hint = findRange(mzs[i], mzTolerance, matches, hint, result[i]);
+    }
 }
 
 
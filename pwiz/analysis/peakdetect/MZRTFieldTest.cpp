@@ -279,6 +279,90 @@ void testFeatureField()
 }
 
 
+void testManyObjects()
+{
+    if (os_) *os_ << "testManyObjects()\n";
+
+    // enough objects for many blocks, with some of the same m/z and retention time
+    vector<SimplePtr> objects;
+    srand(7);
+    for (size_t i=0; i < 5000; ++i)
+    {
+        double rtMin = rand() % 100;
+        objects.push_back(SimplePtr(new Simple(400 + (rand() % 2000) * .01, rtMin, rtMin + rand() % 10)));
+    }
+
+    MZRTField<Simple> field, bulkField(objects.begin(), objects.end());
+    set<SimplePtr, LessThan_MZRT<Simple> > reference;
+    for (size_t i=0; i < objects.size(); ++i)
+        unit_assert_operator_equal(reference.insert(objects[i]).second, field.insert(objects[i]).second);
+
+    unit_assert_operator_equal(reference.size(), field.size());
+    unit_assert(equal(reference.begin(), reference.end(), field.begin()));
+    unit_assert_operator_equal(reference.size(), bulkField.size());
+    unit_assert(equal(reference.begin(), reference.end(), bulkField.begin()));
+
+    // single and batched finds match a scan of all objects
+    vector<double> mzs;
+    for (double mz=399.5; mz < 421; mz += .37)
+        mzs.push_back(mz);
+    RTMatches_Contains<Simple> rtMatches(50, 1);
+    vector< vector<SimplePtr> > batchedResult;
+    field.find(mzs, .1, rtMatches, batchedResult);
+    unit_assert_operator_equal(mzs.size(), batchedResult.size());
+
+    for (size_t i=0; i < mzs.size(); ++i)
+    {
+        vector<SimplePtr> expected;
+        BOOST_FOREACH(const SimplePtr& p, reference)
+            if (p->mz >= mzs[i] - .1 && p->mz <= mzs[i] + .1 && rtMatches(*p))
+                expected.push_back(p);
+
+        unit_assert(expected == field.find(mzs[i], .1, rtMatches));
+        unit_assert(expected == batchedResult[i]);
+    }
+
+    // remove every other object, by iterator and by reference
+    bool byIterator = true;
+    for (MZRTField<Simple>::iterator it=field.begin(); it!=field.end(); byIterator = !byIterator)
+    {
+        SimplePtr p = *it;
+        reference.erase(p);
+        if (byIterator)
+            it = field.erase(it);
+        else
+        {
+            ++it;
+            SimplePtr next = it == field.end() ? SimplePtr() : *it;
+            field.remove(p);
+            it = next.get() ? field.lower_bound(next) : field.end();
+        }
+        if (it != field.end()) ++it;
+    }
+
+    unit_assert_operator_equal(reference.size(), field.size());
+    unit_assert(equal(reference.begin(), reference.end(), field.begin()));
+    unit_assert(*field.upper_bound(*reference.begin()) == *++reference.begin());
+
+    BOOST_FOREACH(const SimplePtr& p, reference)
+        field.remove(p);
+    unit_assert(field.empty());
+    unit_assert(field.begin() == field.end());
+
+    // an emptied or cleared field has no blocks, and can be searched and filled again
+    unit_assert(field.find(410, 20, RTMatches_Any<Simple>()).empty());
+    unit_assert(field.lower_bound(objects[0]) == field.end());
+    unit_assert(field.insert(objects[0]).second);
+    unit_assert(field.find(objects[0]->mz, .01, RTMatches_Any<Simple>()) == vector<SimplePtr>(1, objects[0]));
+
+    bulkField.clear();
+    unit_assert(bulkField.empty());
+    unit_assert(bulkField.find(410, 20, RTMatches_Any<Simple>()).empty());
+    unit_assert(bulkField.insert(objects[1]).second);
+    unit_assert_operator_equal(1, bulkField.size());
+}
+
+
 void test()
 {
     testPredicate();
@@ -287,6 +371,7 @@ void test()
     testFind();
     testPeakelField();
     testFeatureField();
+    testManyObjects();
 }
 
 
@@ -66,12 +66,19 @@ namespace {
 
 //#define PEAKELGROWER_DEBUG
 
-void insertNewPeakel(PeakelField& peakelField, const Peak& peak)
+PeakelPtr createPeakel(const Peak& peak)
 {
     PeakelPtr peakel(new Peakel);
     peakel->mz = peak.mz;
     peakel->retentionTime = peak.retentionTime;
     peakel->peaks.push_back(peak);
+    return peakel;
+}
+
+
+void insertNewPeakel(PeakelField& peakelField, const Peak& peak)
+{
+    PeakelPtr peakel = createPeakel(peak);
 
     peakelField.insert(peakel);
 
@@ -103,16 +110,68 @@ void PeakelGrower_Proximity::sowPeak(PeakelField& peakelField, const Peak& peak)
     else if (candidates.size() == 1)
         updatePeakel(*candidates.front(), peak);
     else
+        logCandidates(peak, candidates);
+}
+
+
+void PeakelGrower_Proximity::sowPeaks(PeakelField& peakelField, const vector<Peak>& peaks) const
+{
+    vector<double> mzs;
+    mzs.reserve(peaks.size());
+    for (vector<Peak>::const_iterator it=peaks.begin(); it!=peaks.end(); ++it)
+    {
+        if (it->retentionTime != peaks.front().retentionTime || (!mzs.empty() && it->mz < mzs.back()))
+        {
+            PeakelGrower::sowPeaks(peakelField, peaks);
+            return;
+        }
+        mzs.push_back(it->mz);
+    }
+
+    RTMatches_Contains<Peakel> rtMatches(peaks.empty() ? 0 : peaks.front().retentionTime, config_.rtTolerance);
+    vector< vector<PeakelPtr> > candidates;
+    peakelField.find(mzs, config_.mzTolerance, rtMatches, candidates);
+
+    // the result must be the same as sowing the peaks one at a time: growing a peakel with
+    // a peak of this spectrum does not change whether it matches the others, but the
+    // peakels created for earlier peaks are candidates too
+    vector<PeakelPtr> newPeakels;
+    for (size_t i=0; i < peaks.size(); ++i)
     {
-        if (config_.log)
+        const Peak& peak = peaks[i];
+        for (vector<PeakelPtr>::const_reverse_iterator it=newPeakels.rbegin();
+             it!=newPeakels.rend() && (*it)->mz >= peak.mz - config_.mzTolerance; ++it)
+            if (rtMatches(**it))
+                candidates[i].push_back(*it);
+
+        if (candidates[i].empty())
         {
-            *config_.log << "[PeakelGrower_Proximity::sowPeak()] Warning: multiple candidate peakels.\n"
-                 << "  peak: " << peak
-                 << "  candidates: " << candidates.size() << endl;
-            for (vector<PeakelPtr>::const_iterator it=candidates.begin(); it!=candidates.end(); ++it)
-                *config_.log << **it << endl;
-            *config_.log << endl;
+            newPeakels.push_back(createPeakel(peak));
+#ifdef PEAKELGROWER_DEBUG
+            cout << "insertNewPeakel():\n  " << *newPeakels.back() << endl;
+#endif
         }
+        else if (candidates[i].size() == 1)
+            updatePeakel(*candidates[i].front(), peak);
+        else
+            logCandidates(peak, candidates[i]);
+    }
+
+    for (vector<PeakelPtr>::const_iterator it=newPeakels.begin(); it!=newPeakels.end(); ++it)
+        peakelField.insert(*it);
+}
+
+
+void PeakelGrower_Proximity::logCandidates(const Peak& peak, const vector<PeakelPtr>& candidates) const
+{
+    if (config_.log)
+    {
+        *config_.log << "[PeakelGrower_Proximity::sowPeak()] Warning: multiple candidate peakels.\n"
+             << "  peak: " << peak
+             << "  candidates: " << candidates.size() << endl;
+        for (vector<PeakelPtr>::const_iterator it=candidates.begin(); it!=candidates.end(); ++it)
+            *config_.log << **it << endl;
+        *config_.log << endl;
     }
 }
 
@@ -72,8 +72,15 @@ class PWIZ_API_DECL PeakelGrower_Proximity : public PeakelGrower
     PeakelGrower_Proximity(const Config& config = Config());
     virtual void sowPeak(PeakelField&, const Peak& peak) const;
 
+    /// the peaks of one spectrum (same retention time, increasing m/z) are looked up in one
+    /// pass over the field; otherwise they are sown one at a time
+    virtual void sowPeaks(PeakelField& peakelField, const std::vector<Peak>& peaks) const;
+    using PeakelGrower::sowPeaks;
+
     private:
     Config config_;
+
+    void logCandidates(const Peak& peak, const std::vector<pwiz::data::peakdata::PeakelPtr>& candidates) const;
 };
 
 
@@ -108,9 +108,48 @@ void testToyExample()
 }
 
 
+void testBatchedSowing()
+{
+    if (os_) *os_ << "testBatchedSowing()\n";
+
+    // dense spectra with peaks drifting slightly in m/z, some of them close enough
+    // to grow into the same peakel within a spectrum
+    vector< vector<Peak> > peaks(100);
+    srand(42);
+    for (size_t i=0; i < peaks.size(); ++i)
+    {
+        for (size_t j=0; j < 300; ++j)
+        {
+            Peak peak;
+            peak.retentionTime = i;
+            peak.mz = 400 + j * .5 + (rand() % 100) * .0002;
+            if (rand() % 10 == 0) continue; // gaps
+            peaks[i].push_back(peak);
+            if (rand() % 20 == 0) {peak.mz += .001; peaks[i].push_back(peak);} // close neighbor
+        }
+    }
+
+    PeakelGrower_Proximity::Config config;
+    config.mzTolerance = MZTolerance(10, MZTolerance::PPM);
+    config.rtTolerance = 2.5;
+    PeakelGrower_Proximity peakelGrower(config);
+
+    PeakelField batched, serial;
+    peakelGrower.sowPeaks(batched, peaks);
+    for (size_t i=0; i < peaks.size(); ++i)
+        for (size_t j=0; j < peaks[i].size(); ++j)
+            peakelGrower.sowPeak(serial, peaks[i][j]);
+
+    unit_assert_operator_equal(serial.size(), batched.size());
+    for (PeakelField::const_iterator it=serial.begin(), jt=batched.begin(); it!=serial.end(); ++it, ++jt)
+        unit_assert(**it == **jt);
+}
+
+
 void test()
 {
     testToyExample();
+    testBatchedSowing();
 }
 
 
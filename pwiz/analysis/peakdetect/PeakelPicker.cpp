@@ -212,10 +212,10 @@ void BasicPickImpl::pick()
 {
     if (config_.log) *config_.log << "[PeakelPicker_Basic] pick() begin\n\n" << peakelField_ << endl;
 
+    // process() removes peakels, which invalidates end()
     PeakelField::iterator it = peakelField_.begin();
-    PeakelField::iterator end = peakelField_.end();
    
-    while (it != end)
+    while (it != peakelField_.end())
         it = process(it);
 
     if (config_.log) *config_.log << "[PeakelPicker_Basic] pick() end\n\n";
@@ -107,6 +107,7 @@ PWIZ_API_DECL SpectrumPtr SpectrumList_ChargeFromIsotope::spectrum(size_t index,
 {
 
     SpectrumPtr s = inner_->spectrum(index, true);
+    s->storeBinaryDataAsFloat64();
 
     // return non-MS/MS as-is
     CVParam spectrumType = s->cvParamChild(MS_spectrum_type);
@@ -872,6 +873,7 @@ void SpectrumList_ChargeFromIsotope::getParentPeaks(const SpectrumPtr s,const ve
         {
 
             SpectrumPtr sPar = inner_->spectrum( parents[i], true );
+            sPar->storeBinaryDataAsFloat64();
             vector<double>& peakMZs = sPar->getMZArray()->data;
             vector<double>& peakIntensities = sPar->getIntensityArray()->data;
             vector<int> elementsForDeletion;
@@ -35,8 +35,12 @@
 #include "pwiz/analysis/demux/DemuxHelpers.hpp"
 #include "pwiz/analysis/demux/DemuxTypes.hpp"
 #include "pwiz/data/msdata/SpectrumListCache.hpp"
+#include "pwiz/data/msdata/SpectrumWorkerThreads.hpp"
+#include "pwiz/utility/misc/mru_list.hpp"
 #include "pwiz/analysis/spectrum_processing/SpectrumListFactory.hpp"
 #include <boost/make_shared.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
 
 #ifdef _PROFILE_PERFORMANCE
 #include <chrono>
@@ -66,13 +70,21 @@ namespace analysis {
 
         private:
 
-        /// Simple caching object for storing the last solved demultiplexing spectrum
-        struct PreviousDemuxSolution
+        /// Caching object for storing a solved demultiplexing spectrum. Its mutex is held while the spectrum is solved, so concurrent
+        /// requests for the demultiplexed spectra of the same multiplexed spectrum wait for a single solve instead of repeating it.
+        struct DemuxSolution
         {
+            explicit DemuxSolution(size_t origSpecIndex) : origSpecIndex(origSpecIndex) {}
+
             size_t origSpecIndex; ///< index of original spectrum
             MatrixPtr solution; ///< solution matrix output of DemuxSolver
+            std::vector<size_t> spectrumIndices; ///< rows of the solution matrix for the demux windows of the original spectrum
+            boost::mutex mutex; ///< held while solving
         };
 
+        typedef boost::shared_ptr<DemuxSolution> DemuxSolutionPtr;
+        typedef util::mru_list<DemuxSolutionPtr, BOOST_MULTI_INDEX_MEMBER(DemuxSolution, size_t, origSpecIndex)> SolutionCache;
+
         /// Container that maps from the indices of the demultiplexed output spectra to their source multiplexed input spectra. This provides
         /// the number of output demultiplexed spectra so that they can be iterated through. This also provides the multiplexed source spectra
         /// for each demultiplexed spectra and an index to the specific demultiplexed spectrum within the source spectrum.
@@ -135,10 +147,16 @@ namespace analysis {
         /// @return The requested demultiplexed spectrum
         msdata::Spectrum_const_ptr GetDemuxSpectrum(size_t index) const;
 
+        /// Retrieves the solution for a multiplexed spectrum from cache or, if it isn't cached, solves it.
+        /// @param[in] originalIndex Index of the multiplexed spectrum
+        /// @return The solved spectrum; its solution is not modified after it is returned
+        DemuxSolutionPtr GetSolution(size_t originalIndex) const;
+
         /// PrecursorMaskCodec is used for interpreting a series of spectra and generating an MSX design matrix
         IPrecursorMaskCodec::ptr pmc_;
 
-        /// SpectrumList that caches recently used spectra since we expect to access the same spectra multiple times while demultiplexing
+        /// SpectrumList that caches recently used spectra since we expect to access the same spectra multiple times while demultiplexing.
+        /// The cache is sharded so that several threads demultiplexing different cycles can read it at once.
         msdata::SpectrumListPtr sl_;
 
         /// Each input mux'd spectrum is split into multiple demux'd spectra. Therefore, we need to reinterpret spectrum
@@ -150,10 +168,13 @@ namespace analysis {
         /// demultiplexing problem can be framed as a non-negative least squares problem. This NNLS problem is delegated to the DemuxSolver.
         DemuxSolver::ptr demuxSolver_;
 
-        /// This caches the last solution generated by the DemuxSolver.
-        /// We expect to access the demultiplixed spectra in order but may access a multiplexed spectrum multiple times before moving to the next solve.
-        /// The primary application is currently to write spectra sequentially to file so caching optimization for random access isn't necessary at this time.
-        boost::shared_ptr<PreviousDemuxSolution> lastSolved_;
+        /// This caches the most recent solutions generated by the DemuxSolver.
+        /// We expect to access the demultiplexed spectra in order but may access a multiplexed spectrum multiple times before moving to the next solve.
+        /// With SpectrumWorkerThreads, nearby multiplexed spectra are solved concurrently, so a few solutions are kept for each worker thread.
+        mutable SolutionCache solutions_;
+
+        /// Guards solutions_ (but not the solutions themselves, which have their own mutex)
+        mutable boost::mutex solutionsMutex_;
 
         /// The demultiplexer to use for generating the matrices to be solved
         IDemultiplexer::ptr demux_;
@@ -163,6 +184,7 @@ namespace analysis {
 
 #ifdef _USE_DEMUX_DEBUG_WRITER
         boost::shared_ptr<DemuxDebugWriter> debugWriter_;
+        mutable boost::mutex debugWriterMutex_;
 #endif
     };
 
@@ -186,6 +208,13 @@ namespace analysis {
     
     namespace {
 
+    /// Byte budget of the cache of multiplexed spectra, shared by all threads demultiplexing from the list
+    const size_t kMuxSpectrumCacheBytes = 512 * 1024 * 1024;
+
+    /// Number of solutions cached for each worker thread, and at least
+    const size_t kSolutionsPerThread = 4;
+    const size_t kMinSolutions = 16;
+
     /// Key-value pairs for transforming Optimization enums to strings and vice-versa
     const std::map<SpectrumList_Demux::Params::Optimization, std::string> kOptimizationStrings = {
         { SpectrumList_Demux::Params::Optimization::NONE, "none" },
@@ -279,7 +308,7 @@ namespace analysis {
 
     SpectrumList_Demux::Impl::Impl(const SpectrumListPtr& inner, const Params& p, DataProcessingPtr dp) :
         demuxSolver_(new NNLSSolver(p.nnlsMaxIter, p.nnlsEps)),
-        lastSolved_(new PreviousDemuxSolution),
+        solutions_(max(kMinSolutions, kSolutionsPerThread * SpectrumWorkerThreads::defaultThreadCount())),
         params_(p)
 #ifdef _USE_DEMUX_DEBUG_WRITER		
         ,
@@ -320,7 +349,7 @@ namespace analysis {
         cout << "Build IndexMapper: " << duration << endl;
 #endif
         // Use a SpectrumListCache since we expect to request the same spectra multiple times to extract all demux spectra before moving to the next
-        sl_ = boost::make_shared<SpectrumListCache>(inner, MemoryMRUCacheMode_MetaDataAndBinaryData, 1000);
+        sl_ = boost::make_shared<SpectrumListCache>(inner, boost::make_shared<ShardedSpectrumCache>(MemoryMRUCacheMode_MetaDataAndBinaryData, kMuxSpectrumCacheBytes));
         // Record the processing method that will be used to demultiplex
         ProcessingMethod method = pmc_->GetProcessingMethod();
         method.order = static_cast<int>(dp->processingMethods.size());
@@ -365,67 +394,83 @@ namespace analysis {
         return indexMapper_->spectrumIdentities.at(index);
     }
 
-    Spectrum_const_ptr SpectrumList_Demux::Impl::GetDemuxSpectrum(size_t index) const
+    SpectrumList_Demux::Impl::DemuxSolutionPtr SpectrumList_Demux::Impl::GetSolution(size_t originalIndex) const
     {
-        IndexMapper::DemuxRequestIndex& request = indexMapper_->indexMap[index];
-        Spectrum_const_ptr refSpectrum = sl_->spectrum(request.spectrumOriginalIndex, true); // The multiplexed spectrum to be demultiplexed
-        MatrixPtr solution;
-        if (lastSolved_->solution && lastSolved_->origSpecIndex == request.spectrumOriginalIndex)
+        DemuxSolutionPtr solved;
         {
-            // This spectrum has been already solved (there will be separate requests for each precursor of a single spectrum)
-            solution = lastSolved_->solution;
+            // a cached solution is looked up by index; a new entry is only made when it is missing. Either way the mru is its entry
+            boost::lock_guard<boost::mutex> lock(solutionsMutex_);
+            if (!solutions_.touch(originalIndex))
+                solutions_.insert(boost::make_shared<DemuxSolution>(originalIndex));
+            solved = solutions_.mru();
         }
-        else
+
+        // Hold the solution's lock while solving; other threads requesting the same spectrum wait here
+        boost::lock_guard<boost::mutex> lock(solved->mutex);
+        if (solved->solution)
         {
+            // This spectrum has been already solved (there will be separate requests for each precursor of a single spectrum)
+            return solved;
+        }
+
 #ifdef _PROFILE_PERFORMANCE
-            auto t1 = high_resolution_clock::now();
+        auto t1 = high_resolution_clock::now();
 #endif
-            // Figure out which spectra to include in the system of equations to demux
-            vector<size_t> muxIndices;
-            demux_->GetMatrixBlockIndices(request.spectrumOriginalIndex, muxIndices, params_.demuxBlockExtra);
+        // Figure out which spectra to include in the system of equations to demux
+        vector<size_t> muxIndices;
+        demux_->GetMatrixBlockIndices(originalIndex, muxIndices, params_.demuxBlockExtra);
 #ifdef _PROFILE_PERFORMANCE
-            // add function to be timed here
-            auto t2 = high_resolution_clock::now();
-            auto duration = duration_cast<microseconds >(t2 - t1).count();
-            cout << "GetMatrixBlockIndices: " << duration << endl;
+        // add function to be timed here
+        auto t2 = high_resolution_clock::now();
+        auto duration = duration_cast<microseconds >(t2 - t1).count();
+        cout << "GetMatrixBlockIndices: " << duration << endl;
 #endif
 
 #ifdef _PROFILE_PERFORMANCE
-            t1 = high_resolution_clock::now();
+        t1 = high_resolution_clock::now();
 #endif
-            // Generate matrices for least squares solve
-            MatrixPtr masks;
-            MatrixPtr signal;
-            demux_->BuildDeconvBlock(request.spectrumOriginalIndex, muxIndices, masks, signal);
+        // Generate matrices for least squares solve
+        MatrixPtr masks;
+        MatrixPtr signal;
+        demux_->BuildDeconvBlock(originalIndex, muxIndices, masks, signal, solved->spectrumIndices);
 #ifdef _PROFILE_PERFORMANCE
-            // add function to be timed here
-            t2 = high_resolution_clock::now();
-            duration = duration_cast<microseconds >(t2 - t1).count();
-            cout << "BuildDeconvBlock: " << duration << endl;
+        // add function to be timed here
+        t2 = high_resolution_clock::now();
+        duration = duration_cast<microseconds >(t2 - t1).count();
+        cout << "BuildDeconvBlock: " << duration << endl;
 #endif
 
 #ifdef _PROFILE_PERFORMANCE
-            t1 = high_resolution_clock::now();
+        t1 = high_resolution_clock::now();
 #endif
-            // Perform the least squares solve
-            solution.reset(new MatrixType(masks->cols(), signal->cols()));
-            demuxSolver_->Solve(masks, signal, solution);
-            lastSolved_->solution = solution;
-            lastSolved_->origSpecIndex = request.spectrumOriginalIndex;
+        // Perform the least squares solve
+        MatrixPtr solution(new MatrixType(masks->cols(), signal->cols()));
+        demuxSolver_->Solve(masks, signal, solution);
 #ifdef _PROFILE_PERFORMANCE
-            // add function to be timed here
-            t2 = high_resolution_clock::now();
-            duration = duration_cast<microseconds >(t2 - t1).count();
-            cout << "Solve: " << duration << endl;
+        // add function to be timed here
+        t2 = high_resolution_clock::now();
+        duration = duration_cast<microseconds >(t2 - t1).count();
+        cout << "Solve: " << duration << endl;
 #endif
 
 #ifdef _USE_DEMUX_DEBUG_WRITER
-            if (debugWriter_->IsOpen())
-            {
-                debugWriter_->WriteDeconvBlock(request.spectrumOriginalIndex, masks, solution, signal);
-            }
-#endif
+        if (debugWriter_->IsOpen())
+        {
+            boost::lock_guard<boost::mutex> debugWriterLock(debugWriterMutex_);
+            debugWriter_->WriteDeconvBlock(originalIndex, masks, solution, signal);
         }
+#endif
+        // Only set the solution once it is complete, so a failed solve is retried by the next request
+        solved->solution = solution;
+        return solved;
+    }
+
+    Spectrum_const_ptr SpectrumList_Demux::Impl::GetDemuxSpectrum(size_t index) const
+    {
+        const IndexMapper::DemuxRequestIndex& request = indexMapper_->indexMap[index];
+        Spectrum_const_ptr refSpectrum = sl_->spectrum(request.spectrumOriginalIndex, true); // The multiplexed spectrum to be demultiplexed
+        DemuxSolutionPtr solved = GetSolution(request.spectrumOriginalIndex);
+        const MatrixPtr& solution = solved->solution;
         
         // Build a new demultiplexed spectrum from a copy of the original spectrum
         SpectrumPtr demuxed = boost::make_shared<Spectrum>(*refSpectrum);
@@ -464,10 +509,10 @@ namespace analysis {
         demuxed->setMZIntensityArrays(vector<double>(), vector<double>(), MS_number_of_detector_counts);
         vector<double>& newMzs = demuxed->getMZArray()->data;
         vector<double>& newIntensities = demuxed->getIntensityArray()->data;
-        vector<double>& originalMzs = refSpectrum->getMZArray()->data;
-        vector<double>& originalIntensities = refSpectrum->getIntensityArray()->data;
+        const BinaryDataArray& originalMzs = *refSpectrum->getMZArray();
+        const BinaryDataArray& originalIntensities = *refSpectrum->getIntensityArray();
 
-        auto& referenceDemuxIndices = demux_->SpectrumIndices();
+        const auto& referenceDemuxIndices = solved->spectrumIndices;
         auto summedIntensities = solution->row(referenceDemuxIndices[0]).eval(); // eval() performs copy instead of reference
         for (size_t i = 1; i < referenceDemuxIndices.size(); ++i)
         {
@@ -479,12 +524,12 @@ namespace analysis {
             if (rawSolutionIntensities[i] <= 0.0) continue;
 
             // The original intensities can be 0 even if the least squares solution are non-zero. This may invalidate the idea of rescaling the intensities...
-            if (originalIntensities[i] <= 0.0) continue;
+            if (originalIntensities.value(i) <= 0.0) continue;
 
-            newMzs.push_back(originalMzs[i]);
+            newMzs.push_back(originalMzs.value(i));
             if (!params_.variableFill)
             {
-                auto newIntensity = originalIntensities[i] * rawSolutionIntensities[i] / summedIntensities[i];
+                auto newIntensity = originalIntensities.value(i) * rawSolutionIntensities[i] / summedIntensities[i];
                 newIntensities.push_back(newIntensity);
             }
             else
@@ -31,6 +31,9 @@ namespace analysis {
     /** 
      * SpectrumList_Demux can separate multiplexed spectra into several demultiplexed spectra by inferring from adjacent multiplexed spectra. This method
      * can handle variable fill times, requiring that the user specify whether the fill times have varied.
+     *
+     * spectrum() may be called from several threads at once (e.g. by SpectrumWorkerThreads): spectra from different cycles are solved
+     * concurrently, while requests for the demultiplexed spectra of one multiplexed spectrum share a single solve.
     */
     class PWIZ_API_DECL SpectrumList_Demux : public msdata::SpectrumListWrapper
     {
@@ -27,9 +27,11 @@
 #include "pwiz/data/msdata/MSDataFile.hpp"
 #include "pwiz/data/msdata/Serializer_mzML.hpp"
 #include "pwiz/data/msdata/Diff.hpp"
+#include "pwiz/data/msdata/SpectrumWorkerThreads.hpp"
 #include "pwiz_tools/common/FullReaderList.hpp"
 #include <pwiz/utility/misc/IntegerSet.hpp>
 #include <boost/make_shared.hpp>
+#include <boost/thread.hpp>
 
 #define _VERIFY_EXACT_SPECTRUM
 
@@ -424,6 +426,63 @@ void testMSXOnly(const string& filepath)
 }
 
 
+void testConcurrentDemux(const string& filepath, DemuxOptimization optimization)
+{
+    DemuxTest test;
+    SpectrumList_Demux::Params demuxParams;
+    demuxParams.optimization = optimization;
+    auto serialList = test.GenerateSpectrumList(filepath, true, demuxParams);
+    auto concurrentList = test.GenerateSpectrumList(filepath, true, demuxParams);
+    unit_assert(SpectrumWorkerThreads::isThreadSafe(*concurrentList.spectrumList));
+
+    // the first few cycles are enough to have several threads solving at once
+    size_t spectrumCount = min(serialList.spectrumList->size(), (size_t) 60);
+    vector<SpectrumPtr> serialSpectra(spectrumCount);
+    for (size_t i = 0; i < spectrumCount; ++i)
+        serialSpectra[i] = serialList.spectrumList->spectrum(i, true);
+
+    // Interleave the indices among the threads, so the demux spectra of one multiplexed spectrum are requested at once
+    const size_t threadCount = 4;
+    vector<SpectrumPtr> concurrentSpectra(spectrumCount);
+    vector<string> errors(threadCount);
+    boost::thread_group threads;
+    for (size_t t = 0; t < threadCount; ++t)
+        threads.create_thread([&, t]
+        {
+            try
+            {
+                for (size_t i = t; i < spectrumCount; i += threadCount)
+                    concurrentSpectra[i] = concurrentList.spectrumList->spectrum(i, true);
+            }
+            catch (exception& e)
+            {
+                errors[t] = e.what();
+            }
+        });
+    threads.join_all();
+    for (const string& error : errors)
+        if (!error.empty()) throw runtime_error(error);
+
+    // And through SpectrumWorkerThreads, as msconvert does
+    SpectrumWorkerThreads::Config config;
+    config.threadCount = threadCount;
+    SpectrumWorkerThreads workers(*serialList.spectrumList, config);
+
+    for (size_t i = 0; i < spectrumCount; ++i)
+    {
+        const Spectrum& expected = *serialSpectra[i];
+        SpectrumPtr prefetched = workers.processBatch(i, true);
+        for (const Spectrum* actual : { concurrentSpectra[i].get(), prefetched.get() })
+        {
+            unit_assert_operator_equal(expected.id, actual->id);
+            unit_assert_operator_equal(expected.index, actual->index);
+            unit_assert(expected.getMZArray()->data == actual->getMZArray()->data);
+            unit_assert(expected.getIntensityArray()->data == actual->getIntensityArray()->data);
+        }
+    }
+}
+
+
 void parseArgs(const vector<string>& args, vector<string>& rawpaths)
 {
     for (size_t i = 1; i < args.size(); ++i)
@@ -452,10 +511,12 @@ int main(int argc, char* argv[])
             if (bal::ends_with(filepath, "MsxTest.mzML"))
             {
                 testMSXOnly(filepath);
+                testConcurrentDemux(filepath, DemuxOptimization::NONE);
             }
             else if (bal::ends_with(filepath, "OverlapTest.mzML"))
             {
                 testOverlapOnly(filepath);
+                testConcurrentDemux(filepath, DemuxOptimization::OVERLAP_ONLY);
             }
         }
     }
@@ -25,6 +25,8 @@
 
 #include "pwiz/data/common/cv.hpp"
 #include "SpectrumList_Filter.hpp"
+#include "pwiz/data/msdata/SpectrumWorkerThreads.hpp"
+#include "pwiz/utility/misc/WorkerPool.hpp"
 #include "pwiz/utility/misc/Std.hpp"
 
 namespace pwiz {
@@ -52,6 +54,12 @@ struct SpectrumList_Filter::Impl
 
     Impl(SpectrumListPtr original, const Predicate& predicate);
     void pushSpectrum(const SpectrumIdentity& spectrumIdentity);
+
+    private:
+    void acceptSerially(const Predicate& predicate);
+    void acceptConcurrently(const Predicate& predicate, size_t threadCount);
+    void acceptSpectra(const vector<size_t>& indices, vector<tribool>& accepted, const Predicate& predicate, size_t threadCount);
+    tribool acceptSpectrum(size_t index, const Predicate& predicate, DetailLevel& detailLevel) const;
 };
 
 
@@ -60,6 +68,16 @@ SpectrumList_Filter::Impl::Impl(SpectrumListPtr _original, const Predicate& pred
 {
     if (!original.get()) throw runtime_error("[SpectrumList_Filter] Null pointer");
 
+    size_t threadCount = predicate.isThreadSafe() ? SpectrumWorkerThreads::defaultThreadCount() : 1;
+    if (threadCount > 1 && original->size() > 1 && SpectrumWorkerThreads::isThreadSafe(*original))
+        acceptConcurrently(predicate, threadCount);
+    else
+        acceptSerially(predicate);
+}
+
+
+void SpectrumList_Filter::Impl::acceptSerially(const Predicate& predicate)
+{
     // iterate through the spectra, using predicate to build the sub-list
     for (size_t i=0, end=original->size(); i<end; i++)
     {
@@ -69,33 +87,84 @@ SpectrumList_Filter::Impl::Impl(SpectrumListPtr _original, const Predicate& pred
         const SpectrumIdentity& spectrumIdentity = original->spectrumIdentity(i);
         tribool accepted = predicate.accept(spectrumIdentity);
 
+        if (boost::logic::indeterminate(accepted))
+            accepted = acceptSpectrum(i, predicate, detailLevel);
+
         if (accepted)
+            pushSpectrum(spectrumIdentity);
+    }
+}
+
+
+void SpectrumList_Filter::Impl::acceptConcurrently(const Predicate& predicate, size_t threadCount)
+{
+    // iterate through the spectra a chunk at a time: acceptance is decided from the
+    // SpectrumIdentity alone first, in order, then the spectra that are left undecided
+    // are retrieved and judged by several threads
+    const size_t chunkSize = 256 * threadCount;
+    vector<tribool> accepted;
+    vector<size_t> pendingIndices;
+    vector<tribool> pendingAccepted;
+    bool done = false;
+
+    for (size_t chunkBegin=0, end=original->size(); chunkBegin<end && !done; chunkBegin+=chunkSize)
+    {
+        size_t chunkEnd = min(end, chunkBegin + chunkSize);
+        accepted.clear();
+        pendingIndices.clear();
+
+        for (size_t i=chunkBegin; i<chunkEnd; i++)
         {
-            pushSpectrum(spectrumIdentity);            
-        }
-        else if (!accepted)
-        {
-            // do nothing 
-        }
-        else // indeterminate
-        {
-            // not enough info -- we need to retrieve the Spectrum
-            do
-            {
-                SpectrumPtr spectrum = original->spectrum(i, detailLevel);
-                accepted = predicate.accept(*spectrum);
+            if (predicate.done()) {done = true; break;}
 
-                if (boost::logic::indeterminate(accepted) && (int) detailLevel < (int) DetailLevel_FullMetadata)
-                    detailLevel = DetailLevel(int(detailLevel) + 1);
-                else
-                {
-                    if (accepted)
-                       pushSpectrum(spectrumIdentity);
-                    break;
-                }
-            }
-            while ((int) detailLevel <= (int) DetailLevel_FullMetadata);
+            accepted.push_back(predicate.accept(original->spectrumIdentity(i)));
+            if (boost::logic::indeterminate(accepted.back()))
+                pendingIndices.push_back(i);
         }
+
+        acceptSpectra(pendingIndices, pendingAccepted, predicate, threadCount);
+        for (size_t j=0; j < pendingIndices.size(); ++j)
+            accepted[pendingIndices[j] - chunkBegin] = pendingAccepted[j];
+
+        for (size_t i=0; i < accepted.size(); ++i)
+            if (accepted[i])
+                pushSpectrum(original->spectrumIdentity(chunkBegin + i));
+    }
+}
+
+
+void SpectrumList_Filter::Impl::acceptSpectra(const vector<size_t>& indices, vector<tribool>& accepted, const Predicate& predicate, size_t threadCount)
+{
+    accepted.assign(indices.size(), tribool(false));
+    threadCount = max((size_t) 1, min(threadCount, indices.size()));
+
+    // each worker escalates its own detail level; the highest is kept for the next chunk
+    vector<DetailLevel> detailLevels(threadCount, detailLevel);
+
+    parallelFor(indices.size(), [&](size_t j, size_t worker)
+    {
+        accepted[j] = acceptSpectrum(indices[j], predicate, detailLevels[worker]);
+    }, threadCount);
+
+    for (size_t t=0; t < threadCount; ++t)
+        if ((int) detailLevels[t] > (int) detailLevel)
+            detailLevel = detailLevels[t];
+}
+
+
+tribool SpectrumList_Filter::Impl::acceptSpectrum(size_t index, const Predicate& predicate, DetailLevel& detailLevel) const
+{
+    // not enough info from the SpectrumIdentity -- we need to retrieve the Spectrum,
+    // in increasing detail until the predicate can decide
+    while (true)
+    {
+        SpectrumPtr spectrum = original->spectrum(index, detailLevel);
+        tribool accepted = predicate.accept(*spectrum);
+
+        if (boost::logic::indeterminate(accepted) && (int) detailLevel < (int) DetailLevel_FullMetadata)
+            detailLevel = DetailLevel(int(detailLevel) + 1);
+        else
+            return accepted;
     }
 }
 
@@ -252,9 +321,9 @@ PWIZ_API_DECL boost::logic::tribool SpectrumList_FilterPredicate_ScanEventSet::a
 {
     Scan dummy;
     const Scan& scan = spectrum.scanList.scans.empty() ? dummy : spectrum.scanList.scans[0];
-    CVParam param = scan.cvParam(MS_preset_scan_configuration);
-    if (param.cvid == CVID_Unknown) return boost::logic::indeterminate;
-    int scanEvent = lexical_cast<int>(param.value);
+    const CVParam* param = scan.findCVParam(MS_preset_scan_configuration);
+    if (!param) return boost::logic::indeterminate;
+    int scanEvent = lexical_cast<int>(param->value);
     bool result = scanEventSet_.contains(scanEvent);
     return result;
 }
@@ -281,9 +350,9 @@ PWIZ_API_DECL boost::logic::tribool SpectrumList_FilterPredicate_ScanTimeRange::
 {
     Scan dummy;
     const Scan& scan = spectrum.scanList.scans.empty() ? dummy : spectrum.scanList.scans[0];
-    CVParam param = scan.cvParam(MS_scan_start_time);
-    if (param.cvid == CVID_Unknown) return boost::logic::indeterminate;
-    double time = param.timeInSeconds();
+    const CVParam* param = scan.findCVParam(MS_scan_start_time);
+    if (!param) return boost::logic::indeterminate;
+    double time = param->timeInSeconds();
 
     return (time>=scanTimeLow_ && time<=scanTimeHigh_);
 }
@@ -301,13 +370,13 @@ PWIZ_API_DECL SpectrumList_FilterPredicate_MSLevelSet::SpectrumList_FilterPredic
 
 PWIZ_API_DECL boost::logic::tribool SpectrumList_FilterPredicate_MSLevelSet::accept(const msdata::Spectrum& spectrum) const
 {
-    CVParam param = spectrum.cvParamChild(MS_spectrum_type);
-    if (param.cvid == CVID_Unknown) return boost::logic::indeterminate;
-    if (!cvIsA(param.cvid, MS_mass_spectrum))
+    const CVParam* param = spectrum.findCVParamChild(MS_spectrum_type);
+    if (!param) return boost::logic::indeterminate;
+    if (!cvIsA(param->cvid, MS_mass_spectrum))
         return msLevelSet_.contains(0); // non-MS spectra are considered ms level 0
-    param = spectrum.cvParam(MS_ms_level);
-    if (param.cvid == CVID_Unknown) return boost::logic::indeterminate;
-    int msLevel = param.valueAs<int>();
+    param = spectrum.findCVParam(MS_ms_level);
+    if (!param) return boost::logic::indeterminate;
+    int msLevel = param->valueAs<int>();
     bool result = msLevelSet_.contains(msLevel);
     return result;
 }
@@ -325,13 +394,13 @@ PWIZ_API_DECL SpectrumList_FilterPredicate_ChargeStateSet::SpectrumList_FilterPr
 
 PWIZ_API_DECL boost::logic::tribool SpectrumList_FilterPredicate_ChargeStateSet::accept(const msdata::Spectrum& spectrum) const
 {
-    CVParam param = spectrum.cvParamChild(MS_spectrum_type);
-    if (param.cvid == CVID_Unknown) return boost::logic::indeterminate;
-    if (!cvIsA(param.cvid, MS_mass_spectrum))
+    const CVParam* param = spectrum.findCVParamChild(MS_spectrum_type);
+    if (!param) return boost::logic::indeterminate;
+    if (!cvIsA(param->cvid, MS_mass_spectrum))
         return true; // charge state filter doesn't affect non-MS spectra
-    param = spectrum.cvParam(MS_ms_level);
-    if (param.cvid == CVID_Unknown) return boost::logic::indeterminate;
-    int msLevel = param.valueAs<int>();
+    param = spectrum.findCVParam(MS_ms_level);
+    if (!param) return boost::logic::indeterminate;
+    int msLevel = param->valueAs<int>();
     if (msLevel == 1 || // MS1s don't have charge state
         spectrum.precursors.empty()) // can't do much without a precursor
         return false;
@@ -379,9 +448,9 @@ PWIZ_API_DECL boost::logic::tribool SpectrumList_FilterPredicate_PrecursorMzSet:
     double precursorMz = getPrecursorMz(spectrum);
     if (precursorMz == 0)
     {
-        CVParam param = spectrum.cvParam(MS_ms_level);
-        if (param.cvid == CVID_Unknown) return boost::logic::indeterminate;
-        int msLevel = param.valueAs<int>();
+        const CVParam* param = spectrum.findCVParam(MS_ms_level);
+        if (!param) return boost::logic::indeterminate;
+        int msLevel = param->valueAs<int>();
         // If not level 1, then it should have a precursor, so request more meta data.
         if (msLevel != 1) return boost::logic::indeterminate;
     }
@@ -405,16 +474,16 @@ PWIZ_API_DECL double SpectrumList_FilterPredicate_PrecursorMzSet::getPrecursorMz
             {
                 for (size_t j = 0; j < spectrum.precursors[i].selectedIons.size(); j++)
                 {
-                    CVParam param = spectrum.precursors[i].selectedIons[j].cvParam(MS_selected_ion_m_z);
-                    if (param.cvid != CVID_Unknown)
-                        return lexical_cast<double>(param.value);
+                    const CVParam* param = spectrum.precursors[i].selectedIons[j].findCVParam(MS_selected_ion_m_z);
+                    if (param)
+                        return lexical_cast<double>(param->value);
                 }
             }
             case TargetMode_Isolated:
             {
-                CVParam param = spectrum.precursors[i].isolationWindow.cvParam(MS_isolation_window_target_m_z);
-                if (param.cvid != CVID_Unknown)
-                    return lexical_cast<double>(param.value);
+                const CVParam* param = spectrum.precursors[i].isolationWindow.findCVParam(MS_isolation_window_target_m_z);
+                if (param)
+                    return lexical_cast<double>(param->value);
             }
         }
     }
@@ -461,14 +530,14 @@ PWIZ_API_DECL SpectrumList_FilterPredicate_ActivationType::SpectrumList_FilterPr
 
 PWIZ_API_DECL boost::logic::tribool SpectrumList_FilterPredicate_ActivationType::accept(const msdata::Spectrum& spectrum) const
 {
-    CVParam param = spectrum.cvParamChild(MS_spectrum_type);
-    if (param.cvid == CVID_Unknown) return boost::logic::indeterminate;
-    if (!cvIsA(param.cvid, MS_mass_spectrum))
+    const CVParam* param = spectrum.findCVParamChild(MS_spectrum_type);
+    if (!param) return boost::logic::indeterminate;
+    if (!cvIsA(param->cvid, MS_mass_spectrum))
         return true; // activation filter doesn't affect non-MS spectra
 
-    param = spectrum.cvParam(MS_ms_level);
-    if (param.cvid == CVID_Unknown) return boost::logic::indeterminate;
-    int msLevel = param.valueAs<int>();
+    param = spectrum.findCVParam(MS_ms_level);
+    if (!param) return boost::logic::indeterminate;
+    int msLevel = param->valueAs<int>();
 
     if (msLevel == 1)
         return true; // activation filter doesn't affect MS1 spectra
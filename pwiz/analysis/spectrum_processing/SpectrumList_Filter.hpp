@@ -75,6 +75,11 @@ class PWIZ_API_DECL SpectrumList_Filter : public msdata::SpectrumListWrapper
         /// increasing, ...)
         virtual bool done() const {return false;} 
 
+        /// can be overridden to return true by predicates whose accept(const Spectrum&) may be called
+        /// from several threads at once, and whose done() depends only on the SpectrumIdentity calls;
+        /// the spectra such a predicate needs are then retrieved concurrently (if the list allows it)
+        virtual bool isThreadSafe() const {return false;}
+
         virtual ~Predicate() {}
     };
 
@@ -144,6 +149,7 @@ class PWIZ_API_DECL SpectrumList_FilterPredicate_ScanEventSet : public SpectrumL
     SpectrumList_FilterPredicate_ScanEventSet(const util::IntegerSet& scanEventSet);
     virtual boost::logic::tribool accept(const msdata::SpectrumIdentity& spectrumIdentity) const {return boost::logic::indeterminate;}
     virtual boost::logic::tribool accept(const msdata::Spectrum& spectrum) const;
+    virtual bool isThreadSafe() const {return true;}
 
     private:
     util::IntegerSet scanEventSet_;
@@ -156,6 +162,7 @@ class PWIZ_API_DECL SpectrumList_FilterPredicate_ScanTimeRange : public Spectrum
     SpectrumList_FilterPredicate_ScanTimeRange(double scanTimeLow, double scanTimeHigh);
     virtual boost::logic::tribool accept(const msdata::SpectrumIdentity& spectrumIdentity) const;
     virtual boost::logic::tribool accept(const msdata::Spectrum& spectrum) const;
+    virtual bool isThreadSafe() const {return true;}
 
     private:
     double scanTimeLow_;
@@ -169,6 +176,7 @@ class PWIZ_API_DECL SpectrumList_FilterPredicate_MSLevelSet : public SpectrumLis
     SpectrumList_FilterPredicate_MSLevelSet(const util::IntegerSet& msLevelSet);
     virtual boost::logic::tribool accept(const msdata::SpectrumIdentity& spectrumIdentity) const {return boost::logic::indeterminate;}
     virtual boost::logic::tribool accept(const msdata::Spectrum& spectrum) const;
+    virtual bool isThreadSafe() const {return true;}
 
     private:
     util::IntegerSet msLevelSet_;
@@ -181,6 +189,7 @@ class PWIZ_API_DECL SpectrumList_FilterPredicate_ChargeStateSet : public Spectru
     SpectrumList_FilterPredicate_ChargeStateSet(const util::IntegerSet& chargeStateSet);
     virtual boost::logic::tribool accept(const msdata::SpectrumIdentity& spectrumIdentity) const {return boost::logic::indeterminate;}
     virtual boost::logic::tribool accept(const msdata::Spectrum& spectrum) const;
+    virtual bool isThreadSafe() const {return true;}
 
     private:
     util::IntegerSet chargeStateSet_;
@@ -200,6 +209,7 @@ class PWIZ_API_DECL SpectrumList_FilterPredicate_PrecursorMzSet : public Spectru
     SpectrumList_FilterPredicate_PrecursorMzSet(const std::set<double>& precursorMzSet, chemistry::MZTolerance tolerance, FilterMode mode, TargetMode target = TargetMode_Selected);
     virtual boost::logic::tribool accept(const msdata::SpectrumIdentity& spectrumIdentity) const {return boost::logic::indeterminate;}
     virtual boost::logic::tribool accept(const msdata::Spectrum& spectrum) const;
+    virtual bool isThreadSafe() const {return true;}
 
     private:
     std::set<double> precursorMzSet_;
@@ -217,6 +227,7 @@ class PWIZ_API_DECL SpectrumList_FilterPredicate_DefaultArrayLengthSet : public
     SpectrumList_FilterPredicate_DefaultArrayLengthSet(const util::IntegerSet& defaultArrayLengthSet);
     virtual boost::logic::tribool accept(const msdata::SpectrumIdentity& spectrumIdentity) const {return boost::logic::indeterminate;}
     virtual boost::logic::tribool accept(const msdata::Spectrum& spectrum) const;
+    virtual bool isThreadSafe() const {return true;}
 
     private:
     util::IntegerSet defaultArrayLengthSet_;
@@ -229,6 +240,7 @@ class PWIZ_API_DECL SpectrumList_FilterPredicate_ActivationType : public Spectru
     SpectrumList_FilterPredicate_ActivationType(const std::set<pwiz::cv::CVID> filterItem, bool hasNoneOf_ = false);
     virtual boost::logic::tribool accept(const msdata::SpectrumIdentity& spectrumIdentity) const {return boost::logic::indeterminate;}
     virtual boost::logic::tribool accept(const msdata::Spectrum& spectrum) const;
+    virtual bool isThreadSafe() const {return true;}
 
     private:
     std::set<pwiz::cv::CVID> cvFilterItems;
@@ -242,6 +254,7 @@ class PWIZ_API_DECL SpectrumList_FilterPredicate_AnalyzerType : public SpectrumL
     SpectrumList_FilterPredicate_AnalyzerType(const std::set<pwiz::cv::CVID> filterItem);
     virtual boost::logic::tribool accept(const msdata::SpectrumIdentity& spectrumIdentity) const {return boost::logic::indeterminate;}
     virtual boost::logic::tribool accept(const msdata::Spectrum& spectrum) const;
+    virtual bool isThreadSafe() const {return true;}
 
     private:
     std::set<pwiz::cv::CVID> cvFilterItems;
@@ -254,6 +267,7 @@ class PWIZ_API_DECL SpectrumList_FilterPredicate_Polarity : public SpectrumList_
     SpectrumList_FilterPredicate_Polarity(pwiz::cv::CVID polarity);
     virtual boost::logic::tribool accept(const msdata::SpectrumIdentity& spectrumIdentity) const {return boost::logic::indeterminate;}
     virtual boost::logic::tribool accept(const msdata::Spectrum& spectrum) const;
+    virtual bool isThreadSafe() const {return true;}
 
     private:
     pwiz::cv::CVID polarity;
@@ -268,6 +282,7 @@ class PWIZ_API_DECL SpectrumList_FilterPredicate_MzPresent : public SpectrumList
     virtual msdata::DetailLevel suggestedDetailLevel() const {return msdata::DetailLevel_FullData;}
     virtual boost::logic::tribool accept(const msdata::SpectrumIdentity& spectrumIdentity) const {return boost::logic::indeterminate;}
     virtual boost::logic::tribool accept(const msdata::Spectrum& spectrum) const;
+    virtual bool isThreadSafe() const {return true;}
 
     private:
     chemistry::MZTolerance mzt_;
@@ -282,6 +297,7 @@ class PWIZ_API_DECL SpectrumList_FilterPredicate_ThermoScanFilter : public Spect
     SpectrumList_FilterPredicate_ThermoScanFilter(const std::string& matchString, bool matchExact, bool inverse);
     virtual boost::logic::tribool accept(const msdata::SpectrumIdentity& spectrumIdentity) const {return boost::logic::indeterminate;}
     virtual boost::logic::tribool accept(const msdata::Spectrum& spectrum) const;
+    virtual bool isThreadSafe() const {return true;}
 
     private:
     std::string matchString_;
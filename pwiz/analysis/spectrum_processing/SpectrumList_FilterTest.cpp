@@ -27,6 +27,7 @@
 #include "pwiz/utility/misc/Std.hpp"
 #include "pwiz/data/msdata/examples.hpp"
 #include "pwiz/data/msdata/Serializer_mzML.hpp"
+#include "pwiz/data/msdata/SpectrumWorkerThreads.hpp"
 #include <cstring>
 
 
@@ -759,6 +760,40 @@ void testThermoFilterFilter(SpectrumListPtr sl)
     unit_assert(filter5.spectrumIdentity(7).id == "scan=108");
 }
 
+void testConcurrentClassification()
+{
+    if (os_) *os_ << "testConcurrentClassification:\n";
+
+    // enough spectra to span several chunks of the concurrent pre-pass
+    SpectrumListSimplePtr sl(new SpectrumListSimple);
+    for (size_t i=0; i<5000; ++i)
+    {
+        SpectrumPtr spectrum(new Spectrum);
+        spectrum->index = i;
+        spectrum->id = "scan=" + lexical_cast<string>(i+1);
+        spectrum->set(i%7==0 ? MS_MS1_spectrum : MS_MSn_spectrum);
+        spectrum->set(MS_ms_level, i%7==0 ? 1 : 2);
+        sl->spectra.push_back(spectrum);
+    }
+
+    IntegerSet msLevelSet;
+    msLevelSet.insert(1);
+
+    SpectrumWorkerThreads::setDefaultThreadCount(1);
+    SpectrumList_Filter serialFilter(sl, SpectrumList_FilterPredicate_MSLevelSet(msLevelSet));
+    SpectrumWorkerThreads::setDefaultThreadCount(4);
+    SpectrumList_Filter concurrentFilter(sl, SpectrumList_FilterPredicate_MSLevelSet(msLevelSet));
+    SpectrumWorkerThreads::setDefaultThreadCount(0);
+
+    unit_assert_operator_equal(715, serialFilter.size());
+    unit_assert_operator_equal(serialFilter.size(), concurrentFilter.size());
+    for (size_t i=0; i < serialFilter.size(); ++i)
+    {
+        unit_assert_operator_equal("scan=" + lexical_cast<string>(i*7+1), concurrentFilter.spectrumIdentity(i).id);
+        unit_assert_operator_equal(serialFilter.spectrumIdentity(i).id, concurrentFilter.spectrumIdentity(i).id);
+    }
+}
+
 void test()
 {
     SpectrumListPtr sl = createSpectrumList();
@@ -775,6 +810,7 @@ void test()
     testMassAnalyzerFilter(sl);
     testMZPresentFilter(sl);
     testThermoFilterFilter(sl);
+    testConcurrentClassification();
 }
 
 
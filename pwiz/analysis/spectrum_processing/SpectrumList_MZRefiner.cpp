@@ -1875,6 +1875,7 @@ void SpectrumList_MZRefiner::Impl::getMSDataData(const MSData& msd, pwiz::util::
                 {
                     s = sl->spectrum(i, true); // Need binary data for MSn error calculation.
                 }
+                s->storeBinaryDataAsFloat64();
                 // Add fragmentation ion data to the ms2Data for a separate shift.
                 fragmentationIonPpmErrors(datum->peptideSeq, datum->peptideSeqLength, s);
             }
@@ -2403,6 +2404,7 @@ PWIZ_API_DECL SpectrumPtr SpectrumList_MZRefiner::spectrum(size_t index, bool ge
         return inner_->spectrum(index, getBinaryData);
     }
     SpectrumPtr originalSpectrum = inner_->spectrum(index, getBinaryData);  
+    originalSpectrum->storeBinaryDataAsFloat64();
     
     // Determine if is High-res scan, and get the start time as well - they should both be available in the scans
     bool isHighRes = false;
@@ -2439,19 +2441,19 @@ PWIZ_API_DECL SpectrumPtr SpectrumList_MZRefiner::spectrum(size_t index, bool ge
         if (it != originalSpectrum->cvParams.end())
         {
             value = adjust->shift(scanTime, it->valueAs<double>());
-            it->value = boost::lexical_cast<std::string>(value);
+            it->setValue(boost::lexical_cast<std::string>(value));
         }
         it = find_if(originalSpectrum->cvParams.begin(), originalSpectrum->cvParams.end(), CVParamIs(MS_lowest_observed_m_z));
         if (it != originalSpectrum->cvParams.end())
         {
             value = adjust->shift(scanTime, it->valueAs<double>());
-            it->value = boost::lexical_cast<std::string>(value);
+            it->setValue(boost::lexical_cast<std::string>(value));
         }
         it = find_if(originalSpectrum->cvParams.begin(), originalSpectrum->cvParams.end(), CVParamIs(MS_highest_observed_m_z));
         if (it != originalSpectrum->cvParams.end())
         {
             value = adjust->shift(scanTime, it->valueAs<double>());
-            it->value = boost::lexical_cast<std::string>(value);
+            it->setValue(boost::lexical_cast<std::string>(value));
         }
 
         // Adjust the spectrum data (all m/z values)
@@ -2487,7 +2489,7 @@ PWIZ_API_DECL SpectrumPtr SpectrumList_MZRefiner::spectrum(size_t index, bool ge
             if (it != p.isolationWindow.cvParams.end())
             {
                 value = impl_->adjust->shift(pScanTime, it->valueAs<double>());
-                it->value = boost::lexical_cast<std::string>(value);
+                it->setValue(boost::lexical_cast<std::string>(value));
             }
             BOOST_FOREACH(SelectedIon &si, p.selectedIons)
             {
@@ -2495,7 +2497,7 @@ PWIZ_API_DECL SpectrumPtr SpectrumList_MZRefiner::spectrum(size_t index, bool ge
                 if (it != si.cvParams.end())
                 {
                     value = impl_->adjust->shift(pScanTime, it->valueAs<double>());
-                    it->value = boost::lexical_cast<std::string>(value);
+                    it->setValue(boost::lexical_cast<std::string>(value));
                 }
             }
         }
@@ -71,6 +71,7 @@ PWIZ_API_DECL SpectrumPtr SpectrumList_MetadataFixer::spectrum(size_t index, boo
 {
     // always get binary data
     SpectrumPtr s = inner_->spectrum(index, true);
+    s->storeBinaryDataAsFloat64();
 
     BinaryDataArrayPtr mzArray = s->getMZArray();
     BinaryDataArrayPtr intensityArray = s->getIntensityArray();
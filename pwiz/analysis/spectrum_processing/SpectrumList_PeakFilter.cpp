@@ -71,6 +71,7 @@ PWIZ_API_DECL SpectrumPtr SpectrumList_PeakFilter::spectrum(size_t index, Detail
     }
 
     const SpectrumPtr currentSpectrum = inner_->spectrum(index, true);
+    currentSpectrum->storeBinaryDataAsFloat64(); // the filters modify the arrays in place
     (*filterFunctor_)(currentSpectrum);
     currentSpectrum->dataProcessingPtr = dp_;
     return currentSpectrum;
@@ -246,6 +246,7 @@ PWIZ_API_DECL SpectrumPtr SpectrumList_PeakPicker::spectrum(size_t index, bool g
     // make sure the spectrum has binary data
     if (!s->getMZArray().get() || !s->getIntensityArray().get())
         s = inner_->spectrum(index, true);
+    s->storeBinaryDataAsFloat64();
 
     // replace profile or nonspecific term with centroid term; if spectrum representation is in a paramGroup, we migrate those parameters to the spectrum itself
     if (specRepParamGroup)
@@ -208,28 +208,30 @@ void SpectrumList_ScanSummer::sumSubScansNaive( vector<double> & x, vector<doubl
     for( vector<int>::const_iterator listIt = InitialIt; listIt != precursorGroupPtr->indexList.end(); ++listIt)
     {
         SpectrumPtr s2 = inner_->spectrum( *listIt, detailLevel );
-        vector<double>& subMz = s2->getMZArray()->data;
-        vector<double>& subIntensity = s2->getIntensityArray()->data;
+        const BinaryDataArray& subMzArray = *s2->getMZArray();
+        const BinaryDataArray& subIntensityArray = *s2->getIntensityArray();
 
-        for( size_t j=0, jend=subMz.size(); j < jend ; ++j)
+        for( size_t j=0, jend=subMzArray.size(); j < jend ; ++j)
         {
+            double subMz = subMzArray.value(j);
+            double subIntensity = subIntensityArray.value(j);
             // check if this m/z point was recorded from a previous sub-scan
             vector<double>::iterator pIonIt;
-            pIonIt = lower_bound(summedMZ.begin(), summedMZ.end(), subMz[j] - 1e-2); // first element that is greater than or equal to subMz[j]
+            pIonIt = lower_bound(summedMZ.begin(), summedMZ.end(), subMz - 1e-2); // first element that is greater than or equal to subMz
             int indexMZ = pIonIt - summedMZ.begin();
             if (pIonIt == summedMZ.end()) // first check if mzs[j] is outside search range
             {
-                summedMZ.push_back(subMz[j]);
-                summedIntensity.push_back(subIntensity[j]);
+                summedMZ.push_back(subMz);
+                summedIntensity.push_back(subIntensity);
             }
-            else if (fabs(*pIonIt - subMz[j]) > 1e-2) // if the closest value is not equal to mzs[i], start a new m/z point
+            else if (fabs(*pIonIt - subMz) > 1e-2) // if the closest value is not equal to mzs[i], start a new m/z point
             {
-                summedMZ.insert(pIonIt,subMz[j]);
-                summedIntensity.insert(summedIntensity.begin()+indexMZ,subIntensity[j]);
+                summedMZ.insert(pIonIt,subMz);
+                summedIntensity.insert(summedIntensity.begin()+indexMZ,subIntensity);
             }
             else // m/z value recorded from previous sub-scan for this precursor; calculate the sum
             {
-                summedIntensity[indexMZ] += subIntensity[j];
+                summedIntensity[indexMZ] += subIntensity;
             }
         }
     }
@@ -373,6 +375,8 @@ PWIZ_API_DECL SpectrumPtr SpectrumList_ScanSummer::spectrum(size_t index, Detail
             // keep only first scan
             summedSpectrum->scanList.scans.erase(summedSpectrum->scanList.scans.begin() + 1, summedSpectrum->scanList.scans.end());
 
+            summedSpectrum->getMZArray()->storeAsFloat64();
+            summedSpectrum->getIntensityArray()->storeAsFloat64();
             vector<double>& mzs = summedSpectrum->getMZArray()->data;
             vector<double>& intensities = summedSpectrum->getIntensityArray()->data;
             sumSubScansNaive(mzs, intensities, precursorGroupPtr, DetailLevel_FullData);
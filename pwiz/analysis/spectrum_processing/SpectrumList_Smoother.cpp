@@ -71,6 +71,7 @@ PWIZ_API_DECL SpectrumPtr SpectrumList_Smoother::spectrum(size_t index, bool get
     //    return inner_->spectrum(index, false);
 
     SpectrumPtr s = inner_->spectrum(index, true);
+    s->storeBinaryDataAsFloat64();
 
     vector<CVParam>& cvParams = s->cvParams;
     vector<CVParam>::iterator itr = std::find(cvParams.begin(), cvParams.end(), MS_profile_spectrum);
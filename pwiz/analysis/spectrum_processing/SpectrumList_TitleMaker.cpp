@@ -59,7 +59,7 @@ void replaceCvParam(ParamContainer& pc, CVID cvid, const value_type& value)
     if (itr == pc.cvParams.end())
         pc.set(cvid, value);
     else
-        itr->value = lexical_cast<string>(value);
+        itr->setValue(lexical_cast<string>(value));
 }
 
 // TODO: Make this a public function? It's copied and modified from Serializer_mzXML.cpp;
@@ -75,6 +75,7 @@ PWIZ_API_DECL bool SpectrumList_ZeroSamplesFilter::accept(const msdata::Spectrum
 PWIZ_API_DECL SpectrumPtr SpectrumList_ZeroSamplesFilter::spectrum(size_t index, bool getBinaryData) const
 {
     SpectrumPtr s = inner_->spectrum(index, true);
+    s->storeBinaryDataAsFloat64();
 
     if (!msLevelsToFilter_.contains(s->cvParam(MS_ms_level).valueAs<int>()))
         return s;
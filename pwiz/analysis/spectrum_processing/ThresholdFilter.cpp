@@ -244,6 +244,8 @@ PWIZ_API_DECL void ThresholdFilter::operator () (const SpectrumPtr& s) const
     if (!msLevelsToThreshold.contains(s->cvParam(MS_ms_level).valueAs<int>()))
         return;
 
+    s->storeBinaryDataAsFloat64();
+
     // do nothing to empty spectra
     if (s->defaultArrayLength == 0)
         return;
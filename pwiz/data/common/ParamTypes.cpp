@@ -40,6 +40,21 @@ namespace data {
 
 PWIZ_API_DECL CVParam::~CVParam() {}
 
+PWIZ_API_DECL void CVParam::storeNumber()
+{
+    numberTextLength_ = 0;
+    if (value.empty() || value.length() > maxNumberTextLength_ ||
+        !(isdigit((unsigned char) value[0]) || value[0] == '-' || value[0] == '+' || value[0] == '.'))
+        return;
+
+    bool success;
+    number_ = boost::lexical_cast<double>(value, success);
+    if (!success)
+        return;
+    memcpy(numberText_, value.data(), value.length());
+    numberTextLength_ = (unsigned char) value.length();
+}
+
 PWIZ_API_DECL string CVParam::name() const
 {
     return cvTermInfo(cvid).name;
@@ -177,49 +192,63 @@ PWIZ_API_DECL bool UserParam::operator!=(const UserParam& that) const
 //
 
 
-PWIZ_API_DECL CVParam ParamContainer::cvParam(CVID cvid) const
+PWIZ_API_DECL const CVParam* ParamContainer::findCVParam(CVID cvid) const
 {
     // first look in our own cvParams
 
     vector<CVParam>::const_iterator it = 
         find_if(cvParams.begin(), cvParams.end(), CVParamIs(cvid));
    
-    if (it!=cvParams.end()) return *it;
+    if (it!=cvParams.end()) return &*it;
 
     // then recurse into paramGroupPtrs
 
     for (vector<ParamGroupPtr>::const_iterator jt=paramGroupPtrs.begin();
          jt!=paramGroupPtrs.end(); ++jt)
     {
-        CVParam result = jt->get() ? (*jt)->cvParam(cvid) : CVParam();
-        if (result.cvid != CVID_Unknown)
+        const CVParam* result = jt->get() ? (*jt)->findCVParam(cvid) : 0;
+        if (result)
             return result;
     }
 
-    return CVParam();
+    return 0;
 }
 
 
-PWIZ_API_DECL CVParam ParamContainer::cvParamChild(CVID cvid) const
+PWIZ_API_DECL const CVParam* ParamContainer::findCVParamChild(CVID cvid) const
 {
     // first look in our own cvParams
 
     vector<CVParam>::const_iterator it = 
         find_if(cvParams.begin(), cvParams.end(), CVParamIsChildOf(cvid));
    
-    if (it!=cvParams.end()) return *it;
+    if (it!=cvParams.end()) return &*it;
 
     // then recurse into paramGroupPtrs
 
     for (vector<ParamGroupPtr>::const_iterator jt=paramGroupPtrs.begin();
          jt!=paramGroupPtrs.end(); ++jt)
     {
-        CVParam result = jt->get() ? (*jt)->cvParamChild(cvid) : CVParam();
-        if (result.cvid != CVID_Unknown)
+        const CVParam* result = jt->get() ? (*jt)->findCVParamChild(cvid) : 0;
+        if (result)
             return result;
     }
 
-    return CVParam();
+    return 0;
+}
+
+
+PWIZ_API_DECL CVParam ParamContainer::cvParam(CVID cvid) const
+{
+    const CVParam* result = findCVParam(cvid);
+    return result ? *result : CVParam();
+}
+
+
+PWIZ_API_DECL CVParam ParamContainer::cvParamChild(CVID cvid) const
+{
+    const CVParam* result = findCVParamChild(cvid);
+    return result ? *result : CVParam();
 }
 
 
@@ -251,15 +280,13 @@ PWIZ_API_DECL vector<CVParam> ParamContainer::cvParamChildren(CVID cvid) const
 
 PWIZ_API_DECL bool ParamContainer::hasCVParam(CVID cvid) const
 {
-    CVParam param = cvParam(cvid);
-    return (param.cvid != CVID_Unknown);
+    return findCVParam(cvid) != 0;
 }
 
 
 PWIZ_API_DECL bool ParamContainer::hasCVParamChild(CVID cvid) const
 {
-    CVParam param = cvParamChild(cvid);
-    return (param.cvid != CVID_Unknown);
+    return findCVParamChild(cvid) != 0;
 }
 
 
@@ -287,7 +314,7 @@ PWIZ_API_DECL void ParamContainer::set(CVID cvid, const string& value, CVID unit
    
     if (it!=cvParams.end())
     {
-        it->value = value;
+        it->setValue(value);
         it->units = units;
         return;
     }
@@ -30,6 +30,7 @@
 #include "cv.hpp"
 #include <iosfwd>
 #include <vector>
+#include <cstring>
 #include <boost/shared_ptr.hpp>
 
 
@@ -44,6 +45,11 @@ using namespace pwiz::cv;
 struct PWIZ_API_DECL CVParam
 {
     CVID cvid;
+
+    /// the value as text; a number is also stored parsed when the value is set by a constructor
+    /// or setValue(), so that valueAs<double>() need not parse it again; the stored number is only
+    /// used while value still holds the text it was parsed from, so assigning value directly is safe
+    /// (it is parsed on each valueAs() call until setValue() is used)
     std::string value;
     CVID units;
 
@@ -51,63 +57,71 @@ struct PWIZ_API_DECL CVParam
     :   cvid(_cvid), 
         value(boost::lexical_cast<std::string>(_value)),
         units(_units)
-    {}
+    {storeNumber();}
 
     CVParam(CVID _cvid, double _value, CVID _units = CVID_Unknown)
     :   cvid(_cvid), 
         value(boost::lexical_cast<std::string>(_value)),
         units(_units)
-    {}
+    {storeNumber();}
 
     CVParam(CVID _cvid, int _value, CVID _units = CVID_Unknown)
     :   cvid(_cvid), 
         value(boost::lexical_cast<std::string>(_value)),
         units(_units)
-    {}
+    {storeNumber();}
 
     CVParam(CVID _cvid, long _value, CVID _units = CVID_Unknown)
     :   cvid(_cvid), 
         value(boost::lexical_cast<std::string>(_value)),
         units(_units)
-    {}
+    {storeNumber();}
 
     CVParam(CVID _cvid, unsigned int _value, CVID _units = CVID_Unknown)
     :   cvid(_cvid), 
         value(boost::lexical_cast<std::string>(_value)),
         units(_units)
-    {}
+    {storeNumber();}
 
     CVParam(CVID _cvid, unsigned long _value, CVID _units = CVID_Unknown)
     :   cvid(_cvid), 
         value(boost::lexical_cast<std::string>(_value)),
         units(_units)
-    {}
+    {storeNumber();}
 
     CVParam(CVID _cvid, std::string _value, CVID _units = CVID_Unknown)
     :   cvid(_cvid), 
         value(_value),
         units(_units)
-    {}
+    {storeNumber();}
 
     CVParam(CVID _cvid, const char* _value, CVID _units = CVID_Unknown)
     :   cvid(_cvid), 
         value(_value),
         units(_units)
-    {}
+    {storeNumber();}
 
     /// special case for bool (no lexical_cast)
     CVParam(CVID _cvid, bool _value, CVID _units = CVID_Unknown)
-    :   cvid(_cvid), value(_value ? "true" : "false"), units(_units)
+    :   cvid(_cvid), value(_value ? "true" : "false"), units(_units), numberTextLength_(0)
     {}
 
     /// constructor for non-valued CVParams
     CVParam(CVID _cvid = CVID_Unknown)
-    :   cvid(_cvid), units(CVID_Unknown)
+    :   cvid(_cvid), units(CVID_Unknown), numberTextLength_(0)
     {}
 
     ~CVParam();
 
+    /// sets value, and the stored number if it is one
+    void setValue(const std::string& _value)
+    {
+        value = _value;
+        storeNumber();
+    }
+
     /// templated value access with type conversion
+    /// - valueAs<double>() and valueAs<float>() use the stored number (see value); other types parse value
     template<typename value_type>
     value_type valueAs() const
     {
@@ -140,6 +154,25 @@ struct PWIZ_API_DECL CVParam
     }
 
     bool empty() const {return cvid==CVID_Unknown && value.empty() && units==CVID_Unknown;}
+
+    private:
+
+    // parses value into number_ if it is a short enough number, keeping a copy of the text
+    void storeNumber();
+
+    // returns true if number_ was parsed from the current value
+    bool hasStoredNumber() const
+    {
+        return numberTextLength_ > 0 && numberTextLength_ == value.length() &&
+               memcmp(numberText_, value.data(), numberTextLength_) == 0;
+    }
+
+    // room for any double formatted with 17 significant digits
+    static const size_t maxNumberTextLength_ = 23;
+
+    double number_;
+    unsigned char numberTextLength_; // 0 if no number is stored
+    char numberText_[maxNumberTextLength_];
 };
 
 
@@ -178,6 +211,25 @@ inline bool CVParam::valueAs<bool>() const
 }
 
 
+/// special cases for floating point types, which use the stored number
+/// (its conversion to float is the same as lexical_cast<float>, which also parses a double)
+template<>
+inline double CVParam::valueAs<double>() const
+{
+    if (hasStoredNumber())
+        return number_;
+    return !value.empty() ? boost::lexical_cast<double>(value) : 0.0;
+}
+
+template<>
+inline float CVParam::valueAs<float>() const
+{
+    if (hasStoredNumber())
+        return (float) number_;
+    return !value.empty() ? boost::lexical_cast<float>(value) : 0.0f;
+}
+
+
 PWIZ_API_DECL std::ostream& operator<<(std::ostream& os, const CVParam& param);
 
 
@@ -264,26 +316,40 @@ struct PWIZ_API_DECL ParamContainer
     /// - recursive: looks into paramGroupPtrs
     CVParam cvParamChild(CVID cvid) const;
 
+    /// finds cvid in the container without copying it:
+    /// - returns a pointer to the first CVParam result such that (result.cvid == cvid); 
+    /// - if not found, returns null
+    /// - recursive: looks into paramGroupPtrs
+    const CVParam* findCVParam(CVID cvid) const;
+
+    /// finds child of cvid in the container without copying it:
+    /// - returns a pointer to the first CVParam result such that (result.cvid is_a cvid); 
+    /// - if not found, returns null
+    /// - recursive: looks into paramGroupPtrs
+    const CVParam* findCVParamChild(CVID cvid) const;
+
     /// finds cvid in the container:
     /// - returns first CVParam result's value such that (result.cvid == cvid); 
     /// - if not found, returns the given default value
     /// - recursive: looks into paramGroupPtrs
+    /// - the value is converted in place, without copying the CVParam
     template<typename ValueT>
     ValueT cvParamValueOrDefault(CVID cvid, ValueT defaultValue) const
     {
-        CVParam p = cvParam(cvid);
-        return p.empty() ? defaultValue : p.valueAs<ValueT>();
+        const CVParam* p = findCVParam(cvid);
+        return p ? p->valueAs<ValueT>() : defaultValue;
     }
 
     /// finds child of cvid in the container:
     /// - returns first CVParam result's value such that (result.cvid is_a cvid); 
     /// - if not found, returns the given default value
     /// - recursive: looks into paramGroupPtrs
+    /// - the value is converted in place, without copying the CVParam
     template<typename ValueT>
-    CVParam cvParamChildValueOrDefault(CVID cvid, ValueT defaultValue) const
+    ValueT cvParamChildValueOrDefault(CVID cvid, ValueT defaultValue) const
     {
-        CVParam p = cvParamChild(cvid);
-        return p.empty() ? defaultValue : p.valueAs<ValueT>();
+        const CVParam* p = findCVParamChild(cvid);
+        return p ? p->valueAs<ValueT>() : defaultValue;
     }
 
     /// finds all children of cvid in the container:
@@ -236,6 +236,20 @@ void testParamContainer()
     unit_assert(userParam.units == UO_minute);
     unit_assert(pc.userParam("goober").valueAs<int>() == 0);
 
+    unit_assert(pc.findCVParam(MS_reflectron_off) == &pc.cvParams[2]);
+    unit_assert(pc.findCVParam(UO_dalton) == &pg->cvParams[0]);
+    unit_assert(pc.findCVParam(MS_selected_ion_m_z) == 0);
+    unit_assert(pc.findCVParamChild(MS_spectrum_type) == &pc.cvParams[1]);
+    unit_assert(pc.findCVParamChild(UO_mass_unit) == &pg->cvParams[0]);
+    unit_assert(pc.findCVParamChild(MS_scan_polarity) == 0);
+
+    unit_assert_operator_equal(420, pc.cvParamValueOrDefault(MS_ionization_type, 0));
+    unit_assert_operator_equal(666.0, pc.cvParamValueOrDefault(UO_dalton, 0.0));
+    unit_assert_operator_equal(-1, pc.cvParamValueOrDefault(MS_selected_ion_m_z, -1));
+    unit_assert_operator_equal(0, pc.cvParamValueOrDefault(MS_reflectron_off, -1)); // present without a value
+    unit_assert_operator_equal(666, pc.cvParamChildValueOrDefault(UO_mass_unit, 0));
+    unit_assert_operator_equal(-1.5, pc.cvParamChildValueOrDefault(MS_scan_polarity, -1.5));
+
     pc.set(MS_ms_level, 2);
     unit_assert(pc.cvParam(MS_ms_level).valueAs<int>() == 2);
     pc.set(MS_ms_level, 3);
@@ -257,6 +271,53 @@ void testParamContainer()
 }
 
 
+void testStoredNumber()
+{
+    // the number is stored by the constructors and setValue()
+    CVParam mz(MS_selected_ion_m_z, "445.34");
+    unit_assert_operator_equal(445.34, mz.valueAs<double>());
+    unit_assert_operator_equal(445.34f, mz.valueAs<float>());
+    unit_assert_operator_equal(445, mz.valueAs<int>());
+
+    mz.setValue("1234.5678");
+    unit_assert_operator_equal(1234.5678, mz.valueAs<double>());
+    unit_assert_operator_equal(1234.5678f, mz.valueAs<float>());
+
+    // assigning value directly bypasses the stored number, which is then not used
+    mz.value = "1234.5679";
+    unit_assert_operator_equal(1234.5679, mz.valueAs<double>());
+    mz.value = "goober";
+    unit_assert_throws(mz.valueAs<double>(), boost::bad_lexical_cast);
+    mz.value.clear();
+    unit_assert_operator_equal(0.0, mz.valueAs<double>());
+
+    // non-numeric and overlong values are parsed as before
+    mz.setValue("goober");
+    unit_assert_throws(mz.valueAs<double>(), boost::bad_lexical_cast);
+    mz.setValue("1.23456789012345678901234");
+    unit_assert_operator_equal(1.23456789012345678901234, mz.valueAs<double>());
+    mz.setValue("-5e-3");
+    unit_assert_operator_equal(-5e-3, mz.valueAs<double>());
+
+    unit_assert_operator_equal(2.5, CVParam(MS_scan_start_time, 2.5).valueAs<double>());
+    unit_assert_operator_equal(7.0, CVParam(MS_ms_level, 7).valueAs<double>());
+    unit_assert_operator_equal(0.0, CVParam(MS_reflectron_on).valueAs<double>());
+
+    // copies keep the stored number with the text
+    CVParam copy = mz;
+    mz.setValue("1");
+    unit_assert_operator_equal(-5e-3, copy.valueAs<double>());
+    unit_assert_operator_equal(1.0, mz.valueAs<double>());
+
+    // ParamContainer::set keeps the stored number in step with the text
+    ParamContainer pc;
+    pc.set(MS_selected_ion_m_z, 445.34);
+    unit_assert_operator_equal(445.34, pc.cvParam(MS_selected_ion_m_z).valueAs<double>());
+    pc.set(MS_selected_ion_m_z, 500.25);
+    unit_assert_operator_equal(500.25, pc.cvParam(MS_selected_ion_m_z).valueAs<double>());
+}
+
+
 int main(int argc, char* argv[])
 {
     TEST_PROLOG(argc, argv)
@@ -268,6 +329,7 @@ int main(int argc, char* argv[])
         testIs();
         testIsChildOf();
         testParamContainer();
+        testStoredNumber();
     }
     catch (exception& e)
     {
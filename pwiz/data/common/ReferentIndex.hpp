@@ -0,0 +1,104 @@
+//
+// $Id$
+//
+//
+// Original author: agent <agent@local>
+//
+// Copyright 2026
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef _REFERENTINDEX_HPP_
+#define _REFERENTINDEX_HPP_
+
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <boost/shared_ptr.hpp>
+
+
+namespace pwiz {
+namespace data {
+
+
+/// id lookups into lists of objects with an 'id' member, for resolving many references into the
+/// same lists (e.g. every PeptideEvidence of a document, or the spectra of a file as they are read):
+/// - add() hashes a list by id; the list must stay alive while the index is used
+/// - find() searches lists that were not added, are short, or have changed size linearly, and checks
+///   the id of a hashed match against the list
+/// - once all lists are added, the index is not modified and find() may be called from several threads
+class ReferentIndex
+{
+    public:
+
+    /// lists shorter than this are searched linearly rather than hashed
+    static const size_t MinHashedSize = 16;
+
+    /// hashes referentList by id, keeping the first of any objects with the same id
+    template <typename object_type>
+    void add(const std::vector< boost::shared_ptr<object_type> >& referentList)
+    {
+        if (referentList.size() < MinHashedSize)
+            return;
+
+        Positions& positions = lists_[&referentList];
+        positions.listSize = referentList.size();
+        positions.byId.clear();
+        positions.byId.reserve(referentList.size());
+        for (size_t i=0; i < referentList.size(); ++i)
+            if (referentList[i].get())
+                positions.byId.insert(std::make_pair(referentList[i]->id, i));
+    }
+
+    /// returns the first object in referentList with the given id, or null if there is none
+    template <typename object_type>
+    const boost::shared_ptr<object_type>* find(const std::vector< boost::shared_ptr<object_type> >& referentList,
+                                               const std::string& id) const
+    {
+        std::map<const void*, Positions>::const_iterator list = lists_.find(&referentList);
+        if (list != lists_.end() && list->second.listSize == referentList.size())
+        {
+            IdPositions::const_iterator it = list->second.byId.find(id);
+            if (it != list->second.byId.end() && referentList[it->second].get() && referentList[it->second]->id == id)
+                return &referentList[it->second];
+        }
+
+        // not hashed, changed since it was hashed, or no such id
+        for (size_t i=0; i < referentList.size(); ++i)
+            if (referentList[i].get() && referentList[i]->id == id)
+                return &referentList[i];
+        return 0;
+    }
+
+    private:
+
+    typedef std::unordered_map<std::string, size_t> IdPositions;
+
+    struct Positions
+    {
+        size_t listSize;
+        IdPositions byId;
+    };
+
+    std::map<const void*, Positions> lists_;
+};
+
+
+} // namespace data
+} // namespace pwiz
+
+
+#endif // _REFERENTINDEX_HPP_
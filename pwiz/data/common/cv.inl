@@ -67,13 +67,120 @@ PWIZ_API_DECL string CVTermInfo::prefix() const
 }
 
 
+namespace {
+
+/// dense indices for the terms of CVTermData, with the transitive is_a ancestors of each term,
+/// so that cvTermInfo(CVID) is a table lookup and cvIsA() a search of a short sorted list
+class CVTermIndex : public boost::singleton<CVTermIndex>
+{
+    public:
+
+    CVTermIndex(boost::restricted) : unknownIndex_(-1)
+    {
+        const map<CVID,CVTermInfo>& infoMap = CVTermData::instance->infoMap();
+        terms_.reserve(infoMap.size());
+        for (map<CVID,CVTermInfo>::const_iterator it=infoMap.begin(); it!=infoMap.end(); ++it)
+        {
+            addIndex(it->first, (int) terms_.size());
+            terms_.push_back(&it->second);
+        }
+
+        ancestors_.resize(terms_.size());
+        vector<char> visited(terms_.size(), 0);
+        for (size_t i=0; i < terms_.size(); ++i)
+            addAncestors((int) i, visited);
+    }
+
+    /// returns the dense index of cvid, or -1 if there is no term for cvid
+    int index(CVID cvid) const
+    {
+        if (cvid == CVID_Unknown)
+            return unknownIndex_;
+        if (cvid < 0)
+            return -1;
+
+        size_t block = cvid / enumBlockSize_;
+        size_t accession = cvid % enumBlockSize_;
+        size_t page = accession / PageSize;
+        if (block >= pages_.size() || page >= pages_[block].size() || pages_[block][page].empty())
+            return -1;
+        return pages_[block][page][accession % PageSize];
+    }
+
+    const CVTermInfo& info(int index) const {return *terms_[index];}
+
+    /// returns true iff parent is the term at index or one of its is_a ancestors
+    bool isA(int index, CVID parent) const
+    {
+        return binary_search(ancestors_[index].begin(), ancestors_[index].end(), parent);
+    }
+
+    private:
+
+    // accessions are grouped in pages so that sparse prefixes (e.g. MS:0000000 and MS:1000001...)
+    // only allocate the ranges they use
+    static const size_t PageSize = 1024;
+
+    void addIndex(CVID cvid, int index)
+    {
+        if (cvid == CVID_Unknown)
+        {
+            unknownIndex_ = index;
+            return;
+        }
+
+        size_t block = cvid / enumBlockSize_;
+        size_t accession = cvid % enumBlockSize_;
+        size_t page = accession / PageSize;
+        if (block >= pages_.size())
+            pages_.resize(block + 1);
+        if (page >= pages_[block].size())
+            pages_[block].resize(page + 1);
+        if (pages_[block][page].empty())
+            pages_[block][page].resize(PageSize, -1);
+        pages_[block][page][accession % PageSize] = index;
+    }
+
+    // fills ancestors_[index] with the term's own CVID and the CVIDs of all its is_a ancestors
+    // (visited: 0 = not yet, 1 = in progress, 2 = done)
+    void addAncestors(int index, vector<char>& visited)
+    {
+        if (visited[index])
+            return;
+        visited[index] = 1;
+
+        vector<CVID>& ancestors = ancestors_[index];
+        ancestors.push_back(terms_[index]->cvid);
+        for (CVTermInfo::id_list::const_iterator it=terms_[index]->parentsIsA.begin(); it!=terms_[index]->parentsIsA.end(); ++it)
+        {
+            ancestors.push_back(*it);
+            int parentIndex = this->index(*it);
+            if (parentIndex < 0)
+                continue;
+            addAncestors(parentIndex, visited);
+            ancestors.insert(ancestors.end(), ancestors_[parentIndex].begin(), ancestors_[parentIndex].end());
+        }
+
+        sort(ancestors.begin(), ancestors.end());
+        ancestors.erase(unique(ancestors.begin(), ancestors.end()), ancestors.end());
+        visited[index] = 2;
+    }
+
+    vector<const CVTermInfo*> terms_;
+    vector<vector<CVID> > ancestors_;
+    vector<vector<vector<int> > > pages_; // [prefix block][accession / PageSize][accession % PageSize]
+    int unknownIndex_;
+};
+
+} // namespace
+
+
 PWIZ_API_DECL const CVTermInfo& cvTermInfo(CVID cvid)
 {
-    const map<CVID,CVTermInfo>& infoMap = CVTermData::instance->infoMap();
-    map<CVID,CVTermInfo>::const_iterator itr = infoMap.find(cvid);
-    if (itr == infoMap.end())
+    int index = CVTermIndex::instance->index(cvid);
+    if (index < 0)
         throw invalid_argument("[cvTermInfo()] no term associated with CVID \"" + lexical_cast<string>(cvid) + "\"");
-    return itr->second;
+    return CVTermIndex::instance->info(index);
 }
 
 
@@ -108,13 +215,12 @@ PWIZ_API_DECL const CVTermInfo& cvTermInfo(const char* id)
             if ((!*op) && (*ip++==':')) 
             {   // id has form "FOO:nnnnnn", and ip points at "nnnnnn"
                 CVID cvid = (CVID)(o*enumBlockSize_ + strtoul(ip,NULL,10));
-                const map<CVID, CVTermInfo>& infoMap = CVTermData::instance->infoMap();
-                map<CVID, CVTermInfo>::const_iterator find = infoMap.find(cvid);
-                if (find == infoMap.end())
+                int index = CVTermIndex::instance->index(cvid);
+                if (index < 0)
                 {
                     throw out_of_range("Invalid cvParam accession \"" + lexical_cast<string>(cvid) + "\"");
                 }
-                return find->second;
+                return CVTermIndex::instance->info(index);
             }
         }
     return CVTermData::instance->infoMap().find(CVID_Unknown)->second;
@@ -124,10 +230,10 @@ PWIZ_API_DECL const CVTermInfo& cvTermInfo(const char* id)
 PWIZ_API_DECL bool cvIsA(CVID child, CVID parent)
 {
     if (child == parent) return true;
-    const CVTermInfo& info = cvTermInfo(child);
-    for (CVTermInfo::id_list::const_iterator it=info.parentsIsA.begin(); it!=info.parentsIsA.end(); ++it)
-        if (cvIsA(*it,parent)) return true;
-    return false;
+    int index = CVTermIndex::instance->index(child);
+    if (index < 0)
+        throw invalid_argument("[cvIsA()] no term associated with CVID \"" + lexical_cast<string>(child) + "\"");
+    return CVTermIndex::instance->isA(index, parent);
 }
 
 
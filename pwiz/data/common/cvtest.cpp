@@ -81,6 +81,43 @@ void testIsA()
 }
 
 
+// the recursive walk of parentsIsA that cvIsA() used to do on every call
+bool naiveIsA(CVID child, CVID parent)
+{
+    if (child == parent) return true;
+    const CVTermInfo& info = cvTermInfo(child);
+    for (CVTermInfo::id_list::const_iterator it=info.parentsIsA.begin(); it!=info.parentsIsA.end(); ++it)
+        if (naiveIsA(*it, parent)) return true;
+    return false;
+}
+
+
+void testIsAAllTerms()
+{
+    // every term against a few branches of each CV, and against its own parents
+    CVID parents[] = {MS_mass_analyzer_type, MS_spectrum_type, MS_dissociation_method, MS_ionization_type,
+                      MS_spectrum_representation, MS_binary_data_array, MS_instrument_model, MS_modification_specificity_peptide_N_term,
+                      UO_unit, UO_mass_unit, UO_time_unit, UNIMOD_unimod_root_node, CVID_Unknown};
+    const vector<CVID>& terms = cvids();
+    for (vector<CVID>::const_iterator it=terms.begin(); it!=terms.end(); ++it)
+    {
+        for (size_t i=0; i < sizeof(parents)/sizeof(CVID); ++i)
+            unit_assert_operator_equal(naiveIsA(*it, parents[i]), cvIsA(*it, parents[i]));
+
+        const CVTermInfo& info = cvTermInfo(*it);
+        for (CVTermInfo::id_list::const_iterator jt=info.parentsIsA.begin(); jt!=info.parentsIsA.end(); ++jt)
+        {
+            unit_assert(cvIsA(*it, *jt));
+            unit_assert(*it == *jt || !cvIsA(*jt, *it));
+        }
+    }
+
+    unit_assert_throws(cvIsA((CVID) 123456789, MS_m_z), invalid_argument);
+    unit_assert_throws(cvTermInfo((CVID) 123456789), invalid_argument);
+    unit_assert_throws(cvTermInfo("MS:1999999"), out_of_range);
+}
+
+
 void testOtherRelations()
 {
     const CVTermInfo& info = cvTermInfo(MS_accuracy);
@@ -148,6 +185,7 @@ void testThreadSafetyWorker(boost::barrier* testBarrier)
     {
         test();
         testIsA();
+        testIsAAllTerms();
         testOtherRelations();
         testSynonyms();
         testIDTranslation();
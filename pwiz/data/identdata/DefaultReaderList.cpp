@@ -146,6 +146,17 @@ class Reader_mzid : public Reader
         read(filename, head, *results.back(), config);
     }
 
+    virtual ResultListPtr readResults(const std::string& filename, const std::string& head, IdentData& metadata, const Config& config) const
+    {
+        shared_ptr<istream> is(new random_access_compressed_ifstream(filename.c_str()));
+        if (!is.get() || !*is)
+            throw runtime_error(("[Reader_mzid::readResults] Unable to open file " + filename).c_str());
+
+        ResultListPtr results = Serializer_mzIdentML().readResults(is, metadata, config.iterationListenerRegistry);
+        fillInCommonMetadata(filename, metadata);
+        return results;
+    }
+
     virtual const char *getType() const {return "mzIdentML";}
 };
 
@@ -191,6 +202,17 @@ public:
         read(filename, head, *results.back(), config);
     }
 
+    virtual ResultListPtr readResults(const std::string& filename, const std::string& head, IdentData& metadata, const Config& config) const
+    {
+        shared_ptr<istream> is(new random_access_compressed_ifstream(filename.c_str()));
+        if (!is.get() || !*is)
+            throw runtime_error("[Reader_pepXML::readResults] Unable to open file " + filename);
+
+        ResultListPtr results = Serializer_pepXML().readResults(is, metadata, config.iterationListenerRegistry);
+        fillInCommonMetadata(filename, metadata);
+        return results;
+    }
+
     virtual const char *getType() const {return "pepXML";}
 };
 
@@ -268,7 +268,9 @@ struct HandlerCVParam : public SAXParser::Handler
         if (!accession.empty())
             cvParam->cvid = cvTermInfo(accession).cvid;
 
-        getAttribute(attributes, "value", cvParam->value);
+        string value;
+        getAttribute(attributes, "value", value);
+        cvParam->setValue(value);
 
         string unitAccession;
         getAttribute(attributes, "unitAccession", unitAccession);
@@ -733,9 +735,10 @@ struct HandlerDBSequence : public HandlerIdentifiableParamContainer
 };
 
 
-PWIZ_API_DECL void read(std::istream& is, DBSequence& ds)
+PWIZ_API_DECL void read(std::istream& is, DBSequence& ds, SchemaVersion version)
 {
     HandlerDBSequence handler(&ds);
+    handler.version = version;
     SAXParser::parse(is, handler);
 }
 
@@ -969,9 +972,10 @@ struct HandlerPeptide : public HandlerIdentifiableParamContainer
 };
 
 
-PWIZ_API_DECL void read(std::istream& is, Peptide& peptide)
+PWIZ_API_DECL void read(std::istream& is, Peptide& peptide, SchemaVersion version)
 {
     HandlerPeptide handler(&peptide);
+    handler.version = version;
     SAXParser::parse(is, handler);
 }
 
@@ -1093,10 +1097,11 @@ struct HandlerPeptideEvidence : public HandlerIdentifiableParamContainer
 };
 
 
-PWIZ_API_DECL void read(std::istream& is, PeptideEvidence& pep)
+PWIZ_API_DECL void read(std::istream& is, PeptideEvidence& pep, SchemaVersion version)
 {
     SequenceIndex dummy;
     HandlerPeptideEvidence handler(dummy, &pep);
+    handler.version = version;
     SAXParser::parse(is, handler);
 }
 
@@ -4024,10 +4029,11 @@ struct HandlerSpectrumIdentificationResult : public HandlerIdentifiableParamCont
 };
 
 
-PWIZ_API_DECL void read(std::istream& is, SpectrumIdentificationResult& sirp)
+PWIZ_API_DECL void read(std::istream& is, SpectrumIdentificationResult& sirp, SchemaVersion version)
 {
     SequenceIndex dummy;
     HandlerSpectrumIdentificationResult handler(dummy, &sirp);
+    handler.version = version;
     SAXParser::parse(is, handler);
 }
 
@@ -4456,6 +4462,29 @@ void write(minimxml::XMLWriter& writer, const IdentData& mzid,
     writer.endElement();
 }
 
+// reads the version of an mzIdentML document from the attributes of its root element
+SchemaVersion getSchemaVersion(const SAXParser::Handler::Attributes& attributes, string& versionString)
+{
+    // "http://psidev.info/psi/pi/mzIdentML/1.0 ../schema/mzIdentML<version>.xsd"
+    const char* schemaLocationValue = attributes.findValueByName("xsi:schemaLocation");
+    if (!schemaLocationValue || !*schemaLocationValue)
+    {
+        const char* versionValue = attributes.findValueByName("version"); // deprecated?
+        if (versionValue)
+            versionString = versionValue;
+    }
+    else
+    {
+        string schemaLocation(schemaLocationValue);
+        schemaLocation = schemaLocation.substr(schemaLocation.find(' ')+1);
+        string xsdName = BFS_STRING(bfs::path(schemaLocation).filename());
+        versionString = xsdName.substr(9, xsdName.length()-13); // read between "mzIdentML" and ".xsd"
+    }
+
+    return versionString.find("1.0.0") == 0 ? SchemaVersion_1_0 : SchemaVersion_1_1;
+}
+
+
 struct HandlerIdentData : public HandlerIdentifiable
 {
     IdentData* mzid;
@@ -4483,20 +4512,7 @@ struct HandlerIdentData : public HandlerIdentifiable
         {
             getAttribute(attributes, "creationDate", mzid->creationDate);
 
-            // "http://psidev.info/psi/pi/mzIdentML/1.0 ../schema/mzIdentML<version>.xsd"
-            string schemaLocation;
-            getAttribute(attributes, "xsi:schemaLocation", schemaLocation);
-            if (schemaLocation.empty())
-                getAttribute(attributes, "version", mzid->version_); // deprecated?
-            else
-            {
-                schemaLocation = schemaLocation.substr(schemaLocation.find(' ')+1);
-                string xsdName = BFS_STRING(bfs::path(schemaLocation).filename());
-                mzid->version_ = xsdName.substr(9, xsdName.length()-13); // read between "mzIdentML" and ".xsd"
-            }
-
-            if (mzid->version_.find("1.0.0") == 0)
-                version = (int) SchemaVersion_1_0;
+            version = (int) getSchemaVersion(attributes, mzid->version_);
 
             HandlerIdentifiable::id = mzid;
             return HandlerIdentifiable::startElement(name, attributes, position);
@@ -4617,6 +4633,79 @@ PWIZ_API_DECL void read(std::istream& is, IdentData& mzid,
     References::resolve(mzid); 
 }
 
+
+//
+// ElementIndex
+//
+
+
+struct HandlerElementIndex : public SAXParser::Handler
+{
+    ElementIndex& index;
+
+    HandlerElementIndex(ElementIndex& index, const IterationListenerRegistry* iterationListenerRegistry)
+    : index(index), ilr_(iterationListenerRegistry), inSequenceCollection_(false)
+    {}
+
+    virtual Status startElement(const string& name, 
+                                const Attributes& attributes,
+                                stream_offset position)
+    {
+        if (name == "SpectrumIdentificationResult")
+        {
+            if (ilr_ && ilr_->broadcastUpdateMessage(IterationListener::UpdateMessage(index.results.size(), 0, "indexing spectrum identification results")) == IterationListener::Status_Cancel)
+                return Status::Done;
+
+            index.results.push_back(ResultIdentity());
+            ResultIdentity& result = index.results.back();
+            result.index = index.results.size()-1;
+            getAttribute(attributes, "id", result.id);
+            getAttribute(attributes, "spectrumID", result.spectrumID);
+            index.resultOffsets.push_back(position);
+        }
+        else if (inSequenceCollection_)
+        {
+            // 1.0 PeptideEvidence elements are inside SpectrumIdentificationItems, not the SequenceCollection
+            map<string, stream_offset>* elements = name == "DBSequence" ? &index.dbSequences :
+                                                   name == "Peptide" ? &index.peptides :
+                                                   name == "PeptideEvidence" ? &index.peptideEvidence : 0;
+            if (elements)
+            {
+                getAttribute(attributes, "id", id_);
+                elements->insert(make_pair(id_, position));
+            }
+        }
+        else if (name == "SequenceCollection")
+            inSequenceCollection_ = true;
+        else if (name == "ProteinDetectionList")
+            return Status::Done; // after all the results
+        else if (bal::iequals(name, "MzIdentML"))
+            index.version = getSchemaVersion(attributes, id_);
+
+        return Status::Ok;
+    }
+
+    virtual Status endElement(const string& name, stream_offset position)
+    {
+        if (name == "SequenceCollection")
+            inSequenceCollection_ = false;
+        return Status::Ok;
+    }
+
+    private:
+    const IterationListenerRegistry* ilr_;
+    bool inSequenceCollection_;
+    string id_;
+};
+
+
+PWIZ_API_DECL void read(std::istream& is, ElementIndex& index,
+                        const IterationListenerRegistry* iterationListenerRegistry)
+{
+    HandlerElementIndex handler(index, iterationListenerRegistry);
+    SAXParser::parse(is, handler);
+}
+
 } // namespace pwiz 
 } // namespace identdata 
 } // namespace IO 
@@ -25,8 +25,10 @@
 
 #include "pwiz/utility/misc/Export.hpp"
 #include "IdentData.hpp"
+#include "ResultList.hpp"
 #include "pwiz/utility/minimxml/XMLWriter.hpp"
 #include "pwiz/utility/misc/IterationListener.hpp"
+#include <boost/iostreams/positioning.hpp>
 
 
 namespace pwiz {
@@ -191,7 +193,7 @@ PWIZ_API_DECL void read(std::istream& is, SpectrumIdentificationList& sil,
 
 
 PWIZ_API_DECL void write(minimxml::XMLWriter& writer, const SpectrumIdentificationResult& sir);
-PWIZ_API_DECL void read(std::istream& is, SpectrumIdentificationResult& sir);
+PWIZ_API_DECL void read(std::istream& is, SpectrumIdentificationResult& sir, SchemaVersion version = SchemaVersion_1_1);
 
 
 PWIZ_API_DECL void write(minimxml::XMLWriter& writer, const ProteinDetectionList& pdl);
@@ -223,15 +225,15 @@ PWIZ_API_DECL void read(std::istream& is, AnalysisSoftware& analysisSoftware);
 
 
 PWIZ_API_DECL void write(minimxml::XMLWriter& writer, const DBSequence& dbSequence);
-PWIZ_API_DECL void read(std::istream& is, DBSequence& dbSequence);
+PWIZ_API_DECL void read(std::istream& is, DBSequence& dbSequence, SchemaVersion version = SchemaVersion_1_1);
 
 
 PWIZ_API_DECL void write(minimxml::XMLWriter& writer, const Peptide& peptide);
-PWIZ_API_DECL void read(std::istream& is, Peptide& peptide);
+PWIZ_API_DECL void read(std::istream& is, Peptide& peptide, SchemaVersion version = SchemaVersion_1_1);
 
 
 PWIZ_API_DECL void write(minimxml::XMLWriter& writer, const PeptideEvidence& pe);
-PWIZ_API_DECL void read(std::istream& is, PeptideEvidence& pe);
+PWIZ_API_DECL void read(std::istream& is, PeptideEvidence& pe, SchemaVersion version = SchemaVersion_1_1);
 
 
 PWIZ_API_DECL void write(minimxml::XMLWriter& writer, const Modification& mod);
@@ -263,6 +265,27 @@ PWIZ_API_DECL void read(std::istream& is, IdentData& identdata,
                         AnalysisDataFlag analysisDataFlag = ReadAnalysisData);
 
 
+/// the positions of the elements of an mzIdentML document that can be read on their own,
+/// by seeking to them and reading them with the version of the document
+struct PWIZ_API_DECL ElementIndex
+{
+    SchemaVersion version;
+
+    /// the SpectrumIdentificationResults of all SpectrumIdentificationLists, in document order
+    std::vector<ResultIdentity> results;
+    std::vector<boost::iostreams::stream_offset> resultOffsets;
+
+    /// the elements of the SequenceCollection by id
+    std::map<std::string, boost::iostreams::stream_offset> dbSequences, peptides, peptideEvidence;
+
+    ElementIndex() : version(SchemaVersion_1_1) {}
+};
+
+/// indexes an mzIdentML document in a single pass that reads only its element tags
+PWIZ_API_DECL void read(std::istream& is, ElementIndex& index,
+                        const pwiz::util::IterationListenerRegistry* iterationListenerRegistry = 0);
+
+
 } // namespace IO
 
 } // namespace pwiz 
@@ -57,6 +57,21 @@ PWIZ_API_DECL void Reader::read(const std::string& filename,
     return read(filename, read_file_header(filename, 512), results, config);
 }
 
+PWIZ_API_DECL ResultListPtr Reader::readResults(const std::string& filename,
+                                                IdentData& metadata,
+                                                const Config& config) const
+{
+    return readResults(filename, read_file_header(filename, 512), metadata, config);
+}
+
+PWIZ_API_DECL ResultListPtr Reader::readResults(const std::string& filename,
+                                                const std::string& head,
+                                                IdentData& metadata,
+                                                const Config& config) const
+{
+    throw ReaderFail(string("[Reader::readResults] reading results one at a time is not supported for ") + getType() + " files");
+}
+
 
 
 PWIZ_API_DECL std::string ReaderList::identify(const string& filename) const
@@ -130,6 +145,21 @@ PWIZ_API_DECL void ReaderList::read(const string& filename, const string& head,
 }
 
 
+PWIZ_API_DECL ResultListPtr ReaderList::readResults(const string& filename, IdentData& metadata, const Config& config) const
+{
+    return readResults(filename, read_file_header(filename, 512), metadata, config);
+}
+
+
+PWIZ_API_DECL ResultListPtr ReaderList::readResults(const string& filename, const string& head, IdentData& metadata, const Config& config) const
+{
+    for (const_iterator it=begin(); it!=end(); ++it)
+        if ((*it)->accept(filename, head))
+            return (*it)->readResults(filename, head, metadata, config);
+    throw ReaderFail(" don't know how to read " + filename);
+}
+
+
 /*PWIZ_API_DECL void ReaderList::readIds(const string& filename, vector<string>& results) const
 {
     readIds(filename, read_file_header(filename, 512), results);
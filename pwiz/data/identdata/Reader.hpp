@@ -26,6 +26,7 @@
 
 #include "pwiz/utility/misc/Export.hpp"
 #include "IdentData.hpp"
+#include "ResultList.hpp"
 #include <string>
 #include <stdexcept>
 #include "pwiz/utility/misc/IterationListener.hpp"
@@ -41,8 +42,8 @@ class PWIZ_API_DECL Reader
 
 
     /// HACK: provide an option to read only file-level metadata;
-    ///       once we have an enumerable ResultList implementation
-    ///       this will be deprecated
+    ///       to iterate over the results of a file without reading
+    ///       them all at once, use readResults() instead
     struct PWIZ_API_DECL Config
     {
         bool ignoreSequenceCollectionAndAnalysisData;
@@ -102,6 +103,19 @@ class PWIZ_API_DECL Reader
                       std::vector<IdentDataPtr>& results,
                       const Config& config = Config()) const = 0;
 
+    /// fill in the file-level metadata and return a ResultList that reads the
+    /// SpectrumIdentificationResults one at a time; the Config's ignore options do not apply
+    virtual ResultListPtr readResults(const std::string& filename,
+                                      IdentData& metadata,
+                                      const Config& config = Config()) const;
+
+    /// fill in the file-level metadata and return a ResultList that reads the
+    /// SpectrumIdentificationResults one at a time; the default implementation throws ReaderFail
+    virtual ResultListPtr readResults(const std::string& filename,
+                                      const std::string& head,
+                                      IdentData& metadata,
+                                      const Config& config = Config()) const;
+
 	virtual const char *getType() const = 0; // what kind of reader are you?
 
     virtual ~Reader(){}
@@ -181,6 +195,17 @@ class PWIZ_API_DECL ReaderList : public Reader,
                       std::vector<IdentDataPtr>& results,
                       const Config& config = Config()) const;
 
+    /// delegates to first child that identifies
+    virtual ResultListPtr readResults(const std::string& filename,
+                                      IdentData& metadata,
+                                      const Config& config = Config()) const;
+
+    /// delegates to first child that identifies
+    virtual ResultListPtr readResults(const std::string& filename,
+                                      const std::string& head,
+                                      IdentData& metadata,
+                                      const Config& config = Config()) const;
+
     /// appends all of the rhs operand's Readers to the list
     ReaderList& operator +=(const ReaderList& rhs);
 
@@ -24,6 +24,7 @@
 
 #include "References.hpp"
 #include "TextWriter.hpp"
+#include "pwiz/data/common/ReferentIndex.hpp"
 #include "pwiz/utility/misc/Std.hpp"
 
 namespace pwiz {
@@ -31,30 +32,20 @@ namespace identdata {
 namespace References {
 
 
-template <typename object_type>
-struct HasID
-{
-    const string& id_;
-    HasID(const string& id) : id_(id) {}
-
-    bool operator()(const shared_ptr<object_type>& objectPtr)
-    {
-        return objectPtr.get() && objectPtr->id == id_;
-    }
-};
+using data::ReferentIndex;
 
 
 template <typename object_type>
 void resolve(shared_ptr<object_type>& reference, 
-             const vector< shared_ptr<object_type> >& referentList)
+             const vector< shared_ptr<object_type> >& referentList,
+             const ReferentIndex& index)
 {
     if (!reference.get() || reference->id.empty())
         return; 
 
-    typename vector< shared_ptr<object_type> >::const_iterator it = 
-        find_if(referentList.begin(), referentList.end(), HasID<object_type>(reference->id));
+    const shared_ptr<object_type>* referent = index.find(referentList, reference->id);
 
-    if (it == referentList.end())
+    if (!referent)
     {
         ostringstream oss;
         oss << "[References::resolve()] Failed to resolve reference.\n"
@@ -67,63 +58,85 @@ void resolve(shared_ptr<object_type>& reference,
         throw runtime_error(oss.str().c_str());
     }
 
-    reference = *it;
+    reference = *referent;
 }
 
 
 template <typename object_type>
 void resolve(vector < shared_ptr<object_type> >& references,
-             const vector< shared_ptr<object_type> >& referentList)
+             const vector< shared_ptr<object_type> >& referentList,
+             const ReferentIndex& index)
 {
     for (typename vector< shared_ptr<object_type> >::iterator it=references.begin();
          it!=references.end(); ++it)
-        resolve(*it, referentList);
+        resolve(*it, referentList, index);
 }
 
-PWIZ_API_DECL void resolve(ContactRole& cr, IdentData& mzid)
+
+// hashes the lists of mzid that references point into, so that resolving all the references of a
+// document takes time linear in its size rather than searching a list for each reference
+void addReferents(ReferentIndex& index, const IdentData& mzid)
 {
-    resolve(cr.contactPtr, mzid.auditCollection);
+    index.add(mzid.analysisSoftwareList);
+    index.add(mzid.auditCollection);
+    index.add(mzid.analysisSampleCollection.samples);
+    index.add(mzid.sequenceCollection.dbSequences);
+    index.add(mzid.sequenceCollection.peptides);
+    index.add(mzid.sequenceCollection.peptideEvidence);
+    index.add(mzid.analysisProtocolCollection.spectrumIdentificationProtocol);
+    index.add(mzid.analysisProtocolCollection.proteinDetectionProtocol);
+    index.add(mzid.dataCollection.inputs.searchDatabase);
+    index.add(mzid.dataCollection.inputs.spectraData);
+    index.add(mzid.dataCollection.analysisData.spectrumIdentificationList);
+    BOOST_FOREACH(const SpectrumIdentificationListPtr& sil, mzid.dataCollection.analysisData.spectrumIdentificationList)
+        if (sil.get())
+            index.add(sil->fragmentationTable);
 }
 
 
-PWIZ_API_DECL void resolve(AnalysisSoftwarePtr& asp, IdentData& mzid)
+void resolve(ContactRole& cr, IdentData& mzid, const ReferentIndex& index)
+{
+    resolve(cr.contactPtr, mzid.auditCollection, index);
+}
+
+
+void resolve(AnalysisSoftwarePtr& asp, IdentData& mzid, const ReferentIndex& index)
 {
     if (asp->contactRolePtr.get() && !asp->contactRolePtr->empty())
-        resolve(*asp->contactRolePtr, mzid);
+        resolve(*asp->contactRolePtr, mzid, index);
 }
 
 
-void resolve(Provider& provider, IdentData& mzid)
+void resolve(Provider& provider, IdentData& mzid, const ReferentIndex& index)
 {   
     if (mzid.provider.contactRolePtr.get())
-        resolve(*mzid.provider.contactRolePtr, mzid);
+        resolve(*mzid.provider.contactRolePtr, mzid, index);
     if (mzid.provider.analysisSoftwarePtr.get())
-        resolve(mzid.provider.analysisSoftwarePtr, mzid);
+        resolve(mzid.provider.analysisSoftwarePtr, mzid, index);
 }
 
 
-PWIZ_API_DECL void resolve(AnalysisSampleCollection& asc, IdentData& mzid)
+void resolve(AnalysisSampleCollection& asc, IdentData& mzid, const ReferentIndex& index)
 {
     BOOST_FOREACH(SamplePtr& s, asc.samples)
     {
         BOOST_FOREACH(ContactRolePtr& cr, s->contactRole)
-            resolve(*cr, mzid);
+            resolve(*cr, mzid, index);
         BOOST_FOREACH(SamplePtr& ss, s->subSamples)
             if (ss.get() && !ss->empty())
-                resolve(ss, asc.samples);
+                resolve(ss, asc.samples, index);
     }
 }
 
 
-PWIZ_API_DECL void resolve(OrganizationPtr& reference, vector<ContactPtr>& referentList)
+void resolve(OrganizationPtr& reference, vector<ContactPtr>& referentList, const ReferentIndex& index)
 {
     if (!reference.get() || reference->id.empty())
         return; 
 
-    vector<ContactPtr>::iterator it = 
-        find_if(referentList.begin(), referentList.end(), HasID<Contact>(reference->id));
+    const ContactPtr* referent = index.find(referentList, reference->id);
 
-    if (it == referentList.end())
+    if (!referent)
     {
         ostringstream oss;
         oss << "[References::resolve()] Failed to resolve reference.\n"
@@ -135,28 +148,28 @@ PWIZ_API_DECL void resolve(OrganizationPtr& reference, vector<ContactPtr>& refer
         throw runtime_error(oss.str().c_str());
     }
 
-    reference = boost::static_pointer_cast<Organization>(*it);
+    reference = boost::static_pointer_cast<Organization>(*referent);
 }
 
 
-PWIZ_API_DECL void resolve(vector<ContactPtr>& vcp, IdentData& mzid)
+void resolve(vector<ContactPtr>& vcp, IdentData& mzid, const ReferentIndex& index)
 {
     BOOST_FOREACH(ContactPtr& c, vcp)
     {
         if (dynamic_cast<Organization*>(c.get()))
-            resolve(static_cast<Organization*>(c.get())->parent, mzid.auditCollection);
+            resolve(static_cast<Organization*>(c.get())->parent, mzid.auditCollection, index);
         else if (dynamic_cast<Person*>(c.get()))
             BOOST_FOREACH(OrganizationPtr& org, static_cast<Person*>(c.get())->affiliations)
                 if (org.get() && !org->empty())
-                    resolve(org, vcp);
+                    resolve(org, vcp, index);
     }
 }
 
 
-PWIZ_API_DECL void resolve(SequenceCollection& sc, IdentData& mzid)
+void resolve(SequenceCollection& sc, IdentData& mzid, const ReferentIndex& index)
 {
     BOOST_FOREACH(DBSequencePtr& dbs, sc.dbSequences)
-        resolve(dbs->searchDatabasePtr, mzid.dataCollection.inputs.searchDatabase);
+        resolve(dbs->searchDatabasePtr, mzid.dataCollection.inputs.searchDatabase, index);
 
     // Create a single Enzyme referent list
     vector<EnzymePtr> enzymePtrs;
@@ -164,7 +177,8 @@ PWIZ_API_DECL void resolve(SequenceCollection& sc, IdentData& mzid)
         enzymePtrs.insert(enzymePtrs.end(), sip->enzymes.enzymes.begin(), sip->enzymes.enzymes.end());    
 }
 
-PWIZ_API_DECL void resolve(MassTablePtr& mt, const vector<SpectrumIdentificationProtocolPtr>& spectrumIdProts)
+
+void resolve(MassTablePtr& mt, const vector<SpectrumIdentificationProtocolPtr>& spectrumIdProts)
 {
     if (!mt.get() || mt->id.empty())
         return; 
@@ -192,16 +206,16 @@ PWIZ_API_DECL void resolve(MassTablePtr& mt, const vector<SpectrumIdentification
     throw runtime_error(oss.str().c_str());
 }
 
-PWIZ_API_DECL void resolve(PeptideEvidencePtr& pe, const IdentData& mzid)
+void resolve(PeptideEvidencePtr& pe, const IdentData& mzid, const ReferentIndex& index)
 {
     if (!pe.get())
         throw runtime_error("NULL value passed into resolve(PeptideEvidencePtr, IdentData&)");
 
     if (pe->peptidePtr.get())
-        resolve(pe->peptidePtr, mzid.sequenceCollection.peptides);
+        resolve(pe->peptidePtr, mzid.sequenceCollection.peptides, index);
 
     if (pe->dbSequencePtr.get())
-        resolve(pe->dbSequencePtr, mzid.sequenceCollection.dbSequences);
+        resolve(pe->dbSequencePtr, mzid.sequenceCollection.dbSequences, index);
 
     // TODO construct a collection of TranslationTable's from all the
     // SpectrumIdentificationProtocolPtr's in AnalysisProtocolCollection.
@@ -212,76 +226,61 @@ PWIZ_API_DECL void resolve(PeptideEvidencePtr& pe, const IdentData& mzid)
 }
 
 
-//template <IdentData& mzid>
-struct ResolvePE
-{
-    const IdentData* mzid_;
-    ResolvePE(const IdentData* mzid) : mzid_(mzid) {}
-    
-    void operator()(PeptideEvidencePtr& pe)
-    {
-        if (pe->peptidePtr)
-            return;
-        return resolve(pe, (*mzid_));
-    }
-};
-
-PWIZ_API_DECL void resolve(SpectrumIdentificationListPtr& sil, IdentData& mzid)
+void resolve(SpectrumIdentificationListPtr& sil, IdentData& mzid, const ReferentIndex& index)
 {
     BOOST_FOREACH(SpectrumIdentificationResultPtr& sir, sil->spectrumIdentificationResult)
     {
         if (sir->spectraDataPtr.get())
-            resolve(sir->spectraDataPtr, mzid.dataCollection.inputs.spectraData);
+            resolve(sir->spectraDataPtr, mzid.dataCollection.inputs.spectraData, index);
 
         BOOST_FOREACH(SpectrumIdentificationItemPtr& sii, sir->spectrumIdentificationItem)
         {
             resolve(sii->massTablePtr, mzid.analysisProtocolCollection.spectrumIdentificationProtocol);
-            resolve(sii->samplePtr, mzid.analysisSampleCollection.samples);
+            resolve(sii->samplePtr, mzid.analysisSampleCollection.samples, index);
 
             BOOST_FOREACH(IonTypePtr& it, sii->fragmentation)
             BOOST_FOREACH(FragmentArrayPtr& fa, it->fragmentArray)
-                resolve(fa->measurePtr, sil->fragmentationTable);
+                resolve(fa->measurePtr, sil->fragmentationTable, index);
 
             if (!mzid.sequenceCollection.empty() &&
                 sii->peptidePtr.get() &&
                 sii->peptidePtr->peptideSequence.empty())
             {
-                resolve(sii->peptidePtr, mzid.sequenceCollection.peptides);
+                resolve(sii->peptidePtr, mzid.sequenceCollection.peptides, index);
             }
 
-            ResolvePE rpe(&mzid);
-            for_each(sii->peptideEvidencePtr.begin(),
-                     sii->peptideEvidencePtr.end(),
-                     rpe);
+            BOOST_FOREACH(PeptideEvidencePtr& pe, sii->peptideEvidencePtr)
+                if (!pe->peptidePtr)
+                    resolve(pe, mzid, index);
         }
     }
 }
 
-PWIZ_API_DECL void resolve(SpectrumIdentification& si, IdentData& mzid)
+void resolve(SpectrumIdentification& si, IdentData& mzid, const ReferentIndex& index)
 {
     if (si.spectrumIdentificationProtocolPtr.get())
         resolve(si.spectrumIdentificationProtocolPtr,
-                mzid.analysisProtocolCollection.spectrumIdentificationProtocol);
+                mzid.analysisProtocolCollection.spectrumIdentificationProtocol, index);
     
     if (si.spectrumIdentificationListPtr.get() &&
         !mzid.dataCollection.analysisData.spectrumIdentificationList.empty())
         resolve(si.spectrumIdentificationListPtr,
-                mzid.dataCollection.analysisData.spectrumIdentificationList);
+                mzid.dataCollection.analysisData.spectrumIdentificationList, index);
 
-    resolve(si.inputSpectra, mzid.dataCollection.inputs.spectraData);
-    resolve(si.searchDatabase, mzid.dataCollection.inputs.searchDatabase);
+    resolve(si.inputSpectra, mzid.dataCollection.inputs.spectraData, index);
+    resolve(si.searchDatabase, mzid.dataCollection.inputs.searchDatabase, index);
 }
 
 
-PWIZ_API_DECL void resolve(AnalysisCollection& ac, IdentData& mzid)
+void resolve(AnalysisCollection& ac, IdentData& mzid, const ReferentIndex& index)
 {
     for (vector<SpectrumIdentificationPtr>::iterator it=ac.spectrumIdentification.begin();
          it != ac.spectrumIdentification.end(); it++)
-        resolve(**it, mzid);
+        resolve(**it, mzid, index);
 
     // TODO resolve proteinDetectionProtocolPtr & proteinDetectionListPtr;
     resolve(ac.proteinDetection.proteinDetectionProtocolPtr,
-            mzid.analysisProtocolCollection.proteinDetectionProtocol);
+            mzid.analysisProtocolCollection.proteinDetectionProtocol, index);
 
     if (ac.proteinDetection.proteinDetectionListPtr.get() &&
         mzid.dataCollection.analysisData.proteinDetectionListPtr.get())
@@ -298,36 +297,36 @@ PWIZ_API_DECL void resolve(AnalysisCollection& ac, IdentData& mzid)
 
     if (!mzid.dataCollection.analysisData.spectrumIdentificationList.empty())
         resolve(ac.proteinDetection.inputSpectrumIdentifications,
-                mzid.dataCollection.analysisData.spectrumIdentificationList);
+                mzid.dataCollection.analysisData.spectrumIdentificationList, index);
 }
 
 
-PWIZ_API_DECL void resolve(vector<SpectrumIdentificationProtocolPtr>& vsip, IdentData& mzid)
+void resolve(vector<SpectrumIdentificationProtocolPtr>& vsip, IdentData& mzid, const ReferentIndex& index)
 {
     for (vector<SpectrumIdentificationProtocolPtr>::iterator it=vsip.begin();
          it!=vsip.end(); it++)
     {
         if (it->get())
-            resolve((*it)->analysisSoftwarePtr, mzid.analysisSoftwareList);
+            resolve((*it)->analysisSoftwarePtr, mzid.analysisSoftwareList, index);
     }
 }
 
 
-PWIZ_API_DECL void resolve(vector<ProteinDetectionProtocolPtr>& vpdp, IdentData& mzid)
+void resolve(vector<ProteinDetectionProtocolPtr>& vpdp, IdentData& mzid, const ReferentIndex& index)
 {
     for (vector<ProteinDetectionProtocolPtr>::iterator it=vpdp.begin();
          it!=vpdp.end(); it++)
     {
         if (it->get())
-            resolve((*it)->analysisSoftwarePtr, mzid.analysisSoftwareList);
+            resolve((*it)->analysisSoftwarePtr, mzid.analysisSoftwareList, index);
     }    
 }
 
 
-PWIZ_API_DECL void resolve(DataCollection& dc, IdentData& mzid)
+void resolve(DataCollection& dc, IdentData& mzid, const ReferentIndex& index)
 {
     BOOST_FOREACH(SpectrumIdentificationListPtr& sil, dc.analysisData.spectrumIdentificationList)
-        resolve(sil, mzid);
+        resolve(sil, mzid, index);
 
     // If there's no proteinDetectionListPtr, then we're done.
     if (!dc.analysisData.proteinDetectionListPtr.get())
@@ -343,13 +342,13 @@ PWIZ_API_DECL void resolve(DataCollection& dc, IdentData& mzid)
     {
         BOOST_FOREACH(ProteinDetectionHypothesisPtr& pdh, pag->proteinDetectionHypothesis)
         {
-            resolve(pdh->dbSequencePtr, mzid.sequenceCollection.dbSequences);
+            resolve(pdh->dbSequencePtr, mzid.sequenceCollection.dbSequences, index);
 
             BOOST_FOREACH(PeptideHypothesis& ph, pdh->peptideHypothesis)
             {
                 if (ph.peptideEvidencePtr && ph.peptideEvidencePtr->peptidePtr)
                     continue;
-                resolve(ph.peptideEvidencePtr, mzid.sequenceCollection.peptideEvidence);
+                resolve(ph.peptideEvidencePtr, mzid.sequenceCollection.peptideEvidence, index);
 
                 //BOOST_FOREACH(SpectrumIdentificationItemPtr& sii, ph.spectrumIdentificationItemPtr)
                 //    resolve(sii, mzid.analysisCollection.proteinDetection.inputSpectrumIdentifications);
@@ -359,21 +358,58 @@ PWIZ_API_DECL void resolve(DataCollection& dc, IdentData& mzid)
 }
 
 
+// resolving one part of a document searches its lists linearly (an empty index hashes nothing),
+// since hashing the whole document for a few references would cost more than it saves;
+// resolve(IdentData&) indexes the lists once for all its references
+
+PWIZ_API_DECL void resolve(ContactRole& cr, IdentData& mzid)
+{
+    resolve(cr, mzid, ReferentIndex());
+}
+
+
+PWIZ_API_DECL void resolve(AnalysisSoftwarePtr& asp, IdentData& mzid)
+{
+    resolve(asp, mzid, ReferentIndex());
+}
+
+
+PWIZ_API_DECL void resolve(AnalysisSampleCollection& asc, IdentData& mzid)
+{
+    resolve(asc, mzid, ReferentIndex());
+}
+
+
+PWIZ_API_DECL void resolve(vector<ContactPtr>& vcp, IdentData& mzid)
+{
+    resolve(vcp, mzid, ReferentIndex());
+}
+
+
+PWIZ_API_DECL void resolve(SequenceCollection& sc, IdentData& mzid)
+{
+    resolve(sc, mzid, ReferentIndex());
+}
+
+
 PWIZ_API_DECL void resolve(IdentData& mzid)
 {
+    ReferentIndex index;
+    addReferents(index, mzid);
+
     BOOST_FOREACH(AnalysisSoftwarePtr& as, mzid.analysisSoftwareList)
         if (as->contactRolePtr.get())
-            resolve(*as->contactRolePtr, mzid);
+            resolve(*as->contactRolePtr, mzid, index);
 
-    resolve(mzid.provider, mzid);
-    resolve(mzid.auditCollection, mzid);
-    resolve(mzid.analysisSampleCollection, mzid);
+    resolve(mzid.provider, mzid, index);
+    resolve(mzid.auditCollection, mzid, index);
+    resolve(mzid.analysisSampleCollection, mzid, index);
     
-    resolve(mzid.sequenceCollection, mzid);
-    resolve(mzid.analysisCollection, mzid);
-    resolve(mzid.analysisProtocolCollection.spectrumIdentificationProtocol, mzid);
-    resolve(mzid.analysisProtocolCollection.proteinDetectionProtocol, mzid);
-    resolve(mzid.dataCollection, mzid);
+    resolve(mzid.sequenceCollection, mzid, index);
+    resolve(mzid.analysisCollection, mzid, index);
+    resolve(mzid.analysisProtocolCollection.spectrumIdentificationProtocol, mzid, index);
+    resolve(mzid.analysisProtocolCollection.proteinDetectionProtocol, mzid, index);
+    resolve(mzid.dataCollection, mzid, index);
 }
 
 
@@ -209,6 +209,60 @@ void testMeasure()
 }
 
 
+void testManyReferents()
+{
+    // lists long enough to be hashed, with a duplicate id that must resolve to its first occurrence
+    IdentData mzid;
+    for (int i=0; i < 100; ++i)
+    {
+        string id = lexical_cast<string>(i);
+        mzid.sequenceCollection.peptides.push_back(PeptidePtr(new Peptide("PEP_" + id)));
+        mzid.sequenceCollection.peptides.back()->peptideSequence = "PEPTIDE" + id;
+        mzid.sequenceCollection.dbSequences.push_back(DBSequencePtr(new DBSequence("DBSeq_" + id, "protein " + id)));
+        mzid.sequenceCollection.peptideEvidence.push_back(PeptideEvidencePtr(new PeptideEvidence("PE_" + id)));
+        mzid.sequenceCollection.peptideEvidence.back()->peptidePtr.reset(new Peptide("PEP_" + id));
+    }
+    PeptidePtr duplicate(new Peptide("PEP_42"));
+    mzid.sequenceCollection.peptides.push_back(duplicate);
+
+    SpectrumIdentificationListPtr sil(new SpectrumIdentificationList);
+    mzid.dataCollection.analysisData.spectrumIdentificationList.push_back(sil);
+    SpectrumIdentificationResultPtr sir(new SpectrumIdentificationResult("SIR_1"));
+    sil->spectrumIdentificationResult.push_back(sir);
+
+    ProteinAmbiguityGroupPtr pag(new ProteinAmbiguityGroup("PAG_1"));
+    mzid.dataCollection.analysisData.proteinDetectionListPtr.reset(new ProteinDetectionList("PDL_1"));
+    mzid.dataCollection.analysisData.proteinDetectionListPtr->proteinAmbiguityGroup.push_back(pag);
+
+    for (int i=99; i >= 0; --i)
+    {
+        string id = lexical_cast<string>(i);
+        sir->spectrumIdentificationItem.push_back(SpectrumIdentificationItemPtr(new SpectrumIdentificationItem("SII_" + id)));
+        sir->spectrumIdentificationItem.back()->peptidePtr.reset(new Peptide("PEP_" + id));
+
+        pag->proteinDetectionHypothesis.push_back(ProteinDetectionHypothesisPtr(new ProteinDetectionHypothesis("PDH_" + id)));
+        pag->proteinDetectionHypothesis.back()->dbSequencePtr.reset(new DBSequence("DBSeq_" + id));
+        pag->proteinDetectionHypothesis.back()->peptideHypothesis.push_back(PeptideHypothesis());
+        pag->proteinDetectionHypothesis.back()->peptideHypothesis.back().peptideEvidencePtr.reset(new PeptideEvidence("PE_" + id));
+    }
+
+    References::resolve(mzid);
+
+    for (int i=0; i < 100; ++i)
+    {
+        unit_assert(sir->spectrumIdentificationItem[99 - i]->peptidePtr == mzid.sequenceCollection.peptides[i]);
+        const ProteinDetectionHypothesis& pdh = *pag->proteinDetectionHypothesis[99 - i];
+        unit_assert(pdh.dbSequencePtr == mzid.sequenceCollection.dbSequences[i]);
+        unit_assert(pdh.peptideHypothesis[0].peptideEvidencePtr == mzid.sequenceCollection.peptideEvidence[i]);
+    }
+    unit_assert(duplicate != mzid.sequenceCollection.peptides[42]);
+
+    // a reference to an id that is not in the list still fails
+    sir->spectrumIdentificationItem[0]->peptidePtr.reset(new Peptide("PEP_100"));
+    unit_assert_throws(References::resolve(mzid), runtime_error);
+}
+
+
 void test()
 {
     testContactRole();
@@ -216,6 +270,7 @@ void test()
     testAnalysisSampleCollection();
     testDBSequence();
     testMeasure();
+    testManyReferents();
 }
 
 int main(int argc, char* argv[])
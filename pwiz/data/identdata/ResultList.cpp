@@ -0,0 +1,98 @@
+//
+// $Id$
+//
+//
+// Original author: agent <agent@local>
+//
+// Copyright 2026
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#define PWIZ_SOURCE
+
+#include "ResultList.hpp"
+#include "pwiz/utility/misc/Std.hpp"
+
+
+namespace pwiz {
+namespace identdata {
+
+
+PWIZ_API_DECL bool ResultList::empty() const
+{
+    return size() == 0;
+}
+
+
+PWIZ_API_DECL size_t ResultList::findSpectrumID(const string& spectrumID) const
+{
+    for (size_t index=0, end=size(); index < end; ++index)
+        if (resultIdentity(index).spectrumID == spectrumID)
+            return index;
+    return size();
+}
+
+
+PWIZ_API_DECL size_t ResultListBase::size() const
+{
+    return identities_.size();
+}
+
+
+PWIZ_API_DECL const ResultIdentity& ResultListBase::resultIdentity(size_t index) const
+{
+    if (index >= identities_.size())
+        throw out_of_range("[ResultListBase::resultIdentity()] Bad index: " + lexical_cast<string>(index));
+    return identities_[index];
+}
+
+
+namespace {
+
+struct SpectrumIDLessThan
+{
+    const vector<ResultIdentity>& identities;
+    SpectrumIDLessThan(const vector<ResultIdentity>& identities) : identities(identities) {}
+
+    bool operator() (size_t lhs, size_t rhs) const {return identities[lhs].spectrumID < identities[rhs].spectrumID;}
+    bool operator() (size_t lhs, const string& rhs) const {return identities[lhs].spectrumID < rhs;}
+};
+
+} // namespace
+
+
+PWIZ_API_DECL size_t ResultListBase::findSpectrumID(const string& spectrumID) const
+{
+    vector<size_t>::const_iterator itr = lower_bound(bySpectrumID_.begin(), bySpectrumID_.end(), spectrumID,
+                                                     SpectrumIDLessThan(identities_));
+    if (itr == bySpectrumID_.end() || identities_[*itr].spectrumID != spectrumID)
+        return size();
+    return *itr;
+}
+
+
+PWIZ_API_DECL void ResultListBase::indexSpectrumIDs()
+{
+    bySpectrumID_.resize(identities_.size());
+    for (size_t i=0; i < bySpectrumID_.size(); ++i)
+        bySpectrumID_[i] = i;
+
+    // stable so the first of several results for a spectrum is found
+    stable_sort(bySpectrumID_.begin(), bySpectrumID_.end(), SpectrumIDLessThan(identities_));
+}
+
+
+} // namespace identdata
+} // namespace pwiz
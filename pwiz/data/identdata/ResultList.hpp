@@ -0,0 +1,115 @@
+//
+// $Id$
+//
+//
+// Original author: agent <agent@local>
+//
+// Copyright 2026
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef _IDENTDATA_RESULTLIST_HPP_
+#define _IDENTDATA_RESULTLIST_HPP_
+
+
+#include "pwiz/utility/misc/Export.hpp"
+#include "IdentData.hpp"
+
+
+namespace pwiz {
+namespace identdata {
+
+
+/// identifying information for a SpectrumIdentificationResult
+struct PWIZ_API_DECL ResultIdentity
+{
+    /// the position of the result in its ResultList
+    size_t index;
+
+    /// the id of the SpectrumIdentificationResult
+    std::string id;
+
+    /// the id of the identified spectrum in its SpectraData (SpectrumIdentificationResult::spectrumID)
+    std::string spectrumID;
+
+    ResultIdentity() : index(0) {}
+};
+
+
+///
+/// Interface for reading the SpectrumIdentificationResults of a file one at a time, in file order,
+/// without reading the whole file into an IdentData.
+///
+/// Each result is read when it is requested, with the Peptide, PeptideEvidence and DBSequence
+/// references of its SpectrumIdentificationItems resolved, so iterating over a file only needs
+/// memory for the index of its results and for the results that are kept.
+///
+class PWIZ_API_DECL ResultList
+{
+    public:
+
+    /// returns the number of results
+    virtual size_t size() const = 0;
+
+    /// returns true iff (size() == 0)
+    virtual bool empty() const;
+
+    /// access to a result index
+    virtual const ResultIdentity& resultIdentity(size_t index) const = 0;
+
+    /// returns the index of the first result for the given spectrum id, or size() if there is none;
+    /// the default implementation performs a linear search
+    virtual size_t findSpectrumID(const std::string& spectrumID) const;
+
+    /// reads the result at the given index; throws out_of_range for an invalid index
+    virtual SpectrumIdentificationResultPtr result(size_t index) const = 0;
+
+    virtual ~ResultList() {}
+};
+
+
+typedef boost::shared_ptr<ResultList> ResultListPtr;
+
+
+/// common functionality for ResultLists that index the identities of all their results up front
+class PWIZ_API_DECL ResultListBase : public ResultList
+{
+    public:
+
+    /// implementation of ResultList
+    virtual size_t size() const;
+    virtual const ResultIdentity& resultIdentity(size_t index) const;
+    virtual size_t findSpectrumID(const std::string& spectrumID) const;
+
+    protected:
+
+    /// filled in by implementations, with each identity's index equal to its position
+    std::vector<ResultIdentity> identities_;
+
+    /// sorts the identities for findSpectrumID(); call once identities_ is filled in
+    void indexSpectrumIDs();
+
+    private:
+
+    // positions in identities_, ordered by spectrumID and then by position
+    std::vector<size_t> bySpectrumID_;
+};
+
+
+} // namespace identdata
+} // namespace pwiz
+
+
+#endif // _IDENTDATA_RESULTLIST_HPP_
@@ -27,7 +27,10 @@
 #include "IO.hpp"
 #include "pwiz/utility/minimxml/XMLWriter.hpp"
 #include "pwiz/utility/minimxml/SAXParser.hpp"
+#include "pwiz/utility/misc/mru_list.hpp"
 #include "pwiz/utility/misc/Std.hpp"
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
 
 namespace pwiz {
 namespace identdata {
@@ -66,6 +69,174 @@ void Serializer_mzIdentML::read(shared_ptr<istream> is, IdentData& mzid,
              config_.readAnalysisData ? IO::ReadAnalysisData : IO::IgnoreAnalysisData);
 }
 
+
+namespace {
+
+
+// MRU cache of the elements of the SequenceCollection that results refer to, by id
+template <typename object_type>
+struct ElementCache
+{
+    typedef pair<string, shared_ptr<object_type> > value_type;
+    typedef util::mru_list<value_type, boost::multi_index::member<value_type, string, &value_type::first> > type;
+
+    struct SetElement
+    {
+        shared_ptr<object_type> element;
+        SetElement(const shared_ptr<object_type>& element) : element(element) {}
+        void operator() (value_type& idElementPair) {idElementPair.second = element;}
+    };
+};
+
+
+class ResultList_mzid : public ResultListBase
+{
+    public:
+
+    ResultList_mzid(const shared_ptr<istream>& is, const IdentData& metadata,
+                    const pwiz::util::IterationListenerRegistry* iterationListenerRegistry)
+    :   is_(is),
+        spectraData_(metadata.dataCollection.inputs.spectraData),
+        searchDatabases_(metadata.dataCollection.inputs.searchDatabase),
+        dbSequenceCache_(CacheSize), peptideCache_(CacheSize), peptideEvidenceCache_(CacheSize)
+    {
+        seek(0);
+        IO::read(*is_, index_, iterationListenerRegistry);
+
+        swap(identities_, index_.results);
+        indexSpectrumIDs();
+    }
+
+    virtual SpectrumIdentificationResultPtr result(size_t index) const
+    {
+        if (index >= identities_.size())
+            throw out_of_range("[ResultList_mzid::result()] Bad index: " + lexical_cast<string>(index));
+
+        boost::lock_guard<boost::mutex> lock(readMutex_);
+
+        SpectrumIdentificationResultPtr sir(new SpectrumIdentificationResult);
+        seek(index_.resultOffsets[index]);
+        IO::read(*is_, *sir, index_.version);
+
+        resolveFromList(sir->spectraDataPtr, spectraData_);
+
+        BOOST_FOREACH(SpectrumIdentificationItemPtr& sii, sir->spectrumIdentificationItem)
+        {
+            resolve(sii->peptidePtr, index_.peptides, peptideCache_);
+
+            // 1.0 PeptideEvidence elements are read with their SpectrumIdentificationItem
+            BOOST_FOREACH(PeptideEvidencePtr& pe, sii->peptideEvidencePtr)
+                if (!resolve(pe, index_.peptideEvidence, peptideEvidenceCache_))
+                    resolveReferences(*pe);
+        }
+
+        return sir;
+    }
+
+    private:
+
+    // many results refer to the same few thousand proteins and peptides at a time
+    static const size_t CacheSize = 10000;
+
+    shared_ptr<istream> is_;
+    IO::ElementIndex index_;
+    vector<SpectraDataPtr> spectraData_;
+    vector<SearchDatabasePtr> searchDatabases_;
+
+    mutable boost::mutex readMutex_;
+    mutable ElementCache<DBSequence>::type dbSequenceCache_;
+    mutable ElementCache<Peptide>::type peptideCache_;
+    mutable ElementCache<PeptideEvidence>::type peptideEvidenceCache_;
+
+    void seek(stream_offset offset) const
+    {
+        is_->clear();
+        is_->seekg(offset);
+        if (!*is_)
+            throw runtime_error("[ResultList_mzid::seek()] Error seeking to offset " + lexical_cast<string>(offset));
+    }
+
+    template <typename object_type>
+    static void resolveFromList(shared_ptr<object_type>& reference, const vector< shared_ptr<object_type> >& referentList)
+    {
+        if (!reference.get())
+            return;
+
+        BOOST_FOREACH(const shared_ptr<object_type>& referent, referentList)
+            if (referent->id == reference->id)
+            {
+                reference = referent;
+                return;
+            }
+    }
+
+    // replaces a reference with the element it refers to, from the cache or read from the stream;
+    // returns false if the element is not in the index
+    template <typename object_type>
+    bool resolve(shared_ptr<object_type>& reference,
+                 const map<string, stream_offset>& offsets,
+                 typename ElementCache<object_type>::type& cache) const
+    {
+        if (!reference.get() || reference->id.empty())
+            return false;
+
+        map<string, stream_offset>::const_iterator itr = offsets.find(reference->id);
+        if (itr == offsets.end())
+            return false;
+
+        // if insert returns true, the element was not in the cache
+        if (cache.insert(make_pair(reference->id, shared_ptr<object_type>())))
+        {
+            try
+            {
+                shared_ptr<object_type> element(new object_type);
+                seek(itr->second);
+                IO::read(*is_, *element, index_.version);
+                resolveReferences(*element);
+                cache.modify(cache.begin(), typename ElementCache<object_type>::SetElement(element));
+            }
+            catch (...)
+            {
+                cache.clear(); // don't leave the element's empty placeholder behind
+                throw;
+            }
+        }
+
+        reference = cache.mru().second;
+        return true;
+    }
+
+    void resolveReferences(Peptide& peptide) const {}
+
+    void resolveReferences(DBSequence& dbSequence) const
+    {
+        resolveFromList(dbSequence.searchDatabasePtr, searchDatabases_);
+    }
+
+    void resolveReferences(PeptideEvidence& pe) const
+    {
+        resolve(pe.peptidePtr, index_.peptides, peptideCache_);
+        resolve(pe.dbSequencePtr, index_.dbSequences, dbSequenceCache_);
+    }
+};
+
+
+} // namespace
+
+
+ResultListPtr Serializer_mzIdentML::readResults(shared_ptr<istream> is, IdentData& metadata,
+                                                const pwiz::util::IterationListenerRegistry* iterationListenerRegistry) const
+{
+    if (!is.get() || !*is)
+        throw runtime_error("[Serializer_mzIdentML::readResults()] Bad istream.");
+
+    is->seekg(0);
+
+    IO::read(*is, metadata, iterationListenerRegistry, IO::IgnoreSequenceCollection, IO::IgnoreAnalysisData);
+
+    return ResultListPtr(new ResultList_mzid(is, metadata, iterationListenerRegistry));
+}
+
 } // namespace pwiz 
 } // namespace identdata 
 
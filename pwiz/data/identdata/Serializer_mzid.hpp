@@ -26,6 +26,7 @@
 
 #include "pwiz/utility/misc/Export.hpp"
 #include "IdentData.hpp"
+#include "ResultList.hpp"
 #include "pwiz/utility/misc/IterationListener.hpp"
 
 
@@ -56,6 +57,12 @@ class PWIZ_API_DECL Serializer_mzIdentML
     void read(boost::shared_ptr<std::istream> is, IdentData& mzid,
               const pwiz::util::IterationListenerRegistry* = 0) const;
 
+    /// read in the metadata of a mzIdentML istream (everything but the SequenceCollection and
+    /// AnalysisData) and return its SpectrumIdentificationResults as a list that reads them one
+    /// at a time from the istream, which must stay open and must not be used by anything else
+    ResultListPtr readResults(boost::shared_ptr<std::istream> is, IdentData& metadata,
+                              const pwiz::util::IterationListenerRegistry* = 0) const;
+
     private:
     const Config config_;
     Serializer_mzIdentML(Serializer_mzIdentML&);
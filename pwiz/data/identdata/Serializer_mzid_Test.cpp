@@ -59,9 +59,82 @@ void testSerialize()
     unit_assert(!diff);
 }
 
+
+void testReadResults()
+{
+    if (os_) *os_ << "begin testReadResults\n";
+    IdentData mzid;
+    initializeTiny(mzid);
+
+    Serializer_mzIdentML ser;
+    ostringstream oss;
+    ser.write(oss, mzid);
+
+    IdentData metadata;
+    boost::shared_ptr<istream> iss(new istringstream(oss.str()));
+    ResultListPtr results = ser.readResults(iss, metadata);
+
+    // the metadata is read without the sequences and results
+    unit_assert(metadata.sequenceCollection.empty());
+    unit_assert(metadata.dataCollection.analysisData.spectrumIdentificationList.empty());
+    unit_assert_operator_equal(mzid.analysisSoftwareList.size(), metadata.analysisSoftwareList.size());
+
+    vector<SpectrumIdentificationResultPtr> expectedResults;
+    BOOST_FOREACH(const SpectrumIdentificationListPtr& sil, mzid.dataCollection.analysisData.spectrumIdentificationList)
+        expectedResults.insert(expectedResults.end(), sil->spectrumIdentificationResult.begin(), sil->spectrumIdentificationResult.end());
+    unit_assert_operator_equal(expectedResults.size(), results->size());
+    unit_assert(!results->empty());
+
+    // read the results twice, the second time from the caches
+    for (int pass=0; pass < 2; ++pass)
+    for (size_t i=0; i < results->size(); ++i)
+    {
+        const SpectrumIdentificationResult& expected = *expectedResults[i];
+        SpectrumIdentificationResultPtr result = results->result(i);
+
+        unit_assert_operator_equal(i, results->resultIdentity(i).index);
+        unit_assert_operator_equal(expected.id, results->resultIdentity(i).id);
+        unit_assert_operator_equal(expected.spectrumID, results->resultIdentity(i).spectrumID);
+        unit_assert_operator_equal(i, results->findSpectrumID(expected.spectrumID));
+
+        unit_assert_operator_equal(expected.id, result->id);
+        unit_assert_operator_equal(expected.spectrumID, result->spectrumID);
+        unit_assert_operator_equal(expected.spectraDataPtr->location, result->spectraDataPtr->location);
+        unit_assert_operator_equal(expected.spectrumIdentificationItem.size(), result->spectrumIdentificationItem.size());
+
+        for (size_t j=0; j < expected.spectrumIdentificationItem.size(); ++j)
+        {
+            const SpectrumIdentificationItem& expectedSii = *expected.spectrumIdentificationItem[j];
+            const SpectrumIdentificationItem& sii = *result->spectrumIdentificationItem[j];
+
+            unit_assert_operator_equal(expectedSii.id, sii.id);
+            unit_assert(!(Diff<ParamContainer, DiffConfig>(expectedSii, sii)));
+            unit_assert(!(Diff<Peptide, DiffConfig>(*expectedSii.peptidePtr, *sii.peptidePtr)));
+            unit_assert_operator_equal(expectedSii.peptideEvidencePtr.size(), sii.peptideEvidencePtr.size());
+
+            for (size_t k=0; k < sii.peptideEvidencePtr.size(); ++k)
+            {
+                const PeptideEvidence& expectedPe = *expectedSii.peptideEvidencePtr[k];
+                const PeptideEvidence& pe = *sii.peptideEvidencePtr[k];
+                unit_assert(!(Diff<PeptideEvidence, DiffConfig>(expectedPe, pe)));
+                unit_assert_operator_equal(expectedPe.peptidePtr->peptideSequence, pe.peptidePtr->peptideSequence);
+                unit_assert_operator_equal(expectedPe.dbSequencePtr->accession, pe.dbSequencePtr->accession);
+                unit_assert_operator_equal(expectedPe.dbSequencePtr->seq, pe.dbSequencePtr->seq);
+                unit_assert_operator_equal(expectedPe.dbSequencePtr->searchDatabasePtr->location,
+                                           pe.dbSequencePtr->searchDatabasePtr->location);
+            }
+        }
+    }
+
+    unit_assert_operator_equal(results->size(), results->findSpectrumID("not a spectrum"));
+    unit_assert_throws(results->result(results->size()), out_of_range);
+}
+
+
 void test()
 {
     testSerialize();
+    testReadResults();
 }
 
 int main(int argc, char** argv)
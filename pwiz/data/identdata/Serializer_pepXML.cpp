@@ -34,6 +34,8 @@
 #include "pwiz/data/proteome/AminoAcid.hpp"
 #include "pwiz/data/common/CVTranslator.hpp"
 #include "pwiz/utility/misc/Singleton.hpp"
+#include "boost/thread/mutex.hpp"
+#include "boost/thread/locks.hpp"
 #include "boost/xpressive/xpressive_dynamic.hpp"
 #include "boost/range/adaptor/transformed.hpp"
 #include "boost/range/algorithm/min_element.hpp"
@@ -1509,6 +1511,29 @@ struct PeptideLessThan
     }
 };
 
+// returns the nativeID of the spectrum of a spectrum_query: the spectrumNativeID attribute if there is one,
+// otherwise the spectrum attribute or, for scan number only nativeIDs, one made from the start_scan attribute
+string getSpectrumNativeID(const SAXParser::Handler::Attributes& attributes, CVID nativeIdFormat)
+{
+    const char* spectrumNativeID = attributes.findValueByName("spectrumNativeID");
+    if (spectrumNativeID && *spectrumNativeID)
+        return spectrumNativeID;
+
+    if (nativeIdFormat != MS_scan_number_only_nativeID_format)
+    {
+        const char* spectrum = attributes.findValueByName("spectrum");
+        return spectrum ? spectrum : "";
+    }
+
+    const char* startScanValue = attributes.findValueByName("start_scan");
+    string start_scan = startScanValue ? startScanValue : "";
+    string result = msdata::id::translateScanNumberToNativeID(nativeIdFormat, start_scan);
+    if (result.empty())
+        result = "scan=" + start_scan;
+    return result;
+}
+
+
 struct HandlerSearchResults : public SAXParser::Handler
 {
     IdentData* _mzid;
@@ -1516,6 +1541,9 @@ struct HandlerSearchResults : public SAXParser::Handler
     SpectrumIdentificationList* _sil;
     CVID nativeIdFormat;
 
+    // prepended to the ids of the Peptides that are read
+    string peptideIdPrefix;
+
     HandlerSearchResults(const CVTranslator& cvTranslator,
                          const IterationListenerRegistry* iterationListenerRegistry,
                          bool strict)
@@ -1528,6 +1556,19 @@ struct HandlerSearchResults : public SAXParser::Handler
     {
     }
 
+    // forgets the results and peptides read so far, so that spectrum queries can be read one result at a time
+    void clearResults()
+    {
+        _sir.reset();
+        _resultMap.clear();
+        _peptides.clear();
+        _currentPeptide.reset();
+        peptideCount = 0;
+    }
+
+    // the next search hit is numbered after searchHitCount
+    void setSearchHitCount(int searchHitCount) {siiCount = searchHitCount;}
+
     bool setDBSequenceParams(const string& accession,
                              const ParamContainer& params)
     {
@@ -1608,7 +1649,7 @@ struct HandlerSearchResults : public SAXParser::Handler
                 // if the variant was added, give it an id
                 if (insertResult.second)
                 {
-                    _currentPeptide->id = "PEP_";
+                    _currentPeptide->id = peptideIdPrefix + "PEP_";
                     _currentPeptide->id += lexical_cast<string>(++peptideCount);
                     _mzid->sequenceCollection.peptides.push_back(_currentPeptide);
 
@@ -1730,25 +1771,9 @@ struct HandlerSearchResults : public SAXParser::Handler
             SpectrumIdentificationResultPtr& sir = _resultMap[spectrumWithoutCharge];
             if (!sir.get())
             {
-                string spectrumNativeID;
-                getAttribute(attributes, "spectrumNativeID", spectrumNativeID);
-                if (spectrumNativeID.empty())
-                {
-                    if (nativeIdFormat != MS_scan_number_only_nativeID_format)
-                        spectrumNativeID = spectrum;
-                    else
-                    {
-                        string start_scan;
-                        getAttribute(attributes, "start_scan", start_scan);
-                        spectrumNativeID = msdata::id::translateScanNumberToNativeID(nativeIdFormat, start_scan);
-                        if (spectrumNativeID.empty())
-                            spectrumNativeID = "scan=" + start_scan;
-                    }
-                }
-
                 sir.reset(new SpectrumIdentificationResult);
                 sir->id = "SIR_" + lexical_cast<string>(_sil->spectrumIdentificationResult.size()+1);
-                sir->spectrumID = spectrumNativeID;
+                sir->spectrumID = getSpectrumNativeID(attributes, nativeIdFormat);
                 sir->name = spectrumWithoutCharge;
                 sir->spectraDataPtr = _mzid->dataCollection.inputs.spectraData[0];
 
@@ -1962,6 +1987,177 @@ struct Handler_pepXML : public SAXParser::Handler
     bool strict;
 };
 
+
+// finds the spectrum_query elements of a pepXML file and groups them into results the way
+// HandlerSearchResults does: the queries of a spectrum (one per assumed charge) make up one result,
+// and a result is only kept (and numbered) once one of its queries has a search_hit
+struct HandlerSpectrumQueryIndex : public SAXParser::Handler
+{
+    struct SpectrumQuery
+    {
+        stream_offset position;
+        int searchHitCount; // the number of search_hits before this query
+        size_t result; // index into results
+    };
+
+    CVID nativeIdFormat;
+    vector<ResultIdentity> results;
+    vector<SpectrumQuery> queries;
+
+    HandlerSpectrumQueryIndex(CVID nativeIdFormat, const IterationListenerRegistry* ilr)
+    :   nativeIdFormat(nativeIdFormat), searchHitCount(0), ilr(ilr)
+    {
+    }
+
+    // drops the queries of spectra without search hits
+    void finish()
+    {
+        vector<SpectrumQuery> hitQueries;
+        BOOST_FOREACH(const SpectrumQuery& query, queries)
+            if (candidateResults[query.result] < results.size())
+            {
+                hitQueries.push_back(query);
+                hitQueries.back().result = candidateResults[query.result];
+            }
+        queries.swap(hitQueries);
+    }
+
+    virtual Status startElement(const string& name, const Attributes& attributes, stream_offset position)
+    {
+        if (name == "spectrum_query")
+        {
+            if (ilr && ilr->broadcastUpdateMessage(IterationListener::UpdateMessage(results.size(), 0, "indexing spectrum queries")) == IterationListener::Status_Cancel)
+                return Status::Done;
+
+            string spectrum;
+            getAttribute(attributes, "spectrum", spectrum);
+
+            pair<map<string, size_t>::iterator, bool> insertResult =
+                candidateBySpectrum.insert(make_pair(stripChargeFromConventionalSpectrumId(spectrum), candidates.size()));
+            if (insertResult.second)
+            {
+                candidates.push_back(ResultIdentity());
+                candidates.back().id = "SIR_" + lexical_cast<string>(results.size()+1);
+                candidates.back().spectrumID = getSpectrumNativeID(attributes, nativeIdFormat);
+                candidateResults.push_back(size_t(-1));
+            }
+
+            SpectrumQuery query = {position, searchHitCount, insertResult.first->second};
+            queries.push_back(query);
+        }
+        else if (name == "search_hit")
+        {
+            ++searchHitCount;
+
+            size_t& result = candidateResults[queries.back().result];
+            if (result == size_t(-1))
+            {
+                result = results.size();
+                results.push_back(candidates[queries.back().result]);
+                results.back().index = result;
+            }
+        }
+        return Status::Ok;
+    }
+
+    private:
+    int searchHitCount;
+    const IterationListenerRegistry* ilr;
+
+    // results for every spectrum, including ones that may never get a search hit
+    map<string, size_t> candidateBySpectrum;
+    vector<ResultIdentity> candidates;
+    vector<size_t> candidateResults; // index into results, or -1
+};
+
+
+// reads the spectrum queries of each result on demand, using the queries' offsets from HandlerSpectrumQueryIndex
+class ResultList_pepXML : public ResultListBase
+{
+    public:
+
+    ResultList_pepXML(const boost::shared_ptr<istream>& is, const IdentData& metadata, const IterationListenerRegistry* ilr)
+    :   is_(is),
+        handler_(cvTranslator_, 0, false),
+        sil_(new SpectrumIdentificationList("SIL"))
+    {
+        const SpectrumIdentificationProtocolPtr& sip = metadata.analysisProtocolCollection.spectrumIdentificationProtocol[0];
+
+        // results refer to the SpectraData and SearchDatabase of the metadata
+        mzid_.dataCollection.inputs = metadata.dataCollection.inputs;
+
+        handler_._mzid = &mzid_;
+        handler_._sip = sip.get();
+        handler_._sil = sil_.get();
+        if (!metadata.dataCollection.inputs.spectraData.empty())
+            handler_.nativeIdFormat = metadata.dataCollection.inputs.spectraData[0]->spectrumIDFormat.cvid;
+
+        // snaps the modifications of each result; the search modifications were snapped with the metadata
+        SpectrumIdentificationProtocolPtr snapSip(new SpectrumIdentificationProtocol(sip->id));
+        snapSip->parentTolerance = sip->parentTolerance;
+        si_.spectrumIdentificationProtocolPtr = snapSip;
+        si_.spectrumIdentificationListPtr = sil_;
+
+        is_->clear();
+        is_->seekg(0);
+        HandlerSpectrumQueryIndex handler(handler_.nativeIdFormat, ilr);
+        SAXParser::parse(*is_, handler);
+        handler.finish();
+
+        identities_.swap(handler.results);
+        indexSpectrumIDs();
+
+        queryBegin_.resize(identities_.size()+1, 0);
+        BOOST_FOREACH(const HandlerSpectrumQueryIndex::SpectrumQuery& query, handler.queries)
+            ++queryBegin_[query.result+1];
+        for (size_t i=1; i < queryBegin_.size(); ++i)
+            queryBegin_[i] += queryBegin_[i-1];
+
+        queries_.resize(handler.queries.size());
+        vector<size_t> next(queryBegin_.begin(), queryBegin_.end()-1);
+        BOOST_FOREACH(const HandlerSpectrumQueryIndex::SpectrumQuery& query, handler.queries)
+            queries_[next[query.result]++] = query;
+    }
+
+    virtual SpectrumIdentificationResultPtr result(size_t index) const
+    {
+        const ResultIdentity& identity = resultIdentity(index);
+
+        boost::lock_guard<boost::mutex> lock(mutex_);
+
+        // the queries of a result share its SpectrumIdentificationResult and Peptides
+        handler_.clearResults();
+        handler_.peptideIdPrefix = identity.id + "_";
+        for (size_t i=queryBegin_[index]; i < queryBegin_[index+1]; ++i)
+        {
+            handler_.setSearchHitCount(queries_[i].searchHitCount);
+            is_->clear();
+            is_->seekg(queries_[i].position);
+            SAXParser::parse(*is_, handler_);
+        }
+        SpectrumIdentificationResultPtr sir = sil_->spectrumIdentificationResult.at(0);
+        sir->id = identity.id;
+
+        snapModificationsToUnimod(si_);
+
+        sil_->spectrumIdentificationResult.clear();
+        mzid_.sequenceCollection.peptides.clear();
+        mzid_.sequenceCollection.peptideEvidence.clear();
+        return sir;
+    }
+
+    private:
+    boost::shared_ptr<istream> is_;
+    CVTranslator cvTranslator_;
+    mutable IdentData mzid_;
+    mutable HandlerSearchResults handler_;
+    SpectrumIdentificationListPtr sil_;
+    SpectrumIdentification si_;
+    vector<HandlerSpectrumQueryIndex::SpectrumQuery> queries_; // ordered by result
+    vector<size_t> queryBegin_; // the queries of result i are [queryBegin_[i], queryBegin_[i+1])
+    mutable boost::mutex mutex_;
+};
+
 } // namespace
 
 
@@ -1993,6 +2189,24 @@ PWIZ_API_DECL void Serializer_pepXML::read(boost::shared_ptr<std::istream> is, I
 }
 
 
+PWIZ_API_DECL ResultListPtr Serializer_pepXML::readResults(boost::shared_ptr<std::istream> is, IdentData& metadata,
+                                                           const pwiz::util::IterationListenerRegistry* iterationListenerRegistry) const
+{
+    if (!is.get() || !*is)
+        throw runtime_error("[Serializer_pepXML::readResults()] Bad istream.");
+
+    is->seekg(0);
+
+    // read up to the first spectrum_query
+    Handler_pepXML handler(metadata, false, iterationListenerRegistry, false);
+    SAXParser::parse(*is, handler);
+
+    snapModificationsToUnimod(*metadata.analysisCollection.spectrumIdentification[0]);
+
+    return ResultListPtr(new ResultList_pepXML(is, metadata, iterationListenerRegistry));
+}
+
+
 namespace {
   
 const string allResidues = "ABCDEFGHIJKLMNOPQRSTUVWYZ";
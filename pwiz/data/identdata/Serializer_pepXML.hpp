@@ -25,6 +25,7 @@
 
 #include "pwiz/utility/misc/Export.hpp"
 #include "IdentData.hpp"
+#include "ResultList.hpp"
 #include "pwiz/utility/misc/IterationListener.hpp"
 
 
@@ -55,6 +56,12 @@ class PWIZ_API_DECL Serializer_pepXML
     void read(boost::shared_ptr<std::istream> is, IdentData& mzid,
               const pwiz::util::IterationListenerRegistry* = 0) const;
 
+    /// read the metadata of a pepXML istream (everything before the first spectrum_query) into an IdentData,
+    /// and return a list that reads its SpectrumIdentificationResults on demand; the istream must stay
+    /// seekable and must not be used by anything else while the list is in use
+    ResultListPtr readResults(boost::shared_ptr<std::istream> is, IdentData& metadata,
+                              const pwiz::util::IterationListenerRegistry* = 0) const;
+
     private:
     const Config config_;
     Serializer_pepXML(Serializer_pepXML&);
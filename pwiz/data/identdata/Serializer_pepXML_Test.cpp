@@ -260,6 +260,86 @@ void testSerialize()
     testSerializeReally(mzid, Serializer_pepXML::Config(false));
 }
 
+void testReadResults()
+{
+    if (os_) *os_ << "begin testReadResults" << endl;
+
+    IdentData mzid;
+    initializeBasicSpectrumIdentification(mzid);
+    stripUnmappedMetadata(mzid);
+
+    Serializer_pepXML serializer;
+    ostringstream oss;
+    serializer.write(oss, mzid, "tiny.pepXML");
+
+    // the results read one at a time should match the results read all at once
+    IdentData expected;
+    serializer.read(shared_ptr<istream>(new istringstream(oss.str())), expected);
+
+    IdentData metadata;
+    ResultListPtr results = serializer.readResults(shared_ptr<istream>(new istringstream(oss.str())), metadata);
+
+    unit_assert(metadata.sequenceCollection.empty());
+    unit_assert(metadata.dataCollection.analysisData.spectrumIdentificationList.empty());
+    Diff<SpectrumIdentificationProtocol, DiffConfig> sipDiff(*expected.analysisProtocolCollection.spectrumIdentificationProtocol[0],
+                                                             *metadata.analysisProtocolCollection.spectrumIdentificationProtocol[0]);
+    if (os_ && sipDiff) *os_ << sipDiff << endl;
+    unit_assert(!sipDiff);
+
+    const vector<SpectrumIdentificationResultPtr>& expectedResults = expected.dataCollection.analysisData.spectrumIdentificationList[0]->spectrumIdentificationResult;
+    unit_assert_operator_equal(expectedResults.size(), results->size());
+
+    // read the results in reverse to check that they do not depend on the results read before them
+    for (size_t i=results->size(); i > 0; --i)
+    {
+        const SpectrumIdentificationResult& expectedSir = *expectedResults[i-1];
+        SpectrumIdentificationResultPtr sir = results->result(i-1);
+
+        unit_assert_operator_equal(expectedSir.id, results->resultIdentity(i-1).id);
+        unit_assert_operator_equal(expectedSir.spectrumID, results->resultIdentity(i-1).spectrumID);
+        unit_assert_operator_equal(i-1, results->findSpectrumID(expectedSir.spectrumID));
+
+        unit_assert_operator_equal(expectedSir.id, sir->id);
+        unit_assert_operator_equal(expectedSir.spectrumID, sir->spectrumID);
+        unit_assert_operator_equal(expectedSir.name, sir->name);
+        unit_assert(!(Diff<ParamContainer, DiffConfig>(expectedSir, *sir)));
+        unit_assert_operator_equal(expectedSir.spectraDataPtr->location, sir->spectraDataPtr->location);
+        unit_assert_operator_equal(expectedSir.spectrumIdentificationItem.size(), sir->spectrumIdentificationItem.size());
+
+        for (size_t j=0; j < sir->spectrumIdentificationItem.size(); ++j)
+        {
+            const SpectrumIdentificationItem& expectedSii = *expectedSir.spectrumIdentificationItem[j];
+            const SpectrumIdentificationItem& sii = *sir->spectrumIdentificationItem[j];
+
+            unit_assert_operator_equal(expectedSii.id, sii.id);
+            unit_assert_operator_equal(expectedSii.chargeState, sii.chargeState);
+            unit_assert(!(Diff<ParamContainer, DiffConfig>(expectedSii, sii)));
+
+            // peptide ids are only unique within a result
+            unit_assert_operator_equal(expectedSii.peptidePtr->peptideSequence, sii.peptidePtr->peptideSequence);
+            unit_assert(bal::starts_with(sii.peptidePtr->id, sir->id));
+            unit_assert_operator_equal(expectedSii.peptidePtr->modification.size(), sii.peptidePtr->modification.size());
+            for (size_t k=0; k < sii.peptidePtr->modification.size(); ++k)
+                unit_assert(!(Diff<Modification, DiffConfig>(*expectedSii.peptidePtr->modification[k], *sii.peptidePtr->modification[k])));
+
+            unit_assert_operator_equal(expectedSii.peptideEvidencePtr.size(), sii.peptideEvidencePtr.size());
+            for (size_t k=0; k < sii.peptideEvidencePtr.size(); ++k)
+            {
+                const PeptideEvidence& expectedPe = *expectedSii.peptideEvidencePtr[k];
+                const PeptideEvidence& pe = *sii.peptideEvidencePtr[k];
+                unit_assert_operator_equal(expectedPe.pre, pe.pre);
+                unit_assert_operator_equal(expectedPe.post, pe.post);
+                unit_assert_operator_equal(expectedPe.dbSequencePtr->accession, pe.dbSequencePtr->accession);
+                unit_assert_operator_equal(expectedPe.dbSequencePtr->searchDatabasePtr->location,
+                                           pe.dbSequencePtr->searchDatabasePtr->location);
+            }
+        }
+    }
+
+    unit_assert_operator_equal(results->size(), results->findSpectrumID("not a spectrum"));
+    unit_assert_throws(results->result(results->size()), out_of_range);
+}
+
 void testPepXMLSpecificity()
 {
     PepXMLSpecificity result;
@@ -437,6 +517,7 @@ int main(int argc, char** argv)
         testStripChargeFromConventionalSpectrumId();
         testTranslation();
         testSerialize();
+        testReadResults();
     }
     catch (exception& e)
     {
@@ -37,6 +37,12 @@
 #include "boost/iostreams/device/array.hpp"
 #include "pwiz/utility/misc/Std.hpp"
 #include "pwiz/data/msdata/MSNumpress.hpp"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PWIZ_BINARYDATAENCODER_SSE2
+#include <emmintrin.h>
+#endif
 
 namespace pwiz {
 namespace msdata {
@@ -66,6 +72,7 @@ class BinaryDataEncoder::Impl
     {
         decode(encodedData.c_str(),encodedData.length(),result);
     }
+    void decode(const char *encodedData, size_t len, vector<float>& result);
     const Config & getConfig() const
     {
         return config_;
@@ -332,8 +339,35 @@ void BinaryDataEncoder::Impl::encode(const double* data, size_t dataSize, std::s
 }
 
 
-template <typename float_type>
-void copyBuffer(const void* byteBuffer, size_t byteCount, vector<double>& result)
+// widens count floats packed at the start of buffer into the doubles of buffer;
+// going backwards, each store only overwrites floats that have already been read
+void widenFloatsInPlace(double* buffer, size_t count)
+{
+    const char* floats = reinterpret_cast<const char*>(buffer);
+    size_t i = count;
+
+#ifdef PWIZ_BINARYDATAENCODER_SSE2
+    while (i >= 4)
+    {
+        i -= 4;
+        __m128 f = _mm_loadu_ps(reinterpret_cast<const float*>(floats + i*sizeof(float)));
+        _mm_storeu_pd(buffer + i + 2, _mm_cvtps_pd(_mm_movehl_ps(f, f)));
+        _mm_storeu_pd(buffer + i, _mm_cvtps_pd(f));
+    }
+#endif
+
+    while (i > 0)
+    {
+        --i;
+        float f;
+        memcpy(&f, floats + i*sizeof(float), sizeof(float));
+        buffer[i] = f;
+    }
+}
+
+
+template <typename float_type, typename value_type>
+void copyBuffer(const void* byteBuffer, size_t byteCount, vector<value_type>& result)
 {
     const float_type* floatBuffer = reinterpret_cast<const float_type*>(byteBuffer);
 
@@ -352,6 +386,28 @@ void BinaryDataEncoder::Impl::decode(const char *encodedData, size_t length, vec
 {
     if (!encodedData || !length) return;
 
+    #ifdef PWIZ_LITTLE_ENDIAN
+    bool nativeByteOrder = (config_.byteOrder == ByteOrder_LittleEndian);
+    #elif defined(PWIZ_BIG_ENDIAN)
+    bool nativeByteOrder = (config_.byteOrder == ByteOrder_BigEndian);
+    #endif
+
+    // uncompressed native values: Base64 decode straight into the result array,
+    // widening floats in place
+
+    if (config_.compression == Compression_None && config_.numpress == Numpress_None && nativeByteOrder)
+    {
+        size_t valueSize = config_.precision == Precision_64 ? sizeof(double) : sizeof(float);
+        result.resize((Base64::textToBinarySize(length) + valueSize - 1) / valueSize);
+        size_t binarySize = Base64::textToBinary(encodedData, length, &result[0]);
+        if (binarySize % valueSize != 0)
+            throw runtime_error("[BinaryDataEncoder::decode()] Bad byteCount.");
+        if (config_.precision == Precision_32)
+            widenFloatsInPlace(&result[0], binarySize / sizeof(float));
+        result.resize(binarySize / valueSize);
+        return;
+    }
+
     // Base64 decoding
 
     vector<unsigned char> binary(Base64::textToBinarySize(length));
@@ -465,6 +521,67 @@ void BinaryDataEncoder::Impl::decode(const char *encodedData, size_t length, vec
 }
 
 
+void BinaryDataEncoder::Impl::decode(const char *encodedData, size_t length, vector<float>& result)
+{
+    result.clear();
+    if (!encodedData || !length) return;
+
+    if (config_.precision != Precision_32 || config_.numpress != Numpress_None)
+    {
+        vector<double> decoded;
+        decode(encodedData, length, decoded);
+        result.assign(decoded.begin(), decoded.end());
+        return;
+    }
+
+    #ifdef PWIZ_LITTLE_ENDIAN
+    bool mustEndianize = (config_.byteOrder == ByteOrder_BigEndian);
+    #elif defined(PWIZ_BIG_ENDIAN)
+    bool mustEndianize = (config_.byteOrder == ByteOrder_LittleEndian);
+    #endif
+
+    if (config_.compression == Compression_None && !mustEndianize)
+    {
+        result.resize((Base64::textToBinarySize(length) + sizeof(float) - 1) / sizeof(float));
+        size_t binarySize = Base64::textToBinary(encodedData, length, &result[0]);
+        if (binarySize % sizeof(float) != 0)
+            throw runtime_error("[BinaryDataEncoder::decode()] Bad byteCount.");
+        result.resize(binarySize / sizeof(float));
+        return;
+    }
+
+    vector<unsigned char> binary(Base64::textToBinarySize(length));
+    size_t binarySize = Base64::textToBinary(encodedData, length, &binary[0]);
+    binary.resize(binarySize);
+
+    void* byteBuffer = &binary[0];
+    size_t byteCount = binarySize;
+
+    vector<unsigned char> decompressed;
+    switch (config_.compression) {
+        case Compression_Zlib:
+            filterArray<zlib_decompressor>(byteBuffer, byteCount, decompressed);
+            if (decompressed.empty())
+                throw runtime_error("[BinaryDataEncoder::decode()] Compression error?");
+            byteBuffer = reinterpret_cast<void*>(&decompressed[0]);
+            byteCount = decompressed.size();
+            break;
+        case Compression_None:
+            break;
+        default:
+            throw runtime_error("[BinaryDataEncoder::decode()] unknown compression type");
+    }
+
+    if (mustEndianize)
+    {
+        unsigned int* p = reinterpret_cast<unsigned int*>(byteBuffer);
+        transform(p, p+byteCount/sizeof(float), p, endianize32);
+    }
+
+    copyBuffer<float>(byteBuffer, byteCount, result);
+}
+
+
 //
 // BinaryDataEncoder
 //
@@ -491,6 +608,11 @@ PWIZ_API_DECL void BinaryDataEncoder::decode(const char * encodedData, size_t le
     impl_->decode(encodedData, len, result);
 }
 
+PWIZ_API_DECL void BinaryDataEncoder::decode(const char * encodedData, size_t len, std::vector<float>& result) const
+{
+    impl_->decode(encodedData, len, result);
+}
+
 PWIZ_API_DECL const BinaryDataEncoder::Config& BinaryDataEncoder::getConfig() const // get the config actually used - may differ from input for numpress use
 {
     return impl_->getConfig();
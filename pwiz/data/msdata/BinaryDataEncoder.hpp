@@ -94,6 +94,10 @@ class PWIZ_API_DECL BinaryDataEncoder
         decode(encodedData.c_str(),encodedData.length(),result);
     }
 
+    /// decode text-encoded data as single precision binary: 32-bit arrays without numpress
+    /// are copied without widening, anything else is decoded as usual and then narrowed
+    void decode(const char *encodedData, size_t len, std::vector<float>& result) const;
+
     private:
     class Impl;
     boost::shared_ptr<Impl> impl_;
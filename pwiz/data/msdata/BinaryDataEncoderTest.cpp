@@ -229,6 +229,14 @@ void testConfiguration(const BinaryDataEncoder::Config& config_in)
         break;
     }
     if (os_) *os_ << "validated with epsilon: " << fixed << setprecision(1) << scientific << epsilon << "\n\n";
+
+    // decoding at single precision gives the double precision result, narrowed
+
+    vector<float> decoded32;
+    encoder.decode(encoded.c_str(), encoded.size(), decoded32);
+    unit_assert(decoded32.size() == decoded.size());
+    for (size_t i=0; i < decoded.size(); ++i)
+        unit_assert(decoded32[i] == float(decoded[i]));
 }
 
 
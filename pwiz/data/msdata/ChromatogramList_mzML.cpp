@@ -59,12 +59,13 @@ class ChromatogramList_mzMLImpl : public ChromatogramList_mzML
     private:
     shared_ptr<istream> is_;
     const MSData& msd_;
+    References::Referents referents_;
     Index_mzML_Ptr index_;
 };
 
 
 ChromatogramList_mzMLImpl::ChromatogramList_mzMLImpl(shared_ptr<istream> is, const MSData& msd, const Index_mzML_Ptr& index)
-:   is_(is), msd_(msd), index_(index)
+:   is_(is), msd_(msd), referents_(msd), index_(index)
 {
 }
 
@@ -122,7 +123,7 @@ ChromatogramPtr ChromatogramList_mzMLImpl::chromatogram(size_t index, bool getBi
 
     // resolve any references into the MSData object
 
-    References::resolve(*result, msd_);
+    References::resolve(*result, referents_);
 
     return result;
 }
@@ -138,20 +138,24 @@ PWIZ_API_DECL void Reader_mzML::read(const std::string& filename,
     if (!is.get() || !*is)
         throw runtime_error(("[Reader_mzML::read] Unable to open file " + filename).c_str());
 
+    Serializer_mzML::Config serializerConfig;
+    serializerConfig.persistIndex = config.persistIndex;
+    serializerConfig.memoryMap = config.memoryMap;
+    serializerConfig.float32Storage = config.float32Storage;
+
     switch (type(*is))
     {
         case Type_mzML:
         {
-            Serializer_mzML::Config config;
-            config.indexed = false;
-            Serializer_mzML serializer(config);
-            serializer.read(is, result);
+            serializerConfig.indexed = false;
+            Serializer_mzML serializer(serializerConfig);
+            serializer.read(is, result, filename);
             break;
         }
         case Type_mzML_Indexed:
         {
-            Serializer_mzML serializer;
-            serializer.read(is, result);
+            Serializer_mzML serializer(serializerConfig);
+            serializer.read(is, result, filename);
             break;
         }
         case Type_Unknown:
@@ -461,7 +465,9 @@ PWIZ_API_DECL void Reader_mz5::read(const string& filename,
     if (runIndex != 0)
         throw ReaderFail("[Reader_mz5::read] multiple runs not supported, yet...");
 
-    Serializer_mz5 serializer;
+    mz5::Configuration_mz5 mz5Config;
+    mz5Config.setBinaryDataAccessPolicy(mz5::Configuration_mz5::toBinaryDataAccessPolicy(config.binaryDataAccessPolicy));
+    Serializer_mz5 serializer(mz5Config);
     serializer.read(filename, result);
 
     // TODO: add "conversion to mz5 tag", sourceFile history and pwiz
@@ -479,7 +485,7 @@ PWIZ_API_DECL void Reader_mz5::read(const std::string& filename,
 {
     // TODO multiple read mz5
     results.push_back(MSDataPtr(new MSData));
-    read(filename, head, *results.back());
+    read(filename, head, *results.back(), 0, config);
 }
 
 
@@ -339,16 +339,22 @@ void diff(const BinaryDataArray& a,
         diff(static_cast<const ParamContainer&>(a), b, a_b, b_a, config);
     }
 
-    if (a.data.size() != b.data.size())
+    if (a.size() != b.size())
     {
         a_b.userParams.push_back(UserParam("Binary data array size: " + 
-                                           lexical_cast<string>(a.data.size())));
+                                           lexical_cast<string>(a.size())));
         b_a.userParams.push_back(UserParam("Binary data array size: " + 
-                                           lexical_cast<string>(b.data.size())));
+                                           lexical_cast<string>(b.size())));
     }
     else
     {
-        pair<size_t, double> max = maxdiff(a.data, b.data);
+        // arrays held at single precision are compared at double precision
+        vector<double> aWidened, bWidened;
+        if (a.storedAsFloat32()) aWidened.assign(a.floatData.begin(), a.floatData.end());
+        if (b.storedAsFloat32()) bWidened.assign(b.floatData.begin(), b.floatData.end());
+
+        pair<size_t, double> max = maxdiff(a.storedAsFloat32() ? aWidened : a.data,
+                                           b.storedAsFloat32() ? bWidened : b.data);
        
         if (max.second > config.precision + numeric_limits<double>::epsilon())
         {
@@ -29,6 +29,9 @@
 #include "pwiz/utility/misc/Filesystem.hpp"
 #include "pwiz/utility/misc/Std.hpp"
 #include "SpectrumWorkerThreads.hpp"
+#include "pwiz/utility/misc/WorkerPool.hpp"
+#include <boost/thread.hpp>
+#include <deque>
 
 namespace pwiz {
 namespace msdata {
@@ -185,7 +188,9 @@ struct HandlerCVParam : public SAXParser::Handler
         if (accession)
             cvParam->cvid = cvTermInfo(accession).cvid;
 
-        getAttribute(attributes, "value", cvParam->value);
+        string value;
+        getAttribute(attributes, "value", value);
+        cvParam->setValue(value);
 
         const char *unitAccession = getAttribute(attributes, "unitAccession", NoXMLUnescape); 
         if (unitAccession)
@@ -1618,7 +1623,10 @@ void write(minimxml::XMLWriter& writer, const BinaryDataArray& binaryDataArray,
 
     BinaryDataEncoder encoder(usedConfig);
     string encoded;
-    encoder.encode(binaryDataArray.data, encoded);
+    if (binaryDataArray.storedAsFloat32())
+        encoder.encode(vector<double>(binaryDataArray.floatData.begin(), binaryDataArray.floatData.end()), encoded);
+    else
+        encoder.encode(binaryDataArray.data, encoded);
     usedConfig = encoder.getConfig(); // config may have changed if numpress error was excessive
 
     XMLWriter::Attributes attributes;
@@ -1628,7 +1636,7 @@ void write(minimxml::XMLWriter& writer, const BinaryDataArray& binaryDataArray,
         !binaryDataArray.hasCVParam(MS_time_array) &&
         !binaryDataArray.hasCVParam(MS_intensity_array))
     {
-        attributes.add("arrayLength", binaryDataArray.data.size());
+        attributes.add("arrayLength", binaryDataArray.size());
     }
 
     attributes.add("encodedLength", encoded.size());
@@ -1699,12 +1707,14 @@ struct HandlerBinaryDataArray : public HandlerParamContainer
     BinaryDataArray* binaryDataArray;
     const MSData* msd;
     size_t defaultArrayLength;
+    bool float32Storage; // keep 32-bit float arrays in BinaryDataArray::floatData
     BinaryDataEncoder::Config config;
 
     HandlerBinaryDataArray(BinaryDataArray* _binaryDataArray = 0, const MSData* _msd = 0)
     :   binaryDataArray(_binaryDataArray),
         msd(_msd),
         defaultArrayLength(0),
+        float32Storage(false),
         arrayLength_(0),
         encodedLength_(0)
     {
@@ -1749,25 +1759,48 @@ struct HandlerBinaryDataArray : public HandlerParamContainer
 
     virtual Status characters(const SAXParser::saxstring& text,
                               stream_offset position)
+    {
+        return decode(text.c_str(), text.length(), position);
+    }
+
+    // decodes straight from the parser's source when it is in memory (e.g. a mapped file)
+    virtual Status charactersInPlace(const char* begin, const char* end,
+                                     stream_offset position)
+    {
+        return decode(begin, end - begin, position);
+    }
+
+    private:
+
+    Status decode(const char* text, size_t length, stream_offset position)
     {
         if (!binaryDataArray)
             throw runtime_error("[IO::HandlerBinaryDataArray] Null binaryDataArray."); 
 
         BinaryDataEncoder encoder(config);
-        encoder.decode(text.c_str(), text.length(), binaryDataArray->data); 
+        if (float32Storage &&
+            config.precision == BinaryDataEncoder::Precision_32 &&
+            config.numpress == BinaryDataEncoder::Numpress_None)
+        {
+            binaryDataArray->data.clear();
+            encoder.decode(text, length, binaryDataArray->floatData);
+        }
+        else
+        {
+            binaryDataArray->floatData.clear();
+            encoder.decode(text, length, binaryDataArray->data);
+        }
 
-        if (binaryDataArray->data.size() != arrayLength_)
+        if (binaryDataArray->size() != arrayLength_)
             throw runtime_error((format("[IO::HandlerBinaryDataArray] At position %d: expected array of size %d, but decoded array is actually size %d.")
-                                 % position % arrayLength_ % binaryDataArray->data.size()).str()); 
+                                 % position % arrayLength_ % binaryDataArray->size()).str()); 
 
-        if (text.length() != encodedLength_)
+        if (length != encodedLength_)
             throw runtime_error("[IO::HandlerBinaryDataArray] At position " + lexical_cast<string>(position) + ": encoded lengths differ."); 
 
         return Status::Ok;
     }
 
-    private:
-
     size_t arrayLength_;
     size_t encodedLength_;
 
@@ -1976,6 +2009,7 @@ struct HandlerSpectrum : public HandlerParamContainer
     const SpectrumIdentityFromXML *spectrumID; 
     const map<string,string>* legacyIdRefToNativeId;
     const MSData* msd;
+    bool float32Storage;
 
     HandlerSpectrum(BinaryDataFlag _binaryDataFlag,
                     Spectrum* _spectrum = 0,
@@ -1987,6 +2021,7 @@ struct HandlerSpectrum : public HandlerParamContainer
         spectrumID(_spectrumID),
         legacyIdRefToNativeId(legacyIdRefToNativeId),
         msd(_msd),
+        float32Storage(false),
         handlerPrecursor_(0, legacyIdRefToNativeId)
     {
     }
@@ -2063,6 +2098,7 @@ struct HandlerSpectrum : public HandlerParamContainer
                 handlerBinaryDataArray_.binaryDataArray = spectrum->binaryDataArrayPtrs.back().get();
                 handlerBinaryDataArray_.defaultArrayLength = spectrum->defaultArrayLength;
                 handlerBinaryDataArray_.msd = msd;
+                handlerBinaryDataArray_.float32Storage = float32Storage;
                 return Status(Status::Delegate, &handlerBinaryDataArray_);
             }
             else if (name == "binaryDataArrayList")
@@ -2106,10 +2142,12 @@ PWIZ_API_DECL void read(std::istream& is, Spectrum& spectrum,
                         int version,
                         const map<string,string>* legacyIdRefToNativeId,
                         const MSData* msd,
-                        const SpectrumIdentityFromXML *id)
+                        const SpectrumIdentityFromXML *id,
+                        bool float32Storage)
 {
     HandlerSpectrum handler(binaryDataFlag, &spectrum, legacyIdRefToNativeId, msd, id);
     handler.version = version;
+    handler.float32Storage = float32Storage;
     SAXParser::parse(is, handler);
 }
 
@@ -2241,6 +2279,168 @@ PWIZ_API_DECL void read(std::istream& is, Chromatogram& chromatogram,
 //
 
 
+namespace {
+
+/// encodes spectra (binary arrays and XML) into ready-to-write <spectrum> elements on the shared
+/// util::WorkerPool, with at most threadCount encodings at once; the encoded elements are handed back
+/// in the same order the spectra were pushed
+class SpectrumEncoderPool : public WorkerPool::Job
+{
+    public:
+
+    SpectrumEncoderPool(const MSData& msd,
+                        const BinaryDataEncoder::Config& config,
+                        const XMLWriter::Config& fragmentConfig,
+                        size_t threadCount)
+    :   msd_(msd), config_(config), fragmentConfig_(fragmentConfig), threadCount_(threadCount),
+        queuedJobCount_(0), runningJobCount_(0)
+    {
+    }
+
+    ~SpectrumEncoderPool()
+    {
+        // drop the tasks nobody has started, then wait for the pool to finish the running ones
+        boost::unique_lock<boost::mutex> lock(mutex_);
+        queue_.clear();
+        queuedJobCount_ -= WorkerPool::instance().cancel(this);
+        while (queuedJobCount_ > 0 || runningJobCount_ > 0)
+            taskFinishedCondition_.wait(lock);
+    }
+
+    /// number of spectra to keep queued ahead of the writer
+    size_t windowSize() const {return threadCount_ * 2;}
+
+    void push(const SpectrumPtr& spectrum)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        TaskPtr task(new Task(spectrum));
+        tasks_.push_back(task);
+        queue_.push_back(task);
+        scheduleJobs();
+    }
+
+    /// waits for the oldest pushed spectrum to be encoded and returns its XML;
+    /// if no pool thread has started on it yet, it is encoded on the calling thread
+    string pop()
+    {
+        boost::unique_lock<boost::mutex> lock(mutex_);
+        if (tasks_.empty())
+            throw runtime_error("[IO::write(SpectrumList)] No spectrum queued for encoding.");
+
+        TaskPtr task = tasks_.front();
+        if (!queue_.empty() && queue_.front() == task)
+        {
+            queue_.pop_front();
+            lock.unlock();
+            encode(*task);
+            lock.lock();
+        }
+
+        while (!task->done)
+            taskFinishedCondition_.wait(lock);
+        tasks_.pop_front();
+
+        if (!task->error.empty())
+            throw runtime_error(task->error);
+        return task->xml;
+    }
+
+    private:
+
+    struct Task
+    {
+        Task(const SpectrumPtr& spectrum) : spectrum(spectrum), done(false) {}
+
+        SpectrumPtr spectrum;
+        string xml;
+        string error;
+        bool done;
+    };
+    typedef boost::shared_ptr<Task> TaskPtr;
+
+    // submits a pool job for each queued task, keeping at most threadCount jobs in flight (mutex_ must be held)
+    void scheduleJobs()
+    {
+        while (queuedJobCount_ + runningJobCount_ < threadCount_ && queuedJobCount_ < queue_.size())
+        {
+            ++queuedJobCount_;
+            WorkerPool::instance().submit(this);
+        }
+    }
+
+    // encodes the oldest queued task on the calling pool thread
+    virtual void runJob()
+    {
+        boost::unique_lock<boost::mutex> lock(mutex_);
+        --queuedJobCount_;
+
+        // the task may have been taken by pop(), or the queue cleared by the destructor
+        if (queue_.empty())
+        {
+            taskFinishedCondition_.notify_all();
+            return;
+        }
+
+        TaskPtr task = queue_.front();
+        queue_.pop_front();
+        ++runningJobCount_;
+        lock.unlock();
+
+        encode(*task);
+
+        lock.lock();
+        --runningJobCount_;
+        scheduleJobs();
+        taskFinishedCondition_.notify_all();
+    }
+
+    void encode(Task& task)
+    {
+        try
+        {
+            ostringstream oss;
+            XMLWriter fragmentWriter(oss, fragmentConfig_);
+            write(fragmentWriter, *task.spectrum, msd_, config_);
+            task.xml = oss.str();
+        }
+        catch (exception& e)
+        {
+            task.error = e.what();
+        }
+
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        task.spectrum.reset();
+        task.done = true;
+        taskFinishedCondition_.notify_all();
+    }
+
+    const MSData& msd_;
+    const BinaryDataEncoder::Config config_;
+    const XMLWriter::Config fragmentConfig_;
+    const size_t threadCount_;
+
+    std::deque<TaskPtr> tasks_; // all unwritten tasks in write order
+    std::deque<TaskPtr> queue_; // tasks not yet taken by a worker
+    size_t queuedJobCount_; // jobs submitted to the pool but not started
+    size_t runningJobCount_;
+    boost::mutex mutex_;
+    boost::condition_variable taskFinishedCondition_;
+};
+
+
+SpectrumPtr getSpectrumToWrite(SpectrumWorkerThreads& spectrumWorkers, size_t index)
+{
+    //SpectrumPtr spectrum = spectrumList.spectrum(i, true);
+    SpectrumPtr spectrum = spectrumWorkers.processBatch(index);
+    BOOST_ASSERT(spectrum->binaryDataArrayPtrs.empty() ||
+                 spectrum->defaultArrayLength == spectrum->getMZArray()->size());
+    if (spectrum->index != index) throw runtime_error("[IO::write(SpectrumList)] Bad index.");
+    return spectrum;
+}
+
+} // namespace
+
+
 PWIZ_API_DECL
 void write(minimxml::XMLWriter& writer, const SpectrumList& spectrumList, const MSData& msd,
            const BinaryDataEncoder::Config& config,
@@ -2257,6 +2457,14 @@ void write(minimxml::XMLWriter& writer, const SpectrumList& spectrumList, const
     writer.startElement("spectrumList", attributes);
     SpectrumWorkerThreads spectrumWorkers(spectrumList);
 
+    // binary data encoding and XML formatting run on the worker pool (this thread helps with the
+    // spectrum it is waiting for); this thread fetches spectra in order and appends the finished elements
+    boost::scoped_ptr<SpectrumEncoderPool> encoders;
+    size_t encoderThreadCount = SpectrumWorkerThreads::defaultThreadCount();
+    if (encoderThreadCount > 1 && spectrumList.size() > 1)
+        encoders.reset(new SpectrumEncoderPool(msd, config, writer.fragmentConfig(), encoderThreadCount));
+    size_t queuedCount = 0;
+
     for (size_t i=0; i<spectrumList.size(); i++)
     {
         // send progress updates, handling cancel
@@ -2277,12 +2485,17 @@ void write(minimxml::XMLWriter& writer, const SpectrumList& spectrumList, const
 
         // write the spectrum
 
-        //SpectrumPtr spectrum = spectrumList.spectrum(i, true);
-        SpectrumPtr spectrum = spectrumWorkers.processBatch(i);
-        BOOST_ASSERT(spectrum->binaryDataArrayPtrs.empty() ||
-                     spectrum->defaultArrayLength == spectrum->getMZArray()->data.size());
-        if (spectrum->index != i) throw runtime_error("[IO::write(SpectrumList)] Bad index.");
-        write(writer, *spectrum, msd, config);
+        if (!encoders)
+        {
+            write(writer, *getSpectrumToWrite(spectrumWorkers, i), msd, config);
+            continue;
+        }
+
+        // keep the encoders busy with the spectra following the one being written
+        for (; queuedCount < spectrumList.size() && queuedCount < i + encoders->windowSize(); ++queuedCount)
+            encoders->push(getSpectrumToWrite(spectrumWorkers, queuedCount));
+
+        writer.writeFragment(encoders->pop());
     }
 
     writer.endElement();
@@ -182,7 +182,8 @@ void read(std::istream& is, Spectrum& spectrum,
           int version = 0,
           const std::map<std::string,std::string>* legacyIdRefToNativeId = 0,
           const MSData* msd = 0,
-          const SpectrumIdentityFromXML *id = 0);
+          const SpectrumIdentityFromXML *id = 0,
+          bool float32Storage = false); // keep 32-bit float arrays in BinaryDataArray::floatData
 
 
 PWIZ_API_DECL
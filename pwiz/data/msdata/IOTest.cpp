@@ -24,6 +24,7 @@
 #include "IO.hpp"
 #include "Diff.hpp"
 #include "References.hpp"
+#include "SpectrumWorkerThreads.hpp"
 #include "pwiz/utility/misc/unit.hpp"
 #include "pwiz/utility/misc/Std.hpp"
 
@@ -566,6 +567,69 @@ void testSpectrum()
 }
 
 
+void testSpectrumFloat32Storage()
+{
+    if (os_) *os_ << "testSpectrumFloat32Storage():\n";
+
+    Spectrum a;
+    a.index = 0;
+    a.id = "scan=1";
+    a.setMZIntensityArrays(vector<double>(), vector<double>(), MS_number_of_detector_counts);
+    a.defaultArrayLength = 100;
+    for (size_t i=0; i<a.defaultArrayLength; i++)
+    {
+        a.getMZArray()->data.push_back(100 + i * 0.25); // exact in single precision
+        a.getIntensityArray()->data.push_back(i * 1000);
+    }
+
+    BinaryDataEncoder::Config config;
+    config.precision = BinaryDataEncoder::Precision_32;
+    config.precisionOverrides[MS_intensity_array] = BinaryDataEncoder::Precision_64;
+
+    for (int zlib=0; zlib < 2; ++zlib)
+    {
+        config.compression = zlib ? BinaryDataEncoder::Compression_Zlib : BinaryDataEncoder::Compression_None;
+
+        ostringstream oss;
+        XMLWriter writer(oss);
+        MSData dummy;
+        IO::write(writer, a, dummy, config);
+
+        Spectrum b;
+        istringstream iss(oss.str());
+        IO::read(iss, b, IO::ReadBinaryData, 0, 0, 0, 0, true);
+
+        // the 32-bit m/z array is kept at single precision, the 64-bit intensity array is not
+        unit_assert(b.getMZArray()->storedAsFloat32());
+        unit_assert(b.getMZArray()->data.empty());
+        unit_assert(b.getMZArray()->floatData.size() == a.defaultArrayLength);
+        unit_assert(!b.getIntensityArray()->storedAsFloat32());
+        unit_assert(b.getIntensityArray()->size() == a.defaultArrayLength);
+
+        Diff<Spectrum, DiffConfig> diff(a,b);
+        if (diff && os_) *os_ << "diff:\n" << diff << endl;
+        unit_assert(!diff);
+
+        vector<MZIntensityPair> pairs;
+        b.getMZIntensityPairs(pairs);
+        unit_assert(pairs.size() == a.defaultArrayLength);
+        unit_assert(pairs[7].mz == 101.75 && pairs[7].intensity == 7000);
+
+        // writing it back out gives the same encoding
+        ostringstream oss2;
+        XMLWriter writer2(oss2);
+        IO::write(writer2, b, dummy, config);
+        unit_assert(oss2.str() == oss.str());
+
+        b.getMZArray()->storeAsFloat64();
+        unit_assert(!b.getMZArray()->storedAsFloat32());
+        unit_assert(b.getMZArray()->data.size() == a.defaultArrayLength && b.getMZArray()->data[7] == 101.75);
+        b.getMZArray()->storeAsFloat32();
+        unit_assert(b.getMZArray()->data.empty() && b.getMZArray()->value(7) == 101.75);
+    }
+}
+
+
 void testChromatogram()
 {
     if (os_) *os_ << "testChromatogram():\n";
@@ -684,6 +748,72 @@ void testSpectrumListWithPositions()
 }
 
 
+void testSpectrumListWithBinaryData(size_t threadCount)
+{
+    if (os_) *os_ << "testSpectrumListWithBinaryData(" << threadCount << ")\n  ";
+
+    // more than one thread encodes on the worker pool, even on a single-core machine
+    SpectrumWorkerThreads::setDefaultThreadCount(threadCount);
+    SpectrumWorkerThreads::setPoolThreadCount(threadCount);
+
+    // enough spectra to cycle the encoder pool's queue several times
+    SpectrumListSimple a;
+    for (size_t i=0; i < 100; ++i)
+    {
+        SpectrumPtr spectrum(new Spectrum);
+        spectrum->id = "scan=" + lexical_cast<string>(i+1);
+        spectrum->index = i;
+        spectrum->set(MS_ms_level, 1 + i % 2);
+
+        vector<double> mz, intensity;
+        for (size_t j=0; j < 10 + i; ++j)
+        {
+            mz.push_back(100 + i + j * 0.5);
+            intensity.push_back(1000 * j + i);
+        }
+        spectrum->setMZIntensityArrays(mz, intensity, MS_number_of_detector_counts);
+        a.spectra.push_back(spectrum);
+    }
+
+    BinaryDataEncoder::Config config;
+    config.compression = BinaryDataEncoder::Compression_Zlib;
+
+    ostringstream oss;
+    XMLWriter writer(oss);
+    vector<stream_offset> positions;
+    MSData dummy;
+    IO::write(writer, a, dummy, config, &positions);
+
+    // positions must point at the spectra in order
+    unit_assert_operator_equal(a.size(), positions.size());
+    string xml = oss.str();
+    for (size_t i=0; i < positions.size(); ++i)
+    {
+        string indexAttribute = "<spectrum index=\"" + lexical_cast<string>(i) + "\"";
+        unit_assert_operator_equal(indexAttribute, xml.substr((size_t) positions[i], indexAttribute.length()));
+    }
+
+    // output must be the same as writing each spectrum in turn
+    ostringstream expected;
+    XMLWriter expectedWriter(expected);
+    expectedWriter.startElement("spectrumList", XMLWriter::Attributes());
+    for (size_t i=0; i < a.size(); ++i)
+        IO::write(expectedWriter, *a.spectrum(i, true), dummy, config);
+    expectedWriter.endElement();
+    unit_assert_operator_equal(expected.str().substr(expected.str().find('\n')), xml.substr(xml.find('\n')));
+
+    SpectrumListSimple b;
+    istringstream iss(xml);
+    IO::read(iss, b);
+    Diff<SpectrumList, DiffConfig, SpectrumListSimple> diff(a,b);
+    if (diff && os_) *os_ << "diff:\n" << diff << endl;
+    unit_assert(!diff);
+
+    SpectrumWorkerThreads::setDefaultThreadCount(0);
+    SpectrumWorkerThreads::setPoolThreadCount(0);
+}
+
+
 class TestIterationListener : public IterationListener
 {
     public:
@@ -1288,9 +1418,12 @@ void test()
     testBinaryDataArray();
     testBinaryDataArrayExternalMetadata();
     testSpectrum();
+    testSpectrumFloat32Storage();
     testChromatogram();
     testSpectrumList();
     testSpectrumListWithPositions();
+    testSpectrumListWithBinaryData(1);
+    testSpectrumListWithBinaryData(4);
     testSpectrumListWriteProgress();
     testChromatogramList();
     testChromatogramListWithPositions();
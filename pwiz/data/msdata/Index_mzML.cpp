@@ -23,8 +23,15 @@
 
 #include "Index_mzML.hpp"
 #include "pwiz/utility/misc/Std.hpp"
+#include "pwiz/utility/misc/Filesystem.hpp"
+#include "pwiz/utility/misc/FileStamp.hpp"
+#include "pwiz/utility/misc/random_access_compressed_ifstream.hpp"
 #include "pwiz/utility/minimxml/SAXParser.hpp"
 #include "boost/iostreams/positioning.hpp"
+#include "boost/iostreams/device/array.hpp"
+#include "boost/iostreams/device/mapped_file.hpp"
+#include "boost/iostreams/stream.hpp"
+#include "boost/cstdint.hpp"
 #include "pwiz/data/msdata/IO.hpp"
 
 using namespace pwiz::util;
@@ -38,20 +45,26 @@ namespace msdata {
 
 struct Index_mzML::Impl
 {
-    Impl(const boost::shared_ptr<std::istream>& is, int schemaVersion)
-        : is_(is), schemaVersion_(schemaVersion),
+    Impl(const boost::shared_ptr<std::istream>& is, int schemaVersion, const string& filename)
+        : is_(is), schemaVersion_(schemaVersion), filename_(filename),
           spectrumCount_(0), chromatogramCount_(0)
     {
-        createIndex();
+        createIndex(true);
     }
 
     void recreate() const;
     void readIndex() const;
-    void createIndex() const;
+    void createIndex(bool useSidecar) const;
     void createMaps() const;
+    void clear() const;
+
+    bool readSidecar() const;
+    void writeSidecar() const;
+    random_access_compressed_ifstream* gzipStream() const;
 
     boost::shared_ptr<std::istream> is_;
     int schemaVersion_;
+    string filename_;
 
     mutable size_t spectrumCount_;
     mutable vector<SpectrumIdentityFromXML> spectrumIndex_;
@@ -380,16 +393,26 @@ void Index_mzML::Impl::readIndex() const
     SAXParser::parse(*is_, handlerIndexList);
 }
 
-void Index_mzML::Impl::createIndex() const
+void Index_mzML::Impl::createIndex(bool useSidecar) const
 {
     //boost::call_once(indexSizeSet_.flag, boost::bind(&SpectrumList_mzMLImpl::setIndexSize, this));
 
-    spectrumIndex_.clear();
-    chromatogramIndex_.clear();
+    clear();
 
     // resize the index assuming the count attribute is accurate
     //index_.resize(size_);
 
+    if (useSidecar && !filename_.empty())
+    {
+        if (readSidecar())
+        {
+            createMaps();
+            return;
+        }
+        clear();
+    }
+
+    bool scanned = false;
     try
     {
         readIndex();
@@ -397,17 +420,224 @@ void Index_mzML::Impl::createIndex() const
     catch (runtime_error&)
     {
         // TODO: log warning that the index was corrupt/missing
+        clear();
         is_->clear();
         is_->seekg(0);
         HandlerIndexCreator handler(schemaVersion_,
                                     spectrumCount_, spectrumIndex_, legacyIdRefToNativeId_,
                                     chromatogramCount_, chromatogramIndex_);
         SAXParser::parse(*is_, handler);
+        scanned = true;
     }
 
+    // an intact <indexList> in a plain file is as cheap to read as the sidecar
+    if (!filename_.empty() && (scanned || gzipStream()))
+        writeSidecar();
+
     createMaps();
 }
 
+void Index_mzML::Impl::clear() const
+{
+    spectrumCount_ = chromatogramCount_ = 0;
+    spectrumIndex_.clear();
+    chromatogramIndex_.clear();
+    legacyIdRefToNativeId_.clear();
+}
+
+random_access_compressed_ifstream* Index_mzML::Impl::gzipStream() const
+{
+    random_access_compressed_ifstream* racis = dynamic_cast<random_access_compressed_ifstream*>(is_.get());
+    return racis && racis->getCompressionType() == random_access_compressed_ifstream::GZIP ? racis : 0;
+}
+
+
+namespace {
+
+// sidecar layout (integers are little endian uint64, strings are length-prefixed):
+// magic | format version | source size | source mtime | source fingerprint | schema version |
+// spectrum count | (offset, id, spotID)... | legacy id count | (idRef, nativeID)... |
+// chromatogram count | (offset, id)... | has gzip seek index | [random_access_compressed_ifstream seek index]
+
+const char sidecarMagic_[8] = {'p','w','i','z','m','z','i','x'};
+const boost::uint64_t sidecarVersion_ = 1;
+
+void writeUInt(ostream& os, boost::uint64_t value)
+{
+    char bytes[8];
+    for (int i=0; i < 8; ++i)
+        bytes[i] = static_cast<char>(value >> (8*i));
+    os.write(bytes, 8);
+}
+
+void writeString(ostream& os, const string& value)
+{
+    writeUInt(os, value.size());
+    os.write(value.c_str(), value.size());
+}
+
+boost::uint64_t readUInt(istream& is)
+{
+    unsigned char bytes[8];
+    if (!is.read(reinterpret_cast<char*>(bytes), 8))
+        throw runtime_error("[Index_mzML::readSidecar()] Unexpected end of sidecar index.");
+    boost::uint64_t value = 0;
+    for (int i=7; i >= 0; --i)
+        value = (value << 8) | bytes[i];
+    return value;
+}
+
+string readString(istream& is, size_t maxLength)
+{
+    boost::uint64_t length = readUInt(is);
+    if (length > maxLength)
+        throw runtime_error("[Index_mzML::readSidecar()] Bad string length in sidecar index.");
+    string value(static_cast<size_t>(length), '\0');
+    if (length > 0 && !is.read(&value[0], value.size()))
+        throw runtime_error("[Index_mzML::readSidecar()] Unexpected end of sidecar index.");
+    return value;
+}
+
+// the source file version that an index was made from
+void writeStamp(ostream& os, const FileStamp& stamp)
+{
+    writeUInt(os, stamp.size);
+    writeUInt(os, stamp.modificationTime);
+    writeString(os, stamp.fingerprint);
+}
+
+bool stampMatches(istream& is, const FileStamp& stamp)
+{
+    return readUInt(is) == stamp.size &&
+           readUInt(is) == stamp.modificationTime &&
+           readString(is, stamp.fingerprint.size()) == stamp.fingerprint;
+}
+
+} // namespace
+
+
+bool Index_mzML::Impl::readSidecar() const
+{
+    string sidecarFilename = Index_mzML::sidecarFilename(filename_);
+
+    try
+    {
+        if (!bfs::exists(sidecarFilename))
+            return false;
+
+        boost::iostreams::mapped_file_source mapping(sidecarFilename);
+        boost::iostreams::stream<boost::iostreams::array_source> is(mapping.data(), mapping.size());
+        size_t maxLength = mapping.size();
+
+        char magic[sizeof(sidecarMagic_)];
+        if (!is.read(magic, sizeof(magic)) || string(magic, sizeof(magic)) != string(sidecarMagic_, sizeof(sidecarMagic_)) ||
+            readUInt(is) != sidecarVersion_ ||
+            !stampMatches(is, FileStamp(filename_)) ||
+            readUInt(is) != static_cast<boost::uint64_t>(schemaVersion_))
+            return false;
+
+        // each spectrum entry takes at least 24 bytes, so a bad count can't make us allocate much
+        boost::uint64_t spectrumCount = readUInt(is);
+        if (spectrumCount > maxLength / 24)
+            return false;
+        spectrumIndex_.resize(static_cast<size_t>(spectrumCount));
+        for (size_t i=0; i < spectrumIndex_.size(); ++i)
+        {
+            SpectrumIdentityFromXML& si = spectrumIndex_[i];
+            si.index = i;
+            si.sourceFilePosition = static_cast<boost::iostreams::stream_offset>(readUInt(is));
+            si.id = readString(is, maxLength);
+            si.spotID = readString(is, maxLength);
+        }
+        spectrumCount_ = spectrumIndex_.size();
+
+        for (boost::uint64_t i = readUInt(is); i > 0; --i)
+        {
+            string idRef = readString(is, maxLength);
+            legacyIdRefToNativeId_[idRef] = readString(is, maxLength);
+        }
+
+        boost::uint64_t chromatogramCount = readUInt(is);
+        if (chromatogramCount > maxLength / 16)
+            return false;
+        chromatogramIndex_.resize(static_cast<size_t>(chromatogramCount));
+        for (size_t i=0; i < chromatogramIndex_.size(); ++i)
+        {
+            ChromatogramIdentity& ci = chromatogramIndex_[i];
+            ci.index = i;
+            ci.sourceFilePosition = static_cast<boost::iostreams::stream_offset>(readUInt(is));
+            ci.id = readString(is, maxLength);
+        }
+        chromatogramCount_ = chromatogramIndex_.size();
+
+        bool hasSeekIndex = readUInt(is) != 0;
+        random_access_compressed_ifstream* gzis = gzipStream();
+        if (gzis && (!hasSeekIndex || !gzis->load_index(is)))
+            return false; // the offsets alone would still leave a full decompression pass to do
+
+        return true;
+    }
+    catch (exception&)
+    {
+        // missing, stale, or damaged: fall back to building the index
+    }
+    return false;
+}
+
+void Index_mzML::Impl::writeSidecar() const
+{
+    string sidecarFilename = Index_mzML::sidecarFilename(filename_);
+    bfs::path tempFilename = sidecarFilename + "." + bfs::unique_path().string() + ".tmp";
+
+    try
+    {
+        {
+            ofstream os(tempFilename.string().c_str(), ios::binary);
+            os.write(sidecarMagic_, sizeof(sidecarMagic_));
+            writeUInt(os, sidecarVersion_);
+            writeStamp(os, FileStamp(filename_));
+            writeUInt(os, schemaVersion_);
+
+            writeUInt(os, spectrumIndex_.size());
+            BOOST_FOREACH(const SpectrumIdentityFromXML& si, spectrumIndex_)
+            {
+                writeUInt(os, si.sourceFilePosition);
+                writeString(os, si.id);
+                writeString(os, si.spotID);
+            }
+
+            writeUInt(os, legacyIdRefToNativeId_.size());
+            for (map<string,string>::const_iterator itr = legacyIdRefToNativeId_.begin(); itr != legacyIdRefToNativeId_.end(); ++itr)
+            {
+                writeString(os, itr->first);
+                writeString(os, itr->second);
+            }
+
+            writeUInt(os, chromatogramIndex_.size());
+            BOOST_FOREACH(const ChromatogramIdentity& ci, chromatogramIndex_)
+            {
+                writeUInt(os, ci.sourceFilePosition);
+                writeString(os, ci.id);
+            }
+
+            // for a scanned gzip file this is the one extra decompression pass that later opens are spared
+            random_access_compressed_ifstream* gzis = gzipStream();
+            writeUInt(os, gzis ? 1 : 0);
+            if ((gzis && !gzis->save_index(os)) || !os)
+                throw runtime_error("[Index_mzML::writeSidecar()] Error writing " + tempFilename.string());
+        }
+
+        // readers of the same file may be racing to write the sidecar; whole files replace each other atomically
+        bfs::rename(tempFilename, sidecarFilename);
+    }
+    catch (exception&)
+    {
+        // the sidecar is only an optimization (e.g. the directory may be read-only)
+        boost::system::error_code ec;
+        bfs::remove(tempFilename, ec);
+    }
+}
+
 void Index_mzML::Impl::createMaps() const
 {
     // actually just init - build when/if actually called for
@@ -417,11 +647,13 @@ void Index_mzML::Impl::createMaps() const
 }
 
 
-PWIZ_API_DECL Index_mzML::Index_mzML(boost::shared_ptr<std::istream> is, const MSData& msd)
-: impl_(new Impl(is, bal::starts_with(msd.version(), "1.0") ? 1 : 0))
+PWIZ_API_DECL Index_mzML::Index_mzML(boost::shared_ptr<std::istream> is, const MSData& msd, const std::string& filename)
+: impl_(new Impl(is, bal::starts_with(msd.version(), "1.0") ? 1 : 0, filename))
 {}
 
-PWIZ_API_DECL void Index_mzML::recreate() {impl_->createIndex();}
+PWIZ_API_DECL void Index_mzML::recreate() {impl_->createIndex(false);}
+
+PWIZ_API_DECL std::string Index_mzML::sidecarFilename(const std::string& filename) {return filename + ".pwizidx";}
 
 PWIZ_API_DECL size_t Index_mzML::spectrumCount() const {return impl_->spectrumCount_;}
 PWIZ_API_DECL const SpectrumIdentityFromXML& Index_mzML::spectrumIdentity(size_t index) const {return impl_->spectrumIndex_[index];}
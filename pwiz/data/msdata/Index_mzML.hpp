@@ -38,10 +38,17 @@ struct SpectrumIdentityFromXML; // forward ref
 
 struct PWIZ_API_DECL Index_mzML
 {
-    Index_mzML(boost::shared_ptr<std::istream> is, const MSData& msd);
+    /// if filename (the file that is read) is given, an index that had to be built by scanning
+    /// the file (no usable <indexList>) or decompressing it (gzip) is saved to sidecarFilename(filename),
+    /// along with the gzip seek points; later opens use the sidecar while the file is unchanged
+    Index_mzML(boost::shared_ptr<std::istream> is, const MSData& msd, const std::string& filename = std::string());
 
+    /// rebuilds the index from the file, ignoring (and then replacing) any sidecar
     void recreate();
 
+    /// the sidecar index file name for an mzML file
+    static std::string sidecarFilename(const std::string& filename);
+
     size_t spectrumCount() const;
     const SpectrumIdentityFromXML& spectrumIdentity(size_t index) const;
     size_t findSpectrumId(const std::string& id) const;
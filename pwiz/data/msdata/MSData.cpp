@@ -433,10 +433,36 @@ PWIZ_API_DECL bool BinaryDataArray::empty() const
 {
     return (!dataProcessingPtr.get() || dataProcessingPtr->empty()) && 
            data.empty() && 
+           floatData.empty() && 
            ParamContainer::empty();
 }
 
 
+PWIZ_API_DECL void BinaryDataArray::storeAsFloat32()
+{
+    if (data.empty()) return;
+    floatData.assign(data.begin(), data.end());
+    vector<double>().swap(data);
+}
+
+
+PWIZ_API_DECL void BinaryDataArray::storeAsFloat64()
+{
+    if (floatData.empty()) return;
+    data.assign(floatData.begin(), floatData.end());
+    vector<float>().swap(floatData);
+}
+
+
+PWIZ_API_DECL void BinaryDataArray::getValues(vector<double>& values) const
+{
+    if (floatData.empty())
+        values = data;
+    else
+        values.assign(floatData.begin(), floatData.end());
+}
+
+
 //
 // MZIntensityPair 
 //
@@ -658,23 +684,14 @@ PWIZ_API_DECL void Spectrum::getMZIntensityPairs(vector<MZIntensityPair>& output
     if (!arrays.first.get() || !arrays.second.get()) 
         return;
 
-    if (arrays.first->data.size() != arrays.second->data.size())
+    if (arrays.first->size() != arrays.second->size())
         throw runtime_error("[MSData::Spectrum::getMZIntensityPairs()] Sizes do not match.");
 
     output.clear();
-    output.resize(arrays.first->data.size());
+    output.resize(arrays.first->size());
 
     if (!output.empty())
-    {
-        double* mz = &arrays.first->data[0];
-        double* intensity = &arrays.second->data[0];
-        MZIntensityPair* start = &output[0];
-        for (MZIntensityPair* p = start; p != start + output.size(); ++p) 
-        {
-            p->mz = *mz++;
-            p->intensity = *intensity++;
-        }
-    }
+        getMZIntensityPairs(&output[0], output.size());
 }
 
 
@@ -689,10 +706,10 @@ PWIZ_API_DECL void Spectrum::getMZIntensityPairs(MZIntensityPair* output, size_t
     if (!arrays.first.get() || !arrays.second.get()) 
         return;
 
-    if (arrays.first->data.size() != expectedSize)
+    if (arrays.first->size() != expectedSize)
         throw runtime_error("[MSData::Spectrum::getMZIntensityPairs()] m/z array invalid size.");
 
-    if (arrays.second->data.size() != expectedSize)
+    if (arrays.second->size() != expectedSize)
         throw runtime_error("[MSData::Spectrum::getMZIntensityPairs()] Intensity array invalid size.");
 
     if (!output)
@@ -700,12 +717,12 @@ PWIZ_API_DECL void Spectrum::getMZIntensityPairs(MZIntensityPair* output, size_t
 
     // copy data into return buffer
 
-    double* mz = &arrays.first->data[0];
-    double* intensity = &arrays.second->data[0];
-    for (MZIntensityPair* p=output; p!=output+expectedSize; ++p) 
+    const BinaryDataArray& mz = *arrays.first;
+    const BinaryDataArray& intensity = *arrays.second;
+    for (size_t i=0; i < expectedSize; ++i)
     {
-        p->mz = *mz++;
-        p->intensity = *intensity++;
+        output[i].mz = mz.value(i);
+        output[i].intensity = intensity.value(i);
     }
 }
 
@@ -735,6 +752,15 @@ PWIZ_API_DECL BinaryDataArrayPtr Spectrum::getIntensityArray() const
 }
 
 
+PWIZ_API_DECL void Spectrum::storeBinaryDataAsFloat64()
+{
+    for (vector<BinaryDataArrayPtr>::const_iterator it = binaryDataArrayPtrs.begin();
+         it != binaryDataArrayPtrs.end();
+         ++it)
+        if (it->get()) (*it)->storeAsFloat64();
+}
+
+
 PWIZ_API_DECL void Spectrum::setMZIntensityPairs(const vector<MZIntensityPair>& input, CVID intensityUnits)
 {
     if (!input.empty())    
@@ -408,6 +408,29 @@ struct PWIZ_API_DECL BinaryDataArray : public ParamContainer
     /// the binary data.
     std::vector<double> data;
 
+    /// the binary data at single precision: an opt-in compact alternative to data, filled by readers
+    /// instead of data when a 32-bit float array is read with float32 storage enabled; data is then empty
+    std::vector<float> floatData;
+
+    /// returns the number of values, whichever of data or floatData holds them
+    size_t size() const {return floatData.empty() ? data.size() : floatData.size();}
+
+    /// returns the value at index i, whichever of data or floatData holds it
+    double value(size_t i) const {return floatData.empty() ? data[i] : floatData[i];}
+
+    /// returns true iff the values are held in floatData
+    bool storedAsFloat32() const {return !floatData.empty();}
+
+    /// replaces the contents of values with the values, whichever of data or floatData holds them
+    void getValues(std::vector<double>& values) const;
+
+    /// moves the values into floatData, narrowing them to single precision
+    void storeAsFloat32();
+
+    /// moves the values into data, widening them to double precision;
+    /// code that modifies data in place should call this first
+    void storeAsFloat64();
+
     /// returns true iff the element contains no params and all members are empty or null
     bool empty() const;
 };
@@ -534,7 +557,7 @@ struct PWIZ_API_DECL Spectrum : public SpectrumIdentity, public ParamContainer
     bool hasBinaryData() const {
         return binaryDataArrayPtrs.size() && 
                binaryDataArrayPtrs[0] &&
-              !binaryDataArrayPtrs[0]->data.empty();
+              binaryDataArrayPtrs[0]->size() > 0;
     };
 
     /// copy binary data arrays into m/z-intensity pair array
@@ -554,6 +577,10 @@ struct PWIZ_API_DECL Spectrum : public SpectrumIdentity, public ParamContainer
     /// get array with specified CVParam (may be null)
     BinaryDataArrayPtr getArrayByCVID(CVID arrayType) const;
 
+    /// moves the values of all binary data arrays into their data members (see BinaryDataArray::storeAsFloat64());
+    /// spectrum list wrappers and writers that use BinaryDataArray::data directly call this first
+    void storeBinaryDataAsFloat64();
+
     /// set binary data arrays 
     void setMZIntensityPairs(const std::vector<MZIntensityPair>& input, CVID intensityUnits);
 
@@ -336,11 +336,32 @@ PWIZ_API_DECL ostream& operator<<(ostream& os, const MSDataFile::WriteConfig& co
         os << " " << config.binaryDataEncoderConfig
            << " indexed=\"" << boolalpha << config.indexed << "\"";
     else if (config.format == MSDataFile::Format_MZ5)
-        os << " " << config.binaryDataEncoderConfig;
+        os << " " << config.binaryDataEncoderConfig
+           << " binaryDataAccessPolicy=\"" << config.binaryDataAccessPolicy << "\"";
     return os;
 }
 
 
+PWIZ_API_DECL ostream& operator<<(ostream& os, BinaryDataAccessPolicy policy)
+{
+    switch (policy)
+    {
+        case BinaryDataAccessPolicy_Balanced:
+            os << "balanced";
+            return os;
+        case BinaryDataAccessPolicy_RandomAccess:
+            os << "random";
+            return os;
+        case BinaryDataAccessPolicy_Sequential:
+            os << "sequential";
+            return os;
+        default:
+            os << "unknown";
+            return os;
+    }
+}
+
+
 } // namespace msdata
 } // namespace pwiz
 
@@ -55,9 +55,10 @@ struct PWIZ_API_DECL MSDataFile : public MSData
         BinaryDataEncoder::Config binaryDataEncoderConfig;
         bool indexed;
 		bool gzipped; // if true, file is written as .gz
+        BinaryDataAccessPolicy binaryDataAccessPolicy; // sizes the chunks of formats that have them (currently mz5)
 
         WriteConfig(Format _format = Format_mzML,bool _gzipped = false)
-        :   format(_format), indexed(true), gzipped(_gzipped)
+        :   format(_format), indexed(true), gzipped(_gzipped), binaryDataAccessPolicy(BinaryDataAccessPolicy_Balanced)
         {}
     };
 
@@ -95,6 +96,7 @@ PWIZ_API_DECL void calculateSHA1Checksums(const MSData& msd);
 
 PWIZ_API_DECL std::ostream& operator<<(std::ostream& os, MSDataFile::Format format);
 PWIZ_API_DECL std::ostream& operator<<(std::ostream& os, const MSDataFile::WriteConfig& config);
+PWIZ_API_DECL std::ostream& operator<<(std::ostream& os, BinaryDataAccessPolicy policy);
 
 
 } // namespace msdata
@@ -22,6 +22,8 @@
 
 
 #include "MSDataFile.hpp"
+#include "DefaultReaderList.hpp"
+#include "Index_mzML.hpp"
 #include "Diff.hpp"
 #include "IO.hpp"
 #include "SpectrumListBase.hpp"
@@ -392,6 +394,153 @@ void testSHA1()
 }
 
 
+void readPersistingIndex(const string& filename, MSData& msd)
+{
+    Reader::Config config;
+    config.persistIndex = true;
+    Reader_mzML().read(filename, "", msd, 0, config);
+}
+
+
+void validatePersistIndex(const MSData& source, bool indexed, bool gzipped)
+{
+    if (os_) *os_ << "validatePersistIndex() indexed=" << indexed << " gzipped=" << gzipped << endl;
+
+    string filename = filenameBase_ + ".persistIndex.mzML" + (gzipped ? ".gz" : "");
+    string sidecarFilename = Index_mzML::sidecarFilename(filename);
+    boost::filesystem::remove(sidecarFilename);
+
+    MSDataFile::WriteConfig writeConfig(MSDataFile::Format_mzML, gzipped);
+    writeConfig.indexed = indexed;
+    MSDataFile::write(source, filename, writeConfig);
+
+    const SpectrumList& sourceSL = *source.run.spectrumListPtr;
+
+    // first read builds the index, and saves it unless it was cheap to get
+    {
+        MSData msd;
+        readPersistingIndex(filename, msd);
+        unit_assert(boost::filesystem::exists(sidecarFilename) == (!indexed || gzipped));
+    }
+    if (indexed && !gzipped)
+    {
+        boost::filesystem::remove(filename);
+        return;
+    }
+
+    // second read uses the sidecar (including gzip seek points); read out of order to exercise seeking
+    {
+        MSData msd;
+        readPersistingIndex(filename, msd);
+        const SpectrumList& sl = *msd.run.spectrumListPtr;
+        unit_assert_operator_equal(sourceSL.size(), sl.size());
+        unit_assert_operator_equal(source.run.chromatogramListPtr->size(), msd.run.chromatogramListPtr->size());
+        for (size_t i=sl.size(); i > 0; i -= 7)
+        {
+            SpectrumPtr spectrum = sl.spectrum(i-1, true);
+            Diff<Spectrum, DiffConfig> diff(*sourceSL.spectrum(i-1, true), *spectrum);
+            if (diff && os_) *os_ << diff << endl;
+            unit_assert(!diff);
+            if (i <= 7) break;
+        }
+    }
+
+    // tamper with an id in the sidecar to prove that it is what gets read
+    string sidecar;
+    {
+        ifstream is(sidecarFilename.c_str(), ios::binary);
+        ostringstream oss;
+        oss << is.rdbuf();
+        sidecar = oss.str();
+    }
+    string id = sourceSL.spectrumIdentity(6).id;
+    string::size_type idOffset = sidecar.find(id);
+    unit_assert(idOffset != string::npos);
+    sidecar[idOffset + id.size() - 1] = 'Z';
+    {
+        ofstream os(sidecarFilename.c_str(), ios::binary);
+        os << sidecar;
+    }
+    {
+        MSData msd;
+        readPersistingIndex(filename, msd);
+        unit_assert_operator_equal(id.substr(0, id.size() - 1) + "Z", msd.run.spectrumListPtr->spectrumIdentity(6).id);
+    }
+
+    // once the source file changes, the stale sidecar is ignored and replaced
+    boost::filesystem::last_write_time(filename, boost::filesystem::last_write_time(filename) + 10);
+    {
+        MSData msd;
+        readPersistingIndex(filename, msd);
+        unit_assert_operator_equal(id, msd.run.spectrumListPtr->spectrumIdentity(6).id);
+    }
+    {
+        MSData msd;
+        readPersistingIndex(filename, msd);
+        unit_assert_operator_equal(id, msd.run.spectrumListPtr->spectrumIdentity(6).id);
+    }
+
+    boost::filesystem::remove(filename);
+    boost::filesystem::remove(sidecarFilename);
+}
+
+
+void testPersistIndex()
+{
+    // enough poorly compressible data for several gzip seek points
+    MSData msd;
+    examples::initializeTiny(msd);
+    shared_ptr<SpectrumListSimple> sl(new SpectrumListSimple);
+    unsigned int seed = 42;
+    for (size_t i=0; i < 200; ++i)
+    {
+        SpectrumPtr spectrum(new Spectrum);
+        spectrum->index = i;
+        spectrum->id = "scan=" + lexical_cast<string>(i+1);
+        vector<double> mz(1000), intensity(1000);
+        for (size_t j=0; j < mz.size(); ++j)
+        {
+            seed = seed * 1103515245 + 12345;
+            mz[j] = 100 + j + (seed % 10000) / 10000.0;
+            intensity[j] = seed % 1000000;
+        }
+        spectrum->setMZIntensityArrays(mz, intensity, MS_number_of_detector_counts);
+        sl->spectra.push_back(spectrum);
+    }
+    msd.run.spectrumListPtr = sl;
+
+    validatePersistIndex(msd, false, false);
+    validatePersistIndex(msd, true, false);
+    validatePersistIndex(msd, false, true);
+    validatePersistIndex(msd, true, true);
+}
+
+
+void testMemoryMap()
+{
+    if (os_) *os_ << "testMemoryMap()\n";
+
+    string filename = filenameBase_ + ".memoryMap.mzML";
+    MSData tiny;
+    examples::initializeTiny(tiny);
+    MSDataFile::write(tiny, filename);
+
+    {
+        MSData msd, msdMapped;
+        Reader::Config config;
+        Reader_mzML().read(filename, "", msd, 0, config);
+        config.memoryMap = true;
+        Reader_mzML().read(filename, "", msdMapped, 0, config);
+
+        Diff<MSData, DiffConfig> diff(msd, msdMapped);
+        if (diff && os_) *os_ << diff << endl;
+        unit_assert(!diff);
+    }
+
+    boost::filesystem::remove(filename);
+}
+
+
 int main(int argc, char* argv[])
 {
     TEST_PROLOG(argc, argv)
@@ -403,6 +552,8 @@ int main(int argc, char* argv[])
         //demo();
         testReader();
         testSHA1();
+        testPersistIndex();
+        testMemoryMap();
     }
     catch (exception& e)
     {
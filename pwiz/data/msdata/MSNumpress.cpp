@@ -29,6 +29,11 @@
 #include <algorithm>
 #include "MSNumpress.hpp"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MSNUMPRESS_SSE2
+#include <emmintrin.h>
+#endif
+
 namespace pwiz {
 namespace msdata {
 namespace MSNumpress {
@@ -194,6 +199,72 @@ void decodeInt(
 
 
 
+/**
+ * Inlined equivalent of decodeInt, for the decoding loops
+ */
+static inline unsigned int nextHalfByte(
+        const unsigned char *data,
+        size_t &di,
+        int &half
+) {
+    unsigned int hb;
+    if (half == 0) {
+        hb = data[di] >> 4;
+    } else {
+        hb = data[di] & 0xf;
+        di++;
+    }
+    half = 1 - half;
+    return hb;
+}
+
+static inline int decodeIntInline(
+        const unsigned char *data,
+        size_t &di,
+        int &half
+) {
+    unsigned int head = nextHalfByte(data, di, half);
+    unsigned int res = 0;
+    size_t n;
+
+    if (head <= 8) {
+        n = head;
+    } else { // leading ones, fill n half bytes in res
+        n = head - 8;
+        res = 0xffffffffu << (32 - 4*n);
+    }
+
+    for (size_t i=n; i<8; i++) {
+        res |= nextHalfByte(data, di, half) << ((i-n)*4);
+    }
+    return (int) res;
+}
+
+
+/**
+ * Divides values in place by fixedPoint, two at a time where SSE2 is available
+ * (IEEE division, so the results are the same either way)
+ */
+static void divideByFixedPoint(
+        double *values,
+        size_t count,
+        double fixedPoint
+) {
+    size_t i = 0;
+#ifdef MSNUMPRESS_SSE2
+    __m128d divisor = _mm_set1_pd(fixedPoint);
+    for (; i + 2 <= count; i += 2) {
+        _mm_storeu_pd(values + i, _mm_div_pd(_mm_loadu_pd(values + i), divisor));
+    }
+#endif
+    for (; i < count; i++) {
+        values[i] /= fixedPoint;
+    }
+}
+
+
+
+
 /////////////////////////////////////////////////////////////
 
 PWIZ_API_DECL
@@ -376,6 +447,8 @@ size_t decodeLinear(
         ri = 2;
         di = 16;
         
+        // the prediction is inherently sequential, so the integers are restored
+        // first and scaled afterwards, in a loop that vectorizes
         while (di < dataSize) {
             ints[0] = ints[1];
             ints[1] = ints[2];
@@ -384,12 +457,12 @@ size_t decodeLinear(
                     break;
                 }
             }
-            decodeInt(data, &di, &half, &diff);
+            diff = decodeIntInline(data, di, half);
             
             extrapol = ints[1] + (ints[1] - ints[0]);
             y = extrapol + diff;
             //printf("%lu %lu,   extrapol: %ld    diff: %d \n", ints[0], ints[1], extrapol, diff);
-            result[ri++]     = y / fixedPoint;
+            result[ri++]     = (double) y;
             ints[2]         = y;
         }
     } catch (...) {
@@ -409,6 +482,9 @@ size_t decodeLinear(
         cerr << endl;
     }
     
+    if (ri > 2) {
+        divideByFixedPoint(result + 2, ri - 2, fixedPoint);
+    }
     return ri;
 }
 
@@ -510,7 +586,7 @@ size_t decodePic(
                     break;
                 }
             }
-            decodeInt(&data[0], &di, &half, &count);
+            count = decodeIntInline(&data[0], di, half);
             
             //printf("count: %d \n", count);
             result[ri++]     = count;
@@ -46,6 +46,10 @@ Reader::Config::Config()
     , adjustUnknownTimeZonesToHostTimeZone(true)
     , iterationListenerRegistry(nullptr)
     , preferOnlyMsLevel(0)
+    , persistIndex(false)
+    , memoryMap(false)
+    , float32Storage(false)
+    , binaryDataAccessPolicy(BinaryDataAccessPolicy_Balanced)
 {
 }
 
@@ -61,6 +65,10 @@ Reader::Config::Config(const Config& rhs)
     adjustUnknownTimeZonesToHostTimeZone = rhs.adjustUnknownTimeZonesToHostTimeZone;
     iterationListenerRegistry = rhs.iterationListenerRegistry;
     preferOnlyMsLevel = rhs.preferOnlyMsLevel;
+    persistIndex = rhs.persistIndex;
+    memoryMap = rhs.memoryMap;
+    float32Storage = rhs.float32Storage;
+    binaryDataAccessPolicy = rhs.binaryDataAccessPolicy;
 }
 
 // default implementation; most Readers don't need to worry about multi-run input files
@@ -34,6 +34,15 @@
 namespace pwiz {
 namespace msdata {
 
+/// the order in which spectrum binary data is expected to be read, for formats that can lay out
+/// or buffer their data for it (currently mz5)
+enum PWIZ_API_DECL BinaryDataAccessPolicy
+{
+    BinaryDataAccessPolicy_Balanced,     ///< no particular order
+    BinaryDataAccessPolicy_RandomAccess, ///< spectra are mostly read in random order
+    BinaryDataAccessPolicy_Sequential    ///< spectra are mostly read in order
+};
+
 /// interface for file readers
 class PWIZ_API_DECL Reader
 {
@@ -73,6 +82,22 @@ class PWIZ_API_DECL Reader
         /// when nonzero, if reader can enumerate only spectra of ms level, it will (currently only supported by Bruker TDF)
         int preferOnlyMsLevel;
 
+        /// when true, readers that must scan or decompress a file to index it (currently unindexed or gzipped mzML)
+        /// save that index in a sidecar file next to it, and reuse it on later reads while the file is unchanged
+        bool persistIndex;
+
+        /// when true, readers of uncompressed text formats (currently mzML) parse spectra in place from a
+        /// read-only memory mapping of the file instead of reading them through a stream
+        bool memoryMap;
+
+        /// when true, readers that support it (currently mzML) keep arrays stored as 32-bit floats at single
+        /// precision, in BinaryDataArray::floatData instead of data; consumers must use the BinaryDataArray
+        /// accessors (size(), value()) or call storeAsFloat64() before touching data
+        bool float32Storage;
+
+        /// the expected order of spectrum reads, for readers that can buffer their data for it (currently mz5)
+        BinaryDataAccessPolicy binaryDataAccessPolicy;
+
         Config();
         Config(const Config& rhs);
     };
@@ -32,30 +32,29 @@ namespace References {
 
 
 
-template <typename object_type>
-struct HasID
+PWIZ_API_DECL Referents::Referents(const MSData& msd)
+:   msd(msd)
 {
-    const string& id_;
-    HasID(const string& id) : id_(id) {}
-
-    bool operator()(const shared_ptr<object_type>& objectPtr)
-    {
-        return objectPtr.get() && objectPtr->id == id_;
-    }
-};
+    index.add(msd.paramGroupPtrs);
+    index.add(msd.fileDescription.sourceFilePtrs);
+    index.add(msd.samplePtrs);
+    index.add(msd.softwarePtrs);
+    index.add(msd.instrumentConfigurationPtrs);
+    index.add(msd.dataProcessingPtrs);
+}
 
 
 template <typename object_type>
 void resolve(shared_ptr<object_type>& reference, 
-             const vector< shared_ptr<object_type> >& referentList)
+             const vector< shared_ptr<object_type> >& referentList,
+             const Referents& referents)
 {
     if (!reference.get() || reference->id.empty())
         return; 
 
-    typename vector< shared_ptr<object_type> >::const_iterator it = 
-        find_if(referentList.begin(), referentList.end(), HasID<object_type>(reference->id));
+    const shared_ptr<object_type>* referent = referents.index.find(referentList, reference->id);
 
-    if (it == referentList.end())
+    if (!referent)
     {
         ostringstream oss;
         oss << "[References::resolve()] Failed to resolve reference.\n"
@@ -68,173 +67,196 @@ void resolve(shared_ptr<object_type>& reference,
         throw runtime_error(oss.str().c_str());
     }
 
-    reference = *it;
+    reference = *referent;
 }
 
 
 template <typename object_type>
 void resolve(vector < shared_ptr<object_type> >& references,
-             const vector< shared_ptr<object_type> >& referentList)
+             const vector< shared_ptr<object_type> >& referentList,
+             const Referents& referents)
 {
     for (typename vector< shared_ptr<object_type> >::iterator it=references.begin();
          it!=references.end(); ++it)
-        resolve(*it, referentList);
+        resolve(*it, referentList, referents);
 }
 
 
-PWIZ_API_DECL void resolve(ParamContainer& paramContainer, const MSData& msd)
+void resolve(ParamContainer& paramContainer, const Referents& referents)
 {
-    resolve(paramContainer.paramGroupPtrs, msd.paramGroupPtrs); 
+    resolve(paramContainer.paramGroupPtrs, referents.msd.paramGroupPtrs, referents); 
 }
 
 
 template <typename object_type>
-void resolve(vector<object_type>& objects, const MSData& msd)
+void resolve(vector<object_type>& objects, const Referents& referents)
 {
     for (typename vector<object_type>::iterator it=objects.begin(); it!=objects.end(); ++it)
-        resolve(*it, msd);
+        resolve(*it, referents);
 }
 
 
 template <typename object_type>
-void resolve(vector< shared_ptr<object_type> >& objectPtrs, const MSData& msd)
+void resolve(vector< shared_ptr<object_type> >& objectPtrs, const Referents& referents)
 {
     for (typename vector< shared_ptr<object_type> >::iterator it=objectPtrs.begin(); 
          it!=objectPtrs.end(); ++it)
-        resolve(**it, msd);
+        resolve(**it, referents);
 }
 
 
-PWIZ_API_DECL void resolve(FileDescription& fileDescription, const MSData& msd)
+void resolve(FileDescription& fileDescription, const Referents& referents)
 {
-    resolve(fileDescription.fileContent, msd);
-    resolve(fileDescription.sourceFilePtrs, msd);
-    resolve(fileDescription.contacts, msd);
+    resolve(fileDescription.fileContent, referents);
+    resolve(fileDescription.sourceFilePtrs, referents);
+    resolve(fileDescription.contacts, referents);
 }
 
 
-PWIZ_API_DECL void resolve(ComponentList& componentList, const MSData& msd)
+void resolve(ComponentList& componentList, const Referents& referents)
 {
     for (size_t i=0; i < componentList.size(); ++i)
-        resolve(componentList[i], msd); 
+        resolve(componentList[i], referents); 
 }
 
 
-PWIZ_API_DECL void resolve(InstrumentConfiguration& instrumentConfiguration, const MSData& msd)
+void resolve(InstrumentConfiguration& instrumentConfiguration, const Referents& referents)
 {
-    resolve(static_cast<ParamContainer&>(instrumentConfiguration), msd);
-    resolve(instrumentConfiguration.componentList, msd);
-    resolve(instrumentConfiguration.softwarePtr, msd.softwarePtrs); 
+    resolve(static_cast<ParamContainer&>(instrumentConfiguration), referents);
+    resolve(instrumentConfiguration.componentList, referents);
+    resolve(instrumentConfiguration.softwarePtr, referents.msd.softwarePtrs, referents); 
 }
 
 
-PWIZ_API_DECL void resolve(ProcessingMethod& processingMethod, const MSData& msd)
+void resolve(ProcessingMethod& processingMethod, const Referents& referents)
 {
-    resolve(static_cast<ParamContainer&>(processingMethod), msd);
-    resolve(processingMethod.softwarePtr, msd.softwarePtrs); 
+    resolve(static_cast<ParamContainer&>(processingMethod), referents);
+    resolve(processingMethod.softwarePtr, referents.msd.softwarePtrs, referents); 
 }
 
 
-PWIZ_API_DECL void resolve(DataProcessing& dataProcessing, const MSData& msd)
+void resolve(DataProcessing& dataProcessing, const Referents& referents)
 {
-    resolve(dataProcessing.processingMethods, msd);
+    resolve(dataProcessing.processingMethods, referents);
 }
 
 
-PWIZ_API_DECL void resolve(ScanSettings& scanSettings, const MSData& msd)
+void resolve(ScanSettings& scanSettings, const Referents& referents)
 {
-    resolve(scanSettings.sourceFilePtrs, msd.fileDescription.sourceFilePtrs);
-    resolve(scanSettings.targets, msd);
+    resolve(scanSettings.sourceFilePtrs, referents.msd.fileDescription.sourceFilePtrs, referents);
+    resolve(scanSettings.targets, referents);
 }
 
 
-PWIZ_API_DECL void resolve(Precursor& precursor, const MSData& msd)
+void resolve(Precursor& precursor, const Referents& referents)
 {
-    resolve(static_cast<ParamContainer&>(precursor), msd);
-    resolve(precursor.sourceFilePtr, msd.fileDescription.sourceFilePtrs);
-    resolve(precursor.isolationWindow, msd);
-    resolve(precursor.selectedIons, msd);
-    resolve(precursor.activation, msd);
+    resolve(static_cast<ParamContainer&>(precursor), referents);
+    resolve(precursor.sourceFilePtr, referents.msd.fileDescription.sourceFilePtrs, referents);
+    resolve(precursor.isolationWindow, referents);
+    resolve(precursor.selectedIons, referents);
+    resolve(precursor.activation, referents);
 }
 
 
-PWIZ_API_DECL void resolve(Product& product, const MSData& msd)
+void resolve(Product& product, const Referents& referents)
 {
-    resolve(product.isolationWindow, msd);
+    resolve(product.isolationWindow, referents);
 }
 
 
-PWIZ_API_DECL void resolve(Scan& scan, const MSData& msd)
+void resolve(Scan& scan, const Referents& referents)
 {
-    resolve(static_cast<ParamContainer&>(scan), msd);
+    resolve(static_cast<ParamContainer&>(scan), referents);
     if (!scan.instrumentConfigurationPtr.get())
-        scan.instrumentConfigurationPtr = msd.run.defaultInstrumentConfigurationPtr;
-    resolve(scan.instrumentConfigurationPtr, msd.instrumentConfigurationPtrs);
-    resolve(scan.scanWindows, msd);
+        scan.instrumentConfigurationPtr = referents.msd.run.defaultInstrumentConfigurationPtr;
+    resolve(scan.instrumentConfigurationPtr, referents.msd.instrumentConfigurationPtrs, referents);
+    resolve(scan.scanWindows, referents);
 }
 
 
-PWIZ_API_DECL void resolve(ScanList& scanList, const MSData& msd)
+void resolve(ScanList& scanList, const Referents& referents)
 {
-    resolve(static_cast<ParamContainer&>(scanList), msd);
-    resolve(scanList.scans, msd);
+    resolve(static_cast<ParamContainer&>(scanList), referents);
+    resolve(scanList.scans, referents);
 }
 
 
-PWIZ_API_DECL void resolve(BinaryDataArray& binaryDataArray, const MSData& msd)
+void resolve(BinaryDataArray& binaryDataArray, const Referents& referents)
 {
-    resolve(static_cast<ParamContainer&>(binaryDataArray), msd);
-    resolve(binaryDataArray.dataProcessingPtr, msd.dataProcessingPtrs);
+    resolve(static_cast<ParamContainer&>(binaryDataArray), referents);
+    resolve(binaryDataArray.dataProcessingPtr, referents.msd.dataProcessingPtrs, referents);
 }
 
 
-PWIZ_API_DECL void resolve(Spectrum& spectrum, const MSData& msd)
+PWIZ_API_DECL void resolve(Spectrum& spectrum, const Referents& referents)
 {
-    resolve(static_cast<ParamContainer&>(spectrum), msd);
-    resolve(spectrum.dataProcessingPtr, msd.dataProcessingPtrs);
-    resolve(spectrum.sourceFilePtr, msd.fileDescription.sourceFilePtrs);
-    resolve(spectrum.scanList, msd);
-    resolve(spectrum.precursors, msd);
-    resolve(spectrum.products, msd);
-    resolve(spectrum.binaryDataArrayPtrs, msd);
+    resolve(static_cast<ParamContainer&>(spectrum), referents);
+    resolve(spectrum.dataProcessingPtr, referents.msd.dataProcessingPtrs, referents);
+    resolve(spectrum.sourceFilePtr, referents.msd.fileDescription.sourceFilePtrs, referents);
+    resolve(spectrum.scanList, referents);
+    resolve(spectrum.precursors, referents);
+    resolve(spectrum.products, referents);
+    resolve(spectrum.binaryDataArrayPtrs, referents);
 }
 
 
-PWIZ_API_DECL void resolve(Chromatogram& chromatogram, const MSData& msd)
+PWIZ_API_DECL void resolve(Chromatogram& chromatogram, const Referents& referents)
 {
-    resolve(static_cast<ParamContainer&>(chromatogram), msd);
-    resolve(chromatogram.dataProcessingPtr, msd.dataProcessingPtrs);
-    resolve(chromatogram.binaryDataArrayPtrs, msd);
+    resolve(static_cast<ParamContainer&>(chromatogram), referents);
+    resolve(chromatogram.dataProcessingPtr, referents.msd.dataProcessingPtrs, referents);
+    resolve(chromatogram.binaryDataArrayPtrs, referents);
 }
 
 
-PWIZ_API_DECL void resolve(Run& run, const MSData& msd)
+void resolve(Run& run, const Referents& referents)
 {
-    resolve(static_cast<ParamContainer&>(run), msd);
-    resolve(run.defaultInstrumentConfigurationPtr, msd.instrumentConfigurationPtrs);
-    resolve(run.samplePtr, msd.samplePtrs);
-    resolve(run.defaultSourceFilePtr, msd.fileDescription.sourceFilePtrs);
+    resolve(static_cast<ParamContainer&>(run), referents);
+    resolve(run.defaultInstrumentConfigurationPtr, referents.msd.instrumentConfigurationPtrs, referents);
+    resolve(run.samplePtr, referents.msd.samplePtrs, referents);
+    resolve(run.defaultSourceFilePtr, referents.msd.fileDescription.sourceFilePtrs, referents);
 }
 
 
+// resolving a single object indexes only the long referent lists, which costs no more than one
+// search of each; resolving many objects against one Referents avoids repeating even that
+
+PWIZ_API_DECL void resolve(ParamContainer& paramContainer, const MSData& msd) {resolve(paramContainer, Referents(msd));}
+PWIZ_API_DECL void resolve(FileDescription& fileDescription, const MSData& msd) {resolve(fileDescription, Referents(msd));}
+PWIZ_API_DECL void resolve(ComponentList& componentList, const MSData& msd) {resolve(componentList, Referents(msd));}
+PWIZ_API_DECL void resolve(InstrumentConfiguration& instrumentConfiguration, const MSData& msd) {resolve(instrumentConfiguration, Referents(msd));}
+PWIZ_API_DECL void resolve(ProcessingMethod& processingMethod, const MSData& msd) {resolve(processingMethod, Referents(msd));}
+PWIZ_API_DECL void resolve(DataProcessing& dataProcessing, const MSData& msd) {resolve(dataProcessing, Referents(msd));}
+PWIZ_API_DECL void resolve(ScanSettings& scanSettings, const MSData& msd) {resolve(scanSettings, Referents(msd));}
+PWIZ_API_DECL void resolve(Precursor& precursor, const MSData& msd) {resolve(precursor, Referents(msd));}
+PWIZ_API_DECL void resolve(Product& product, const MSData& msd) {resolve(product, Referents(msd));}
+PWIZ_API_DECL void resolve(Scan& scan, const MSData& msd) {resolve(scan, Referents(msd));}
+PWIZ_API_DECL void resolve(ScanList& scanList, const MSData& msd) {resolve(scanList, Referents(msd));}
+PWIZ_API_DECL void resolve(BinaryDataArray& binaryDataArray, const MSData& msd) {resolve(binaryDataArray, Referents(msd));}
+PWIZ_API_DECL void resolve(Spectrum& spectrum, const MSData& msd) {resolve(spectrum, Referents(msd));}
+PWIZ_API_DECL void resolve(Chromatogram& chromatogram, const MSData& msd) {resolve(chromatogram, Referents(msd));}
+PWIZ_API_DECL void resolve(Run& run, const MSData& msd) {resolve(run, Referents(msd));}
+
+
 PWIZ_API_DECL void resolve(MSData& msd)
 {
-    resolve(msd.paramGroupPtrs, msd);
-    resolve(msd.samplePtrs, msd);
-    resolve(msd.instrumentConfigurationPtrs, msd);
-    resolve(msd.dataProcessingPtrs, msd);
-    resolve(msd.scanSettingsPtrs, msd);
-    resolve(msd.run, msd);
+    Referents referents(msd);
+
+    resolve(msd.paramGroupPtrs, referents);
+    resolve(msd.samplePtrs, referents);
+    resolve(msd.instrumentConfigurationPtrs, referents);
+    resolve(msd.dataProcessingPtrs, referents);
+    resolve(msd.scanSettingsPtrs, referents);
+    resolve(msd.run, referents);
 
     // if we're using SpectrumListSimple, resolve the references in each Spectrum
     SpectrumListSimple* simple = dynamic_cast<SpectrumListSimple*>(msd.run.spectrumListPtr.get());
     if (simple)
-        resolve(simple->spectra, msd);
+        resolve(simple->spectra, referents);
 
     // if we're using ChromatogramListSimple, resolve the references in each Chromatogram
     ChromatogramListSimple* chromatogramListSimple = dynamic_cast<ChromatogramListSimple*>(msd.run.chromatogramListPtr.get());
     if (chromatogramListSimple)
-        resolve(chromatogramListSimple->chromatograms, msd);
+        resolve(chromatogramListSimple->chromatograms, referents);
 }
 
 
@@ -26,6 +26,7 @@
 
 
 #include "pwiz/utility/misc/Export.hpp"
+#include "pwiz/data/common/ReferentIndex.hpp"
 #include "MSData.hpp"
 
 
@@ -37,6 +38,18 @@ namespace msdata {
 namespace References {
 
 
+/// an MSData with its referent lists (param groups, data processing, source files, ...) hashed by id,
+/// for resolving the references of many objects against it, e.g. each spectrum as a file-backed
+/// SpectrumList reads it; lists added to the MSData later are searched linearly
+struct PWIZ_API_DECL Referents
+{
+    explicit Referents(const MSData& msd);
+
+    const MSData& msd;
+    data::ReferentIndex index;
+};
+
+
 PWIZ_API_DECL void resolve(ParamContainer& paramContainer, const MSData& msd);
 PWIZ_API_DECL void resolve(FileDescription& fileDescription, const MSData& msd);
 PWIZ_API_DECL void resolve(ComponentList& componentList, const MSData& msd);
@@ -53,6 +66,10 @@ PWIZ_API_DECL void resolve(Spectrum& spectrum, const MSData& msd);
 PWIZ_API_DECL void resolve(Chromatogram& chromatogram, const MSData& msd);
 PWIZ_API_DECL void resolve(Run& run, const MSData& msd);
 
+/// resolve the references of a spectrum or chromatogram using indexed referent lists
+PWIZ_API_DECL void resolve(Spectrum& spectrum, const Referents& referents);
+PWIZ_API_DECL void resolve(Chromatogram& chromatogram, const Referents& referents);
+
 
 ///
 /// Resolve internal references in an MSData object.
@@ -501,6 +501,49 @@ void testMSData()
 }
 
 
+void testReferents()
+{
+    if (os_) *os_ << "testReferents()\n"; 
+
+    // enough param groups and data processings to be hashed, with a duplicate id
+    MSData msd;
+    for (int i=0; i < 100; ++i)
+    {
+        msd.paramGroupPtrs.push_back(ParamGroupPtr(new ParamGroup("pg" + lexical_cast<string>(i))));
+        msd.paramGroupPtrs.back()->userParams.push_back(UserParam("user" + lexical_cast<string>(i)));
+        msd.dataProcessingPtrs.push_back(DataProcessingPtr(new DataProcessing("dp" + lexical_cast<string>(i))));
+    }
+    msd.paramGroupPtrs.push_back(ParamGroupPtr(new ParamGroup("pg42")));
+
+    References::Referents referents(msd);
+
+    for (int i=0; i < 100; ++i)
+    {
+        Spectrum spectrum;
+        spectrum.paramGroupPtrs.push_back(ParamGroupPtr(new ParamGroup("pg" + lexical_cast<string>(99 - i))));
+        spectrum.dataProcessingPtr = DataProcessingPtr(new DataProcessing("dp" + lexical_cast<string>(i)));
+        References::resolve(spectrum, referents);
+        unit_assert(spectrum.paramGroupPtrs[0] == msd.paramGroupPtrs[99 - i]);
+        unit_assert(spectrum.dataProcessingPtr == msd.dataProcessingPtrs[i]);
+    }
+
+    // lists changed after indexing are still searched
+    msd.dataProcessingPtrs.push_back(DataProcessingPtr(new DataProcessing("dp100")));
+    msd.paramGroupPtrs[0] = ParamGroupPtr(new ParamGroup("pgNew"));
+
+    Chromatogram chromatogram;
+    chromatogram.paramGroupPtrs.push_back(ParamGroupPtr(new ParamGroup("pgNew")));
+    chromatogram.dataProcessingPtr = DataProcessingPtr(new DataProcessing("dp100"));
+    References::resolve(chromatogram, referents);
+    unit_assert(chromatogram.paramGroupPtrs[0] == msd.paramGroupPtrs[0]);
+    unit_assert(chromatogram.dataProcessingPtr == msd.dataProcessingPtrs.back());
+
+    Spectrum spectrum;
+    spectrum.paramGroupPtrs.push_back(ParamGroupPtr(new ParamGroup("pg0")));
+    unit_assert_throws(References::resolve(spectrum, referents), runtime_error);
+}
+
+
 void test()
 {
     testParamContainer();
@@ -518,6 +561,7 @@ void test()
     testChromatogram();
     testRun();
     testMSData();
+    testReferents();
 }
 
 
@@ -136,9 +136,9 @@ void Serializer_MGF::Impl::write(ostream& os, const MSData& msd,
             for (size_t p=0; p < s->defaultArrayLength; ++p)
             {
                 char* b = buffer;
-                generate(b, nosci10, intensityArray.data[p]);
+                generate(b, nosci10, intensityArray.value(p));
                 *b = 0;
-                os << mzArray.data[p] << ' ' << buffer << '\n';
+                os << mzArray.value(p) << ' ' << buffer << '\n';
             }
 
             os << "END IONS\n";
@@ -184,6 +184,26 @@ void testWriteRead()
 }
 
 
+// stores the arrays of all spectra at single precision, as readers do with float32 storage enabled
+void storeSpectraAsFloat32(MSData& msd)
+{
+    SpectrumListSimple& spectrumList = dynamic_cast<SpectrumListSimple&>(*msd.run.spectrumListPtr);
+    for (size_t i=0; i < spectrumList.spectra.size(); ++i)
+        for (size_t j=0; j < spectrumList.spectra[i]->binaryDataArrayPtrs.size(); ++j)
+            spectrumList.spectra[i]->binaryDataArrayPtrs[j]->storeAsFloat32();
+}
+
+
+void testWriteReadFloat32()
+{
+    MSData msd;
+    initializeTinyMGF(msd);
+    storeSpectraAsFloat32(msd);
+
+    testWriteRead(msd);
+}
+
+
 int main(int argc, char* argv[])
 {
     TEST_PROLOG(argc, argv)
@@ -192,6 +212,7 @@ int main(int argc, char* argv[])
     {
         if (argc>1 && !strcmp(argv[1],"-v")) os_ = &cout;
         testWriteRead();
+        testWriteReadFloat32();
     }
     catch (exception& e)
     {
@@ -232,7 +232,7 @@ namespace
         const BinaryDataArray& intensityArray = *s->getIntensityArray();
         for (size_t p=0; p < s->defaultArrayLength; ++p)
         {
-            os << mzArray.data[p] << " " << intensityArray.data[p] << "\n";
+            os << mzArray.value(p) << " " << intensityArray.value(p) << "\n";
         }
     }
 
@@ -247,8 +247,8 @@ namespace
         const BinaryDataArray& intensityArray = *s->getIntensityArray();
         for(int j = 0; j < numPeaks; j++)
         {
-            pD[j] = mzArray.data[j];
-            pF[j] = (float) intensityArray.data[j];
+            pD[j] = mzArray.value(j);
+            pF[j] = (float) intensityArray.value(j);
         }
 
         // compress mz
@@ -406,10 +406,10 @@ namespace
             const BinaryDataArray& intensityArray = *s->getIntensityArray();
             for(int i = 0; i < numPeaks; i++)
             {
-                double mzPeak = mzArray.data[i];
+                double mzPeak = mzArray.value(i);
                 os.write(reinterpret_cast<char *>(&mzPeak), sizeDoubleMSn);
                 
-                float intensityPeak = (float) intensityArray.data[i];
+                float intensityPeak = (float) intensityArray.value(i);
                 os.write(reinterpret_cast<char *>(&intensityPeak), sizeFloatMSn);
             }
         }
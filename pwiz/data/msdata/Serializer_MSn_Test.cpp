@@ -279,6 +279,34 @@ void testWriteRead()
 }
 
 
+// stores the arrays of all spectra at single precision, as readers do with float32 storage enabled
+void storeSpectraAsFloat32(MSData& msd)
+{
+    SpectrumListSimple& spectrumList = dynamic_cast<SpectrumListSimple&>(*msd.run.spectrumListPtr);
+    for (size_t i=0; i < spectrumList.spectra.size(); ++i)
+        for (size_t j=0; j < spectrumList.spectra[i]->binaryDataArrayPtrs.size(); ++j)
+            spectrumList.spectra[i]->binaryDataArrayPtrs[j]->storeAsFloat32();
+}
+
+
+void testWriteReadFloat32()
+{
+    MSData msd1, msd2;
+
+    initializeTinyMS1(msd1);
+    initializeTinyMS2(msd2);
+    storeSpectraAsFloat32(msd1);
+    storeSpectraAsFloat32(msd2);
+
+    testWriteReadMS1(msd1);
+    testWriteReadBMS1(msd1);
+    testWriteReadCMS1(msd1);
+    testWriteReadMS2(msd2);
+    testWriteReadBMS2(msd2);
+    testWriteReadCMS2(msd2);
+}
+
+
 int main(int argc, char* argv[])
 {
     TEST_PROLOG(argc, argv)
@@ -287,6 +315,7 @@ int main(int argc, char* argv[])
     {
         if (argc>1 && !strcmp(argv[1],"-v")) os_ = &cout;
         testWriteRead();
+        testWriteReadFloat32();
     }
     catch (exception& e)
     {
@@ -101,6 +101,24 @@ void testWriteRead()
     // TODO: test without compression
 }
 
+// stores the arrays of all spectra at single precision, as readers do with float32 storage enabled
+void storeSpectraAsFloat32(MSData& msd)
+{
+    SpectrumListSimple& spectrumList = dynamic_cast<SpectrumListSimple&>(*msd.run.spectrumListPtr);
+    for (size_t i=0; i < spectrumList.spectra.size(); ++i)
+        for (size_t j=0; j < spectrumList.spectra[i]->binaryDataArrayPtrs.size(); ++j)
+            spectrumList.spectra[i]->binaryDataArrayPtrs[j]->storeAsFloat32();
+}
+
+void testWriteReadFloat32()
+{
+    MSData msd;
+    examples::initializeTiny(msd);
+    storeSpectraAsFloat32(msd);
+
+    testWriteRead(msd, MSDataFile::WriteConfig());
+}
+
 void testThreadSafetyWorker(boost::barrier* testBarrier)
 {
     testBarrier->wait(); // wait until all threads have started
@@ -138,6 +156,7 @@ int main(int argc, char* argv[])
             os_ = &cout;
 
         testWriteRead();
+        testWriteReadFloat32();
         testThreadSafety(2);
         testThreadSafety(4);
         testThreadSafety(8);
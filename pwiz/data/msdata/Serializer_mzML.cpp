@@ -30,7 +30,9 @@
 #include "SHA1OutputObserver.hpp"
 #include "pwiz/utility/minimxml/XMLWriter.hpp"
 #include "pwiz/utility/minimxml/SAXParser.hpp"
+#include "pwiz/utility/misc/random_access_compressed_ifstream.hpp"
 #include "pwiz/utility/misc/Std.hpp"
+#include <boost/iostreams/device/mapped_file.hpp>
 
 namespace pwiz {
 namespace msdata {
@@ -53,7 +55,7 @@ class Serializer_mzML::Impl
     void write(ostream& os, const MSData& msd,
                const pwiz::util::IterationListenerRegistry* iterationListenerRegistry) const;
 
-    void read(shared_ptr<istream> is, MSData& msd) const;
+    void read(shared_ptr<istream> is, MSData& msd, const string& filename) const;
 
     private:
     Config config_; 
@@ -207,7 +209,7 @@ struct HandlerIndexedMZML : public SAXParser::Handler
 };
 
 
-void Serializer_mzML::Impl::read(shared_ptr<istream> is, MSData& msd) const
+void Serializer_mzML::Impl::read(shared_ptr<istream> is, MSData& msd, const string& filename) const
 {
     if (!is.get() || !*is)
         throw runtime_error("[Serializer_mzML::read()] Bad istream.");
@@ -221,8 +223,24 @@ void Serializer_mzML::Impl::read(shared_ptr<istream> is, MSData& msd) const
     }
 
     IO::read(*is, msd, IO::IgnoreSpectrumList);
-    Index_mzML_Ptr indexPtr(new Index_mzML(is, msd));
-    msd.run.spectrumListPtr = SpectrumList_mzML::create(is, msd, indexPtr);
+    Index_mzML_Ptr indexPtr(new Index_mzML(is, msd, config_.persistIndex ? filename : string()));
+
+    shared_ptr<boost::iostreams::mapped_file_source> mapping;
+    random_access_compressed_ifstream* racis = dynamic_cast<random_access_compressed_ifstream*>(is.get());
+    if (config_.memoryMap && !filename.empty() && racis && racis->getCompressionType() == random_access_compressed_ifstream::NONE)
+    {
+        try
+        {
+            mapping.reset(new boost::iostreams::mapped_file_source(filename));
+        }
+        catch (exception&)
+        {
+            // e.g. no address space for it in a 32-bit process: read through the stream
+            mapping.reset();
+        }
+    }
+
+    msd.run.spectrumListPtr = SpectrumList_mzML::create(is, msd, indexPtr, mapping, config_.float32Storage);
     msd.run.chromatogramListPtr = ChromatogramList_mzML::create(is, msd, indexPtr);
 }
 
@@ -247,7 +265,13 @@ PWIZ_API_DECL void Serializer_mzML::write(ostream& os, const MSData& msd,
 
 PWIZ_API_DECL void Serializer_mzML::read(shared_ptr<istream> is, MSData& msd) const
 {
-    return impl_->read(is, msd);
+    return impl_->read(is, msd, string());
+}
+
+
+PWIZ_API_DECL void Serializer_mzML::read(shared_ptr<istream> is, MSData& msd, const string& filename) const
+{
+    return impl_->read(is, msd, filename);
 }
 
 
@@ -50,7 +50,18 @@ class PWIZ_API_DECL Serializer_mzML
         /// (indexed==true): read/write with <indexedmzML> wrapper
         bool indexed;
 
-        Config() : indexed(true) {}
+        /// (reading from a named file) keep the spectrum/chromatogram index in a sidecar file
+        /// when building it is expensive (see Index_mzML)
+        bool persistIndex;
+
+        /// (reading from a named file) if the file is uncompressed, parse spectra in place
+        /// from a read-only memory mapping of it (see SpectrumList_mzML)
+        bool memoryMap;
+
+        /// (reading) keep 32-bit float arrays at single precision, in BinaryDataArray::floatData
+        bool float32Storage;
+
+        Config() : indexed(true), persistIndex(false), memoryMap(false), float32Storage(false) {}
     };
 
     /// constructor
@@ -66,6 +77,9 @@ class PWIZ_API_DECL Serializer_mzML
     /// lazy evaluation of Spectrum data
     void read(boost::shared_ptr<std::istream> is, MSData& msd) const;
 
+    /// as above, where is reads filename, for the options that need the file itself
+    void read(boost::shared_ptr<std::istream> is, MSData& msd, const std::string& filename) const;
+
     private:
     class Impl;
     boost::shared_ptr<Impl> impl_;
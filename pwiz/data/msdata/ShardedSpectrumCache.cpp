@@ -0,0 +1,234 @@
+//
+// $Id$
+//
+//
+// Original author: agent <agent@local>
+//
+// Copyright 2026
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#define PWIZ_SOURCE
+
+#include "ShardedSpectrumCache.hpp"
+#include "SpectrumWorkerThreads.hpp"
+#include "pwiz/utility/misc/Std.hpp"
+#include <boost/multi_index_container.hpp>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/sequenced_index.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/locks.hpp>
+
+
+namespace pwiz {
+namespace msdata {
+
+
+namespace {
+
+
+struct CacheEntry
+{
+    CacheEntry(size_t k, const SpectrumPtr& s, size_t b) : key(k), spectrum(s), bytes(b) {}
+    size_t key; // index * 2 + tier
+    SpectrumPtr spectrum;
+    size_t bytes;
+};
+
+typedef boost::multi_index::multi_index_container
+<
+    CacheEntry,
+    boost::multi_index::indexed_by
+    <
+        boost::multi_index::sequenced<>,
+        boost::multi_index::hashed_unique<BOOST_MULTI_INDEX_MEMBER(CacheEntry, size_t, key)>
+    >
+> EntryList;
+
+
+struct Shard
+{
+    Shard() : bytes(0), hits(0), misses(0), evictions(0) {}
+
+    boost::mutex mutex;
+    EntryList entries; // from MRU to LRU
+    size_t bytes;
+    size_t hits, misses, evictions;
+};
+
+
+size_t byteSize(const ParamContainer& pc)
+{
+    size_t bytes = pc.cvParams.capacity() * sizeof(CVParam) +
+                   pc.userParams.capacity() * sizeof(UserParam) +
+                   pc.paramGroupPtrs.capacity() * sizeof(ParamGroupPtr);
+    BOOST_FOREACH(const CVParam& p, pc.cvParams)
+        bytes += p.value.capacity();
+    return bytes;
+}
+
+
+} // namespace
+
+
+class ShardedSpectrumCache::Impl
+{
+    public:
+
+    Impl(MemoryMRUCacheMode mode, size_t maxBytes, size_t shardCount)
+        : mode_(mode), maxBytes_(maxBytes),
+          shardCount_(shardCount > 0 ? shardCount : max((size_t) 1, SpectrumWorkerThreads::defaultThreadCount())),
+          maxShardBytes_(maxBytes_ / shardCount_),
+          shards_(new Shard[shardCount_])
+    {
+    }
+
+    MemoryMRUCacheMode mode_;
+    const size_t maxBytes_;
+    const size_t shardCount_;
+    const size_t maxShardBytes_;
+    boost::scoped_array<Shard> shards_;
+
+    Shard& shard(size_t index) const {return shards_[index % shardCount_];}
+};
+
+
+PWIZ_API_DECL ShardedSpectrumCache::ShardedSpectrumCache(MemoryMRUCacheMode mode, size_t maxBytes, size_t shardCount)
+    : impl_(new Impl(mode, maxBytes, shardCount))
+{
+}
+
+PWIZ_API_DECL ShardedSpectrumCache::~ShardedSpectrumCache() {}
+
+
+PWIZ_API_DECL MemoryMRUCacheMode ShardedSpectrumCache::mode() const {return impl_->mode_;}
+
+PWIZ_API_DECL void ShardedSpectrumCache::setMode(MemoryMRUCacheMode mode)
+{
+    if (mode != impl_->mode_)
+        clear();
+    impl_->mode_ = mode;
+}
+
+PWIZ_API_DECL size_t ShardedSpectrumCache::maxBytes() const {return impl_->maxBytes_;}
+PWIZ_API_DECL size_t ShardedSpectrumCache::shardCount() const {return impl_->shardCount_;}
+
+
+PWIZ_API_DECL SpectrumPtr ShardedSpectrumCache::find(size_t index, Tier tier) const
+{
+    Shard& shard = impl_->shard(index);
+    boost::lock_guard<boost::mutex> lock(shard.mutex);
+
+    EntryList::nth_index<1>::type& byKey = shard.entries.get<1>();
+    EntryList::nth_index<1>::type::iterator itr = byKey.find(index * 2 + tier);
+    if (itr == byKey.end())
+    {
+        ++shard.misses;
+        return SpectrumPtr();
+    }
+
+    ++shard.hits;
+    shard.entries.relocate(shard.entries.begin(), shard.entries.project<0>(itr));
+    return itr->spectrum;
+}
+
+
+PWIZ_API_DECL void ShardedSpectrumCache::insert(size_t index, Tier tier, const SpectrumPtr& spectrum) const
+{
+    if (!spectrum.get())
+        return;
+
+    size_t bytes = byteSize(*spectrum);
+    if (bytes > impl_->maxShardBytes_)
+        return;
+
+    Shard& shard = impl_->shard(index);
+    boost::lock_guard<boost::mutex> lock(shard.mutex);
+
+    // a concurrent miss on the same spectrum may have cached it already; keep the newer one
+    EntryList::nth_index<1>::type& byKey = shard.entries.get<1>();
+    EntryList::nth_index<1>::type::iterator itr = byKey.find(index * 2 + tier);
+    if (itr != byKey.end())
+    {
+        shard.bytes -= itr->bytes;
+        byKey.erase(itr);
+    }
+
+    while (!shard.entries.empty() && shard.bytes + bytes > impl_->maxShardBytes_)
+    {
+        shard.bytes -= shard.entries.back().bytes;
+        shard.entries.pop_back();
+        ++shard.evictions;
+    }
+
+    shard.entries.push_front(CacheEntry(index * 2 + tier, spectrum, bytes));
+    shard.bytes += bytes;
+}
+
+
+PWIZ_API_DECL void ShardedSpectrumCache::clear()
+{
+    for (size_t i=0; i < impl_->shardCount_; ++i)
+    {
+        Shard& shard = impl_->shards_[i];
+        boost::lock_guard<boost::mutex> lock(shard.mutex);
+        shard.entries.clear();
+        shard.bytes = 0;
+    }
+}
+
+
+PWIZ_API_DECL ShardedSpectrumCache::Statistics ShardedSpectrumCache::statistics() const
+{
+    Statistics result;
+    for (size_t i=0; i < impl_->shardCount_; ++i)
+    {
+        Shard& shard = impl_->shards_[i];
+        boost::lock_guard<boost::mutex> lock(shard.mutex);
+        result.hits += shard.hits;
+        result.misses += shard.misses;
+        result.evictions += shard.evictions;
+        result.size += shard.entries.size();
+        result.byteSize += shard.bytes;
+    }
+    return result;
+}
+
+
+PWIZ_API_DECL size_t ShardedSpectrumCache::byteSize(const Spectrum& spectrum)
+{
+    size_t bytes = sizeof(Spectrum) + spectrum.id.capacity() + spectrum.spotID.capacity() +
+                   pwiz::msdata::byteSize(spectrum) + pwiz::msdata::byteSize(spectrum.scanList);
+
+    BOOST_FOREACH(const Scan& scan, spectrum.scanList.scans)
+        bytes += sizeof(Scan) + pwiz::msdata::byteSize(scan);
+    BOOST_FOREACH(const Precursor& precursor, spectrum.precursors)
+        bytes += sizeof(Precursor) + pwiz::msdata::byteSize(precursor.activation) +
+                 precursor.selectedIons.size() * sizeof(SelectedIon);
+    bytes += spectrum.products.size() * sizeof(Product);
+
+    BOOST_FOREACH(const BinaryDataArrayPtr& array, spectrum.binaryDataArrayPtrs)
+        if (array.get())
+            bytes += sizeof(BinaryDataArray) + pwiz::msdata::byteSize(*array) +
+                     array->data.capacity() * sizeof(double) +
+                     array->floatData.capacity() * sizeof(float);
+
+    return bytes;
+}
+
+
+} // namespace msdata
+} // namespace pwiz
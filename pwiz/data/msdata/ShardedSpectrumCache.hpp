@@ -0,0 +1,108 @@
+//
+// $Id$
+//
+//
+// Original author: agent <agent@local>
+//
+// Copyright 2026
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef _SHARDEDSPECTRUMCACHE_HPP_
+#define _SHARDEDSPECTRUMCACHE_HPP_
+
+
+#include "pwiz/utility/misc/Export.hpp"
+#include "MSData.hpp"
+#include "MemoryMRUCache.hpp"
+#include <boost/smart_ptr.hpp>
+
+
+namespace pwiz {
+namespace msdata {
+
+
+/// an MRU cache of spectra with a memory budget in bytes rather than a spectrum count;
+/// spectra are split into shards by index, each with its own lock, budget and MRU order,
+/// so that concurrent readers (e.g. SpectrumWorkerThreads) rarely contend
+class PWIZ_API_DECL ShardedSpectrumCache
+{
+    public:
+
+    /// the part of a spectrum an entry holds; the cache mode decides which tiers are used
+    enum Tier
+    {
+        Tier_MetaData,  ///< the spectrum without binary data arrays
+        Tier_BinaryData ///< only the binary data arrays (or the whole spectrum, as the caller chooses)
+    };
+
+    struct PWIZ_API_DECL Statistics
+    {
+        Statistics() : hits(0), misses(0), evictions(0), size(0), byteSize(0) {}
+
+        size_t hits;
+        size_t misses;
+        size_t evictions;
+        size_t size;     ///< number of entries (over both tiers)
+        size_t byteSize; ///< approximate memory held by the entries
+    };
+
+    /// creates a cache holding about maxBytes of spectra, divided evenly among shardCount shards;
+    /// a shardCount of 0 uses one shard per SpectrumWorkerThreads::defaultThreadCount()
+    ShardedSpectrumCache(MemoryMRUCacheMode mode, size_t maxBytes, size_t shardCount = 0);
+    ~ShardedSpectrumCache();
+
+    /// get the current caching mode
+    MemoryMRUCacheMode mode() const;
+
+    /// set the caching mode
+    /// note: if the new mode is different than the current mode, the cache will be cleared;
+    /// must not be called while other threads are using the cache
+    void setMode(MemoryMRUCacheMode mode);
+
+    size_t maxBytes() const;
+    size_t shardCount() const;
+
+    /// returns the cached entry for index in the given tier and makes it most recently used,
+    /// or returns a null pointer if there is none
+    SpectrumPtr find(size_t index, Tier tier) const;
+
+    /// caches spectrum as the entry for index in the given tier, evicting the least recently used
+    /// entries of its shard to stay within budget; spectra larger than a shard's budget are not cached
+    void insert(size_t index, Tier tier, const SpectrumPtr& spectrum) const;
+
+    /// removes all entries; the statistics are kept
+    void clear();
+
+    /// returns the counters summed over all shards
+    Statistics statistics() const;
+
+    /// returns an approximation of the memory held by spectrum
+    static size_t byteSize(const Spectrum& spectrum);
+
+    private:
+    class Impl;
+    boost::scoped_ptr<Impl> impl_;
+    ShardedSpectrumCache(ShardedSpectrumCache&);
+    ShardedSpectrumCache& operator=(ShardedSpectrumCache&);
+};
+
+typedef boost::shared_ptr<ShardedSpectrumCache> ShardedSpectrumCachePtr;
+
+
+} // namespace msdata
+} // namespace pwiz
+
+
+#endif // _SHARDEDSPECTRUMCACHE_HPP_
@@ -38,6 +38,14 @@ PWIZ_API_DECL SpectrumListCache::SpectrumListCache(const SpectrumListPtr& inner,
 }
 
 
+PWIZ_API_DECL SpectrumListCache::SpectrumListCache(const SpectrumListPtr& inner,
+                                                   const ShardedSpectrumCachePtr& shardedCache)
+: SpectrumListWrapper(inner), spectrumCache_(MemoryMRUCacheMode_Off, 0), shardedCache_(shardedCache)
+{
+    if (!shardedCache_.get()) throw runtime_error("[SpectrumListCache] Null pointer");
+}
+
+
 namespace {
 
 
@@ -53,6 +61,22 @@ void clearSpectrumMetadata(Spectrum& spectrum)
 }
 
 
+SpectrumPtr copyWithoutBinaryData(const Spectrum& spectrum)
+{
+    SpectrumPtr copy(new Spectrum(spectrum));
+    copy->binaryDataArrayPtrs.clear();
+    return copy;
+}
+
+
+SpectrumPtr copyWithoutMetadata(const Spectrum& spectrum)
+{
+    SpectrumPtr copy(new Spectrum(spectrum));
+    clearSpectrumMetadata(*copy);
+    return copy;
+}
+
+
 struct modifyCachedSpectrumPtr
 {
     modifyCachedSpectrumPtr(const SpectrumPtr& newSpectrumPtr)
@@ -88,6 +112,9 @@ struct modifyCachedSpectrumPtr
 
 PWIZ_API_DECL SpectrumPtr SpectrumListCache::spectrum(size_t index, bool getBinaryData) const
 {
+    if (shardedCache_.get())
+        return shardedSpectrum(index, getBinaryData);
+
     SpectrumPtr original, copy;
     if (getBinaryData)
     {
@@ -158,6 +185,59 @@ PWIZ_API_DECL SpectrumPtr SpectrumListCache::spectrum(size_t index, bool getBina
     }
 }
 
+// The sharded cache behaves the same way, except that in cache-all mode the metadata and the
+// binary data are cached as separate tiers sharing the byte budget: metadata requests are served
+// from the metadata tier, and when only one tier of a spectrum is still cached, only the other
+// is read from the inner list.
+
+SpectrumPtr SpectrumListCache::shardedSpectrum(size_t index, bool getBinaryData) const
+{
+    typedef ShardedSpectrumCache SSC;
+    const ShardedSpectrumCache& cache = *shardedCache_;
+    MemoryMRUCacheMode mode = cache.mode();
+
+    if (mode == MemoryMRUCacheMode_Off ||
+        (!getBinaryData && mode == MemoryMRUCacheMode_BinaryDataOnly))
+        return inner_->spectrum(index, getBinaryData);
+
+    SpectrumPtr metadata, binaryData, result;
+    bool useMetadata = mode != MemoryMRUCacheMode_BinaryDataOnly;
+    bool useBinaryData = getBinaryData && mode != MemoryMRUCacheMode_MetaDataOnly;
+
+    if (useMetadata) metadata = cache.find(index, SSC::Tier_MetaData);
+    if (useBinaryData) binaryData = cache.find(index, SSC::Tier_BinaryData);
+
+    if (!getBinaryData)
+    {
+        if (!metadata.get())
+        {
+            metadata = inner_->spectrum(index, false);
+            cache.insert(index, SSC::Tier_MetaData, metadata);
+        }
+        return metadata;
+    }
+
+    if (binaryData.get())
+    {
+        // copy the cached metadata or get it from the inner list, then add cached binary data to it
+        result = metadata.get() ? SpectrumPtr(new Spectrum(*metadata)) : inner_->spectrum(index, false);
+        result->binaryDataArrayPtrs = binaryData->binaryDataArrayPtrs;
+        if (useMetadata && !metadata.get())
+            cache.insert(index, SSC::Tier_MetaData, copyWithoutBinaryData(*result));
+        return result;
+    }
+
+    // we have cached metadata, hopefully this format knows how
+    // to jump to binary data without rescanning metadata
+    result = metadata.get() ? inner_->spectrum(metadata, true) : inner_->spectrum(index, true);
+
+    if (useMetadata && !metadata.get())
+        cache.insert(index, SSC::Tier_MetaData, copyWithoutBinaryData(*result));
+    if (useBinaryData)
+        cache.insert(index, SSC::Tier_BinaryData, copyWithoutMetadata(*result));
+    return result;
+}
+
 PWIZ_API_DECL SpectrumListCache::CacheType& SpectrumListCache::spectrumCache()
 {
     return spectrumCache_;
@@ -168,6 +248,11 @@ PWIZ_API_DECL const SpectrumListCache::CacheType& SpectrumListCache::spectrumCac
     return spectrumCache_;
 }
 
+PWIZ_API_DECL const ShardedSpectrumCachePtr& SpectrumListCache::shardedSpectrumCache() const
+{
+    return shardedCache_;
+}
+
 
 } // namespace msdata
 } // namespace pwiz
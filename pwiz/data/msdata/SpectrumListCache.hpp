@@ -26,6 +26,7 @@
 #include "pwiz/utility/misc/Export.hpp"
 #include "MSData.hpp"
 #include "MemoryMRUCache.hpp"
+#include "ShardedSpectrumCache.hpp"
 #include "SpectrumListWrapper.hpp"
 
 
@@ -46,6 +47,11 @@ class PWIZ_API_DECL SpectrumListCache : public SpectrumListWrapper
                       MemoryMRUCacheMode cacheMode,
                       size_t cacheSize);
 
+    /// caches spectra in shardedCache (sized in bytes) instead of the spectrum-count MRU cache;
+    /// the cache must not be shared with other SpectrumLists since it is keyed by spectrum index
+    SpectrumListCache(const SpectrumListPtr& inner,
+                      const ShardedSpectrumCachePtr& shardedCache);
+
     /// returns the requested spectrum which may or may not be cached depending on
     /// the current cache mode
     virtual SpectrumPtr spectrum(size_t index, bool getBinaryData = false) const;
@@ -56,10 +62,15 @@ class PWIZ_API_DECL SpectrumListCache : public SpectrumListWrapper
     /// returns a const-reference to the cache
     const CacheType& spectrumCache() const;
 
+    /// returns the sharded cache, or a null pointer if the spectrum-count MRU cache is used
+    const ShardedSpectrumCachePtr& shardedSpectrumCache() const;
+
     protected:
     mutable CacheType spectrumCache_;
+    ShardedSpectrumCachePtr shardedCache_;
 
     private:
+    SpectrumPtr shardedSpectrum(size_t index, bool getBinaryData) const;
     SpectrumListCache(SpectrumListCache&);
     SpectrumListCache& operator=(SpectrumListCache&);
 };
@@ -24,8 +24,11 @@
 #include "MSDataFile.hpp"
 #include "MemoryMRUCache.hpp"
 #include "SpectrumListCache.hpp"
+#include "SpectrumListBase.hpp"
 #include "pwiz/utility/misc/Std.hpp"
 #include "Serializer_MGF.hpp"
+#include <boost/thread.hpp>
+#include <boost/atomic.hpp>
 
 
 using namespace pwiz::util;
@@ -396,6 +399,171 @@ void testModeMetaDataAndBinaryData()
     unit_assert(spectrumHasBinaryData(*cache.lru().spectrum));
 }
 
+void testShardedSpectrumCache()
+{
+    typedef ShardedSpectrumCache SSC;
+
+    // one shard with room for two of the four test spectra (which grow with index)
+    SpectrumPtr s2 = makeSpectrumPtr(2, "S3");
+    size_t s2Bytes = SSC::byteSize(*s2);
+    SSC cache(MemoryMRUCacheMode_MetaDataAndBinaryData, s2Bytes * 2, 1);
+
+    unit_assert_operator_equal(1, cache.shardCount());
+    unit_assert(!cache.find(0, SSC::Tier_BinaryData));
+
+    cache.insert(0, SSC::Tier_BinaryData, makeSpectrumPtr(0, "S1"));
+    cache.insert(1, SSC::Tier_BinaryData, makeSpectrumPtr(1, "S2"));
+    unit_assert(cache.find(0, SSC::Tier_BinaryData));
+    unit_assert(!cache.find(0, SSC::Tier_MetaData)); // tiers are separate
+
+    // inserting S3 must evict the LRU spectrum (S2) but not the recently found S1
+    cache.insert(2, SSC::Tier_BinaryData, s2);
+    unit_assert(cache.find(0, SSC::Tier_BinaryData));
+    unit_assert(!cache.find(1, SSC::Tier_BinaryData));
+    unit_assert_operator_equal(s2, cache.find(2, SSC::Tier_BinaryData));
+
+    SSC::Statistics stats = cache.statistics();
+    unit_assert_operator_equal(2, stats.size);
+    unit_assert_operator_equal(3, stats.hits);
+    unit_assert_operator_equal(3, stats.misses);
+    unit_assert_operator_equal(1, stats.evictions);
+    unit_assert(stats.byteSize <= cache.maxBytes());
+
+    // spectra larger than the budget are not cached
+    cache.insert(3, SSC::Tier_BinaryData, makeSpectrumPtr(30, "S31"));
+    unit_assert(!cache.find(3, SSC::Tier_BinaryData));
+
+    cache.setMode(MemoryMRUCacheMode_MetaDataOnly);
+    unit_assert_operator_equal(0, cache.statistics().size);
+}
+
+
+void testShardedSpectrumListCache()
+{
+    // initialize list
+    MSData msd;
+    shared_ptr<SpectrumListSimple> sl(new SpectrumListSimple);
+    sl->spectra.push_back(makeSpectrumPtr(0, "S1"));
+    sl->spectra.push_back(makeSpectrumPtr(1, "S2"));
+    sl->spectra.push_back(makeSpectrumPtr(2, "S3"));
+    sl->spectra.push_back(makeSpectrumPtr(3, "S4"));
+    msd.run.spectrumListPtr = sl;
+
+    // serializing to MGF and back will produce different shared_ptrs
+    boost::shared_ptr<stringstream> ss(new stringstream);
+    Serializer_MGF serializer;
+    serializer.write(*ss, msd, 0);
+    serializer.read(ss, msd);
+
+    // in metadata-and-binary-data mode, the two tiers are cached and combined separately
+    ShardedSpectrumCachePtr cachePtr(new ShardedSpectrumCache(MemoryMRUCacheMode_MetaDataAndBinaryData, 1 << 20, 2));
+    SpectrumListCache slc(msd.run.spectrumListPtr, cachePtr);
+    const ShardedSpectrumCache& cache = *slc.shardedSpectrumCache();
+
+    SpectrumPtr s = slc.spectrum(1, true);
+    unit_assert(spectrumHasMetadata(*s));
+    unit_assert(spectrumHasBinaryData(*s));
+    unit_assert_operator_equal(2, cache.statistics().size);
+
+    SpectrumPtr metadata = cache.find(1, ShardedSpectrumCache::Tier_MetaData);
+    SpectrumPtr binaryData = cache.find(1, ShardedSpectrumCache::Tier_BinaryData);
+    unit_assert(spectrumHasMetadata(*metadata));
+    unit_assert(!spectrumHasBinaryData(*metadata));
+    unit_assert(!spectrumHasMetadata(*binaryData));
+    unit_assert(spectrumHasBinaryData(*binaryData));
+
+    // metadata access is served from the metadata tier
+    unit_assert_operator_equal(metadata, slc.spectrum(1, false));
+
+    // full access combines both tiers
+    SpectrumPtr s2 = slc.spectrum(1, true);
+    unit_assert(*s == *s2);
+    unit_assert_operator_equal(binaryData->binaryDataArrayPtrs[0], s2->binaryDataArrayPtrs[0]);
+
+    // metadata-only access caches only the metadata tier
+    slc.spectrum(2, false);
+    unit_assert(cache.find(2, ShardedSpectrumCache::Tier_MetaData));
+    unit_assert(!cache.find(2, ShardedSpectrumCache::Tier_BinaryData));
+
+    // in binary-data-only mode, metadata access should not affect the cache
+    cachePtr->setMode(MemoryMRUCacheMode_BinaryDataOnly);
+    slc.spectrum(3, false);
+    unit_assert_operator_equal(0, cache.statistics().size);
+    s = slc.spectrum(3, true);
+    unit_assert(spectrumHasMetadata(*s));
+    unit_assert(spectrumHasBinaryData(*s));
+    unit_assert(!cache.find(3, ShardedSpectrumCache::Tier_MetaData));
+    unit_assert(cache.find(3, ShardedSpectrumCache::Tier_BinaryData));
+}
+
+// a list that makes a new spectrum for each request, like a file-backed list
+class GeneratingSpectrumList : public SpectrumListBase
+{
+    public:
+
+    GeneratingSpectrumList(size_t size)
+    {
+        for (size_t i=0; i < size; ++i)
+        {
+            identities_.push_back(SpectrumIdentity());
+            identities_.back().index = i;
+            identities_.back().id = "S" + lexical_cast<string>(i+1);
+        }
+    }
+
+    virtual size_t size() const {return identities_.size();}
+    virtual const SpectrumIdentity& spectrumIdentity(size_t index) const {return identities_.at(index);}
+
+    virtual SpectrumPtr spectrum(size_t index, bool getBinaryData = false) const
+    {
+        SpectrumPtr spectrum = makeSpectrumPtr(index, identities_.at(index).id);
+        if (!getBinaryData)
+            spectrum->binaryDataArrayPtrs.clear();
+        return spectrum;
+    }
+
+    private:
+    vector<SpectrumIdentity> identities_;
+};
+
+void testShardedSpectrumCacheConcurrency()
+{
+    // several threads read through one cache, with a budget small enough
+    // that they keep evicting each other's spectra
+    const size_t spectrumCount = 40;
+    SpectrumListPtr sl(new GeneratingSpectrumList(spectrumCount));
+    size_t maxBytes = ShardedSpectrumCache::byteSize(*makeSpectrumPtr(spectrumCount, "")) * 8;
+    ShardedSpectrumCachePtr cachePtr(new ShardedSpectrumCache(MemoryMRUCacheMode_MetaDataAndBinaryData, maxBytes, 4));
+    SpectrumListCache slc(sl, cachePtr);
+
+    boost::atomic<size_t> failureCount(0);
+    boost::thread_group threads;
+    for (size_t t=0; t < 8; ++t)
+        threads.create_thread([&, t]
+        {
+            for (size_t i=0; i < 2000; ++i)
+            {
+                size_t index = (i * 7 + t * 13) % spectrumCount;
+                bool getBinaryData = (i + t) % 3 != 0;
+                SpectrumPtr s = slc.spectrum(index, getBinaryData);
+                if (s->index != index ||
+                    s->id != sl->spectrumIdentity(index).id ||
+                    !spectrumHasMetadata(*s) ||
+                    getBinaryData && (s->getMZArray()->data.size() != (index+1)*10 ||
+                                      s->getIntensityArray()->data.back() != ((index+1)*10 - 1) * 100))
+                    ++failureCount;
+            }
+        });
+    threads.join_all();
+
+    unit_assert_operator_equal(0, failureCount);
+
+    ShardedSpectrumCache::Statistics stats = cachePtr->statistics();
+    unit_assert(stats.hits > 0);
+    unit_assert(stats.evictions > 0);
+    unit_assert(stats.byteSize <= cachePtr->maxBytes());
+}
+
 void testFileReads(const char *filename) {
     std::string srcparent(__FILE__); // locate test data relative to this source file
     // something like \ProteoWizard\pwiz\pwiz\data\msdata\SpectrumListCacheTest.cpp
@@ -435,6 +603,9 @@ void test()
     testModeMetaDataOnly();
     testModeBinaryDataOnly();
     testModeMetaDataAndBinaryData();
+    testShardedSpectrumCache();
+    testShardedSpectrumListCache();
+    testShardedSpectrumCacheConcurrency();
     // check the delayed-binary-read
     // logic for mzML and mzXML readers
     testFileReads("tiny.pwiz.mzXML");
@@ -168,6 +168,93 @@ void test()
     bfs::remove(testFilename);
 }
 
+void testBinaryDataAccessPolicies()
+{
+    // spectra whose binary data spans several chunks of each policy
+    MSData msd;
+    msd.id = "policies";
+    boost::shared_ptr<SpectrumListSimple> spectrumList(new SpectrumListSimple);
+    msd.run.spectrumListPtr = spectrumList;
+    for (size_t i = 0; i < 300; ++i)
+    {
+        SpectrumPtr spectrum(new Spectrum);
+        spectrum->index = i;
+        spectrum->id = "scan=" + lexical_cast<string>(i + 1);
+        spectrum->set(MS_ms_level, 1);
+        vector<MZIntensityPair> pairs;
+        for (size_t j = 0; j < 50 + i % 97; ++j)
+            pairs.push_back(MZIntensityPair(100 + j * 0.5, i * 1000.0 + j));
+        spectrum->setMZIntensityPairs(pairs, MS_number_of_detector_counts);
+        spectrumList->spectra.push_back(spectrum);
+    }
+
+    const mz5::Configuration_mz5::BinaryDataAccessPolicy policies[] =
+    {
+        mz5::Configuration_mz5::BDAP_Balanced,
+        mz5::Configuration_mz5::BDAP_RandomAccess,
+        mz5::Configuration_mz5::BDAP_Sequential
+    };
+
+    for (size_t w = 0; w < 3; ++w)
+    {
+        mz5::Configuration_mz5 writeConfig;
+        writeConfig.setBinaryDataAccessPolicy(policies[w]);
+        Serializer_mz5(writeConfig).write(testFilename, msd);
+
+        for (size_t r = 0; r < 3; ++r)
+        {
+            if (os_) *os_ << "write policy " << policies[w] << ", read policy " << policies[r] << endl;
+
+            mz5::Configuration_mz5 readConfig;
+            readConfig.setBinaryDataAccessPolicy(policies[r]);
+            MSData result;
+            Serializer_mz5(readConfig).read(testFilename, result);
+            SpectrumListPtr sl = result.run.spectrumListPtr;
+            unit_assert_operator_equal(300, sl->size());
+
+            // in order, then backwards and striding, so chunks are both reused and evicted
+            vector<size_t> order;
+            for (size_t i = 0; i < 300; ++i) order.push_back(i);
+            for (size_t i = 300; i > 0; --i) order.push_back(i - 1);
+            for (size_t i = 0; i < 300; ++i) order.push_back((i * 7) % 300);
+
+            for (size_t i = 0; i < order.size(); ++i)
+            {
+                vector<MZIntensityPair> expected, actual;
+                spectrumList->spectra[order[i]]->getMZIntensityPairs(expected);
+                sl->spectrum(order[i], true)->getMZIntensityPairs(actual);
+                unit_assert_operator_equal(expected.size(), actual.size());
+                for (size_t j = 0; j < expected.size(); ++j)
+                {
+                    unit_assert_equal(expected[j].mz, actual[j].mz, 1e-10);
+                    unit_assert_operator_equal(expected[j].intensity, actual[j].intensity);
+                }
+            }
+        }
+    }
+    bfs::remove(testFilename);
+}
+
+void testWriteConfigBinaryDataAccessPolicy()
+{
+    MSDataFile::WriteConfig config(MSDataFile::Format_MZ5);
+    unit_assert_operator_equal(mz5::Configuration_mz5::BDAP_Balanced, mz5::Configuration_mz5(config).getBinaryDataAccessPolicy());
+
+    config.binaryDataAccessPolicy = BinaryDataAccessPolicy_RandomAccess;
+    unit_assert_operator_equal(mz5::Configuration_mz5::BDAP_RandomAccess, mz5::Configuration_mz5(config).getBinaryDataAccessPolicy());
+
+    config.binaryDataAccessPolicy = BinaryDataAccessPolicy_Sequential;
+    mz5::Configuration_mz5 mz5Config(config);
+    unit_assert_operator_equal(mz5::Configuration_mz5::BDAP_Sequential, mz5Config.getBinaryDataAccessPolicy());
+    unit_assert_operator_equal(mz5::Configuration_mz5::BDAP_Sequential, mz5::Configuration_mz5(mz5Config).getBinaryDataAccessPolicy());
+
+    Reader::Config readerConfig;
+    unit_assert_operator_equal(BinaryDataAccessPolicy_Balanced, readerConfig.binaryDataAccessPolicy);
+    readerConfig.binaryDataAccessPolicy = BinaryDataAccessPolicy_RandomAccess;
+    unit_assert_operator_equal(mz5::Configuration_mz5::BDAP_RandomAccess,
+                               mz5::Configuration_mz5::toBinaryDataAccessPolicy(Reader::Config(readerConfig).binaryDataAccessPolicy));
+}
+
 int main(int argc, char* argv[])
 {
     TEST_PROLOG(argc, argv)
@@ -176,6 +263,8 @@ int main(int argc, char* argv[])
     {
         if (argc > 1 && !strcmp(argv[1], "-v")) os_ = &cout;
         test();
+        testBinaryDataAccessPolicies();
+        testWriteConfigBinaryDataAccessPolicy();
     }
     catch (exception& e)
     {
@@ -30,6 +30,7 @@
 #include "pwiz/utility/misc/Std.hpp"
 #include <boost/bind.hpp>
 #include <boost/thread.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 
 
 namespace pwiz {
@@ -38,16 +39,81 @@ namespace msdata {
 
 using namespace pwiz::minimxml;
 using boost::iostreams::offset_to_position;
+using boost::iostreams::stream_offset;
 
 
 namespace {
 
 
+// returns the position of the tag that ends parsing of a <spectrum> element:
+// </spectrum>, or the first <binaryDataArray> when binary data is being ignored
+size_t findSpectrumTerminator(const string& buffer, size_t searchFrom, bool ignoreBinaryData)
+{
+    size_t result = buffer.find("</spectrum>", searchFrom);
+    if (!ignoreBinaryData)
+        return result;
+
+    const size_t tagLength = sizeof("<binaryDataArray") - 1;
+    for (size_t i = buffer.find("<binaryDataArray", searchFrom);
+         i < result && i + tagLength < buffer.size();
+         i = buffer.find("<binaryDataArray", i + tagLength))
+        if (buffer[i + tagLength] != 'L') // skip <binaryDataArrayList>
+            return i;
+    return result;
+}
+
+
+// reads the bytes the parser will need for a <spectrum> element starting at the current stream position
+void readSpectrumElement(istream& is, bool ignoreBinaryData, string& buffer)
+{
+    const size_t chunkSize = 16384;
+    const size_t overlap = 32; // longer than any terminator and its following character
+
+    buffer.clear();
+    size_t terminator = string::npos;
+    size_t scanned = 0;
+    while (true)
+    {
+        size_t oldSize = buffer.size();
+        buffer.resize(oldSize + chunkSize);
+        is.read(&buffer[oldSize], chunkSize);
+        buffer.resize(oldSize + is.gcount());
+
+        // a short read at the end of the stream is not an error for the next reader
+        bool endOfStream = !is;
+        if (endOfStream)
+            is.clear();
+
+        if (terminator == string::npos)
+        {
+            terminator = findSpectrumTerminator(buffer, scanned > overlap ? scanned - overlap : 0, ignoreBinaryData);
+            scanned = buffer.size();
+        }
+
+        if (terminator != string::npos)
+        {
+            size_t tagEnd = buffer.find('>', terminator);
+            if (tagEnd != string::npos)
+            {
+                buffer.resize(tagEnd + 1);
+                return;
+            }
+        }
+
+        // the element runs to the end of the stream (e.g. a truncated file): let the parser deal with it
+        if (endOfStream)
+            return;
+    }
+}
+
+
 class SpectrumList_mzMLImpl : public SpectrumList_mzML
 {
     public:
 
-    SpectrumList_mzMLImpl(shared_ptr<istream> is, const MSData& msd, const Index_mzML_Ptr& index);
+    SpectrumList_mzMLImpl(shared_ptr<istream> is, const MSData& msd, const Index_mzML_Ptr& index,
+                          const shared_ptr<boost::iostreams::mapped_file_source>& mapping,
+                          bool float32Storage);
 
     // SpectrumList implementation
 
@@ -61,18 +127,28 @@ class SpectrumList_mzMLImpl : public SpectrumList_mzML
     virtual SpectrumPtr spectrum(size_t index, IO::BinaryDataFlag binaryDataFlag, const SpectrumPtr *defaults) const;
 
     private:
+    void readSpectrum(size_t index, IO::BinaryDataFlag binaryDataFlag, Spectrum& result) const;
+
     shared_ptr<istream> is_;
+    shared_ptr<boost::iostreams::mapped_file_source> mapping_;
+    bool float32Storage_;
     const MSData& msd_;
+    References::Referents referents_; // the MSData's lists indexed once for resolving every spectrum
     int schemaVersion_;
     mutable bool indexed_;
     mutable boost::mutex readMutex;
 
+    // held shared while the index is used and exclusively while it is recreated
+    mutable boost::shared_mutex indexMutex_;
+
     Index_mzML_Ptr index_;
 };
 
 
-SpectrumList_mzMLImpl::SpectrumList_mzMLImpl(shared_ptr<istream> is, const MSData& msd, const Index_mzML_Ptr& index)
-:   is_(is), msd_(msd), index_(index)
+SpectrumList_mzMLImpl::SpectrumList_mzMLImpl(shared_ptr<istream> is, const MSData& msd, const Index_mzML_Ptr& index,
+                                             const shared_ptr<boost::iostreams::mapped_file_source>& mapping,
+                                             bool float32Storage)
+:   is_(is), mapping_(mapping), float32Storage_(float32Storage), msd_(msd), referents_(msd), index_(index)
 {
     schemaVersion_ = bal::starts_with(msd_.version(), "1.0") ? 1 : 0;
 }
@@ -81,6 +157,7 @@ SpectrumList_mzMLImpl::SpectrumList_mzMLImpl(shared_ptr<istream> is, const MSDat
 size_t SpectrumList_mzMLImpl::size() const
 {
     //boost::call_once(indexSizeSet_.flag, boost::bind(&SpectrumList_mzMLImpl::setIndexSize, this));
+    boost::shared_lock<boost::shared_mutex> indexLock(indexMutex_);
     return index_->spectrumCount();
 }
 
@@ -88,6 +165,7 @@ size_t SpectrumList_mzMLImpl::size() const
 const SpectrumIdentity& SpectrumList_mzMLImpl::spectrumIdentity(size_t index) const
 {
     //boost::call_once(indexInitialized_.flag, boost::bind(&SpectrumList_mzMLImpl::createIndex, this));
+    boost::shared_lock<boost::shared_mutex> indexLock(indexMutex_);
     if (index >= index_->spectrumCount())
         throw runtime_error("[SpectrumList_mzML::spectrumIdentity()] Index out of bounds.");
 
@@ -98,6 +176,7 @@ const SpectrumIdentity& SpectrumList_mzMLImpl::spectrumIdentity(size_t index) co
 size_t SpectrumList_mzMLImpl::find(const string& id) const
 {
     //boost::call_once(indexInitialized_.flag, boost::bind(&SpectrumList_mzMLImpl::createIndex, this));
+    boost::shared_lock<boost::shared_mutex> indexLock(indexMutex_);
     return index_->findSpectrumId(id);
 }
 
@@ -105,6 +184,7 @@ size_t SpectrumList_mzMLImpl::find(const string& id) const
 IndexList SpectrumList_mzMLImpl::findSpotID(const string& spotID) const
 {
     //boost::call_once(indexInitialized_.flag, boost::bind(&SpectrumList_mzMLImpl::createIndex, this));
+    boost::shared_lock<boost::shared_mutex> indexLock(indexMutex_);
     return index_->findSpectrumBySpotID(spotID);
 }
 
@@ -125,11 +205,54 @@ SpectrumPtr SpectrumList_mzMLImpl::spectrum(const SpectrumPtr &seed, bool getBin
     return spectrum(seed->index, getBinaryData ? IO::ReadBinaryDataOnly: IO::IgnoreBinaryData, &seed);
 }
 
+// with a mapping, the element is parsed where it lies; otherwise only the seek and the copy of the
+// element's bytes happen under readMutex. XML parsing and binary data decoding run concurrently in the
+// calling threads, which share indexMutex_ so the index can't be recreated underneath them
+void SpectrumList_mzMLImpl::readSpectrum(size_t index, IO::BinaryDataFlag binaryDataFlag, Spectrum& result) const
+{
+    boost::shared_lock<boost::shared_mutex> indexLock(indexMutex_);
+
+    // we may just be here to get binary data of otherwise previously read spectrum
+    const SpectrumIdentityFromXML id = index_->spectrumIdentity(index);
+    stream_offset seekto =
+        binaryDataFlag==IO::ReadBinaryDataOnly ? 
+        id.sourceFilePositionForBinarySpectrumData : // might be set, might be -1
+        (stream_offset)-1;
+    if (seekto == (stream_offset)-1) {
+        seekto = id.sourceFilePosition;
+    }
+
+    if (mapping_)
+    {
+        if (seekto < 0 || seekto >= (stream_offset) mapping_->size())
+            throw runtime_error("[SpectrumList_mzML::spectrum()] Error seeking to <spectrum>.");
+
+        // the parser stops at the end of the element by itself
+        SAXParser::RegionStreambuf elementBuffer(mapping_->data() + seekto, mapping_->data() + mapping_->size(), seekto);
+        istream elementStream(&elementBuffer);
+        IO::read(elementStream, result, binaryDataFlag, schemaVersion_, &index_->legacyIdRefToNativeId(), &msd_, &id, float32Storage_);
+        return;
+    }
+
+    string element;
+    {
+        boost::lock_guard<boost::mutex> lock(readMutex);
+        is_->seekg(offset_to_position(seekto));
+        if (!*is_) 
+            throw runtime_error("[SpectrumList_mzML::spectrum()] Error seeking to <spectrum>.");
+
+        readSpectrumElement(*is_, binaryDataFlag == IO::IgnoreBinaryData, element);
+    }
+
+    SAXParser::RegionStreambuf elementBuffer(element.data(), element.data() + element.size(), seekto);
+    istream elementStream(&elementBuffer);
+    IO::read(elementStream, result, binaryDataFlag, schemaVersion_, &index_->legacyIdRefToNativeId(), &msd_, &id, float32Storage_);
+}
+
 SpectrumPtr SpectrumList_mzMLImpl::spectrum(size_t index, IO::BinaryDataFlag binaryDataFlag, const SpectrumPtr *defaults) const
 {
-    boost::lock_guard<boost::mutex> lock(readMutex);  // lock_guard will unlock mutex when out of scope or when exception thrown (during destruction)
     //boost::call_once(indexInitialized_.flag, boost::bind(&SpectrumList_mzMLImpl::createIndex, this));
-    if (index >= index_->spectrumCount())
+    if (index >= size())
         throw runtime_error("[SpectrumList_mzML::spectrum()] Index out of bounds.");
 
     // allocate Spectrum object and read it in
@@ -143,20 +266,7 @@ SpectrumPtr SpectrumList_mzMLImpl::spectrum(size_t index, IO::BinaryDataFlag bin
 
     try
     {
-        // we may just be here to get binary data of otherwise previously read spectrum
-        const SpectrumIdentityFromXML &id = index_->spectrumIdentity(index);
-        boost::iostreams::stream_offset seekto =
-            binaryDataFlag==IO::ReadBinaryDataOnly ? 
-            id.sourceFilePositionForBinarySpectrumData : // might be set, might be -1
-            (boost::iostreams::stream_offset)-1;
-        if (seekto == (boost::iostreams::stream_offset)-1) {
-            seekto = id.sourceFilePosition;
-        }
-        is_->seekg(offset_to_position(seekto));
-        if (!*is_) 
-            throw runtime_error("[SpectrumList_mzML::spectrum()] Error seeking to <spectrum>.");
-
-        IO::read(*is_, *result, binaryDataFlag, schemaVersion_, &index_->legacyIdRefToNativeId(), &msd_, &id);
+        readSpectrum(index, binaryDataFlag, *result);
 
         // test for reading the wrong spectrum
         if (result->index != index)
@@ -166,17 +276,20 @@ SpectrumPtr SpectrumList_mzMLImpl::spectrum(size_t index, IO::BinaryDataFlag bin
     {
         // TODO: log warning about missing/corrupt index
 
-        // recreate index
+        // recreate index; this path stays fully serialized since it modifies the shared index
+        boost::unique_lock<boost::shared_mutex> indexLock(indexMutex_);
+        boost::lock_guard<boost::mutex> lock(readMutex);
         indexed_ = false;
+        is_->clear();
         index_->recreate();
         const SpectrumIdentityFromXML &id = index_->spectrumIdentity(index);
         is_->seekg(offset_to_position(id.sourceFilePosition));
-        IO::read(*is_, *result, binaryDataFlag, schemaVersion_, &index_->legacyIdRefToNativeId(), &msd_, &id);
+        IO::read(*is_, *result, binaryDataFlag, schemaVersion_, &index_->legacyIdRefToNativeId(), &msd_, &id, float32Storage_);
     }
 
     // resolve any references into the MSData object
 
-    References::resolve(*result, msd_);
+    References::resolve(*result, referents_);
 
     return result;
 }
@@ -189,7 +302,21 @@ PWIZ_API_DECL SpectrumListPtr SpectrumList_mzML::create(shared_ptr<istream> is,
     if (!is.get() || !*is)
         throw runtime_error("[SpectrumList_mzML::create()] Bad istream.");
 
-    return SpectrumListPtr(new SpectrumList_mzMLImpl(is, msd, indexPtr));
+    return SpectrumListPtr(new SpectrumList_mzMLImpl(is, msd, indexPtr, shared_ptr<boost::iostreams::mapped_file_source>(), false));
+}
+
+
+PWIZ_API_DECL SpectrumListPtr SpectrumList_mzML::create(shared_ptr<istream> is, const MSData& msd, const Index_mzML_Ptr& indexPtr,
+                                                        const shared_ptr<boost::iostreams::mapped_file_source>& mapping,
+                                                        bool float32Storage)
+{
+    if (!is.get() || !*is)
+        throw runtime_error("[SpectrumList_mzML::create()] Bad istream.");
+
+    if (mapping.get() && !mapping->is_open())
+        throw runtime_error("[SpectrumList_mzML::create()] Bad mapping.");
+
+    return SpectrumListPtr(new SpectrumList_mzMLImpl(is, msd, indexPtr, mapping, float32Storage));
 }
 
 
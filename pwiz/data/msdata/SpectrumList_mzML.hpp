@@ -31,6 +31,9 @@
 #include <iosfwd>
 
 
+namespace boost { namespace iostreams { class mapped_file_source; } }
+
+
 namespace pwiz {
 namespace msdata {
 
@@ -43,6 +46,16 @@ class PWIZ_API_DECL SpectrumList_mzML : public SpectrumListBase
     static SpectrumListPtr create(boost::shared_ptr<std::istream> is,
                                   const MSData& msd,
                                   const Index_mzML_Ptr& indexPtr);
+
+    /// as above, but if mapping is not null, spectra are parsed in place from it, a read-only
+    /// mapping of the same (uncompressed) file, instead of being read through the stream; the
+    /// stream is still used to rebuild the index if it turns out to be wrong;
+    /// if float32Storage is true, 32-bit float arrays are returned in BinaryDataArray::floatData
+    static SpectrumListPtr create(boost::shared_ptr<std::istream> is,
+                                  const MSData& msd,
+                                  const Index_mzML_Ptr& indexPtr,
+                                  const boost::shared_ptr<boost::iostreams::mapped_file_source>& mapping,
+                                  bool float32Storage = false);
 };
 
 
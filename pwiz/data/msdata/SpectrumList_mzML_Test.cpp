@@ -23,10 +23,15 @@
 
 #include "SpectrumList_mzML.hpp"
 #include "Serializer_mzML.hpp" // depends on Serializer_mzML::write() only
+#include "Diff.hpp"
 #include "examples.hpp"
 #include "pwiz/utility/minimxml/XMLWriter.hpp"
 #include "pwiz/utility/misc/unit.hpp"
 #include "pwiz/utility/misc/Std.hpp"
+#include "pwiz/utility/misc/Filesystem.hpp"
+#include <boost/thread/thread.hpp>
+#include <boost/thread/barrier.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
 
 using namespace pwiz::cv;
 using namespace pwiz::msdata;
@@ -37,9 +42,53 @@ using namespace pwiz::minimxml;
 ostream* os_ = 0;
 
 
-void test(bool indexed)
+void testThreadSafetyWorker(boost::barrier* testBarrier, const SpectrumList* sl, const vector<SpectrumPtr>* expected, int* failures)
 {
-    if (os_) *os_ << "test(): indexed=\"" << boolalpha << indexed << "\"\n";
+    testBarrier->wait(); // wait until all threads have started
+
+    try
+    {
+        // read in reverse so that the threads are not all waiting on the same spectrum
+        for (size_t i = sl->size(); i > 0; --i)
+        {
+            bool getBinaryData = (i - 1) % 2 == 0;
+            SpectrumPtr s = sl->spectrum(i - 1, getBinaryData);
+            Diff<Spectrum, DiffConfig> diff(*s, *(*expected)[i - 1], DiffConfig());
+            if (diff || (getBinaryData && s->binaryDataArrayPtrs.empty()))
+                ++*failures;
+        }
+    }
+    catch (exception& e)
+    {
+        cerr << "Exception in worker thread: " << e.what() << endl;
+        ++*failures;
+    }
+}
+
+
+void testThreadSafety(const SpectrumList& sl, int testThreadCount)
+{
+    if (os_) *os_ << "testThreadSafety(): " << testThreadCount << " threads\n";
+
+    vector<SpectrumPtr> expected;
+    for (size_t i = 0; i < sl.size(); ++i)
+        expected.push_back(sl.spectrum(i, i % 2 == 0));
+
+    vector<int> failures(testThreadCount, 0);
+    boost::barrier testBarrier(testThreadCount);
+    boost::thread_group testThreadGroup;
+    for (int i = 0; i < testThreadCount; ++i)
+        testThreadGroup.add_thread(new boost::thread(&testThreadSafetyWorker, &testBarrier, &sl, &expected, &failures[i]));
+    testThreadGroup.join_all();
+
+    for (int i = 0; i < testThreadCount; ++i)
+        unit_assert_operator_equal(0, failures[i]);
+}
+
+
+void test(bool indexed, bool memoryMapped)
+{
+    if (os_) *os_ << "test(): indexed=\"" << boolalpha << indexed << "\" memoryMapped=\"" << memoryMapped << "\"\n";
 
     MSData tiny;
     examples::initializeTiny(tiny);
@@ -77,7 +126,16 @@ void test(bool indexed)
     dummy.dataProcessingPtrs.push_back(DataProcessingPtr(new DataProcessing("CompassXtract processing")));
 
     Index_mzML_Ptr index(new Index_mzML(is, dummy));
-    SpectrumListPtr sl = SpectrumList_mzML::create(is, dummy, index);
+    SpectrumListPtr sl;
+    string filename = "SpectrumList_mzML_Test.temp.mzML";
+    if (memoryMapped)
+    {
+        ofstream(filename.c_str(), ios::binary) << oss.str();
+        shared_ptr<boost::iostreams::mapped_file_source> mapping(new boost::iostreams::mapped_file_source(filename));
+        sl = SpectrumList_mzML::create(is, dummy, index, mapping);
+    }
+    else
+        sl = SpectrumList_mzML::create(is, dummy, index);
 
     // check easy functions
 
@@ -167,16 +225,35 @@ void test(bool indexed)
     unit_assert(sl->spectrumIdentity(4).index == 4);
     unit_assert(sl->spectrumIdentity(4).id == "sample=1 period=1 cycle=23 experiment=1");
     unit_assert(sl->spectrumIdentity(4).spotID == "A1,42x42,4242x4242");
+
+    // binary data only, reusing the metadata from a previous read
+    s = sl->spectrum(1, false);
+    unit_assert(s->binaryDataArrayPtrs.empty());
+    s = sl->spectrum(s, true);
+    unit_assert(s->id == "scan=20");
+    unit_assert(s->getMZArray().get() && s->getMZArray()->data.size() == 10);
+    unit_assert(s->sourceFilePosition == sl->spectrumIdentity(1).sourceFilePosition);
+
+    testThreadSafety(*sl, 2);
+    testThreadSafety(*sl, 8);
+
+    if (memoryMapped)
+    {
+        sl.reset(); // unmap
+        bfs::remove(filename);
+    }
 }
 
 
 void test()
 {
     bool indexed = true;
-    test(indexed);
+    test(indexed, false);
+    test(indexed, true);
 
     indexed = false;
-    test(indexed);
+    test(indexed, false);
+    test(indexed, true);
 }
 
 
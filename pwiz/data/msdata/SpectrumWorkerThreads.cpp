@@ -25,6 +25,7 @@
 #include "pwiz/data/msdata/SpectrumWorkerThreads.hpp"
 #include "pwiz/data/msdata/SpectrumListWrapper.hpp"
 #include "pwiz/utility/misc/mru_list.hpp"
+#include "pwiz/utility/misc/WorkerPool.hpp"
 #include <boost/thread.hpp>
 #include <deque>
 
@@ -36,69 +37,44 @@ using namespace pwiz::util;
 namespace pwiz {
 namespace msdata {
 
-class SpectrumWorkerThreads::Impl
+
+// each queued pool job of an instance has a task for one pool thread to run
+class SpectrumWorkerThreads::Impl : public WorkerPool::Job
 {
     public:
 
-    Impl(const SpectrumList& sl)
+    Impl(const SpectrumList& sl, const Config& config)
         : sl_(sl)
-        , numThreads_(boost::thread::hardware_concurrency())
-        , maxProcessedTaskCount_(numThreads_ * 4)
+        , numThreads_(config.threadCount > 0 ? config.threadCount : SpectrumWorkerThreads::defaultThreadCount())
+        , prefetchDepth_(config.prefetchDepth > 0 ? config.prefetchDepth : numThreads_)
+        , accessPattern_(config.accessPattern)
+        , stride_(config.stride)
+        , lastIndex_(0)
+        , maxProcessedTaskCount_((prefetchDepth_ + 1) * 4)
         , taskMRU_(maxProcessedTaskCount_)
+        , queuedJobCount_(0)
+        , runningJobCount_(0)
     {
-        InstrumentConfigurationPtr icPtr;
-        if (sl.size() > 0)
-        {
-            SpectrumPtr s0 = sl.spectrum(0, false);
-            if (s0->scanList.scans.size() > 0)
-                icPtr = s0->scanList.scans[0].instrumentConfigurationPtr;
-        }
-
-        bool isBruker = icPtr.get() && icPtr->hasCVParamChild(MS_Bruker_Daltonics_instrument_model);
-
-        bool isDemultiplexed = false;
-        const boost::shared_ptr<const DataProcessing> dp = sl.dataProcessingPtr();
-        if (dp)
-        {
-            BOOST_FOREACH(const ProcessingMethod& pm, dp->processingMethods)
-            {
-                if (!pm.hasCVParam(MS_data_processing)) continue;
-                BOOST_FOREACH(const UserParam& up, pm.userParams)
-                {
-                    if (up.name.find("Demultiplexing") != std::string::npos)
-                    {
-                        isDemultiplexed = true;
-                        break;
-                    }
-                }
-                if (isDemultiplexed) break;
-            }
-        }
-
-        useThreads_ = !(isBruker || isDemultiplexed); // Bruker library is not thread-friendly
+        useThreads_ = SpectrumWorkerThreads::isThreadSafe(sl);
 
         if (sl.size() > 0 && useThreads_)
         {
             // create one task per spectrum
             tasks_.resize(sl.size(), Task());
-
-            // create and start worker threads
-            for (size_t i = 0; i < numThreads_; ++i)
-            {
-                workers_.push_back(TaskWorker());
-                workers_.back().start(this);
-            }
         }
     }
 
     ~Impl()
     {
-        BOOST_FOREACH(TaskWorker& worker, workers_)
-            if (worker.thread)
-            {
-                worker.thread->interrupt();
-                worker.thread->join();
-            }
+        if (!useThreads_)
+            return;
+
+        // drop the tasks nobody has started, then wait for the pool to finish the running ones
+        boost::unique_lock<boost::mutex> taskLock(taskMutex_);
+        taskQueue_.clear();
+        queuedJobCount_ -= WorkerPool::instance().cancel(this);
+        while (queuedJobCount_ > 0 || runningJobCount_ > 0)
+            taskFinishedCondition_.wait(taskLock);
     }
 
     SpectrumPtr spectrum(size_t index, bool getBinaryData)
@@ -111,176 +87,196 @@ class SpectrumWorkerThreads::Impl
         // if the task is already finished and has binary data if getBinaryData is true, return it as-is
         Task& task = tasks_[index];
         if (task.result && (!getBinaryData || task.getBinaryData))
+        {
+            lastIndex_ = index;
             return task.result;
+        }
+
+        // a failed prefetch is retried now that the spectrum is actually requested
+        task.error.clear();
 
-        // otherwise, add this task and the numThreads following tasks to the queue (skipping the tasks that are already processed or being worked on)
-        for (size_t i = index; taskQueue_.size() < numThreads_ && i < tasks_.size(); ++i)
+        // the requested task goes to the front of the queue, then up to prefetchDepth tasks
+        // are queued behind it in the order the access pattern predicts
+        queueTask(index, getBinaryData, true);
+        size_t step = accessPattern_ == AccessPattern_Strided ? (stride_ > 0 ? stride_ : (index > lastIndex_ ? index - lastIndex_ : 1)) : 1;
+        for (size_t i = 1; i <= prefetchDepth_ && taskQueue_.size() <= prefetchDepth_; ++i)
         {
-            Task& task = tasks_[i];
-
-            // if the task result is already ready
-            if (task.result)
-            {
-                // if it has binary data and getBinaryData is true, the task need not be queued
-                if (task.getBinaryData || !getBinaryData)
-                    continue;
-
-                // otherwise the current result is cleared
-                task.result.reset();
-            }
-            // if the task is already being worked on and the existing task will get binary data or binary data isn't being requested, the task need not be requeued
-            else if (task.worker != NULL && (task.getBinaryData || !getBinaryData))
-                continue;
-
-            // if the task is already queued, set its getBinaryData variable to the logical OR of the current task and the current spectrum request
-            if (!task.isQueued)
-            {
-                taskQueue_.push_back(i);
-                task.isQueued = true;
-            }
-            task.getBinaryData |= getBinaryData;
+            size_t offset = i * step;
+            if (accessPattern_ == AccessPattern_Reverse ? offset > index : index + offset >= tasks_.size())
+                break;
+            queueTask(accessPattern_ == AccessPattern_Reverse ? index - offset : index + offset, getBinaryData, false);
         }
+        lastIndex_ = index;
+        scheduleJobs();
 
-        // wait for the result to be set
-        while (!task.result)
+        // wait for the result to be set; workers notify when any task of this instance finishes
+        while (!task.result && task.error.empty())
+            taskFinishedCondition_.wait(taskLock);
+
+        if (!task.result)
         {
-            // notify workers that tasks are available
-            taskQueuedCondition_.notify_all();
-            taskFinishedCondition_.wait_for(taskLock, boost::chrono::milliseconds(100));
+            string error;
+            swap(error, task.error);
+            throw runtime_error("[SpectrumWorkerThreads] error getting spectrum " + lexical_cast<string>(index) + ": " + error);
         }
-
         return task.result;
     }
 
     private:
 
-    struct TaskWorker
-    {
-        void start(Impl* instance)
-        {
-            if (!thread)
-                thread.reset(new boost::thread(boost::bind(&SpectrumWorkerThreads::Impl::work, instance, this)));
-        }
-
-        shared_ptr<boost::thread> thread;
-    };
-
     // each spectrum in the list is a task
     struct Task
     {
-        Task() : worker(NULL), getBinaryData(false), isQueued(false) {}
+        Task() : isRunning(false), getBinaryData(false), isQueued(false) {}
 
-        TaskWorker* worker; // the thread currently working on this task
+        bool isRunning; // true while a pool thread is working on this task
         SpectrumPtr result; // the spectrum produced by this task
+        string error; // the error message if getting the spectrum failed
         bool getBinaryData;
         bool isQueued; // true if the task is currently in the taskQueue
     };
 
-    friend struct TaskWorker;
+    // queues the task at index unless it is already done or being worked on with enough data (taskMutex_ must be held)
+    void queueTask(size_t index, bool getBinaryData, bool toFront)
+    {
+        Task& task = tasks_[index];
+
+        // if the task result is already ready
+        if (task.result)
+        {
+            // if it has binary data and getBinaryData is true, the task need not be queued
+            if (task.getBinaryData || !getBinaryData)
+                return;
+
+            // otherwise the current result is cleared
+            task.result.reset();
+        }
+        // if the task is already being worked on and the existing task will get binary data or binary data isn't being requested, the task need not be requeued
+        else if (task.isRunning && (task.getBinaryData || !getBinaryData))
+            return;
+
+        // if the task is already queued, set its getBinaryData variable to the logical OR of the current task and the current spectrum request
+        if (task.isQueued && toFront)
+            taskQueue_.erase(std::find(taskQueue_.begin(), taskQueue_.end(), index));
+
+        if (!task.isQueued || toFront)
+        {
+            if (toFront)
+                taskQueue_.push_front(index);
+            else
+                taskQueue_.push_back(index);
+            task.isQueued = true;
+        }
+        task.getBinaryData |= getBinaryData;
+    }
 
-    // function executed by worker threads
-    static void work(Impl* instance, TaskWorker* worker)
+    // submits a pool job for each queued task, keeping at most numThreads jobs in flight (taskMutex_ must be held)
+    void scheduleJobs()
     {
-        vector<Task>& tasks = instance->tasks_;
-        TaskQueue& taskQueue = instance->taskQueue_;
-        mru_list<size_t>& taskMRU = instance->taskMRU_;
+        while (queuedJobCount_ + runningJobCount_ < numThreads_ && queuedJobCount_ < taskQueue_.size())
+        {
+            ++queuedJobCount_;
+            WorkerPool::instance().submit(this);
+        }
+    }
 
-        // loop until the main thread kills the worker threads; the condition_variable::wait() call is an interruption point
-        try
+    // runs the task at the front of the queue on the calling pool thread
+    virtual void runJob()
+    {
+        boost::unique_lock<boost::mutex> taskLock(taskMutex_);
+        --queuedJobCount_;
+
+        // the task may have been taken by an earlier job, or the queue cleared by the destructor
+        if (taskQueue_.empty())
         {
-            boost::unique_lock<boost::mutex> taskLock(instance->taskMutex_, boost::defer_lock);
-
-            while (true)
-            {
-                taskLock.lock();
-
-                // wait for a new spectrum to be queued (while the task queue is either empty or the task at the end of the queue already has a worker assigned)
-                while (instance->taskQueue_.empty())
-                    instance->taskQueuedCondition_.wait(taskLock);
-
-                // get the next queued Task
-                TaskQueue::value_type queuedTask = taskQueue.front();
-                taskQueue.pop_front();
-
-                // set worker pointer on the Task
-                size_t taskIndex = queuedTask;
-                Task& task = tasks[taskIndex];
-                bool getBinaryData = task.getBinaryData;
-                task.worker = worker;
-                task.isQueued = false;
-                //cout << taskIndex << " " << task.worker << " " << getBinaryData << endl;
-                // unlock taskLock
-                taskLock.unlock();
-
-                // get the spectrum
-                SpectrumPtr result = instance->sl_.spectrum(taskIndex, getBinaryData);
-
-                // lock the taskLock
-                taskLock.lock();
-
-                // set the result on the Task, and set its worker to empty
-                // if not getting binary data, check if another thread already finished this task which did get binary data
-                if (getBinaryData || !task.getBinaryData)
-                {
-                    task.result = result;
-                    task.getBinaryData = getBinaryData;
-                }
-                task.worker = NULL;
-
-                // notify the main thread that a task has finished
-                instance->taskFinishedCondition_.notify_one();
-
-                // add the task to the MRU; if doing so will push an old task off the MRU, then reset the oldest (LRU) task;
-                // to know whether an old task was pushed off, keep a copy of the LRU item before adding the task
-                boost::optional<size_t> lruToReset;
-                if (taskMRU.size() == taskMRU.max_size())
-                {
-                    lruToReset = taskMRU.lru();
-                }
-
-                taskMRU.insert(taskIndex);
-
-                // if the MRU list's LRU is different now, it means the LRU was popped and needs to be reset; if the popped LRU is the current task, don't reset it
-                if (lruToReset.is_initialized() && lruToReset.get() != taskMRU.lru() && lruToReset.get() != taskIndex)
-                {
-                    tasks[lruToReset.get()].result.reset();
-                }
-
-                taskLock.unlock();
-            }
+            taskFinishedCondition_.notify_all();
+            return;
         }
-        catch (boost::thread_interrupted&)
+
+        // get the next queued Task
+        size_t taskIndex = taskQueue_.front();
+        taskQueue_.pop_front();
+
+        Task& task = tasks_[taskIndex];
+        bool getBinaryData = task.getBinaryData;
+        task.isRunning = true;
+        task.isQueued = false;
+        ++runningJobCount_;
+        taskLock.unlock();
+
+        // get the spectrum
+        SpectrumPtr result;
+        string error;
+        try
         {
-            // return
+            result = sl_.spectrum(taskIndex, getBinaryData);
         }
         catch (exception& e)
         {
-            // TODO: log this
-            cerr << "[SpectrumWorkerThreads::work] error in thread: " << e.what() << endl;
+            error = e.what();
         }
         catch (...)
         {
-            cerr << "[SpectrumWorkerThreads::work] unknown exception in worker thread" << endl;
+            error = "unknown exception";
+        }
+
+        taskLock.lock();
+        --runningJobCount_;
+        task.isRunning = false;
+
+        // set the result on the Task
+        // if not getting binary data, check if another thread already finished this task which did get binary data
+        if (!error.empty())
+            task.error = error;
+        else if (getBinaryData || !task.getBinaryData)
+        {
+            task.result = result;
+            task.getBinaryData = getBinaryData;
         }
+
+        // add the task to the MRU; if doing so will push an old task off the MRU, then reset the oldest (LRU) task;
+        // to know whether an old task was pushed off, keep a copy of the LRU item before adding the task
+        boost::optional<size_t> lruToReset;
+        if (taskMRU_.size() == taskMRU_.max_size())
+        {
+            lruToReset = taskMRU_.lru();
+        }
+
+        taskMRU_.insert(taskIndex);
+
+        // if the MRU list's LRU is different now, it means the LRU was popped and needs to be reset; if the popped LRU is the current task, don't reset it
+        if (lruToReset.is_initialized() && lruToReset.get() != taskMRU_.lru() && lruToReset.get() != taskIndex)
+        {
+            tasks_[lruToReset.get()].result.reset();
+        }
+
+        scheduleJobs();
+
+        // wake the thread waiting for a spectrum (or the destructor)
+        taskFinishedCondition_.notify_all();
     }
 
     const SpectrumList& sl_;
     bool useThreads_;
-    size_t numThreads_;
+    const size_t numThreads_;
+    const size_t prefetchDepth_;
+    const AccessPattern accessPattern_;
+    const size_t stride_;
+    size_t lastIndex_;
 
     const size_t maxProcessedTaskCount_;
     vector<Task> tasks_;
     typedef deque<size_t> TaskQueue;
     TaskQueue taskQueue_;
     mru_list<size_t> taskMRU_;
+    size_t queuedJobCount_; // jobs submitted to the pool but not started
+    size_t runningJobCount_;
     boost::mutex taskMutex_;
-    boost::condition_variable taskQueuedCondition_, taskFinishedCondition_;
-
-    vector<TaskWorker> workers_;
+    boost::condition_variable taskFinishedCondition_;
 };
 
 
-SpectrumWorkerThreads::SpectrumWorkerThreads(const SpectrumList& sl) : impl_(new Impl(sl)) {}
+SpectrumWorkerThreads::SpectrumWorkerThreads(const SpectrumList& sl, const Config& config) : impl_(new Impl(sl, config)) {}
 
 SpectrumWorkerThreads::~SpectrumWorkerThreads() {}
 
@@ -289,6 +285,29 @@ SpectrumPtr SpectrumWorkerThreads::processBatch(size_t index, bool getBinaryData
     return impl_->spectrum(index, getBinaryData);
 }
 
+bool SpectrumWorkerThreads::isThreadSafe(const SpectrumList& sl)
+{
+    InstrumentConfigurationPtr icPtr;
+    if (sl.size() > 0)
+    {
+        SpectrumPtr s0 = sl.spectrum(0, false);
+        if (s0->scanList.scans.size() > 0)
+            icPtr = s0->scanList.scans[0].instrumentConfigurationPtr;
+    }
+
+    bool isBruker = icPtr.get() && icPtr->hasCVParamChild(MS_Bruker_Daltonics_instrument_model);
+
+    return !isBruker; // Bruker library is not thread-friendly
+}
+
+size_t SpectrumWorkerThreads::defaultThreadCount() {return WorkerPool::defaultThreadCount();}
+
+void SpectrumWorkerThreads::setDefaultThreadCount(size_t threadCount) {WorkerPool::setDefaultThreadCount(threadCount);}
+
+size_t SpectrumWorkerThreads::poolThreadCount() {return WorkerPool::poolThreadCount();}
+
+void SpectrumWorkerThreads::setPoolThreadCount(size_t threadCount) {WorkerPool::setPoolThreadCount(threadCount);}
+
 
 } // namespace msdata
 } // namespace pwiz
@@ -35,10 +35,54 @@ class SpectrumWorkerThreads
 {
     public:
 
-    SpectrumWorkerThreads(const SpectrumList& sl);
+    /// the order in which spectra are expected to be requested, which decides what is prefetched
+    enum AccessPattern
+    {
+        AccessPattern_Sequential, ///< prefetch the spectra following the requested one
+        AccessPattern_Reverse,    ///< prefetch the spectra preceding the requested one
+        AccessPattern_Strided     ///< prefetch every stride-th spectrum, e.g. the next scans of one MS level or DIA window
+    };
+
+    struct Config
+    {
+        /// the most spectra retrieved at once for this instance; 0 means defaultThreadCount()
+        size_t threadCount;
+
+        /// how many spectra to queue behind the requested one; 0 means threadCount
+        size_t prefetchDepth;
+
+        AccessPattern accessPattern;
+
+        /// the step for AccessPattern_Strided; 0 means the distance between the last two requests
+        size_t stride;
+
+        Config() : threadCount(0), prefetchDepth(0), accessPattern(AccessPattern_Sequential), stride(0) {}
+    };
+
+    /// spectra are retrieved by the process-wide util::WorkerPool shared by all instances
+    SpectrumWorkerThreads(const SpectrumList& sl, const Config& config = Config());
     ~SpectrumWorkerThreads();
     SpectrumPtr processBatch(size_t index, bool getBinaryData = true);
 
+    /// returns the most spectra one instance retrieves at once (and the number of IO::write's spectrum encoders);
+    /// same as util::WorkerPool::defaultThreadCount(), which also sizes util::parallelFor
+    static size_t defaultThreadCount();
+
+    /// sets the process-wide per-instance limit, e.g. to divide the cores among several
+    /// concurrent conversions; 0 restores the default
+    static void setDefaultThreadCount(size_t threadCount);
+
+    /// returns the most threads in the process-wide util::WorkerPool;
+    /// defaults to boost::thread::hardware_concurrency()
+    static size_t poolThreadCount();
+
+    /// sets the size limit of the process-wide pool, i.e. the thread budget of the whole process;
+    /// 0 restores the default
+    static void setPoolThreadCount(size_t threadCount);
+
+    /// returns false if spectra of sl must not be retrieved concurrently (e.g. the vendor library is not thread-friendly)
+    static bool isThreadSafe(const SpectrumList& sl);
+
     private:
     class Impl;
     boost::scoped_ptr<Impl> impl_;
@@ -0,0 +1,237 @@
+//
+// $Id$
+//
+//
+// Original author: agent <agent@local>
+//
+// Copyright 2026
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "SpectrumWorkerThreads.hpp"
+#include "pwiz/utility/misc/unit.hpp"
+#include "pwiz/utility/misc/Std.hpp"
+#include <boost/thread.hpp>
+
+
+using namespace pwiz::cv;
+using namespace pwiz::msdata;
+using namespace pwiz::util;
+
+
+ostream* os_ = 0;
+
+
+// a list that counts retrievals and fails for one index
+class CountingSpectrumList : public SpectrumListSimple
+{
+    public:
+
+    CountingSpectrumList(size_t size, size_t badIndex) : badIndex_(badIndex), retrievalCount_(0)
+    {
+        for (size_t i=0; i < size; ++i)
+        {
+            SpectrumPtr spectrum(new Spectrum);
+            spectrum->index = i;
+            spectrum->id = "scan=" + lexical_cast<string>(i+1);
+            spectrum->setMZIntensityArrays(vector<double>(1, i), vector<double>(1, i), MS_number_of_detector_counts);
+            spectra.push_back(spectrum);
+        }
+    }
+
+    virtual SpectrumPtr spectrum(size_t index, bool getBinaryData = false) const
+    {
+        ++retrievalCount_;
+        if (index == badIndex_)
+            throw runtime_error("bad spectrum");
+        return SpectrumListSimple::spectrum(index, getBinaryData);
+    }
+
+    size_t retrievalCount() const {return retrievalCount_;}
+
+    private:
+    size_t badIndex_;
+    mutable boost::atomic<size_t> retrievalCount_;
+};
+
+
+void testAccessPattern(SpectrumWorkerThreads::AccessPattern accessPattern, size_t stride, size_t configStride)
+{
+    if (os_) *os_ << "testAccessPattern: " << accessPattern << " " << stride << " " << configStride << endl;
+
+    CountingSpectrumList sl(100, 1000);
+
+    SpectrumWorkerThreads::Config config;
+    config.threadCount = 3;
+    config.prefetchDepth = 5;
+    config.accessPattern = accessPattern;
+    config.stride = configStride;
+    SpectrumWorkerThreads workers(sl, config);
+
+    vector<size_t> indices;
+    for (size_t i=0; i < 100; i += stride)
+        indices.push_back(accessPattern == SpectrumWorkerThreads::AccessPattern_Reverse ? 99 - i : i);
+
+    BOOST_FOREACH(size_t i, indices)
+    {
+        SpectrumPtr s = workers.processBatch(i);
+        unit_assert_operator_equal(i, s->index);
+        unit_assert(s->hasBinaryData());
+        unit_assert_operator_equal(i, s->getMZArray()->data[0]);
+    }
+
+    // a matching access pattern prefetches (almost) only the spectra that are requested
+    unit_assert(sl.retrievalCount() <= indices.size() + config.prefetchDepth + 1); // +1 for isThreadSafe()
+}
+
+
+void testError()
+{
+    if (os_) *os_ << "testError" << endl;
+
+    CountingSpectrumList sl(20, 7);
+    SpectrumWorkerThreads workers(sl);
+
+    for (size_t i=0; i < 7; ++i)
+        unit_assert_operator_equal(i, workers.processBatch(i)->index);
+    unit_assert_throws(workers.processBatch(7), runtime_error);
+    unit_assert_operator_equal(8, workers.processBatch(8)->index);
+}
+
+
+void testSharedPool()
+{
+    if (os_) *os_ << "testSharedPool" << endl;
+
+    // several instances in flight at once share the pool without mixing up their spectra
+    CountingSpectrumList sl1(200, 1000), sl2(200, 1000);
+    SpectrumWorkerThreads workers1(sl1), workers2(sl2);
+
+    for (size_t i=0; i < 200; ++i)
+    {
+        unit_assert_operator_equal(sl1.spectra[i], workers1.processBatch(i));
+        unit_assert_operator_equal(sl2.spectra[199 - i], workers2.processBatch(199 - i));
+    }
+
+    // destroying an instance with prefetches still pending must not hang or crash
+    for (size_t i=0; i < 20; ++i)
+    {
+        SpectrumWorkerThreads workers(sl1);
+        workers.processBatch(i);
+    }
+}
+
+
+// a list that takes a while per spectrum and records how many are retrieved at once
+class SlowSpectrumList : public CountingSpectrumList
+{
+    public:
+
+    SlowSpectrumList(size_t size, boost::atomic<size_t>& processRunningCount, boost::atomic<size_t>& processMaxRunningCount)
+        : CountingSpectrumList(size, size), runningCount_(0), maxRunningCount_(0),
+          processRunningCount_(processRunningCount), processMaxRunningCount_(processMaxRunningCount)
+    {}
+
+    virtual SpectrumPtr spectrum(size_t index, bool getBinaryData = false) const
+    {
+        updateMax(maxRunningCount_, ++runningCount_);
+        updateMax(processMaxRunningCount_, ++processRunningCount_);
+        boost::this_thread::sleep_for(boost::chrono::milliseconds(10));
+        --processRunningCount_;
+        --runningCount_;
+        return CountingSpectrumList::spectrum(index, getBinaryData);
+    }
+
+    size_t maxRunningCount() const {return maxRunningCount_;}
+
+    private:
+
+    static void updateMax(boost::atomic<size_t>& maxCount, size_t count)
+    {
+        size_t oldMax = maxCount;
+        while (count > oldMax && !maxCount.compare_exchange_weak(oldMax, count)) {}
+    }
+
+    mutable boost::atomic<size_t> runningCount_, maxRunningCount_;
+    boost::atomic<size_t>& processRunningCount_;
+    boost::atomic<size_t>& processMaxRunningCount_;
+};
+
+
+void readAll(const SlowSpectrumList& sl)
+{
+    SpectrumWorkerThreads workers(sl);
+    for (size_t i=0; i < sl.size(); ++i)
+        unit_assert_operator_equal(sl.spectra[i], workers.processBatch(i));
+}
+
+
+void testThreadBudget()
+{
+    if (os_) *os_ << "testThreadBudget" << endl;
+
+    // like msconvert --threads 4 --jobs 2: each instance may retrieve 2 spectra at once,
+    // and the pool lets both instances do so at the same time
+    SpectrumWorkerThreads::setPoolThreadCount(4);
+    SpectrumWorkerThreads::setDefaultThreadCount(2);
+
+    boost::atomic<size_t> runningCount(0), maxRunningCount(0);
+    SlowSpectrumList sl1(40, runningCount, maxRunningCount), sl2(40, runningCount, maxRunningCount);
+    boost::thread job1(readAll, boost::cref(sl1)), job2(readAll, boost::cref(sl2));
+    job1.join();
+    job2.join();
+
+    unit_assert(sl1.maxRunningCount() <= 2);
+    unit_assert(sl2.maxRunningCount() <= 2);
+    unit_assert(maxRunningCount > 2);
+    unit_assert(maxRunningCount <= 4);
+
+    SpectrumWorkerThreads::setPoolThreadCount(0);
+    SpectrumWorkerThreads::setDefaultThreadCount(0);
+}
+
+
+void test()
+{
+    testAccessPattern(SpectrumWorkerThreads::AccessPattern_Sequential, 1, 0);
+    testAccessPattern(SpectrumWorkerThreads::AccessPattern_Reverse, 1, 0);
+    testAccessPattern(SpectrumWorkerThreads::AccessPattern_Strided, 4, 4);
+    testAccessPattern(SpectrumWorkerThreads::AccessPattern_Strided, 3, 0); // stride learned from the requests
+    testError();
+    testSharedPool();
+    testThreadBudget();
+}
+
+
+int main(int argc, char* argv[])
+{
+    TEST_PROLOG(argc, argv)
+
+    try
+    {
+        if (argc>1 && !strcmp(argv[1],"-v")) os_ = &cout;
+        test();
+    }
+    catch (exception& e)
+    {
+        TEST_FAILED(e.what())
+    }
+    catch (...)
+    {
+        TEST_FAILED("Caught unknown exception.")
+    }
+
+    TEST_EPILOG
+}
@@ -419,18 +419,18 @@ class PWIZ_API_DECL TextWriter
         if (!p.get() || p->empty()) return *this;
         
         std::stringstream oss;
-        oss << "[" << boost::lexical_cast<std::string>(p->data.size()) << "] ";
+        oss << "[" << boost::lexical_cast<std::string>(p->size()) << "] ";
         oss.precision(12);
-        for (size_t i=0; i < arrayExampleCount_ && i < p->data.size(); i++)
-            oss << p->data[i] << " ";
-        if (p->data.size() > arrayExampleCount_)
+        for (size_t i=0; i < arrayExampleCount_ && i < p->size(); i++)
+            oss << p->value(i) << " ";
+        if (p->size() > arrayExampleCount_)
             oss << "...";
 
         (*this)("binaryDataArray:");
         child() (static_cast<const ParamContainer&>(*p));
         if (p->dataProcessingPtr.get() && !p->dataProcessingPtr->empty())
             child()(p->dataProcessingPtr);
-        if (!p->data.empty())
+        if (p->size() > 0)
             child()("binary: " + oss.str());
         return *this;
     }
@@ -37,7 +37,8 @@ unsigned short Configuration_mz5::MZ5_FILE_MINOR_VERSION = 9;
 
 bool Configuration_mz5::PRINT_HDF5_EXCEPTIONS = false;
 
-Configuration_mz5::Configuration_mz5()
+Configuration_mz5::Configuration_mz5() :
+    binaryDataAccessPolicy_(BDAP_Balanced)
 {
     config_.binaryDataEncoderConfig.precision
             = pwiz::msdata::BinaryDataEncoder::Precision_64;
@@ -46,14 +47,16 @@ Configuration_mz5::Configuration_mz5()
     init(true, true);
 }
 
-Configuration_mz5::Configuration_mz5(const Configuration_mz5& config)
+Configuration_mz5::Configuration_mz5(const Configuration_mz5& config) :
+    binaryDataAccessPolicy_(config.binaryDataAccessPolicy_)
 {
     config_ = config.config_;
     init(config.doTranslating(), config.doTranslating());
 }
 
 Configuration_mz5::Configuration_mz5(
-        const pwiz::msdata::MSDataFile::WriteConfig& config)
+        const pwiz::msdata::MSDataFile::WriteConfig& config) :
+    binaryDataAccessPolicy_(toBinaryDataAccessPolicy(config.binaryDataAccessPolicy))
 {
     config_ = config;
     init(true, true);
@@ -64,6 +67,7 @@ Configuration_mz5& Configuration_mz5::operator=(const Configuration_mz5& rhs)
     if (this != &rhs)
     {
         this->config_ = rhs.config_;
+        this->binaryDataAccessPolicy_ = rhs.binaryDataAccessPolicy_;
         init(rhs.doTranslating(), rhs.doTranslating());
     }
     return *this;
@@ -259,6 +263,14 @@ void Configuration_mz5::init(const bool deltamz,
             RefMZ5::getType()));
 
     hsize_t spectrumChunkSize = 5000L; // 1000=faster random read, 10000=better compression
+    if (binaryDataAccessPolicy_ == BDAP_RandomAccess)
+    {
+        spectrumChunkSize = 1000L;
+    }
+    else if (binaryDataAccessPolicy_ == BDAP_Sequential)
+    {
+        spectrumChunkSize = 10000L;
+    }
     hsize_t chromatogramChunkSize = 1000L;
     hsize_t spectrumMetaChunkSize = 2000L; // should be modified in case of on demand access
     // hsize_t chromatogramMetaChunkSize = 10L; // usually one experiment does not contain a lot of chromatograms, so this chunk size is small in order to save storage space
@@ -399,6 +411,34 @@ const Configuration_mz5::ChromatogramLoadPolicy& Configuration_mz5::getChromatog
     return chromatogramLoadPolicy_;
 }
 
+const Configuration_mz5::BinaryDataAccessPolicy& Configuration_mz5::getBinaryDataAccessPolicy() const
+{
+    return binaryDataAccessPolicy_;
+}
+
+void Configuration_mz5::setBinaryDataAccessPolicy(
+        const BinaryDataAccessPolicy policy)
+{
+    binaryDataAccessPolicy_ = policy;
+    variableChunkSizes_.clear();
+    variableBufferSizes_.clear();
+    init(doTranslating_, doTranslating_);
+}
+
+Configuration_mz5::BinaryDataAccessPolicy Configuration_mz5::toBinaryDataAccessPolicy(
+        const pwiz::msdata::BinaryDataAccessPolicy policy)
+{
+    switch (policy)
+    {
+        case pwiz::msdata::BinaryDataAccessPolicy_RandomAccess:
+            return BDAP_RandomAccess;
+        case pwiz::msdata::BinaryDataAccessPolicy_Sequential:
+            return BDAP_Sequential;
+        default:
+            return BDAP_Balanced;
+    }
+}
+
 const bool Configuration_mz5::doTranslating() const
 {
     return doTranslating_;
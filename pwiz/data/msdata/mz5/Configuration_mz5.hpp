@@ -76,6 +76,27 @@ public:
     //CLP_CachedOnDemand not implemented yet
     };
 
+    /**
+     * Enumeration for the expected access pattern of the binary data of spectra.
+     * When writing, it determines the chunk size of the spectrum datasets; when reading, how many chunks are read at once.
+     */
+    enum BinaryDataAccessPolicy
+    {
+        /**
+         * Trade-off between random read time and compression, with chunks of 5000 values. Only the requested values are read.
+         */
+        BDAP_Balanced,
+        /**
+         * Spectra are mostly read in random order. Chunks of 1000 values are faster to read on their own,
+         * and decompressed chunks are kept so nearby spectra are not decompressed again.
+         */
+        BDAP_RandomAccess,
+        /**
+         * Spectra are mostly read in order. Chunks of 10000 values compress better, and reads continue into the following chunks.
+         */
+        BDAP_Sequential
+    };
+
     /**
      * Enumeration to simplify the use of datasets. These values are used to determine dataset specific parameters, such as chunk size, buffer size, name and type.
      */
@@ -200,7 +221,7 @@ public:
 
     /**
      * Conversion constructor for WriteConfig objects.
-     * Uses values in config to set up specific options such as compression or precision.
+     * Uses values in config to set up specific options such as compression, precision or the binary data access policy.
      * @param config a pwiz config object
      */
     Configuration_mz5(const pwiz::msdata::MSDataFile::WriteConfig& config);
@@ -282,6 +303,25 @@ public:
      */
     const ChromatogramLoadPolicy& getChromatogramLoadPolicy() const;
 
+    /**
+     * Getter for the binary data access policy.
+     * @return binary data access policy
+     */
+    const BinaryDataAccessPolicy& getBinaryDataAccessPolicy() const;
+
+    /**
+     * Setter for the binary data access policy. This changes the chunk and buffer sizes of the spectrum datasets.
+     * @param policy binary data access policy
+     */
+    void setBinaryDataAccessPolicy(const BinaryDataAccessPolicy policy);
+
+    /**
+     * Converts the format independent access policy of Reader::Config and WriteConfig to the mz5 one.
+     * @param policy pwiz binary data access policy
+     * @return mz5 binary data access policy
+     */
+    static BinaryDataAccessPolicy toBinaryDataAccessPolicy(const pwiz::msdata::BinaryDataAccessPolicy policy);
+
     /**
      * Getter for translation flag.
      * If this flag is set, mz values of mass spectra are saved as delta mz's. This greatly improves compression rate and significantly reduces file size.
@@ -363,6 +403,10 @@ private:
      * Chromaogram load policy
      */
     ChromatogramLoadPolicy chromatogramLoadPolicy_;
+    /**
+     * Binary data access policy
+     */
+    BinaryDataAccessPolicy binaryDataAccessPolicy_;
     /**
      * flag for translation.
      */
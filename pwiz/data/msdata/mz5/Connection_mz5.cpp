@@ -26,7 +26,9 @@
 #include "ReferenceRead_mz5.hpp"
 #include "Translator_mz5.hpp"
 #include <algorithm>
+#include <list>
 #include "boost/thread/mutex.hpp"
+#include "boost/make_shared.hpp"
 
 namespace pwiz {
 namespace msdata {
@@ -36,6 +38,75 @@ using namespace H5;
 
 namespace {boost::mutex connectionReadMutex_, connectionWriteMutex_;}
 
+/**
+ * Decompressed chunks of a chunked dataset, most recently used first.
+ */
+class Connection_mz5::ChunkCache
+{
+public:
+    struct Chunk
+    {
+        explicit Chunk(const hsize_t index) : index(index) {}
+        const hsize_t index;
+        std::vector<double> data; // empty until the chunk is read
+    };
+    typedef boost::shared_ptr<Chunk> ChunkPtr;
+
+    ChunkCache(const hsize_t chunkSize, const hsize_t datasetSize,
+            const size_t capacity) :
+        chunkSize(chunkSize), datasetSize(datasetSize), capacity_(capacity)
+    {
+    }
+
+    /**
+     * Returns the chunk with the given index. If it is not cached, an empty chunk takes its place,
+     * evicting the least recently used chunk if the cache is full.
+     */
+    ChunkPtr get(const hsize_t index)
+    {
+        std::map<hsize_t, std::list<ChunkPtr>::iterator>::iterator it = index_.find(index);
+        if (it != index_.end())
+        {
+            chunks_.splice(chunks_.begin(), chunks_, it->second);
+            return chunks_.front();
+        }
+        if (chunks_.size() == capacity_)
+        {
+            index_.erase(chunks_.back()->index);
+            chunks_.pop_back();
+        }
+        chunks_.push_front(boost::make_shared<Chunk>(index));
+        index_[index] = chunks_.begin();
+        return chunks_.front();
+    }
+
+    size_t capacity() const
+    {
+        return capacity_;
+    }
+
+    /**
+     * Number of values in a chunk.
+     */
+    const hsize_t chunkSize;
+    /**
+     * Number of values in the dataset.
+     */
+    const hsize_t datasetSize;
+
+private:
+    size_t capacity_;
+    std::list<ChunkPtr> chunks_; // most recently used first
+    std::map<hsize_t, std::list<ChunkPtr>::iterator> index_;
+};
+
+namespace {
+/**
+ * Maximum number of chunks read after the requested ones with BDAP_Sequential.
+ */
+const size_t MAX_READ_AHEAD_CHUNKS = 8;
+}
+
 Connection_mz5::Connection_mz5(const std::string filename, const OpenPolicy op,
         const Configuration_mz5 config) :
     config_(config)
@@ -351,18 +422,53 @@ void Connection_mz5::getData(std::vector<double>& data,
             it = bufferMap_.find(v);
         }
         DataSet dataset = it->second;
-        DataSpace dataspace = dataset.getSpace();
-        hsize_t offset[1];
-        offset[0] = start;
-        hsize_t count[1];
-        count[0] = scount;
-        dataspace.selectHyperslab(H5S_SELECT_SET, count, offset);
 
-        hsize_t dimsm[1];
-        dimsm[0] = scount;
-        DataSpace memspace(1, dimsm);
+        std::map<Configuration_mz5::MZ5DataSets, boost::shared_ptr<ChunkCache> >::iterator cacheIt =
+                chunkCaches_.find(v);
+        if (cacheIt == chunkCaches_.end())
+        {
+            // chunked datasets are compressed, so their chunks are kept once they are decompressed;
+            // with BDAP_Balanced, only the requested values are read, as HDF5's own chunk cache is
+            // enough when the access pattern is unknown
+            boost::shared_ptr<ChunkCache> cache;
+            DSetCreatPropList cparms = dataset.getCreatePlist();
+            if (cparms.getLayout() == H5D_CHUNKED
+                    && config_.getBinaryDataAccessPolicy() != Configuration_mz5::BDAP_Balanced)
+            {
+                hsize_t chunkDims[1], dims[1];
+                cparms.getChunk(1, chunkDims);
+                DataSpace dataspace = dataset.getSpace();
+                dataspace.getSimpleExtentDims(dims);
+                dataspace.close();
+                size_t capacity = std::max(static_cast<size_t> (1),
+                        static_cast<size_t> (config_.getBufferInB() / (chunkDims[0] * sizeof(double))));
+                cache.reset(new ChunkCache(chunkDims[0], dims[0], capacity));
+            }
+            cparms.close();
+            cacheIt = chunkCaches_.insert(std::make_pair(v, cache)).first;
+        }
 
-        dataset.read(&data[0], PredType::NATIVE_DOUBLE, memspace, dataspace);
+        if (cacheIt->second)
+        {
+            getChunkedData(data, v, dataset, start, end);
+        }
+        else
+        {
+            DataSpace dataspace = dataset.getSpace();
+            hsize_t offset[1];
+            offset[0] = start;
+            hsize_t count[1];
+            count[0] = scount;
+            dataspace.selectHyperslab(H5S_SELECT_SET, count, offset);
+
+            hsize_t dimsm[1];
+            dimsm[0] = scount;
+            DataSpace memspace(1, dimsm);
+
+            dataset.read(&data[0], PredType::NATIVE_DOUBLE, memspace, dataspace);
+            memspace.close();
+            dataspace.close();
+        }
         if (v == Configuration_mz5::SpectrumMZ && config_.doTranslating())
         {
             Translator_mz5::reverseTranslateMZ(data);
@@ -372,8 +478,96 @@ void Connection_mz5::getData(std::vector<double>& data,
         {
             Translator_mz5::reverseTranslateIntensity(data);
         }
+    }
+}
+
+void Connection_mz5::getChunkedData(std::vector<double>& data,
+        const Configuration_mz5::MZ5DataSets v, const DataSet& dataset,
+        const hsize_t start, const hsize_t end)
+{
+    ChunkCache& cache = *chunkCaches_.find(v)->second;
+    hsize_t chunkSize = cache.chunkSize;
+    hsize_t firstChunk = start / chunkSize;
+    hsize_t lastChunk = (end - 1) / chunkSize;
+    hsize_t numberOfChunks = (cache.datasetSize + chunkSize - 1) / chunkSize;
+
+    // holding the chunks keeps them valid even if the cache evicts them
+    std::vector<ChunkCache::ChunkPtr> chunks;
+    for (hsize_t i = firstChunk; i <= lastChunk; ++i)
+    {
+        chunks.push_back(cache.get(i));
+    }
+
+    size_t readAhead = 0;
+    if (config_.getBinaryDataAccessPolicy() == Configuration_mz5::BDAP_Sequential)
+    {
+        readAhead = std::min(MAX_READ_AHEAD_CHUNKS, cache.capacity() / 2);
+    }
+
+    // read each run of chunks that are not cached with one hyperslab read
+    std::vector<double> buffer;
+    for (size_t i = 0; i < chunks.size();)
+    {
+        if (!chunks[i]->data.empty())
+        {
+            ++i;
+            continue;
+        }
+        size_t runEnd = i + 1;
+        while (runEnd < chunks.size() && chunks[runEnd]->data.empty())
+        {
+            ++runEnd;
+        }
+        if (runEnd == chunks.size())
+        {
+            // continue into the following chunks, which are likely to be read next
+            for (size_t j = 0; j < readAhead && chunks.back()->index + 1 < numberOfChunks; ++j)
+            {
+                ChunkCache::ChunkPtr next = cache.get(chunks.back()->index + 1);
+                if (!next->data.empty())
+                {
+                    break;
+                }
+                chunks.push_back(next);
+            }
+            runEnd = chunks.size();
+        }
+
+        hsize_t offset[1], count[1];
+        offset[0] = chunks[i]->index * chunkSize;
+        count[0] = std::min((chunks[runEnd - 1]->index + 1) * chunkSize,
+                cache.datasetSize) - offset[0];
+        DataSpace dataspace = dataset.getSpace();
+        dataspace.selectHyperslab(H5S_SELECT_SET, count, offset);
+        DataSpace memspace(1, count);
+        // a single chunk is read in place
+        std::vector<double>& runData = runEnd - i == 1 ? chunks[i]->data : buffer;
+        runData.resize(count[0]);
+        dataset.read(&runData[0], PredType::NATIVE_DOUBLE, memspace, dataspace);
         memspace.close();
         dataspace.close();
+
+        for (size_t j = i; j < runEnd && runEnd - i > 1; ++j)
+        {
+            std::vector<double>::const_iterator chunkBegin = buffer.begin()
+                    + (j - i) * chunkSize;
+            std::vector<double>::const_iterator chunkEnd = buffer.begin()
+                    + std::min(static_cast<hsize_t> ((j - i + 1) * chunkSize), count[0]);
+            chunks[j]->data.assign(chunkBegin, chunkEnd);
+        }
+        i = runEnd;
+    }
+
+    // copy the requested range out of its chunks
+    data.resize(end - start);
+    for (hsize_t i = firstChunk; i <= lastChunk; ++i)
+    {
+        const std::vector<double>& chunkData = chunks[i - firstChunk]->data;
+        hsize_t chunkStart = i * chunkSize;
+        hsize_t from = std::max(start, chunkStart);
+        hsize_t to = std::min(end, chunkStart + chunkData.size());
+        std::copy(chunkData.begin() + (from - chunkStart), chunkData.begin()
+                + (to - chunkStart), data.begin() + (from - start));
     }
 }
 
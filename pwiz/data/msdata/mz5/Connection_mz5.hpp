@@ -190,6 +190,19 @@ private:
     void addToBuffer(std::vector<double>& b, const std::vector<double>& d1,
             const size_t bs, const H5::DataSet& dataset);
 
+    /**
+     * Reads a range of a chunked dataset through its chunk cache.
+     * Only whole chunks are read from the file, and adjacent chunks that are not cached are read with one hyperslab read.
+     * @param data data vector, resized to end-start
+     * @param v dataset enumeration value
+     * @param dataset the opened dataset
+     * @param start start index
+     * @param end end index
+     */
+    void getChunkedData(std::vector<double>& data,
+            const Configuration_mz5::MZ5DataSets v, const H5::DataSet& dataset,
+            const hsize_t start, const hsize_t end);
+
     /**
      * Flushes all data to the hard drive.
      * @param v dataset enumeration value
@@ -221,6 +234,14 @@ private:
      * Mapping from a dataset enumeration value to a buffer.
      */
     std::map<Configuration_mz5::MZ5DataSets, std::vector<double> > buffers_;
+    /**
+     * Decompressed chunks of a chunked dataset.
+     */
+    class ChunkCache;
+    /**
+     * Mapping from a dataset enumeration value to its chunk cache, which is null for datasets that are not chunked.
+     */
+    std::map<Configuration_mz5::MZ5DataSets, boost::shared_ptr<ChunkCache> > chunkCaches_;
     /**
      * Flag whether file is closed or not.
      */
@@ -457,7 +457,7 @@ void CVParamMZ5::init(const char* value, const unsigned long& cvrefid,
 
 void CVParamMZ5::fill(pwiz::data::CVParam& c, const ReferenceRead_mz5& rref)
 {
-    c.value = this->value;
+    c.setValue(this->value);
     c.cvid = rref.getCVID(this->typeCVRefID);
     c.units = rref.getCVID(this->unitCVRefID);
 }
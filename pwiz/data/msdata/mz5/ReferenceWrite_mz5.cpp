@@ -362,7 +362,7 @@ pwiz::util::IterationListener::Status ReferenceWrite_mz5::readAndWriteSpectra(
 
         pwiz::msdata::SpectrumPtr sp;
         pwiz::msdata::BinaryDataArrayPtr bdap;
-        std::vector<double> mz;
+        std::vector<double> mz, intensity;
         SpectrumWorkerThreads spectrumWorkers(*sl);
         for (size_t i = 0; i < sl->size(); i++)
         {
@@ -382,7 +382,7 @@ pwiz::util::IterationListener::Status ReferenceWrite_mz5::readAndWriteSpectra(
                 spl.push_back(SpectrumMZ5(*sp.get(), *this));
                 if (sp->getMZArray().get() && sp->getIntensityArray().get())
                 {
-                    mz = sp->getMZArray().get()->data;
+                    sp->getMZArray()->getValues(mz);
                     bdl.push_back(BinaryDataMZ5(*sp->getMZArray().get(),
                         *sp->getIntensityArray().get(), *this));
                     if (mz.size() > 0)
@@ -393,7 +393,8 @@ pwiz::util::IterationListener::Status ReferenceWrite_mz5::readAndWriteSpectra(
                         }
                         accIndex += (unsigned long)mz.size();
                         connection.extendData(mz, Configuration_mz5::SpectrumMZ);
-                        connection.extendData(sp->getIntensityArray().get()->data,
+                        sp->getIntensityArray()->getValues(intensity);
+                        connection.extendData(intensity,
                                 Configuration_mz5::SpectrumIntensity);
                     }
                 } else {
@@ -446,8 +447,8 @@ pwiz::util::IterationListener::Status ReferenceWrite_mz5::readAndWriteChromatogr
                     cpl.push_back(ChromatogramMZ5(*cp.get(), *this));
                     if (cp->getTimeArray().get() && cp->getIntensityArray().get())
                     {
-                        time = cp->getTimeArray().get()->data;
-                        inten = cp->getIntensityArray().get()->data;
+                        cp->getTimeArray()->getValues(time);
+                        cp->getIntensityArray()->getValues(inten);
                         bdl.push_back(BinaryDataMZ5(*cp->getTimeArray().get(),
                             *cp->getIntensityArray().get(), *this));
                         if (inten.size() > 0)
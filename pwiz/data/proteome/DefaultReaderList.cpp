@@ -36,10 +36,11 @@ namespace proteome {
 
 
 /// default Reader list
-PWIZ_API_DECL DefaultReaderList::DefaultReaderList(bool indexed /*= false*/)
+PWIZ_API_DECL DefaultReaderList::DefaultReaderList(bool indexed /*= false*/, bool memoryMap /*= false*/)
 {
     Reader_FASTA::Config fastaConfig;
     fastaConfig.indexed = indexed;
+    fastaConfig.memoryMap = memoryMap;
     push_back(ReaderPtr(new Reader_FASTA(fastaConfig)));
 }
 
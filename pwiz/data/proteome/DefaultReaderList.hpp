@@ -37,7 +37,7 @@ namespace proteome {
 class PWIZ_API_DECL DefaultReaderList : public ReaderList
 {
     public:
-    DefaultReaderList(bool indexed = false);
+    DefaultReaderList(bool indexed = false, bool memoryMap = false);
 };
 
 
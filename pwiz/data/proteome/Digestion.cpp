@@ -31,7 +31,10 @@
 #include "pwiz/utility/misc/Exception.hpp"
 #include "pwiz/utility/misc/Std.hpp"
 #include "pwiz/utility/misc/Singleton.hpp"
+#include "pwiz/utility/misc/WorkerPool.hpp"
 #include <boost/xpressive/xpressive_dynamic.hpp>
+#include <boost/thread.hpp>
+#include <bitset>
 
 
 namespace pwiz {
@@ -170,6 +173,46 @@ PWIZ_API_DECL bool DigestedPeptide::operator==(const DigestedPeptide& rhs) const
 }
 
 
+PWIZ_API_DECL DigestedPeptideView::DigestedPeptideView()
+:   polypeptideSequence(0), offset(0), length(0), missedCleavages(0),
+    NTerminusIsSpecific(false), CTerminusIsSpecific(false)
+{
+}
+
+PWIZ_API_DECL const char* DigestedPeptideView::begin() const
+{
+    return polypeptideSequence->data() + offset;
+}
+
+PWIZ_API_DECL const char* DigestedPeptideView::end() const
+{
+    return polypeptideSequence->data() + offset + length;
+}
+
+PWIZ_API_DECL string DigestedPeptideView::sequence() const
+{
+    return polypeptideSequence->substr(offset, length);
+}
+
+PWIZ_API_DECL size_t DigestedPeptideView::specificTermini() const
+{
+    return (size_t) NTerminusIsSpecific + (size_t) CTerminusIsSpecific;
+}
+
+PWIZ_API_DECL DigestedPeptide DigestedPeptideView::peptide() const
+{
+    const string& polypeptide = *polypeptideSequence;
+    return DigestedPeptide(polypeptide.begin() + offset,
+                           polypeptide.begin() + (offset + length),
+                           offset,
+                           missedCleavages,
+                           NTerminusIsSpecific,
+                           CTerminusIsSpecific,
+                           offset > 0 ? polypeptide.substr(offset-1, 1) : "",
+                           offset + length < polypeptide.length() ? polypeptide.substr(offset + length, 1) : "");
+}
+
+
 
 
 PWIZ_API_DECL
@@ -347,6 +390,248 @@ string Digestion::disambiguateCleavageAgentRegex(const string& cleavageAgentRege
 }
 
 
+namespace {
+
+// A cleavage agent regex compiled to residue lookup tables. The regexes of the PSI-MS cleavage agents
+// (and most user regexes) are alternatives of a lookbehind and/or a lookahead over a fixed number
+// of residues, e.g. "(?<=[KR])(?!P)", "(?<=[HKR]P)(?!P)" or "((?<=D))|((?=D))"; the sequence is cut
+// between two residues if the residues before and after the cut match any alternative. Regexes
+// using any other syntax (e.g. anchors or nested groups) are matched with xpressive instead.
+class CleavageRule
+{
+    public:
+
+    CleavageRule(const string& regex)
+    {
+        if (!parseAlternatives(regex))
+        {
+            alternatives_.clear();
+            regex_ = bxp::sregex::compile(regex);
+        }
+    }
+
+    // appends the sorted, unique digestion sites of the sequence, including the N terminus (-1)
+    // and C terminus (length-1) sites; the site i is between residues i and i+1
+    void findSites(const string& sequence, vector<int>& sites) const
+    {
+        sites.push_back(-1);
+
+        if (alternatives_.empty())
+        {
+            for (bxp::sregex_iterator itr(sequence.begin(), sequence.end(), regex_), end; itr != end; ++itr)
+            {
+                // alternatives of a regex can match at the same position more than once
+                int site = int((*itr)[0].first - sequence.begin()) - 1;
+                if (site > sites.back())
+                    sites.push_back(site);
+            }
+        }
+        else
+        {
+            for (int i=1, length=(int) sequence.length(); i < length; ++i)
+                BOOST_FOREACH(const Alternative& alternative, alternatives_)
+                    if (alternative.lookbehind.matches(sequence, i - (int) alternative.lookbehind.residues.size()) &&
+                        alternative.lookahead.matches(sequence, i))
+                    {
+                        sites.push_back(i-1);
+                        break;
+                    }
+        }
+
+        if (sites.back() < (int) sequence.length()-1)
+            sites.push_back((int) sequence.length()-1);
+    }
+
+    private:
+
+    // a lookbehind or lookahead: a residue set for each residue it looks at
+    struct Look
+    {
+        bool negative;
+        vector< std::bitset<256> > residues;
+
+        Look() : negative(false) {}
+
+        // returns true if the look matches the residues starting at the given offset,
+        // or if there is no look; a negative look matches past the ends of the sequence
+        bool matches(const string& sequence, int offset) const
+        {
+            if (residues.empty())
+                return true;
+
+            bool matched = offset >= 0 && offset + residues.size() <= sequence.length();
+            for (size_t i=0; matched && i < residues.size(); ++i)
+                matched = residues[i][(unsigned char) sequence[offset+i]];
+            return matched != negative;
+        }
+    };
+
+    struct Alternative
+    {
+        Look lookbehind;
+        Look lookahead;
+    };
+
+    vector<Alternative> alternatives_;
+    bxp::sregex regex_;
+
+    static bool isResidue(char c) {return c >= 'A' && c <= 'Z';}
+
+    // parses a sequence of residues and residue sets like "K", "[KR]", "[^P]" or "[A-Z]"
+    static bool parseResidues(const string& text, vector< std::bitset<256> >& residues)
+    {
+        for (size_t i=0; i < text.length(); ++i)
+        {
+            std::bitset<256> residueSet;
+            if (text[i] == '[')
+            {
+                size_t end = text.find(']', i);
+                if (end == string::npos)
+                    return false;
+
+                bool negated = text[i+1] == '^';
+                for (size_t j = i + (negated ? 2 : 1); j < end; ++j)
+                {
+                    if (!isResidue(text[j]))
+                        return false;
+
+                    if (j+2 < end && text[j+1] == '-')
+                    {
+                        if (!isResidue(text[j+2]) || text[j+2] < text[j])
+                            return false;
+                        for (char c = text[j]; c <= text[j+2]; ++c)
+                            residueSet.set((unsigned char) c);
+                        j += 2;
+                    }
+                    else
+                        residueSet.set((unsigned char) text[j]);
+                }
+
+                if (residueSet.none())
+                    return false;
+                if (negated)
+                    residueSet.flip();
+                i = end;
+            }
+            else if (isResidue(text[i]))
+                residueSet.set((unsigned char) text[i]);
+            else
+                return false;
+
+            residues.push_back(residueSet);
+        }
+        return !residues.empty();
+    }
+
+    // parses an optional lookbehind followed by an optional lookahead, e.g. "(?<=[KR])(?!P)"
+    static bool parseAlternative(const string& text, Alternative& alternative)
+    {
+        bool hasLookbehind = false, hasLookahead = false;
+        for (size_t i=0; i < text.length();)
+        {
+            if (text.compare(i, 2, "(?") != 0)
+                return false;
+
+            bool isLookbehind = text.compare(i, 3, "(?<") == 0;
+            if (hasLookahead || (isLookbehind && hasLookbehind))
+                return false;
+
+            size_t begin = i + (isLookbehind ? 3 : 2);
+            size_t end = text.find(')', begin);
+            if (end == string::npos || (text[begin] != '=' && text[begin] != '!'))
+                return false;
+
+            Look& look = isLookbehind ? alternative.lookbehind : alternative.lookahead;
+            look.negative = text[begin] == '!';
+            if (!parseResidues(text.substr(begin+1, end-begin-1), look.residues))
+                return false;
+
+            (isLookbehind ? hasLookbehind : hasLookahead) = true;
+            i = end+1;
+        }
+        return hasLookbehind || hasLookahead;
+    }
+
+    // returns the offset of the parenthesis closing the one at the given offset, or npos
+    static size_t closingParenthesis(const string& text, size_t offset)
+    {
+        for (int depth = 0; offset < text.length(); ++offset)
+            if (text[offset] == '(')
+                ++depth;
+            else if (text[offset] == ')' && --depth == 0)
+                return offset;
+        return string::npos;
+    }
+
+    // parses alternatives separated by '|', each of which may be in (non-look) parentheses,
+    // e.g. "((?<=D))|((?=D))" as merged by Digestion for several cleavage agents
+    bool parseAlternatives(string text)
+    {
+        while (text.length() > 2 && text[0] == '(' && text[1] != '?' &&
+               closingParenthesis(text, 0) == text.length()-1)
+            text = text.substr(1, text.length()-2);
+
+        int depth = 0;
+        size_t begin = 0;
+        vector<string> parts;
+        for (size_t i=0; i < text.length(); ++i)
+            if (text[i] == '(')
+                ++depth;
+            else if (text[i] == ')')
+                --depth;
+            else if (text[i] == '|' && depth == 0)
+            {
+                parts.push_back(text.substr(begin, i-begin));
+                begin = i+1;
+            }
+
+        if (depth != 0)
+            return false;
+
+        if (!parts.empty())
+        {
+            parts.push_back(text.substr(begin));
+            BOOST_FOREACH(const string& part, parts)
+                if (!parseAlternatives(part))
+                    return false;
+            return true;
+        }
+
+        Alternative alternative;
+        if (!parseAlternative(text, alternative))
+            return false;
+        alternatives_.push_back(alternative);
+        return true;
+    }
+};
+
+typedef shared_ptr<const CleavageRule> CleavageRulePtr;
+
+
+// compiles each cleavage agent regex once for all Digestions
+class CleavageRuleCache : public boost::singleton<CleavageRuleCache>
+{
+    public:
+
+    CleavageRuleCache(boost::restricted) {}
+
+    CleavageRulePtr rule(const string& regex)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        CleavageRulePtr& rule = rules_[regex];
+        if (!rule.get())
+            rule.reset(new CleavageRule(regex));
+        return rule;
+    }
+
+    private:
+    boost::mutex mutex_;
+    map<string, CleavageRulePtr> rules_;
+};
+
+} // namespace
+
+
 class Digestion::Impl
 {
     public:
@@ -359,7 +644,7 @@ class Digestion::Impl
             if (cleavageAgent_ == MS_unspecific_cleavage)
                 config_.minimumSpecificity = Digestion::NonSpecific;
             else if (cleavageAgent_ != MS_no_cleavage)
-                cleavageAgentRegex_ = bxp::sregex::compile(disambiguateCleavageAgentRegex(getCleavageAgentRegex(cleavageAgent_)));
+                cleavageRule_ = CleavageRuleCache::instance->rule(disambiguateCleavageAgentRegex(getCleavageAgentRegex(cleavageAgent_)));
             return;
         }
 
@@ -369,7 +654,7 @@ class Digestion::Impl
             mergedRegex += ")|(" + disambiguateCleavageAgentRegex(getCleavageAgentRegex(cleavageAgents[i]));
         mergedRegex += "))";
 
-        cleavageAgentRegex_ = bxp::sregex::compile(mergedRegex);
+        cleavageRule_ = CleavageRuleCache::instance->rule(mergedRegex);
     }
 
     Impl(const Peptide& peptide, const vector<string>& cleavageAgentRegexes, const Config& config)
@@ -378,7 +663,7 @@ class Digestion::Impl
         cleavageAgent_ = CVID_Unknown; // Avoid testing uninitialized value in digest()
         if (cleavageAgentRegexes.size() == 1)
         {
-            cleavageAgentRegex_ = bxp::sregex::compile(cleavageAgentRegexes[0]); //disambiguateCleavageAgentRegex(cleavageAgentRegexes[0].str());
+            cleavageRule_ = CleavageRuleCache::instance->rule(cleavageAgentRegexes[0]); //disambiguateCleavageAgentRegex(cleavageAgentRegexes[0].str());
             return;
         }
 
@@ -387,7 +672,7 @@ class Digestion::Impl
             mergedRegex += ")|(" + disambiguateCleavageAgentRegex(cleavageAgentRegexes[i]);
         mergedRegex += "))";
 
-        cleavageAgentRegex_ = bxp::sregex::compile(mergedRegex);
+        cleavageRule_ = CleavageRuleCache::instance->rule(mergedRegex);
     }
 
     inline void digest() const
@@ -402,46 +687,20 @@ class Digestion::Impl
                 {
                     for (int i=-1, end=(int) sequence.size()-1; i < end; ++i)
                         sites_.push_back(i);
-                    sitesSet_.insert(sites_.begin(), sites_.end());
                     return;
                 }
                 else if (cleavageAgent_ == MS_no_cleavage)
                 {
                     sites_.push_back(-1);
                     sites_.push_back(sequence.length()-1);
-                    sitesSet_.insert(sites_.begin(), sites_.end());
                     return;
                 }
 
-                //if (cleavageAgentRegex_.empty())
-                //    throw runtime_error("empty cleavage regex");
-
-                std::string::const_iterator start = sequence.begin();
-                std::string::const_iterator end = sequence.end();
-                bxp::smatch what;
-                bxp::regex_constants::match_flag_type flags = bxp::regex_constants::match_default;
-                while (bxp::regex_search(start, end, what, cleavageAgentRegex_, flags))
-                {
-                    sites_.push_back(int(what[0].first-sequence.begin()-1));
-
-                    // update search position and flags
-                    start = max(what[0].second, start+1);
-                    flags = flags | bxp::regex_constants::match_prev_avail | bxp::regex_constants::match_not_bol;
-                }
-
-                // if regex didn't match n-terminus, insert it
-                if (sites_.empty() || sites_.front() > -1)
-                    sites_.insert(sites_.begin(), -1);
-
-                // if regex didn't match c-terminus, insert it
-                if (sites_.back() < (int)sequence.length()-1)
-                    sites_.push_back(sequence.length()-1);
+                cleavageRule_->findSites(sequence, sites_);
 
                 if (sites_.size() > 2 && sites_[1] != 0 &&
                     !sequence.empty() && config_.clipNTerminalMethionine && sequence[0] == 'M')
                     sites_.insert(sites_.begin()+1, 0);
-
-                sitesSet_.insert(sites_.begin(), sites_.end());
             }
             catch (exception& e)
             {
@@ -472,17 +731,15 @@ class Digestion::Impl
             size_t beginOffset = range.begin() - sequence_.begin();
             size_t endOffset = beginOffset + peptide.sequence().length() - 1;
 
-            bool NTerminusIsSpecific = sitesSet_.count(int(beginOffset) - 1) > 0;
-            bool CTerminusIsSpecific = sitesSet_.count(int(endOffset)) > 0;
+            bool NTerminusIsSpecific = isSite(int(beginOffset) - 1);
+            bool CTerminusIsSpecific = isSite(int(endOffset));
 
             if (((size_t) NTerminusIsSpecific + (size_t) CTerminusIsSpecific) < (size_t) config_.minimumSpecificity)
                 continue;
 
             size_t missedCleavages = 0;
             if (cleavageAgent_ != MS_unspecific_cleavage && cleavageAgent_ != MS_no_cleavage)
-                for (size_t i = beginOffset; i < endOffset; ++i)
-                    if (sitesSet_.count((int) i) > 0)
-                        ++missedCleavages;
+                missedCleavages = countSites(int(beginOffset), int(endOffset));
 
             if (missedCleavages > (size_t) config_.maximumMissedCleavages)
                 continue;
@@ -528,9 +785,7 @@ class Digestion::Impl
 
         size_t missedCleavages = 0;
         if (cleavageAgent_ != MS_unspecific_cleavage && cleavageAgent_ != MS_no_cleavage)
-            for (size_t i = beginOffset; i < endOffset; ++i)
-                if (sitesSet_.count((int) i) > 0)
-                    ++missedCleavages;
+            missedCleavages = countSites(int(beginOffset), int(endOffset));
 
         if (missedCleavages > (size_t) config_.maximumMissedCleavages)
             throw runtime_error("[Digestion::find_first()] Peptide \"" + peptide.sequence() + "\" not found in \"" + sequence_ + "\"");
@@ -540,8 +795,8 @@ class Digestion::Impl
         {
             endOffset = beginOffset + peptide.sequence().length() - 1;
 
-            NTerminusIsSpecific = sitesSet_.count(int(beginOffset)-1) > 0;
-            CTerminusIsSpecific = sitesSet_.count(int(endOffset)) > 0;
+            NTerminusIsSpecific = isSite(int(beginOffset)-1);
+            CTerminusIsSpecific = isSite(int(endOffset));
 
             if (((size_t) NTerminusIsSpecific + (size_t) CTerminusIsSpecific) >= (size_t) config_.minimumSpecificity)
                 break;
@@ -568,11 +823,25 @@ class Digestion::Impl
                                CTerminusSuffix);
     }
 
+    // returns true if there is a digestion site between offset and offset+1
+    inline bool isSite(int offset) const
+    {
+        return binary_search(sites_.begin(), sites_.end(), offset);
+    }
+
+    // returns the number of digestion sites from first up to but not including last
+    inline int countSites(int first, int last) const
+    {
+        if (last <= first)
+            return 0;
+        return int(lower_bound(sites_.begin(), sites_.end(), last) - lower_bound(sites_.begin(), sites_.end(), first));
+    }
+
     private:
     Peptide peptide_;
     Config config_;
     CVID cleavageAgent_;
-    bxp::sregex cleavageAgentRegex_;
+    CleavageRulePtr cleavageRule_;
     friend class Digestion::const_iterator::Impl;
 
     // precalculated offsets to digestion sites in order of occurence;
@@ -580,7 +849,6 @@ class Digestion::Impl
     // -1 is the N terminus digestion site
     // peptide_.sequence().length()-1 is the C terminus digestion site
     mutable vector<int> sites_;
-    mutable set<int> sitesSet_;
 };
 
 
@@ -648,8 +916,7 @@ class Digestion::const_iterator::Impl
         :   digestionImpl_(*digestion.impl_),
             config_(digestionImpl_.config_),
             sequence_(digestionImpl_.peptide_.sequence()),
-            sites_(digestionImpl_.sites_),
-            sitesSet_(digestionImpl_.sitesSet_)
+            sites_(digestionImpl_.sites_)
     {
         digestionImpl_.digest();
         try
@@ -757,73 +1024,64 @@ class Digestion::const_iterator::Impl
         }
     }
 
-    const DigestedPeptide& peptide() const
+    // returns the current peptide as a view of the sequence under digestion
+    DigestedPeptideView view() const
     {
-        try
+        DigestedPeptideView result;
+        result.polypeptideSequence = &sequence_;
+
+        int missedCleavages = 0;
+        switch (config_.minimumSpecificity)
         {
-            string prefix = "";
-            string suffix = "";
+            default:
+            case FullySpecific:
+                missedCleavages = int(end_ - begin_) - 1;
+                if (missedCleavages > 0 && config_.clipNTerminalMethionine && begin_ != sites_.end() && *begin_ < 0 && sequence_[0] == 'M')
+                    --missedCleavages;
+                if (missedCleavages > config_.maximumMissedCleavages)
+                    throw logic_error("digestion result exceeds maximumMissedClevages (something went wrong in a next*() function)");
+
+                result.offset = *begin_+1;
+                result.length = *end_ - *begin_;
+                result.NTerminusIsSpecific = result.CTerminusIsSpecific = true;
+                break;
 
-            int missedCleavages = 0;
+            case SemiSpecific:
+            case NonSpecific:
+                if (digestionImpl_.cleavageAgent_ != MS_unspecific_cleavage && digestionImpl_.cleavageAgent_ != MS_no_cleavage)
+                {
+                    missedCleavages = digestionImpl_.countSites(beginNonSpecific_+1, endNonSpecific_);
+                    if (missedCleavages > 0 && config_.clipNTerminalMethionine && begin_ != sites_.end() && *begin_ < 0 && sequence_[0] == 'M')
+                        --missedCleavages;
+                }
 
+                result.offset = beginNonSpecific_+1;
+                result.length = endNonSpecific_ - beginNonSpecific_;
+                result.NTerminusIsSpecific = begin_ != sites_.end() && *begin_ == beginNonSpecific_;
+                result.CTerminusIsSpecific = end_ != sites_.end() && *end_ == endNonSpecific_;
+                break;
+        }
+        result.missedCleavages = missedCleavages;
+        return result;
+    }
+
+    const DigestedPeptide& peptide() const
+    {
+        try
+        {
             if (!peptide_.get())
             {
-                switch (config_.minimumSpecificity)
-                {
-                    default:
-                    case FullySpecific:
-                        if(*begin_ >= 0 && *begin_ < (int) sequence_.length())
-                            prefix = sequence_.substr(*begin_, 1); //this could be changed to be something other than 1 by a config option later
-                        if(*end_ != (int) sequence_.length())
-                            suffix = sequence_.substr(*end_ + 1, 1);
-
-                        missedCleavages = int(end_ - begin_) - 1;
-                        if (missedCleavages > 0 && config_.clipNTerminalMethionine && begin_ != sites_.end() && *begin_ < 0 && sequence_[0] == 'M')
-                            --missedCleavages;
-                        if (missedCleavages > config_.maximumMissedCleavages)
-                            throw logic_error("digestion result exceeds maximumMissedClevages (something went wrong in a next*() function)");
-
-                        peptide_.reset(
-                            new DigestedPeptide(sequence_.begin()+(*begin_+1),
-                                                sequence_.begin()+(*end_+1),
-                                                *begin_+1,
-                                                missedCleavages,
-                                                true,
-                                                true,
-                                                prefix, 
-                                                suffix
-						));
-			                    
-                    break;
-
-                    case SemiSpecific:
-                    case NonSpecific:
-                        if(beginNonSpecific_ >= 0 && beginNonSpecific_ < (int) sequence_.length())
-                            prefix = sequence_.substr(beginNonSpecific_, 1); //this could be changed to be something other than 1 by a config option later
-                        if(endNonSpecific_ != (int) sequence_.length())
-                            suffix = sequence_.substr(endNonSpecific_ + 1, 1);
-
-                        if (digestionImpl_.cleavageAgent_ != MS_unspecific_cleavage && digestionImpl_.cleavageAgent_ != MS_no_cleavage)
-                        {
-                            for (int i = beginNonSpecific_+1; i < endNonSpecific_; ++i)
-                                if (sitesSet_.count(i) > 0)
-                                    ++missedCleavages;
-                            if (missedCleavages > 0 && config_.clipNTerminalMethionine && begin_ != sites_.end() && *begin_ < 0 && sequence_[0] == 'M')
-                                --missedCleavages;
-                        }
-
-                        peptide_.reset(
-                            new DigestedPeptide(sequence_.begin()+(beginNonSpecific_+1),
-                                                sequence_.begin()+(endNonSpecific_+1),
-                                                beginNonSpecific_+1,
-                                                missedCleavages,
-                                                begin_ != sites_.end() && *begin_ == beginNonSpecific_,
-                                                end_ != sites_.end() && *end_ == endNonSpecific_,
-                                                prefix,
-                                                suffix
-						));
-                        break;
-                }
+                DigestedPeptideView peptideView = view();
+                size_t end = peptideView.offset + peptideView.length;
+                peptide_.reset(
+                    new DigestedPeptide(sequence_.begin() + peptideView.offset,
+                                        sequence_.begin() + end,
+                                        peptideView.offset,
+                                        peptideView.missedCleavages,
+                                        peptideView.NTerminusIsSpecific,
+                                        peptideView.CTerminusIsSpecific,
+                                        peptideView.offset > 0 ? sequence_.substr(peptideView.offset-1, 1) : "",
+                                        end < sequence_.length() ? sequence_.substr(end, 1) : ""));
             }
             return *peptide_;
         }
@@ -1023,7 +1281,6 @@ class Digestion::const_iterator::Impl
     const Config& config_;
     const string& sequence_;
     const vector<int>& sites_;
-    const set<int>& sitesSet_;
 
     // used for all digests
     // fully specific: iterator to the current peptide's N terminal offset-1
@@ -1042,6 +1299,12 @@ class Digestion::const_iterator::Impl
     friend class Digestion::const_iterator;
 };
 
+PWIZ_API_DECL void Digestion::getPeptideViews(vector<DigestedPeptideView>& peptideViews) const
+{
+    for (const_iterator::Impl itr(*this); !itr.atEnd(); ++itr)
+        peptideViews.push_back(itr.view());
+}
+
 PWIZ_API_DECL Digestion::const_iterator::const_iterator()
 {
 }
@@ -1104,5 +1367,67 @@ PWIZ_API_DECL bool Digestion::const_iterator::operator==(const Digestion::const_
         return that.impl_->atEnd();
 }
 
+
+namespace {
+
+template <typename CleavageAgentList>
+void digestProteinListImpl(const ProteinList& proteinList,
+                           const CleavageAgentList& cleavageAgents,
+                           const Digestion::Config& config,
+                           const ProteinDigestionHandler& handler,
+                           size_t threadCount)
+{
+    // ProteinLists need not be thread-safe, so the workers read their chunks of proteins under a lock
+    const size_t chunkSize = 64;
+    const size_t chunkCount = (proteinList.size() + chunkSize - 1) / chunkSize;
+
+    if (threadCount == 0)
+        threadCount = WorkerPool::defaultThreadCount();
+    threadCount = max((size_t) 1, min(threadCount, chunkCount));
+
+    boost::mutex proteinListMutex;
+    vector<vector<ProteinPtr> > proteins(threadCount);
+    vector<vector<DigestedPeptideView> > peptides(threadCount);
+
+    parallelFor(chunkCount, [&](size_t c, size_t worker)
+    {
+        proteins[worker].clear();
+        {
+            boost::lock_guard<boost::mutex> lock(proteinListMutex);
+            for (size_t i = c * chunkSize, end = min(proteinList.size(), i + chunkSize); i < end; ++i)
+                proteins[worker].push_back(proteinList.protein(i));
+        }
+
+        BOOST_FOREACH(const ProteinPtr& protein, proteins[worker])
+        {
+            Digestion digestion(*protein, cleavageAgents, config);
+            peptides[worker].clear();
+            digestion.getPeptideViews(peptides[worker]);
+            handler(*protein, peptides[worker]);
+        }
+    }, threadCount);
+}
+
+} // namespace
+
+
+PWIZ_API_DECL void digestProteinList(const ProteinList& proteinList,
+                                     const vector<CVID>& cleavageAgents,
+                                     const Digestion::Config& config,
+                                     const ProteinDigestionHandler& handler,
+                                     size_t threadCount)
+{
+    digestProteinListImpl(proteinList, cleavageAgents, config, handler, threadCount);
+}
+
+PWIZ_API_DECL void digestProteinList(const ProteinList& proteinList,
+                                     const vector<string>& cleavageAgentRegexes,
+                                     const Digestion::Config& config,
+                                     const ProteinDigestionHandler& handler,
+                                     size_t threadCount)
+{
+    digestProteinListImpl(proteinList, cleavageAgentRegexes, config, handler, threadCount);
+}
+
 } // namespace proteome
 } // namespace pwiz
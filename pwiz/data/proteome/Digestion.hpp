@@ -30,10 +30,13 @@
 #include "pwiz/data/common/cv.hpp"
 #include "pwiz/utility/chemistry/Chemistry.hpp"
 #include "Peptide.hpp"
+#include "ProteomeData.hpp"
 #include "boost/shared_ptr.hpp"
 #include <string>
+#include <vector>
 #include <limits>
 #include <set>
+#include <functional>
 
 
 namespace pwiz {
@@ -107,6 +110,38 @@ class PWIZ_API_DECL DigestedPeptide : public Peptide
 };
 
 
+/// a peptide from digestion as a range of the digested polypeptide's sequence,
+/// with the same metadata as DigestedPeptide but without copying the sequence
+struct PWIZ_API_DECL DigestedPeptideView
+{
+    /// the sequence of the digested polypeptide; it must outlive the view
+    const std::string* polypeptideSequence;
+
+    /// the zero-based offset of the N terminus of the peptide in the polypeptide
+    size_t offset;
+
+    size_t length;
+    size_t missedCleavages;
+    bool NTerminusIsSpecific;
+    bool CTerminusIsSpecific;
+
+    DigestedPeptideView();
+
+    /// returns the range of the peptide's residues in the polypeptide sequence
+    const char* begin() const;
+    const char* end() const;
+
+    /// returns a copy of the peptide's sequence
+    std::string sequence() const;
+
+    /// returns the number of termini that matched to the digestion rules
+    size_t specificTermini() const;
+
+    /// returns a copy of the peptide with the residues before and after it as prefix and suffix
+    DigestedPeptide peptide() const;
+};
+
+
 /// enumerates the peptides from proteolytic digestion of a polypeptide or protein;
 class PWIZ_API_DECL Digestion
 {
@@ -205,6 +240,10 @@ class PWIZ_API_DECL Digestion
     /// note: the filters set in Digestion::Config are respected!
     DigestedPeptide find_first(const Peptide& peptide, size_t offsetHint = 0) const;
 
+    /// appends the peptides that iterating the digestion would enumerate, in the same order,
+    /// as views of the polypeptide's sequence; the views are valid while the Digestion exists
+    void getPeptideViews(std::vector<DigestedPeptideView>& peptideViews) const;
+
 
     ~Digestion();
 
@@ -257,6 +296,28 @@ class PWIZ_API_DECL Digestion
 };
 
 
+/// called by digestProteinList() with each protein and its peptides, which are valid during the call;
+/// it is called concurrently from several threads and in no particular protein order
+typedef std::function<void (const Protein& protein, const std::vector<DigestedPeptideView>& peptides)> ProteinDigestionHandler;
+
+/// digests every protein of proteinList with a combination of commonly used cleavage agents,
+/// calling handler for each protein from threadCount threads (0 for util::WorkerPool::defaultThreadCount());
+/// the first exception thrown by the handler or the protein list is rethrown when all threads have stopped
+PWIZ_API_DECL void digestProteinList(const ProteinList& proteinList,
+                                     const std::vector<CVID>& cleavageAgents,
+                                     const Digestion::Config& config,
+                                     const ProteinDigestionHandler& handler,
+                                     size_t threadCount = 0);
+
+/// digests every protein of proteinList with a combination of user-specified, zero-width Perl regular expressions,
+/// calling handler for each protein from threadCount threads (0 for util::WorkerPool::defaultThreadCount())
+PWIZ_API_DECL void digestProteinList(const ProteinList& proteinList,
+                                     const std::vector<std::string>& cleavageAgentRegexes,
+                                     const Digestion::Config& config,
+                                     const ProteinDigestionHandler& handler,
+                                     size_t threadCount = 0);
+
+
 } // namespace proteome
 } // namespace pwiz
 
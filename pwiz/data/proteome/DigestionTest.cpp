@@ -30,11 +30,13 @@
 #include "boost/thread/barrier.hpp"
 #include "boost/exception/all.hpp"
 #include "boost/foreach_field.hpp"
+#include <boost/xpressive/xpressive_dynamic.hpp>
 
 
 using namespace pwiz::cv;
 using namespace pwiz::util;
 using namespace pwiz::proteome;
+namespace bxp = boost::xpressive;
 
 
 ostream* os_ = 0;
@@ -664,6 +666,154 @@ void testFind()
 }
 
 
+void testPeptideViews()
+{
+    string sequence = "MPEPKTIDEKPEPTIDERPEPKTIDEKKKPEPTIDERD";
+
+    for (int specificity = Digestion::NonSpecific; specificity <= Digestion::FullySpecific; ++specificity)
+    {
+        Digestion digestion(sequence, MS_Lys_C_P, Digestion::Config(2, 3, 12, (Digestion::Specificity) specificity));
+        vector<DigestedPeptide> peptides(digestion.begin(), digestion.end());
+
+        vector<DigestedPeptideView> peptideViews;
+        digestion.getPeptideViews(peptideViews);
+
+        unit_assert(!peptides.empty());
+        unit_assert_operator_equal(peptides.size(), peptideViews.size());
+        for (size_t i=0; i < peptides.size(); ++i)
+        {
+            const DigestedPeptideView& view = peptideViews[i];
+            unit_assert_operator_equal(peptides[i].sequence(), view.sequence());
+            unit_assert_operator_equal(peptides[i].sequence(), string(view.begin(), view.end()));
+            unit_assert_operator_equal(peptides[i].offset(), view.offset);
+            unit_assert_operator_equal(peptides[i].missedCleavages(), view.missedCleavages);
+            unit_assert_operator_equal(peptides[i].specificTermini(), view.specificTermini());
+            unit_assert(peptides[i] == view.peptide());
+        }
+    }
+}
+
+
+// returns the digestion sites (see Digestion) found by searching the sequence with xpressive
+vector<int> regexSites(const bxp::sregex& regex, const string& sequence)
+{
+    vector<int> sites(1, -1);
+    for (bxp::sregex_iterator itr(sequence.begin(), sequence.end(), regex), end; itr != end; ++itr)
+    {
+        int site = int((*itr)[0].first - sequence.begin()) - 1;
+        if (site > sites.back())
+            sites.push_back(site);
+    }
+    if (sites.back() < (int) sequence.length()-1)
+        sites.push_back((int) sequence.length()-1);
+    return sites;
+}
+
+
+void testCleavageRules()
+{
+    // cleaving before and after D must not make the same site (and an empty peptide) twice
+    Digestion formicAcidDigestion("PEPDTIDE", MS_Formic_acid, Digestion::Config(0, 0, 100000, Digestion::FullySpecific, false));
+    vector<Peptide> formicAcidPeptides(formicAcidDigestion.begin(), formicAcidDigestion.end());
+    unit_assert_operator_equal(5, formicAcidPeptides.size());
+    unit_assert_operator_equal("PEP", formicAcidPeptides[0].sequence());
+    unit_assert_operator_equal("D", formicAcidPeptides[1].sequence());
+    unit_assert_operator_equal("TI", formicAcidPeptides[2].sequence());
+    unit_assert_operator_equal("D", formicAcidPeptides[3].sequence());
+    unit_assert_operator_equal("E", formicAcidPeptides[4].sequence());
+
+    // the sites of every cleavage agent must be the same as the sites found by its regex
+    const string residues = "ACDEFGHIKLMNPQRSTVWYBJXZ";
+    vector<string> sequences;
+    unsigned int seed = 42;
+    for (size_t i=0; i < 100; ++i)
+    {
+        sequences.push_back(string());
+        for (size_t j=0, length = i % 50; j < length; ++j)
+        {
+            seed = seed * 1103515245 + 12345;
+            sequences.back() += residues[(seed >> 16) % residues.length()];
+        }
+    }
+    sequences.push_back("MKPKPRPKRPDEDPEEPE");
+
+    vector<string> regexes;
+    BOOST_FOREACH(CVID agent, Digestion::getCleavageAgents())
+        if (agent != MS_unspecific_cleavage && agent != MS_no_cleavage)
+            regexes.push_back(Digestion::disambiguateCleavageAgentRegex(Digestion::getCleavageAgentRegex(agent)));
+    regexes.push_back("(?<=A[DE])(?=[FG])");
+    regexes.push_back("(?<=^M)|(?<=[KR])");
+
+    BOOST_FOREACH(const string& regex, regexes)
+    {
+        bxp::sregex compiledRegex = bxp::sregex::compile(regex);
+        Digestion::Config config(0, 0, 100000, Digestion::FullySpecific, false);
+
+        BOOST_FOREACH(const string& sequence, sequences)
+        {
+            vector<int> sites = regexSites(compiledRegex, sequence);
+
+            vector<DigestedPeptideView> peptideViews;
+            Digestion(sequence, regex, config).getPeptideViews(peptideViews);
+
+            unit_assert_operator_equal(sites.size() - 1, peptideViews.size());
+            for (size_t i=0; i < peptideViews.size(); ++i)
+            {
+                unit_assert_operator_equal(sites[i]+1, (int) peptideViews[i].offset);
+                unit_assert_operator_equal(sites[i+1] - sites[i], (int) peptideViews[i].length);
+            }
+        }
+    }
+}
+
+
+void testDigestProteinList()
+{
+    ProteinListSimple proteinList;
+    for (size_t i=0; i < 300; ++i)
+        proteinList.proteins.push_back(ProteinPtr(new Protein("P" + lexical_cast<string>(i), i, "",
+                                                              "MPEPKTIDEKPEPTIDER" + string(i % 20, 'A') + "KPEPTIDEK")));
+
+    Digestion::Config config(1, 5, 30);
+    vector<CVID> cleavageAgents(1, MS_Lys_C_P);
+
+    vector<vector<string> > expectedPeptides;
+    BOOST_FOREACH(const ProteinPtr& protein, proteinList.proteins)
+    {
+        expectedPeptides.push_back(vector<string>());
+        for (const DigestedPeptide& peptide : Digestion(*protein, cleavageAgents, config))
+            expectedPeptides.back().push_back(peptide.sequence());
+    }
+
+    for (size_t threadCount = 1; threadCount <= 4; threadCount += 3)
+    {
+        boost::mutex mutex;
+        vector<vector<string> > peptides(proteinList.size());
+        vector<size_t> callCounts(proteinList.size(), 0);
+
+        digestProteinList(proteinList, cleavageAgents, config, [&](const Protein& protein, const vector<DigestedPeptideView>& views)
+        {
+            boost::lock_guard<boost::mutex> lock(mutex);
+            ++callCounts[protein.index];
+            BOOST_FOREACH(const DigestedPeptideView& view, views)
+                peptides[protein.index].push_back(view.sequence());
+        }, threadCount);
+
+        unit_assert(callCounts == vector<size_t>(proteinList.size(), 1));
+        unit_assert(peptides == expectedPeptides);
+
+        // exceptions from the handler are rethrown
+        unit_assert_throws_what(digestProteinList(proteinList, vector<string>(1, "(?<=K)"), config,
+                                                  [](const Protein& protein, const vector<DigestedPeptideView>&)
+                                                  {
+                                                      if (protein.index == 200)
+                                                          throw runtime_error("bad protein");
+                                                  }, threadCount),
+                                runtime_error, "bad protein");
+    }
+}
+
+
 struct ThreadStatus
 {
     boost::exception_ptr exception;
@@ -683,6 +833,9 @@ void testThreadSafetyWorker(boost::barrier* testBarrier, ThreadStatus& status)
         testBSADigestion();
         testDigestionCriteria();
         testFind();
+        testPeptideViews();
+        testCleavageRules();
+        testDigestProteinList();
     }
     catch (exception& e)
     {
@@ -0,0 +1,469 @@
+//
+// $Id$
+//
+//
+// Original author: agent <agent@local>
+//
+// Copyright 2026
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#define PWIZ_SOURCE
+
+#include "ProteinList_MappedFASTA.hpp"
+#include "pwiz/utility/misc/Filesystem.hpp"
+#include "pwiz/utility/misc/FileStamp.hpp"
+#include "pwiz/utility/misc/WorkerPool.hpp"
+#include "pwiz/utility/misc/Std.hpp"
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <cstring>
+#include <cstddef>
+
+
+namespace pwiz {
+namespace proteome {
+
+
+using namespace pwiz::util;
+using boost::uint64_t;
+
+
+namespace {
+
+// sidecar layout, in native byte order so the arrays can be used where they are mapped:
+// SidecarHeader | record offsets[proteinCount] | id hashes[proteinCount] | hash table slots[slotCount]
+struct SidecarHeader
+{
+    char magic[8];
+    uint64_t byteOrder;
+    uint64_t version;
+    uint64_t fileSize;
+    uint64_t modificationTime;
+    char fingerprint[40]; // FileStamp::fingerprint
+    uint64_t proteinCount;
+    uint64_t slotCount;
+};
+
+const char sidecarMagic_[8] = {'p','w','i','z','f','a','i','x'};
+const uint64_t sidecarByteOrder_ = 0x0102030405060708ull;
+const uint64_t sidecarVersion_ = 1;
+
+// the smallest part of the file worth giving its own indexing thread
+const size_t minimumBytesPerThread_ = 1 << 20;
+
+inline bool isSpace(char c) {return c == ' ' || (c >= '\t' && c <= '\r');}
+inline bool isDigit(char c) {return c >= '0' && c <= '9';}
+
+// FNV-1a, which unlike std::hash is the same for every build that reads a persisted index
+uint64_t hashId(const char* begin, const char* end)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (; begin != end; ++begin)
+    {
+        hash ^= (unsigned char) *begin;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+// returns the end of the line starting at begin, i.e. the position of its '\n' or end
+inline const char* findLineEnd(const char* begin, const char* end)
+{
+    const char* newline = static_cast<const char*>(memchr(begin, '\n', end - begin));
+    return newline ? newline : end;
+}
+
+// splits a header line (starting with '>', with trailing spaces and carriage returns trimmed)
+// into id and description the same way as the regexes of Serializer_FASTA:
+// ">\s*(\S*?IPI\d+?\.\d+?)(?:\s|\|)(.*)" and then ">\s*(\S+)\s?(.*)"
+bool parseHeader(const char* begin, const char* end,
+                 ProteinList_MappedFASTA::TextRange& id, ProteinList_MappedFASTA::TextRange& description)
+{
+    const char* idBegin = begin + 1;
+    while (idBegin != end && isSpace(*idBegin))
+        ++idBegin;
+
+    const char* idEnd = idBegin;
+    while (idEnd != end && !isSpace(*idEnd))
+        ++idEnd;
+
+    if (idBegin == idEnd)
+        return false;
+
+    // IPI ids end at the version of the first IPI accession in the first word
+    for (const char* ipi = idBegin; ipi + 3 <= idEnd; ++ipi)
+    {
+        if (memcmp(ipi, "IPI", 3) != 0)
+            continue;
+
+        const char* i = ipi + 3;
+        const char* digits = i;
+        while (i != end && isDigit(*i)) ++i;
+        if (i == digits || i == end || *i != '.')
+            continue;
+
+        digits = ++i;
+        while (i != end && isDigit(*i)) ++i;
+        if (i == digits || i == end || !(isSpace(*i) || *i == '|'))
+            continue;
+
+        id = ProteinList_MappedFASTA::TextRange(idBegin, i);
+        description = ProteinList_MappedFASTA::TextRange(i + 1, end);
+        return true;
+    }
+
+    id = ProteinList_MappedFASTA::TextRange(idBegin, idEnd);
+    description = ProteinList_MappedFASTA::TextRange(idEnd == end ? end : idEnd + 1, end);
+    return true;
+}
+
+} // namespace
+
+
+class ProteinList_MappedFASTA::Impl
+{
+    public:
+
+    Impl(const string& filename, const Config& config)
+    :   filename_(filename), config_(config), data_(0), dataSize_(0),
+        size_(0), slotCount_(0), offsets_(0), hashes_(0), slots_(0)
+    {
+        if (!bfs::exists(filename))
+            throw runtime_error("[ProteinList_MappedFASTA] File does not exist: " + filename);
+
+        // an empty file can't be mapped, but it is an empty ProteinList
+        if (bfs::file_size(filename) > 0)
+        {
+            mapping_.open(filename);
+            if (!mapping_.is_open())
+                throw runtime_error("[ProteinList_MappedFASTA] Unable to map " + filename);
+            data_ = mapping_.data();
+            dataSize_ = mapping_.size();
+        }
+
+        if (config_.persistIndex && readSidecar())
+            return;
+
+        createIndex();
+        createHashTable();
+
+        if (config_.persistIndex)
+            writeSidecar();
+    }
+
+    size_t size() const {return size_;}
+
+    Record record(size_t index) const
+    {
+        if (index >= size_)
+            throw out_of_range("[ProteinList_MappedFASTA::record] Index out of range");
+
+        const char* end = data_ + dataSize_;
+        const char* header = data_ + offsets_[index];
+        if (*header != '>')
+            throw runtime_error("[ProteinList_MappedFASTA::record] Invalid index offset");
+
+        const char* headerLineEnd = findLineEnd(header, end);
+        const char* sequenceEnd = index+1 < size_ ? data_ + offsets_[index+1] : end;
+
+        Record result;
+        if (!parseHeader(header, trimmedEnd(header, headerLineEnd), result.id, result.description))
+            throw runtime_error("[ProteinList_MappedFASTA::record] Could not parse id from entry \"" + string(header, headerLineEnd) + "\"");
+        result.sequenceLines = TextRange(headerLineEnd == end ? end : headerLineEnd + 1, sequenceEnd);
+        return result;
+    }
+
+    size_t find(const string& id) const
+    {
+        const char* idBegin = id.c_str();
+        const char* idEnd = idBegin + id.length();
+        uint64_t hash = hashId(idBegin, idEnd);
+
+        for (uint64_t slot = hash & (slotCount_ - 1); slots_[slot] != 0; slot = (slot + 1) & (slotCount_ - 1))
+        {
+            size_t index = static_cast<size_t>(slots_[slot] - 1);
+            if (hashes_[index] == hash)
+            {
+                TextRange candidate = record(index).id;
+                if (candidate.size() == id.length() && std::equal(candidate.begin(), candidate.end(), idBegin))
+                    return index;
+            }
+        }
+        return size_;
+    }
+
+    private:
+
+    string filename_;
+    Config config_;
+
+    boost::iostreams::mapped_file_source mapping_;
+    const char* data_;
+    size_t dataSize_;
+
+    // the index and hash table, either built in these vectors or mapped from the sidecar
+    boost::iostreams::mapped_file_source sidecar_;
+    vector<uint64_t> offsetStorage_, hashStorage_, slotStorage_;
+
+    size_t size_;
+    uint64_t slotCount_; // a power of 2
+    const uint64_t* offsets_; // the offset of each record's header
+    const uint64_t* hashes_; // the hash of each record's id
+    const uint64_t* slots_; // record index + 1, or 0 for an empty slot
+
+    static const char* trimmedEnd(const char* begin, const char* end)
+    {
+        while (end != begin && (end[-1] == ' ' || end[-1] == '\r'))
+            --end;
+        return end;
+    }
+
+    // finds the headers (lines starting with '>') in [begin, end) of the file; a header starting
+    // before begin is found by the thread scanning the part of the file before it
+    void indexPart(size_t begin, size_t end, vector<uint64_t>& offsets, vector<uint64_t>& hashes) const
+    {
+        const char* fileEnd = data_ + dataSize_;
+        const char* line = data_ + begin;
+        if (begin > 0 && line[-1] != '\n')
+        {
+            line = findLineEnd(line, fileEnd);
+            if (line != fileEnd)
+                ++line;
+        }
+
+        for (const char* partEnd = data_ + end; line < partEnd;)
+        {
+            const char* lineEnd = findLineEnd(line, fileEnd);
+            if (*line == '>')
+            {
+                TextRange id, description;
+                if (!parseHeader(line, trimmedEnd(line, lineEnd), id, description))
+                    throw runtime_error("[ProteinList_MappedFASTA::createIndex] could not parse id from entry \"" + string(line, lineEnd) + "\"");
+                offsets.push_back(line - data_);
+                hashes.push_back(hashId(id.begin(), id.end()));
+            }
+            line = lineEnd == fileEnd ? fileEnd : lineEnd + 1;
+        }
+    }
+
+    void createIndex()
+    {
+        size_t threadCount = config_.threadCount > 0 ? config_.threadCount : WorkerPool::defaultThreadCount();
+        threadCount = max((size_t) 1, min(threadCount, dataSize_ / minimumBytesPerThread_));
+
+        // one part of the file per worker
+        vector<vector<uint64_t> > offsets(threadCount), hashes(threadCount);
+        parallelFor(threadCount, [&](size_t t, size_t worker)
+        {
+            indexPart(dataSize_ / threadCount * t,
+                      t+1 < threadCount ? dataSize_ / threadCount * (t+1) : dataSize_,
+                      offsets[t], hashes[t]);
+        }, threadCount);
+
+        for (size_t t=0; t < threadCount; ++t)
+        {
+            offsetStorage_.insert(offsetStorage_.end(), offsets[t].begin(), offsets[t].end());
+            hashStorage_.insert(hashStorage_.end(), hashes[t].begin(), hashes[t].end());
+        }
+
+        size_ = offsetStorage_.size();
+        offsets_ = offsetStorage_.empty() ? 0 : &offsetStorage_[0];
+        hashes_ = hashStorage_.empty() ? 0 : &hashStorage_[0];
+    }
+
+    // builds an open addressing table of the ids with linear probing, at most half full
+    void createHashTable()
+    {
+        slotCount_ = 1;
+        while (slotCount_ < 2 * size_)
+            slotCount_ *= 2;
+        slotStorage_.assign(static_cast<size_t>(slotCount_), 0);
+        slots_ = &slotStorage_[0];
+
+        for (size_t index=0; index < size_; ++index)
+        {
+            uint64_t slot = hashes_[index] & (slotCount_ - 1);
+            for (; slotStorage_[slot] != 0; slot = (slot + 1) & (slotCount_ - 1))
+            {
+                size_t other = static_cast<size_t>(slotStorage_[slot] - 1);
+                if (hashes_[other] == hashes_[index] && record(other).id == record(index).id)
+                {
+                    // note: We could silently skip the duplicates, but that would only be
+                    //       reasonable after checking that the sequences are equal.
+                    TextRange id = record(index).id;
+                    throw runtime_error("[ProteinList_MappedFASTA::createHashTable] duplicate protein id \"" + string(id.begin(), id.end()) + "\"");
+                }
+            }
+            slotStorage_[slot] = index + 1;
+        }
+    }
+
+    SidecarHeader sidecarHeader() const
+    {
+        SidecarHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, sidecarMagic_, sizeof(header.magic));
+        header.byteOrder = sidecarByteOrder_;
+        header.version = sidecarVersion_;
+
+        FileStamp stamp(filename_);
+        header.fileSize = stamp.size;
+        header.modificationTime = stamp.modificationTime;
+        memcpy(header.fingerprint, stamp.fingerprint.c_str(), min(stamp.fingerprint.length(), sizeof(header.fingerprint)));
+
+        header.proteinCount = size_;
+        header.slotCount = slotCount_;
+        return header;
+    }
+
+    bool readSidecar()
+    {
+        string sidecarFilename = ProteinList_MappedFASTA::sidecarFilename(filename_);
+
+        try
+        {
+            if (!bfs::exists(sidecarFilename) || bfs::file_size(sidecarFilename) < sizeof(SidecarHeader))
+                return false;
+
+            sidecar_.open(sidecarFilename);
+            const SidecarHeader& header = *reinterpret_cast<const SidecarHeader*>(sidecar_.data());
+            SidecarHeader expected = sidecarHeader();
+
+            // the counts are checked against the sidecar size instead of the file; the table is
+            // the smallest power of 2 at least twice the count, so it has empty slots for find() to stop at
+            if (memcmp(&header, &expected, offsetof(SidecarHeader, proteinCount)) != 0 ||
+                header.proteinCount > dataSize_ ||
+                header.slotCount == 0 || (header.slotCount & (header.slotCount - 1)) != 0 ||
+                header.slotCount < 2 * header.proteinCount || header.slotCount > max<uint64_t>(1, 4 * header.proteinCount) ||
+                sidecar_.size() != sizeof(SidecarHeader) + (2 * header.proteinCount + header.slotCount) * sizeof(uint64_t))
+            {
+                sidecar_.close();
+                return false;
+            }
+
+            size_ = static_cast<size_t>(header.proteinCount);
+            slotCount_ = header.slotCount;
+            offsets_ = reinterpret_cast<const uint64_t*>(sidecar_.data() + sizeof(SidecarHeader));
+            hashes_ = offsets_ + size_;
+            slots_ = hashes_ + size_;
+
+            // a damaged sidecar must not make record() or find() read outside the file or the index
+            bool valid = true;
+            for (size_t i=0; i < size_ && valid; ++i)
+                valid = offsets_[i] < dataSize_ && (i == 0 || offsets_[i] > offsets_[i-1]) && data_[offsets_[i]] == '>';
+            for (uint64_t slot=0; slot < slotCount_ && valid; ++slot)
+                valid = slots_[slot] <= size_;
+            if (valid)
+                return true;
+        }
+        catch (exception&)
+        {
+            // missing, stale, or damaged: fall back to building the index
+        }
+
+        if (sidecar_.is_open())
+            sidecar_.close();
+        return false;
+    }
+
+    void writeSidecar() const
+    {
+        string sidecarFilename = ProteinList_MappedFASTA::sidecarFilename(filename_);
+        bfs::path tempFilename = sidecarFilename + "." + bfs::unique_path().string() + ".tmp";
+
+        try
+        {
+            {
+                SidecarHeader header = sidecarHeader();
+                ofstream os(tempFilename.string().c_str(), ios::binary);
+                os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+                os.write(reinterpret_cast<const char*>(offsets_), size_ * sizeof(uint64_t));
+                os.write(reinterpret_cast<const char*>(hashes_), size_ * sizeof(uint64_t));
+                os.write(reinterpret_cast<const char*>(slots_), static_cast<size_t>(slotCount_) * sizeof(uint64_t));
+                if (!os)
+                    throw runtime_error("[ProteinList_MappedFASTA::writeSidecar()] Error writing " + tempFilename.string());
+            }
+            bfs::rename(tempFilename, sidecarFilename);
+        }
+        catch (exception&)
+        {
+            // e.g. a read-only directory: the index is only rebuilt on the next open
+            boost::system::error_code ec;
+            bfs::remove(tempFilename, ec);
+        }
+    }
+};
+
+
+PWIZ_API_DECL void ProteinList_MappedFASTA::Record::getSequence(string& sequence) const
+{
+    sequence.clear();
+    const char* end = sequenceLines.end();
+    for (const char* line = sequenceLines.begin(); line < end;)
+    {
+        const char* lineEnd = findLineEnd(line, end);
+        const char* residuesEnd = static_cast<const char*>(memchr(line, '\r', lineEnd - line));
+        sequence.append(line, residuesEnd ? residuesEnd : lineEnd);
+        line = lineEnd + 1;
+    }
+}
+
+
+PWIZ_API_DECL ProteinList_MappedFASTA::ProteinList_MappedFASTA(const string& filename, const Config& config)
+:   impl_(new Impl(filename, config))
+{
+}
+
+
+PWIZ_API_DECL string ProteinList_MappedFASTA::sidecarFilename(const string& filename) {return filename + ".pwizidx";}
+
+
+PWIZ_API_DECL ProteinList_MappedFASTA::Record ProteinList_MappedFASTA::record(size_t index) const
+{
+    return impl_->record(index);
+}
+
+
+PWIZ_API_DECL size_t ProteinList_MappedFASTA::size() const
+{
+    return impl_->size();
+}
+
+
+PWIZ_API_DECL ProteinPtr ProteinList_MappedFASTA::protein(size_t index, bool getSequence) const
+{
+    if (index >= size())
+        throw out_of_range("[ProteinList_MappedFASTA::protein] Index out of range");
+
+    Record record = impl_->record(index);
+    string sequence;
+    if (getSequence)
+        record.getSequence(sequence);
+
+    return ProteinPtr(new Protein(string(record.id.begin(), record.id.end()),
+                                  index,
+                                  string(record.description.begin(), record.description.end()),
+                                  sequence));
+}
+
+
+PWIZ_API_DECL size_t ProteinList_MappedFASTA::find(const string& id) const
+{
+    return impl_->find(id);
+}
+
+
+} // namespace proteome
+} // namespace pwiz
@@ -0,0 +1,112 @@
+//
+// $Id$
+//
+//
+// Original author: agent <agent@local>
+//
+// Copyright 2026
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef _PROTEINLIST_MAPPEDFASTA_HPP_
+#define _PROTEINLIST_MAPPEDFASTA_HPP_
+
+
+#include "pwiz/utility/misc/Export.hpp"
+#include "ProteomeData.hpp"
+#include <boost/range/iterator_range.hpp>
+
+
+namespace pwiz {
+namespace proteome {
+
+
+///
+/// ProteinList backed by a read-only memory mapping of an uncompressed FASTA file:
+/// - the index of the records is built by several threads, each scanning a part of the file
+/// - find() looks up ids in a hash table instead of searching or reading the file
+/// - record() returns a protein's header and sequence lines as ranges of the mapping, without copying;
+///   the sequence range is the raw text of the file, line breaks included (see Record)
+/// - protein() reads from the mapping without locking, so it may be called from several threads
+///
+/// With Config::persistIndex, the index and hash table are saved to <file>.pwizidx and mapped
+/// directly on later opens, for as long as the FASTA file's size, modification time and
+/// head and tail are unchanged.
+///
+class PWIZ_API_DECL ProteinList_MappedFASTA : public ProteinList
+{
+    public:
+
+    struct PWIZ_API_DECL Config
+    {
+        /// number of threads that index the file (0 for util::WorkerPool::defaultThreadCount())
+        size_t threadCount;
+
+        /// save the index beside the file and reuse it on later opens
+        bool persistIndex;
+
+        Config() : threadCount(0), persistIndex(false) {}
+    };
+
+    typedef boost::iterator_range<const char*> TextRange;
+
+    /// a FASTA record as ranges of the mapping, valid while the ProteinList exists
+    struct PWIZ_API_DECL Record
+    {
+        /// the protein's id in the header line
+        TextRange id;
+
+        /// the protein's description in the header line
+        TextRange description;
+
+        /// the sequence lines as they are in the file: NOT a contiguous sequence, since the range
+        /// includes the line breaks (LF or CRLF) between the lines and any blank lines;
+        /// use getSequence() for the residues alone
+        TextRange sequenceLines;
+
+        /// replaces the contents of sequence with the residues of the sequence lines,
+        /// i.e. sequenceLines without its line breaks
+        void getSequence(std::string& sequence) const;
+    };
+
+    /// maps and indexes the given FASTA file; throws runtime_error if the file can't be mapped
+    /// or if a header has no id or an id is not unique
+    ProteinList_MappedFASTA(const std::string& filename, const Config& config = Config());
+
+    /// returns the name of the file the index is persisted to
+    static std::string sidecarFilename(const std::string& filename);
+
+    /// returns the record of the protein at the given index
+    Record record(size_t index) const;
+
+    // ProteinList implementation
+
+    virtual size_t size() const;
+    virtual ProteinPtr protein(size_t index, bool getSequence = true) const;
+    virtual size_t find(const std::string& id) const;
+
+    private:
+    class Impl;
+    boost::shared_ptr<Impl> impl_;
+    ProteinList_MappedFASTA(ProteinList_MappedFASTA&);
+    ProteinList_MappedFASTA& operator=(ProteinList_MappedFASTA&);
+};
+
+
+} // namespace proteome
+} // namespace pwiz
+
+
+#endif // _PROTEINLIST_MAPPEDFASTA_HPP_
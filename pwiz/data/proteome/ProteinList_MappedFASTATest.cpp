@@ -0,0 +1,252 @@
+//
+// $Id$
+//
+//
+// Original author: agent <agent@local>
+//
+// Copyright 2026
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "ProteinList_MappedFASTA.hpp"
+#include "ProteomeDataFile.hpp"
+#include "pwiz/utility/misc/unit.hpp"
+#include "pwiz/utility/misc/Filesystem.hpp"
+#include "pwiz/utility/misc/Std.hpp"
+#include <cstring>
+
+
+using namespace pwiz::util;
+using namespace pwiz::proteome;
+
+
+ostream* os_ = 0;
+
+
+const string filename_ = "temp.ProteinList_MappedFASTATest.fasta";
+
+
+const char* testFASTA_ =
+    ">ABC1 first protein\n"
+    "PEPTIDE\n"
+    ">ABC2\n"
+    "ELVIS\n"
+    "LIVES\n"
+    "\n"
+    ">  ABC3\tthird protein\r\n"
+    "PEP\r\n"
+    "\r\n"
+    "TIDE\r\n"
+    ">IPI:IPI00000001.2|SWISS-PROT:O95793-1|REFSEQ:NP_059347 Tax_Id=9606 Gene_Symbol=STAU1\n"
+    "MKLGKKPMYKPVDPYSRMQSTYNYNMRGGAYPPRYFYQAYHPPA\n"
+    ">ABC4 no sequence\n"
+    ">ABC5 last protein without a line break   \n"
+    "KRLVIS";
+
+
+void writeFile(const string& filename, const string& text)
+{
+    ofstream os(filename.c_str(), ios::binary);
+    os << text;
+}
+
+
+// compares the mapped list to the stream reader's list of the same file
+void testEquivalence(const ProteinList& mapped, const ProteinList& streamed)
+{
+    unit_assert_operator_equal(streamed.size(), mapped.size());
+    for (size_t i=0; i < streamed.size(); ++i)
+    {
+        ProteinPtr expected = streamed.protein(i);
+        ProteinPtr actual = mapped.protein(i);
+        if (os_) *os_ << actual->id << " [" << actual->description << "] " << actual->sequence() << endl;
+
+        unit_assert_operator_equal(expected->id, actual->id);
+        unit_assert_operator_equal(i, actual->index);
+        unit_assert_operator_equal(expected->description, actual->description);
+        unit_assert_operator_equal(expected->sequence(), actual->sequence());
+        unit_assert(mapped.protein(i, false)->sequence().empty());
+
+        unit_assert_operator_equal(i, mapped.find(expected->id));
+    }
+    unit_assert_operator_equal(mapped.size(), mapped.find("ABC"));
+    unit_assert_throws(mapped.protein(mapped.size()), out_of_range);
+}
+
+
+void testRead()
+{
+    if (os_) *os_ << "testRead()" << endl;
+
+    writeFile(filename_, testFASTA_);
+
+    ProteomeDataFile streamed(filename_);
+    ProteinList_MappedFASTA mapped(filename_);
+    testEquivalence(mapped, *streamed.proteinListPtr);
+
+    ProteinList_MappedFASTA::Record record = mapped.record(0);
+    unit_assert_operator_equal("ABC1", string(record.id.begin(), record.id.end()));
+    unit_assert_operator_equal("first protein", string(record.description.begin(), record.description.end()));
+    unit_assert_operator_equal("PEPTIDE\n", string(record.sequenceLines.begin(), record.sequenceLines.end()));
+
+    // the lines of a sequence are views into the file
+    record = mapped.record(2);
+    unit_assert_operator_equal("PEP\r\n\r\nTIDE\r\n", string(record.sequenceLines.begin(), record.sequenceLines.end()));
+    string sequence = "XXX";
+    record.getSequence(sequence);
+    unit_assert_operator_equal("PEPTIDE", sequence);
+
+    unit_assert_operator_equal("IPI:IPI00000001.2", mapped.protein(3)->id);
+    unit_assert_operator_equal("", mapped.protein(4)->sequence());
+    unit_assert_operator_equal("KRLVIS", mapped.protein(5)->sequence());
+
+    // through the reader
+    ProteomeDataFile pd(filename_, false, true);
+    unit_assert(dynamic_cast<ProteinList_MappedFASTA*>(pd.proteinListPtr.get()));
+    testEquivalence(*pd.proteinListPtr, *streamed.proteinListPtr);
+
+    // empty files are empty lists
+    writeFile(filename_, "");
+    unit_assert_operator_equal(0, ProteinList_MappedFASTA(filename_).size());
+    unit_assert_operator_equal(0, ProteinList_MappedFASTA(filename_).find("ABC1"));
+
+    // like the stream reader, duplicate ids are an error
+    writeFile(filename_, ">ABC1\nPEPTIDE\n>ABC2\nPEPTIDE\n>ABC1 again\nPEPTIDE\n");
+    unit_assert_throws(ProteinList_MappedFASTA(filename_).size(), runtime_error);
+    writeFile(filename_, ">ABC1\nPEPTIDE\n> \nPEPTIDE\n");
+    unit_assert_throws(ProteinList_MappedFASTA(filename_).size(), runtime_error);
+
+    bfs::remove(filename_);
+}
+
+
+void testParallelIndex()
+{
+    if (os_) *os_ << "testParallelIndex()" << endl;
+
+    // several MB, so several threads each index a part
+    string text;
+    for (size_t i=0; i < 40000; ++i)
+    {
+        text += ">PROT" + lexical_cast<string>(i) + " protein " + lexical_cast<string>(i) + "\n";
+        for (size_t j=0; j < 1 + i % 3; ++j)
+            text += string(60, "ACDEFGHIKLMNPQRSTVWY"[(i + j) % 20]) + "\n";
+    }
+    writeFile(filename_, text);
+
+    ProteinList_MappedFASTA::Config config;
+    config.threadCount = 1;
+    ProteinList_MappedFASTA serial(filename_, config);
+    config.threadCount = 4;
+    ProteinList_MappedFASTA parallel(filename_, config);
+
+    unit_assert_operator_equal(40000, serial.size());
+    unit_assert_operator_equal(serial.size(), parallel.size());
+    for (size_t i=0; i < serial.size(); ++i)
+    {
+        ProteinList_MappedFASTA::Record serialRecord = serial.record(i), parallelRecord = parallel.record(i);
+        unit_assert(serialRecord.id == parallelRecord.id);
+        unit_assert(serialRecord.sequenceLines == parallelRecord.sequenceLines);
+        unit_assert_operator_equal(i, parallel.find("PROT" + lexical_cast<string>(i)));
+    }
+    unit_assert_operator_equal(string(60, 'W') + string(60, 'Y') + string(60, 'A'), parallel.protein(39998)->sequence());
+
+    bfs::remove(filename_);
+}
+
+
+void testPersistIndex()
+{
+    if (os_) *os_ << "testPersistIndex()" << endl;
+
+    string sidecarFilename = ProteinList_MappedFASTA::sidecarFilename(filename_);
+    bfs::remove(sidecarFilename);
+    writeFile(filename_, testFASTA_);
+
+    ProteinList_MappedFASTA::Config config;
+    config.persistIndex = true;
+
+    {
+        ProteinList_MappedFASTA mapped(filename_, config);
+        unit_assert(bfs::exists(sidecarFilename));
+    }
+
+    {
+        // the index is read from the sidecar
+        ProteomeDataFile streamed(filename_);
+        ProteinList_MappedFASTA mapped(filename_, config);
+        testEquivalence(mapped, *streamed.proteinListPtr);
+    }
+
+    // a changed file makes the sidecar stale
+    writeFile(filename_, string(testFASTA_) + "\n>ABC6\nPEPTIDE\n");
+    {
+        ProteomeDataFile streamed(filename_);
+        ProteinList_MappedFASTA mapped(filename_, config);
+        unit_assert_operator_equal(7, mapped.size());
+        testEquivalence(mapped, *streamed.proteinListPtr);
+    }
+
+    // a damaged sidecar is rebuilt
+    writeFile(sidecarFilename, "garbage");
+    {
+        ProteinList_MappedFASTA mapped(filename_, config);
+        unit_assert_operator_equal(6, mapped.find("ABC6"));
+    }
+    unit_assert(bfs::file_size(sidecarFilename) > 7);
+
+    // so is a sidecar with an offset outside the file; the 7 offsets, 7 hashes and 16 slots end the sidecar
+    string sidecar;
+    {
+        ifstream is(sidecarFilename.c_str(), ios::binary);
+        sidecar.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+    }
+    unit_assert(sidecar.size() > (7 + 7 + 16) * 8);
+    memset(&sidecar[sidecar.size() - (7 + 7 + 16) * 8], 0x7f, 8);
+    writeFile(sidecarFilename, sidecar);
+    {
+        ProteomeDataFile streamed(filename_);
+        ProteinList_MappedFASTA mapped(filename_, config);
+        unit_assert_operator_equal(0, mapped.find("ABC1"));
+        testEquivalence(mapped, *streamed.proteinListPtr);
+    }
+
+    bfs::remove(filename_);
+    bfs::remove(sidecarFilename);
+}
+
+
+int main(int argc, char* argv[])
+{
+    TEST_PROLOG(argc, argv)
+
+    try
+    {
+        if (argc>1 && !strcmp(argv[1],"-v")) os_ = &cout;
+        testRead();
+        testParallelIndex();
+        testPersistIndex();
+    }
+    catch (exception& e)
+    {
+        TEST_FAILED(e.what())
+    }
+    catch (...)
+    {
+        TEST_FAILED("Caught unknown exception.")
+    }
+
+    TEST_EPILOG
+}
@@ -61,9 +61,9 @@ void readFile(const string& uri, ProteomeData& pd, const Reader& reader)
 } // namespace
 
 
-PWIZ_API_DECL ProteomeDataFile::ProteomeDataFile(const string& uri, bool indexed)
+PWIZ_API_DECL ProteomeDataFile::ProteomeDataFile(const string& uri, bool indexed, bool memoryMap)
 {
-    readFile(uri, *this, DefaultReaderList(indexed));
+    readFile(uri, *this, DefaultReaderList(indexed, memoryMap));
 }
 
 
@@ -40,7 +40,8 @@ struct PWIZ_API_DECL ProteomeDataFile : public ProteomeData
 {
     /// constructs ProteomeData object backed by file;
     /// indexed==true -> uses DefaultReaderList with indexing
-    ProteomeDataFile(const std::string& uri, bool indexed = false);
+    /// memoryMap==true -> reads uncompressed FASTA through a memory mapping
+    ProteomeDataFile(const std::string& uri, bool indexed = false, bool memoryMap = false);
 
     /// constructs ProteomeData object backed by file using the specified reader
     ProteomeDataFile(const std::string& uri, const Reader& reader);
@@ -24,10 +24,12 @@
 
 #include "Reader_FASTA.hpp"
 #include "Serializer_FASTA.hpp"
+#include "ProteinList_MappedFASTA.hpp"
 #include "pwiz/data/common/BinaryIndexStream.hpp"
 #include "pwiz/utility/misc/Filesystem.hpp"
 #include "pwiz/utility/misc/Std.hpp"
 #include "pwiz/utility/misc/SHA1Calculator.hpp"
+#include "pwiz/utility/misc/random_access_compressed_ifstream.hpp"
 #include <boost/iostreams/copy.hpp>
 
 
@@ -112,6 +114,23 @@ PWIZ_API_DECL void Reader_FASTA::read(const std::string& uri, shared_ptr<istream
 {
     result.id = uri;
 
+    random_access_compressed_ifstream* racis = dynamic_cast<random_access_compressed_ifstream*>(uriStreamPtr.get());
+    if (config_.memoryMap && racis && racis->getCompressionType() == random_access_compressed_ifstream::NONE)
+    {
+        try
+        {
+            ProteinList_MappedFASTA::Config listConfig;
+            listConfig.persistIndex = config_.indexed;
+            result.proteinListPtr.reset(new ProteinList_MappedFASTA(uri, listConfig));
+            return;
+        }
+        catch (exception&)
+        {
+            // e.g. no address space for it in a 32-bit process: read through the stream,
+            // which also reports any errors in the file itself
+        }
+    }
+
     Serializer_FASTA::Config config;
     if (config_.indexed) // override default MemoryIndex with a BinaryIndexStream
     {
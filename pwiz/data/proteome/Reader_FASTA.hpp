@@ -45,7 +45,11 @@ class PWIZ_API_DECL Reader_FASTA : public Reader
         /// read with a side-by-side index
         bool indexed;
 
-        Config() {}
+        /// read an uncompressed file through a read-only memory mapping (see ProteinList_MappedFASTA);
+        /// with indexed, its index is persisted instead of the stream index
+        bool memoryMap;
+
+        Config() : indexed(false), memoryMap(false) {}
     };
 
     /// constructor
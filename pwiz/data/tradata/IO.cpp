@@ -220,7 +220,9 @@ struct HandlerCVParam : public SAXParser::Handler
         if (!accession.empty())
             cvParam->cvid = cvTermInfo(accession).cvid;
 
-        getAttribute(attributes, "value", cvParam->value);
+        string value;
+        getAttribute(attributes, "value", value);
+        cvParam->setValue(value);
 
         string unitAccession;
         getAttribute(attributes, "unitAccession", unitAccession);
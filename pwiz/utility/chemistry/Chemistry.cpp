@@ -162,63 +162,89 @@ PWIZ_API_DECL ostream& operator<<(ostream& os, const Info::Record& r)
 
 // Formula implementation
 
-class Formula::Impl
-{
-    public:
 
-    Impl(const string& formula);
+namespace {
 
-    inline void calculateMasses()
-    {
-        if (dirty)
-        {
-            dirty = false;
+// equal maps, except that zero counts are the same as missing elements
+bool equalCounts(const Formula::Map* lhs, const Formula::Map* rhs)
+{
+    static const Formula::Map empty;
+    if (!lhs) lhs = &empty;
+    if (!rhs) rhs = &empty;
 
-            monoMass = avgMass = 0;
-            for (size_t i=0; i <= size_t(Element::_15N); ++i)
-            {
-                int count = CHONSP_data[i];
-                if (count != 0)
-                {
-                    const Element::Info::Record& r = Element::Info::record(Element::Type(i));
-                    if (!r.isotopes.empty())
-                        monoMass += r.monoisotope.mass * count;
-                    avgMass += r.atomicWeight * count;
-                }
-            }
+    Formula::Map::const_iterator itr = lhs->begin(), thatItr = rhs->begin();
+    while (true)
+    {
+        while (itr != lhs->end() && itr->second == 0) ++itr;
+        while (thatItr != rhs->end() && thatItr->second == 0) ++thatItr;
 
-            vector<Data::iterator> zeroElements;
-            for (Data::iterator it=data.begin(); it!=data.end(); ++it)
-            {
-                if (it->second == 0)
-                    zeroElements.push_back(it);
-                else
-                {
-                    const Element::Info::Record& r = Element::Info::record(it->first);
-                    if (!r.isotopes.empty())
-                        monoMass += r.monoisotope.mass * it->second;
-                    avgMass += r.atomicWeight * it->second;
-                }
-            }
+        if (itr == lhs->end() || thatItr == rhs->end())
+            return itr == lhs->end() && thatItr == rhs->end();
 
-            for (size_t i=0; i < zeroElements.size(); ++i)
-                data.erase(zeroElements[i]);
-        }
+        if (itr->first != thatItr->first || itr->second != thatItr->second)
+            return false;
+        ++itr, ++thatItr;
     }
+}
 
-    typedef map<Element::Type, int> Data;
-    Data data;
-    vector<int> CHONSP_data;
-    double monoMass;
-    double avgMass;
-    bool dirty; // true if masses need updating
-};
+void eraseZeroCounts(Formula::Map& data)
+{
+    for (Formula::Map::iterator it=data.begin(); it!=data.end();)
+        if (it->second == 0)
+            data.erase(it++);
+        else
+            ++it;
+}
+
+} // namespace
+
+
+PWIZ_API_DECL Formula::Formula(const string& formula)
+:   dataExposed_(false), monoMass_(0), avgMass_(0), dirty_(false)
+{
+    parse(formula);
+}
+
+PWIZ_API_DECL Formula::Formula(const char* formula)
+:   dataExposed_(false), monoMass_(0), avgMass_(0), dirty_(false)
+{
+    parse(formula);
+}
+
+PWIZ_API_DECL Formula::Formula(const Formula& formula)
+:   data_(formula.dataExposed_ ? boost::shared_ptr<Map>(new Map(*formula.data_)) : formula.data_),
+    dataExposed_(false),
+    monoMass_(formula.monoMass_), avgMass_(formula.avgMass_), dirty_(formula.dirty_)
+{
+    copy(formula.CHONSP_data_, formula.CHONSP_data_ + CHONSPSize, CHONSP_data_);
+}
+
+
+PWIZ_API_DECL const Formula& Formula::operator=(const Formula& formula)
+{
+    if (this == &formula)
+        return *this;
+
+    copy(formula.CHONSP_data_, formula.CHONSP_data_ + CHONSPSize, CHONSP_data_);
+    if (formula.dataExposed_)
+        data_.reset(new Map(*formula.data_));
+    else
+        data_ = formula.data_;
+    dataExposed_ = false;
+    monoMass_ = formula.monoMass_;
+    avgMass_ = formula.avgMass_;
+    dirty_ = formula.dirty_;
+    return *this;
+}
 
 
-Formula::Impl::Impl(const string& formula)
-:   monoMass(0), avgMass(0), dirty(false)
+PWIZ_API_DECL Formula::~Formula()
+{}
+
+
+void Formula::parse(const string& formula)
 {
-    CHONSP_data.resize(size_t(Element::_15N)+1, 0);
+    std::fill(CHONSP_data_, CHONSP_data_ + CHONSPSize, 0);
 
     if (formula.empty())
         return;
@@ -238,7 +264,7 @@ Formula::Impl::Impl(const string& formula)
     {
         string::size_type indexTypeBegin = formula.find_first_of(symbolLeads_, index);
         if (indexTypeBegin == string::npos)
-            throw runtime_error("[Formula::Impl::Impl()] Invalid formula: " + formula);
+            throw runtime_error("[Formula::parse()] Invalid formula: " + formula);
         string::size_type indexTypeEnd = indexTypeBegin;
         if (formula[indexTypeBegin] == '_')
         {
@@ -278,61 +304,73 @@ Formula::Impl::Impl(const string& formula)
             }
             catch(bad_lexical_cast&)
             {
-                throw runtime_error("[Formula::Impl::Impl()] Invalid count in formula: " + formula);
+                throw runtime_error("[Formula::parse()] Invalid count in formula: " + formula);
             }
         }
 
         Element::Type type = Element::text2enum(symbol);
         if (type > Element::_15N)
-            data[type] = count;
+            mutableData()[type] = count;
         else
-            CHONSP_data[size_t(type)] = count;
+            CHONSP_data_[size_t(type)] = count;
 
         index = formula.find_first_not_of(whitespace_, indexCountEnd);
-
-        const Element::Info::Record& r = Element::Info::record(type);
-        if (!r.isotopes.empty())
-            monoMass += r.monoisotope.mass * count;
-        avgMass += r.atomicWeight * count;
     }
-}
 
+    if (data_.get())
+        eraseZeroCounts(*data_);
+    dirty_ = true;
+}
 
-PWIZ_API_DECL Formula::Formula(const string& formula)
-:   impl_(new Impl(formula))
-{}
 
-PWIZ_API_DECL Formula::Formula(const char* formula)
-:   impl_(new Impl(formula))
-{}
-
-PWIZ_API_DECL Formula::Formula(const Formula& formula)
-:   impl_(new Impl(*formula.impl_))
-{}
+Formula::Map& Formula::mutableData()
+{
+    if (!data_.get())
+        data_.reset(new Map);
+    else if (data_.use_count() > 1)
+        data_.reset(new Map(*data_)); // copy on write
+    return *data_;
+}
 
 
-PWIZ_API_DECL const Formula& Formula::operator=(const Formula& formula)
+void Formula::calculateMasses() const
 {
-    *impl_ = *formula.impl_;
-    return *this;
-}
+    if (!dirty_)
+        return;
+    dirty_ = false;
 
+    monoMass_ = avgMass_ = 0;
+    for (size_t i=0; i < CHONSPSize; ++i)
+    {
+        monoMass_ += detail::CHONSP_monoisotopicMass[i] * CHONSP_data_[i];
+        avgMass_ += detail::CHONSP_atomicWeight[i] * CHONSP_data_[i];
+    }
 
-PWIZ_API_DECL Formula::~Formula()
-{} // auto destruction of impl_
+    if (!data_.get())
+        return;
+
+    for (Map::const_iterator it=data_->begin(); it!=data_->end(); ++it)
+        if (it->second != 0)
+        {
+            const Element::Info::Record& r = Element::Info::record(it->first);
+            if (!r.isotopes.empty())
+                monoMass_ += r.monoisotope.mass * it->second;
+            avgMass_ += r.atomicWeight * it->second;
+        }
+}
 
 
 PWIZ_API_DECL double Formula::monoisotopicMass() const
 {
-    impl_->calculateMasses();
-    return impl_->monoMass;
+    calculateMasses();
+    return monoMass_;
 }
 
 
 PWIZ_API_DECL double Formula::molecularWeight() const
 {
-    impl_->calculateMasses();
-    return impl_->avgMass;
+    calculateMasses();
+    return avgMass_;
 }
 
 
@@ -341,22 +379,23 @@ PWIZ_API_DECL string Formula::formula() const
     // collect a term for each element
     vector<string> terms;
 
-    for (size_t i=0; i <= size_t(Element::_15N); ++i)
+    for (size_t i=0; i < CHONSPSize; ++i)
     {
-        int count = impl_->CHONSP_data[i];
+        int count = CHONSP_data_[i];
         ostringstream term;
         if (count != 0)
             term << Element::Type(i) << count;
         terms.push_back(term.str());
     }
 
-    for (Impl::Data::const_iterator it=impl_->data.begin(); it!=impl_->data.end(); ++it)
-    { 
-        ostringstream term;
-        if (it->second != 0)
-            term << it->first << it->second;
-        terms.push_back(term.str());
-    }
+    if (data_.get())
+        for (Map::const_iterator it=data_->begin(); it!=data_->end(); ++it)
+        { 
+            ostringstream term;
+            if (it->second != 0)
+                term << it->first << it->second;
+            terms.push_back(term.str());
+        }
 
     // sort alphabetically and return the concatenation
     sort(terms.begin(), terms.end());
@@ -366,29 +405,41 @@ PWIZ_API_DECL string Formula::formula() const
 
 PWIZ_API_DECL int Formula::operator[](Element::Type e) const
 {
-    if (e > Element::_15N)
-        return impl_->data[e];
-    else
-        return impl_->CHONSP_data[e];
+    if (e <= Element::_15N)
+        return CHONSP_data_[e];
+
+    if (!data_.get())
+        return 0;
+    Map::const_iterator itr = data_->find(e);
+    return itr == data_->end() ? 0 : itr->second;
 }
 
 
 PWIZ_API_DECL int& Formula::operator[](Element::Type e)
 {
-    impl_->dirty = true; // worst-case
+    dirty_ = true; // worst-case
     if (e > Element::_15N)
-        return impl_->data[e];
+    {
+        Map& data = mutableData();
+        dataExposed_ = true; // the caller may keep the reference, so data_ must not be shared from now on
+        return data[e];
+    }
     else
-        return impl_->CHONSP_data[e];
+        return CHONSP_data_[e];
 }
 
 
 PWIZ_API_DECL map<Element::Type, int> Formula::data() const
 {
-    map<Element::Type, int> dataCopy(impl_->data);
-    for (size_t i=0; i <= size_t(Element::_15N); ++i)
+    map<Element::Type, int> dataCopy;
+    if (data_.get())
+        for (Map::const_iterator it=data_->begin(); it!=data_->end(); ++it)
+            if (it->second != 0)
+                dataCopy.insert(dataCopy.end(), *it);
+
+    for (size_t i=0; i < CHONSPSize; ++i)
     {
-        int count = impl_->CHONSP_data[i];
+        int count = CHONSP_data_[i];
         if (count != 0)
             dataCopy[Element::Type(i)] = count;
     }
@@ -398,92 +449,59 @@ PWIZ_API_DECL map<Element::Type, int> Formula::data() const
 
 PWIZ_API_DECL Formula& Formula::operator+=(const Formula& that)
 {
-    impl_->CHONSP_data[0] += that.impl_->CHONSP_data[0];
-    impl_->CHONSP_data[1] += that.impl_->CHONSP_data[1];
-    impl_->CHONSP_data[2] += that.impl_->CHONSP_data[2];
-    impl_->CHONSP_data[3] += that.impl_->CHONSP_data[3];
-    impl_->CHONSP_data[4] += that.impl_->CHONSP_data[4];
-    impl_->CHONSP_data[5] += that.impl_->CHONSP_data[5];
-    impl_->CHONSP_data[6] += that.impl_->CHONSP_data[6];
-    impl_->CHONSP_data[7] += that.impl_->CHONSP_data[7];
-    impl_->CHONSP_data[8] += that.impl_->CHONSP_data[8];
-    impl_->CHONSP_data[9] += that.impl_->CHONSP_data[9];
-
-    for (Map::const_iterator it=that.impl_->data.begin(); it!=that.impl_->data.end(); ++it)
-        impl_->data[it->first] += it->second;
-    impl_->dirty = true;
+    for (size_t i=0; i < CHONSPSize; ++i)
+        CHONSP_data_[i] += that.CHONSP_data_[i];
+
+    if (that.data_.get())
+    {
+        Map& data = mutableData();
+        for (Map::const_iterator it=that.data_->begin(); it!=that.data_->end(); ++it)
+            data[it->first] += it->second;
+        eraseZeroCounts(data);
+    }
+    dirty_ = true;
     return *this;
 }
 
 
 PWIZ_API_DECL Formula& Formula::operator-=(const Formula& that)
 {
-    impl_->CHONSP_data[0] -= that.impl_->CHONSP_data[0];
-    impl_->CHONSP_data[1] -= that.impl_->CHONSP_data[1];
-    impl_->CHONSP_data[2] -= that.impl_->CHONSP_data[2];
-    impl_->CHONSP_data[3] -= that.impl_->CHONSP_data[3];
-    impl_->CHONSP_data[4] -= that.impl_->CHONSP_data[4];
-    impl_->CHONSP_data[5] -= that.impl_->CHONSP_data[5];
-    impl_->CHONSP_data[6] -= that.impl_->CHONSP_data[6];
-    impl_->CHONSP_data[7] -= that.impl_->CHONSP_data[7];
-    impl_->CHONSP_data[8] -= that.impl_->CHONSP_data[8];
-    impl_->CHONSP_data[9] -= that.impl_->CHONSP_data[9];
-
-    for (Map::const_iterator it=that.impl_->data.begin(); it!=that.impl_->data.end(); ++it)
-        impl_->data[it->first] -= it->second;
-    impl_->dirty = true;
+    for (size_t i=0; i < CHONSPSize; ++i)
+        CHONSP_data_[i] -= that.CHONSP_data_[i];
+
+    if (that.data_.get())
+    {
+        Map& data = mutableData();
+        for (Map::const_iterator it=that.data_->begin(); it!=that.data_->end(); ++it)
+            data[it->first] -= it->second;
+        eraseZeroCounts(data);
+    }
+    dirty_ = true;
     return *this;
 }
 
 
 PWIZ_API_DECL Formula& Formula::operator*=(int scalar)
 {
-    impl_->CHONSP_data[0] *= scalar;
-    impl_->CHONSP_data[1] *= scalar;
-    impl_->CHONSP_data[2] *= scalar;
-    impl_->CHONSP_data[3] *= scalar;
-    impl_->CHONSP_data[4] *= scalar;
-    impl_->CHONSP_data[5] *= scalar;
-    impl_->CHONSP_data[6] *= scalar;
-    impl_->CHONSP_data[7] *= scalar;
-    impl_->CHONSP_data[8] *= scalar;
-    impl_->CHONSP_data[9] *= scalar;
-
-    for (Map::iterator it=impl_->data.begin(); it!=impl_->data.end(); ++it)
-        it->second *= scalar;
-    impl_->dirty = true;
+    for (size_t i=0; i < CHONSPSize; ++i)
+        CHONSP_data_[i] *= scalar;
+
+    if (data_.get())
+    {
+        Map& data = mutableData();
+        for (Map::iterator it=data.begin(); it!=data.end(); ++it)
+            it->second *= scalar;
+        eraseZeroCounts(data);
+    }
+    dirty_ = true;
     return *this;
 }
 
 
 PWIZ_API_DECL bool Formula::operator==(const Formula& that) const
 {
-    if (impl_->CHONSP_data[0] != that.impl_->CHONSP_data[0] ||
-        impl_->CHONSP_data[1] != that.impl_->CHONSP_data[1] ||
-        impl_->CHONSP_data[2] != that.impl_->CHONSP_data[2] ||
-        impl_->CHONSP_data[3] != that.impl_->CHONSP_data[3] ||
-        impl_->CHONSP_data[4] != that.impl_->CHONSP_data[4] ||
-        impl_->CHONSP_data[5] != that.impl_->CHONSP_data[5] ||
-        impl_->CHONSP_data[6] != that.impl_->CHONSP_data[6] ||
-        impl_->CHONSP_data[7] != that.impl_->CHONSP_data[7] ||
-        impl_->CHONSP_data[8] != that.impl_->CHONSP_data[8] ||
-        impl_->CHONSP_data[9] != that.impl_->CHONSP_data[9])
-        return false;
-
-    impl_->calculateMasses(); // will remove zero-count elements from data map
-    that.impl_->calculateMasses();
-
-    if (impl_->data.size() != that.impl_->data.size())
-        return false;
-
-    Map::const_iterator itr, thatItr;
-    for (itr = impl_->data.begin(), thatItr = that.impl_->data.begin();
-         itr != impl_->data.end();
-         ++itr, ++thatItr)
-         // equal maps are pairwise equal for both elements of the pair
-         if (itr->first != thatItr->first || itr->second != thatItr->second)
-             return false;
-    return true;
+    return std::equal(CHONSP_data_, CHONSP_data_ + CHONSPSize, that.CHONSP_data_) &&
+           (data_ == that.data_ || equalCounts(data_.get(), that.data_.get()));
 }
 
 
@@ -29,6 +29,7 @@
 #include <iosfwd>
 #include <string>
 #include <vector>
+#include <map>
 #include "pwiz/utility/misc/virtual_map.hpp"
 #include <boost/shared_ptr.hpp>
 
@@ -127,9 +128,9 @@ PWIZ_API_DECL std::ostream& operator<<(std::ostream& os, const Info::Record& rec
 } // namespace Element
 
 
-class CompositionMap;
-
-/// class to represent a chemical formula
+/// class to represent a chemical formula;
+/// C, H, O, N, S, P and their heavy isotopes are counted in place, so formulas of
+/// peptides and their fragments can be copied and added without heap allocation
 class PWIZ_API_DECL Formula
 {
     public:
@@ -163,8 +164,27 @@ class PWIZ_API_DECL Formula
     bool operator!=(const Formula& that) const;
     
     private:
-    class Impl;
-    boost::shared_ptr<Impl> impl_;
+
+    /// the number of elements counted in place: Element::C to Element::_15N
+    enum {CHONSPSize = Element::_15N + 1};
+
+    int CHONSP_data_[CHONSPSize];
+
+    /// counts of the other elements, if there are any;
+    /// shared by copies of the formula until one of them changes it
+    boost::shared_ptr<Map> data_;
+
+    /// true once operator[] has returned a reference into data_; such a map is copied instead of
+    /// shared, since a write through the reference would also change the copies sharing it
+    bool dataExposed_;
+
+    mutable double monoMass_;
+    mutable double avgMass_;
+    mutable bool dirty_; // true if masses need updating
+
+    void parse(const std::string& formula);
+    Map& mutableData();
+    void calculateMasses() const;
 };
 
 
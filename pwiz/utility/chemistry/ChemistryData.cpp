@@ -531,6 +531,20 @@ PWIZ_API_DECL int elementsSize()
 }
 
 
+// C, H, O, N, S, P, _13C, _2H, _18O, _15N
+PWIZ_API_DECL const double CHONSP_monoisotopicMass[] =
+{
+    12, 1.0078250321, 15.9949146221, 14.0030740052, 31.97207069, 30.97376151,
+    13.0033548378, 2.014101778, 17.9991604, 15.0001088984
+};
+
+PWIZ_API_DECL const double CHONSP_atomicWeight[] =
+{
+    12.0107, 1.00794, 15.9994, 14.0067, 32.065, 30.973761,
+    13.0033548378, 2.014101778, 17.9991604, 15.0001088984
+};
+
+
 } // namespace detail
 } // namespace chemistry
 } // namespace pwiz
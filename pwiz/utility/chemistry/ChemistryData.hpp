@@ -60,6 +60,12 @@ PWIZ_API_DECL Element* elements();
 PWIZ_API_DECL int elementsSize();
 
 
+/// monoisotopic masses and atomic weights of the elements from C to _15N, in Element::Type order;
+/// these are the masses in elements(), as constants for Formula's mass calculations
+PWIZ_API_DECL extern const double CHONSP_monoisotopicMass[];
+PWIZ_API_DECL extern const double CHONSP_atomicWeight[];
+
+
 } // namespace detail
 } // namespace chemistry
 } // namespace pwiz
@@ -23,6 +23,7 @@
 
 #include "pwiz/utility/misc/unit.hpp"
 #include "Chemistry.hpp"
+#include "ChemistryData.hpp"
 #include "Ion.hpp"
 #include "pwiz/utility/math/round.hpp"
 #include <cstring>
@@ -161,6 +162,49 @@ void testFormulaOperations()
     a = water + water;
     unit_assert(a[H]==4 && a[O]==2);
     if (os_) *os_ << "water: " << a-water << endl;
+
+    // elements outside CHONSP are shared by copies until one of them changes
+    Formula b("C2 Se1 Fe2");
+    Formula c = b;
+    c[Fe] += 1;
+    unit_assert(b[Fe]==2 && c[Fe]==3);
+    c += b;
+    unit_assert(c[C]==4 && c[Se]==2 && c[Fe]==5);
+    unit_assert(b[C]==2 && b[Se]==1 && b[Fe]==2);
+    c -= b*2;
+    unit_assert(c[C]==0 && c[Se]==0 && c[Fe]==1);
+    unit_assert(c == Formula("Fe1"));
+    unit_assert(c != b);
+    unit_assert_operator_equal(1, c.data().size());
+    unit_assert_equal(Element::Info::record(Fe).monoisotope.mass, c.monoisotopicMass(), 1e-10);
+    c[Fe] = 0;
+    unit_assert(c == Formula());
+    unit_assert_operator_equal("", c.formula());
+
+    // a reference from operator[] only changes its own formula, even after copies are made
+    Formula d("C1 Se1");
+    int& dSe = d[Se];
+    Formula e = d, f;
+    f = d;
+    dSe = 3;
+    unit_assert(d[Se]==3 && e[Se]==1 && f[Se]==1);
+    e[Se] += 1;
+    unit_assert(d[Se]==3 && e[Se]==2 && f[Se]==1);
+    const Formula& self = f;
+    f = self;
+    unit_assert(f[Se]==1);
+}
+
+
+void testCHONSPMasses()
+{
+    // Formula's constant masses must match the element records
+    for (int i=Element::C; i <= Element::_15N; ++i)
+    {
+        const Element::Info::Record& r = Element::Info::record(Element::Type(i));
+        unit_assert_operator_equal(r.monoisotope.mass, detail::CHONSP_monoisotopicMass[i]);
+        unit_assert_operator_equal(r.atomicWeight, detail::CHONSP_atomicWeight[i]);
+    }
 }
 
 
@@ -220,6 +264,7 @@ void testThreadSafetyWorker(boost::barrier* testBarrier, int& result)
         testMassAbundance();
         testFormula();
         testFormulaOperations();
+        testCHONSPMasses();
         testInfo();
         infoExample();
         testPolysiloxane();
@@ -253,6 +253,13 @@ class HandlerWrangler : public SAXParser::Handler
         return status;
     }
 
+    virtual Status charactersInPlace(const char* begin, const char* end, stream_offset position)
+    {
+        Status status = topHandler().charactersInPlace(begin, end, position);
+        verifyNoDelegate(status);
+        return status;
+    }
+
     const Handler& topHandler() const {return handlers_.top().handler;}
     Handler& topHandler() {return handlers_.top().handler;}
 
@@ -452,6 +459,29 @@ static bool getline(istream& is, saxstring &vec, char delim, bool append = false
     return false;
 }
 
+// getline for a RegionStreambuf: find the delimiter in place and copy just once
+static bool getline(RegionStreambuf& region, saxstring &vec, char delim, bool append = false) 
+{
+    const char *begin = region.current();
+    const char *found = (const char *) memchr(begin, delim, region.end()-begin);
+    if (!found) 
+    {
+        region.advance(region.end());
+        return false;
+    }
+    size_t oldlen = append?vec.length():0;
+    vec.resize(oldlen + (found-begin));
+    if (found != begin)
+        memcpy(&vec[oldlen], begin, found-begin);
+    region.advance(found+1); // eat the delimiter
+    return true;
+}
+
+static bool getline(istream& is, RegionStreambuf* region, saxstring &vec, char delim, bool append = false) 
+{
+    return region ? getline(*region, vec, delim, append) : getline(is, vec, delim, append);
+}
+
 //
 // parse() responsibilities: 
 // - stream parsing
@@ -465,7 +495,8 @@ PWIZ_API_DECL void parse(istream& is, Handler& handler)
     using boost::iostreams::position_to_offset;
 
     HandlerWrangler wrangler(handler);
-    Handler::stream_offset position = position_to_offset(is.tellg());
+    RegionStreambuf* region = dynamic_cast<RegionStreambuf*>(is.rdbuf());
+    Handler::stream_offset position = region ? region->offset() : position_to_offset(is.tellg());
     saxstring buffer(16384); // hopefully big enough to avoid realloc
 
     while (is)
@@ -473,27 +504,50 @@ PWIZ_API_DECL void parse(istream& is, Handler& handler)
 
         // read text up to next tag (may be empty)
         buffer.clear();
-        if (!getline(is, buffer, '<')) break;
-        size_t lead_ws = buffer.trim_lead_ws(); 
-        // remove trailing ws
-        buffer.trim_trail_ws();
-        // position == beginning of characters
+        if (region && !wrangler.topHandler().autoUnescapeCharacters)
+        {
+            // hand text over in place (or not at all, if the handler doesn't want it)
+            const char *begin = region->current();
+            const char *end = (const char *) memchr(begin, '<', region->end()-begin);
+            if (!end) break;
+            region->advance(end+1);
+
+            const char *text = begin;
+            while (text < end && *text && strchr(ws, *text)) 
+                ++text;
+            end -= count_trail_ws(text, end-text);
+            position += text-begin;
+
+            if (text != end && wrangler.topHandler().parseCharacters)
+            {
+                Handler::Status status = wrangler.charactersInPlace(text, end, position);
+                if (status.flag == Handler::Status::Done) return;
+            }
+        }
+        else
+        {
+            if (!getline(is, region, buffer, '<')) break;
+            size_t lead_ws = buffer.trim_lead_ws(); 
+            // remove trailing ws
+            buffer.trim_trail_ws();
+            // position == beginning of characters
 
-        position += lead_ws; 
+            position += lead_ws; 
 
-        // TODO: is it possible to detect when Handler::characters() has been overridden?
-        const Handler& topHandler = wrangler.topHandler();
-        if (buffer.length() && topHandler.parseCharacters)
-        {
-            if (topHandler.autoUnescapeCharacters)
-                buffer.unescapeXML();
-            Handler::Status status = wrangler.characters(buffer, position);
-            if (status.flag == Handler::Status::Done) return;
+            // TODO: is it possible to detect when Handler::characters() has been overridden?
+            const Handler& topHandler = wrangler.topHandler();
+            if (buffer.length() && topHandler.parseCharacters)
+            {
+                if (topHandler.autoUnescapeCharacters)
+                    buffer.unescapeXML();
+                Handler::Status status = wrangler.characters(buffer, position);
+                if (status.flag == Handler::Status::Done) return;
+            }
         }
 
         // position == beginning of tag
 
-        position = position_to_offset(is.tellg());
+        position = region ? region->offset() : position_to_offset(is.tellg());
         if (position > 0) position--;
 
         // read tag
@@ -504,7 +558,7 @@ PWIZ_API_DECL void parse(istream& is, Handler& handler)
         while (true)
         {
             bool firstpass = (!buffer.length());
-            if (!getline(is,buffer, '>',true))  // append
+            if (!getline(is, region, buffer, '>',true))  // append
                 break;
             if (firstpass) 
                 buffer.trim_lead_ws();
@@ -572,11 +626,45 @@ PWIZ_API_DECL void parse(istream& is, Handler& handler)
         }
 
         // position == after tag end
-        position = position_to_offset(is.tellg());
+        position = region ? region->offset() : position_to_offset(is.tellg());
     }
 }
 
 
+PWIZ_API_DECL RegionStreambuf::RegionStreambuf(const char* begin, const char* end, boost::iostreams::stream_offset beginOffset)
+:   beginOffset_(beginOffset)
+{
+    setg(const_cast<char*>(begin), const_cast<char*>(begin), const_cast<char*>(end));
+}
+
+
+PWIZ_API_DECL RegionStreambuf::pos_type RegionStreambuf::seekoff(off_type off, std::ios_base::seekdir way, std::ios_base::openmode which)
+{
+    if (!(which & std::ios_base::in))
+        return pos_type(off_type(-1));
+
+    off_type pos;
+    if (way == std::ios_base::beg)
+        pos = off - beginOffset_;
+    else if (way == std::ios_base::cur)
+        pos = (gptr() - eback()) + off;
+    else
+        pos = (egptr() - eback()) + off;
+
+    if (pos < 0 || pos > egptr() - eback())
+        return pos_type(off_type(-1));
+
+    setg(eback(), eback() + pos, egptr());
+    return pos_type(beginOffset_ + pos);
+}
+
+
+PWIZ_API_DECL RegionStreambuf::pos_type RegionStreambuf::seekpos(pos_type pos, std::ios_base::openmode which)
+{
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
+
 } // namespace SAXParser
 
 
@@ -33,6 +33,7 @@
 #include "boost/iostreams/positioning.hpp"
 #include <string.h>
 #include <iosfwd>
+#include <streambuf>
 #include <string>
 #include <vector>
 #include <assert.h>
@@ -596,6 +597,18 @@ class Handler
     virtual Status characters(const SAXParser::saxstring& text,
                               stream_offset position) {return Status::Ok;}
 
+    /// Called instead of characters() when parse() can hand over the (whitespace-trimmed)
+    /// text without copying it: when reading from a RegionStreambuf, for handlers with
+    /// autoUnescapeCharacters off.  Handlers of bulk data (e.g. base64) may override this
+    /// to consume the text in place; by default it is copied and passed to characters().
+    virtual Status charactersInPlace(const char* begin, const char* end,
+                                     stream_offset position)
+    {
+        SAXParser::saxstring text(end - begin);
+        if (begin != end) memcpy(text.data(), begin, end - begin);
+        return characters(text, position);
+    }
+
     Handler() : parseCharacters(false), autoUnescapeAttributes(true), autoUnescapeCharacters(true), version(0) {}
     virtual ~Handler(){}
 
@@ -693,6 +706,33 @@ class Handler
 PWIZ_API_DECL void parse(std::istream& is, Handler& handler);
 
 
+///
+/// Read-only streambuf over a region of memory, e.g. part of a memory-mapped file;
+/// positions are reported as offsets into the file the region came from, so handlers
+/// see the same positions as when parsing the file itself.  parse() scans an istream
+/// over a RegionStreambuf in place rather than reading it through the stream interface.
+///
+class PWIZ_API_DECL RegionStreambuf : public std::streambuf
+{
+    public:
+
+    RegionStreambuf(const char* begin, const char* end, boost::iostreams::stream_offset beginOffset);
+
+    const char* current() const {return gptr();}
+    const char* end() const {return egptr();}
+    boost::iostreams::stream_offset offset() const {return beginOffset_ + (gptr() - eback());}
+    void advance(const char* to) {setg(eback(), const_cast<char*>(to), egptr());}
+
+    protected:
+
+    virtual pos_type seekoff(off_type off, std::ios_base::seekdir way, std::ios_base::openmode which);
+    virtual pos_type seekpos(pos_type pos, std::ios_base::openmode which);
+
+    private:
+    boost::iostreams::stream_offset beginOffset_;
+};
+
+
 } // namespace SAXParser
 
 
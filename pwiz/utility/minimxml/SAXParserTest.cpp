@@ -472,6 +472,56 @@ void testDone()
 }
 
 
+void testRegionStreambuf()
+{
+    if (os_) *os_ << "testRegionStreambuf()\n";
+
+    // same events at the same positions as parsing through the stream
+    string xml(sampleXML);
+    ostringstream streamEvents, regionEvents;
+    {
+        istringstream is(xml);
+        PrintEventHandler handler(streamEvents);
+        parse(is, handler);
+        parse(is, handler);
+    }
+    {
+        RegionStreambuf region(xml.c_str(), xml.c_str() + xml.size(), 0);
+        istream is(&region);
+        PrintEventHandler handler(regionEvents);
+        parse(is, handler);
+        parse(is, handler);
+    }
+    unit_assert_operator_equal(streamEvents.str(), regionEvents.str());
+
+    // without unescaping, text goes through charactersInPlace()
+    {
+        RegionStreambuf region(xml.c_str(), xml.c_str() + xml.size(), 0);
+        istream is(&region);
+        Root root;
+        RootHandler rootHandler(root, false, false);
+        parse(is, rootHandler);
+        unit_assert_operator_equal("Some Text with Entity References: &lt;&amp;&gt;", root.first.text);
+        unit_assert_operator_equal(4, root.second.text.size());
+        unit_assert_operator_equal("Post-text.", root.second.text[3]);
+    }
+
+    // positions are file offsets, and the stream is left just past the parsed element
+    {
+        string::size_type anotherRoot = xml.find("<AnotherRoot>");
+        RegionStreambuf region(xml.c_str() + anotherRoot - 6, xml.c_str() + xml.size(), anotherRoot - 6);
+        istream is(&region);
+        AnotherRootHandler handler;
+        parse(is, handler);
+
+        string buffer;
+        getline(is, buffer, '<');
+        unit_assert_operator_equal("The quick brown fox jumps over the lazy dog.", buffer);
+        unit_assert_operator_equal(xml.find("</AnotherRoot>") + 1, (size_t) is.tellg());
+    }
+}
+
+
 void testBadXML()
 {
     if (os_) *os_ << "testBadXML()\n";
@@ -594,6 +644,7 @@ int main(int argc, char* argv[])
         test();
         testNoAutoUnescape();
         testDone();
+        testRegionStreambuf();
         testBadXML();
         testNested();
         testRootElement();
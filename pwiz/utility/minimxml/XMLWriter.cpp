@@ -87,6 +87,8 @@ class XMLWriter::Impl
     void characters(const string& text, bool autoEscape);
     bio::stream_offset position() const;
     bio::stream_offset positionNext() const;
+    Config fragmentConfig() const;
+    void writeFragment(const string& xml);
 
     private:
     ostream& os_;
@@ -94,8 +96,8 @@ class XMLWriter::Impl
     stack<string> elementStack_;
     stack<unsigned int> styleStack_;
 
-    string indentation() const {return string(elementStack_.size()*config_.indentationStep, ' ');}
-    string indentation(size_t depth) const {return string(depth*config_.indentationStep, ' ');}
+    string indentation() const {return indentation(elementStack_.size());}
+    string indentation(size_t depth) const {return string((config_.initialDepth+depth)*config_.indentationStep, ' ');}
     bool style(StyleFlag styleFlag) const {return styleStack_.top() & styleFlag ? true : false;}
 };
 
@@ -288,6 +290,24 @@ XMLWriter::stream_offset XMLWriter::Impl::positionNext() const
 }
 
 
+XMLWriter::Config XMLWriter::Impl::fragmentConfig() const
+{
+    Config result = config_;
+    result.initialStyle = styleStack_.top();
+    result.initialDepth += elementStack_.size();
+    result.outputObserver = 0;
+    return result;
+}
+
+
+void XMLWriter::Impl::writeFragment(const string& xml)
+{
+    if (config_.outputObserver)
+        config_.outputObserver->update(xml);
+    os_ << xml;
+}
+
+
 //
 // XMLWriter forwarding functions 
 //
@@ -321,6 +341,10 @@ PWIZ_API_DECL XMLWriter::stream_offset XMLWriter::position() const {return impl_
 
 PWIZ_API_DECL XMLWriter::stream_offset XMLWriter::positionNext() const {return impl_->positionNext();}
 
+PWIZ_API_DECL XMLWriter::Config XMLWriter::fragmentConfig() const {return impl_->fragmentConfig();}
+
+PWIZ_API_DECL void XMLWriter::writeFragment(const string& xml) {impl_->writeFragment(xml);}
+
 
 namespace {
 
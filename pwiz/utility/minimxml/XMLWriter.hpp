@@ -70,10 +70,11 @@ class PWIZ_API_DECL XMLWriter
     {
         unsigned int initialStyle;
         unsigned int indentationStep;
+        unsigned int initialDepth; // nesting level of the first element (for writing fragments)
         OutputObserver* outputObserver;
 
         Config()
-        :   initialStyle(0), indentationStep(2), outputObserver(0)
+        :   initialStyle(0), indentationStep(2), initialDepth(0), outputObserver(0)
         {}
     };
 
@@ -128,6 +129,13 @@ class PWIZ_API_DECL XMLWriter
     /// returns stream position of next element start tag 
     stream_offset positionNext() const;
 
+    /// returns a configuration for a separate XMLWriter whose output can be
+    /// inserted at the current nesting level and style with writeFragment()
+    Config fragmentConfig() const;
+
+    /// writes an XML fragment verbatim (e.g. from an XMLWriter created with fragmentConfig())
+    void writeFragment(const std::string& xml);
+
 
     private:
     class Impl;
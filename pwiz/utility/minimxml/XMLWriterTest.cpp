@@ -186,6 +186,65 @@ void test()
     unit_assert(encode_xml_id(crazyId) == "_x0021__x0021__x0021_");
 }
 
+void writeRecord(XMLWriter& writer, const string& name, const string& quote)
+{
+    XMLWriter::Attributes attributes;
+    attributes.push_back(make_pair("name", name));
+    writer.startElement("record", attributes);
+        writer.pushStyle(XMLWriter::StyleFlag_InlineInner);
+        writer.startElement("quote");
+        writer.characters(quote);
+        writer.endElement();
+        writer.popStyle();
+    writer.endElement();
+}
+
+void testFragment()
+{
+    XMLWriter::Config config;
+    config.indentationStep = 4;
+
+    ostringstream direct;
+    {
+        XMLWriter writer(direct, config);
+        writer.startElement("root");
+        writeRecord(writer, "nixon", "I'm not a crook.");
+        writeRecord(writer, "bush", "Mission accomplished.");
+        writer.endElement();
+    }
+
+    ostringstream oss;
+    TestOutputObserver outputObserver;
+    config.outputObserver = &outputObserver;
+    XMLWriter writer(oss, config);
+    writer.startElement("root");
+
+    XMLWriter::Config fragmentConfig = writer.fragmentConfig();
+    unit_assert(fragmentConfig.outputObserver == 0);
+    unit_assert_operator_equal(1, fragmentConfig.initialDepth);
+
+    ostringstream fragment1, fragment2;
+    {
+        XMLWriter fragmentWriter(fragment1, fragmentConfig);
+        writeRecord(fragmentWriter, "nixon", "I'm not a crook.");
+    }
+    {
+        XMLWriter fragmentWriter(fragment2, fragmentConfig);
+        writeRecord(fragmentWriter, "bush", "Mission accomplished.");
+    }
+
+    XMLWriter::stream_offset recordPosition = writer.positionNext();
+    writer.writeFragment(fragment1.str());
+    writer.writeFragment(fragment2.str());
+    writer.endElement();
+
+    if (os_) *os_ << "testFragment():\n" << oss.str() << endl;
+
+    unit_assert_operator_equal(direct.str(), oss.str());
+    unit_assert_operator_equal(direct.str(), outputObserver.cache);
+    unit_assert_operator_equal("<record", oss.str().substr((size_t) recordPosition, 7));
+}
+
 void testNormalization()
 {
 #ifndef __APPLE__ // TODO: how to test that this works with Darwin's compiler?
@@ -207,6 +266,7 @@ int main(int argc, char* argv[])
     {
         if (argc>1 && !strcmp(argv[1],"-v")) os_ = &cout;
         test();
+        testFragment();
         testNormalization();
     }
     catch (exception& e)
@@ -26,6 +26,18 @@
 #include "pwiz/utility/misc/Std.hpp"
 #include <cmath>
 
+#if (defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))) || \
+    (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
+#define PWIZ_BASE64_SIMD
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define PWIZ_TARGET(isa)
+#else
+#define PWIZ_TARGET(isa) __attribute__((target(isa)))
+#endif
+#endif
+
 
 namespace pwiz {
 namespace util {
@@ -62,6 +74,137 @@ void initializeByteTable()
 }
 
 
+#ifdef PWIZ_BASE64_SIMD
+
+// The vector kernels translate a block of characters to 6-bit values with range compares,
+// then pack each 4 values into 3 bytes with multiply-adds and a byte shuffle.
+// They stop at the first block holding anything but the 64 alphabet characters ('=' padding,
+// whitespace, garbage) and leave the rest of the text to the scalar loop. Both write a few
+// bytes beyond the block they decode, so they only run while more text follows the block.
+
+enum SimdLevel {SimdLevel_None, SimdLevel_SSSE3, SimdLevel_AVX2};
+
+SimdLevel detectSimdLevel()
+{
+#ifdef _MSC_VER
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool ssse3 = (info[2] & (1 << 9)) != 0;
+    bool osAVX = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+    bool avx2 = false;
+    if (maxLeaf >= 7 && osAVX)
+    {
+        __cpuidex(info, 7, 0);
+        avx2 = (info[1] & (1 << 5)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    bool ssse3 = __builtin_cpu_supports("ssse3");
+    bool avx2 = __builtin_cpu_supports("avx2");
+#endif
+    return avx2 ? SimdLevel_AVX2 : ssse3 ? SimdLevel_SSSE3 : SimdLevel_None;
+}
+
+
+PWIZ_TARGET("ssse3")
+size_t textToBinarySSSE3(const byte*& it, const byte* end, byte*& result)
+{
+    const byte* start = it;
+    while (end - it >= 24)
+    {
+        __m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(it));
+
+        __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8('A'-1)), _mm_cmpgt_epi8(_mm_set1_epi8('Z'+1), in));
+        __m128i lower = _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8('a'-1)), _mm_cmpgt_epi8(_mm_set1_epi8('z'+1), in));
+        __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8('0'-1)), _mm_cmpgt_epi8(_mm_set1_epi8('9'+1), in));
+        __m128i plus = _mm_cmpeq_epi8(in, _mm_set1_epi8('+'));
+        __m128i slash = _mm_cmpeq_epi8(in, _mm_set1_epi8('/'));
+
+        __m128i valid = _mm_or_si128(_mm_or_si128(_mm_or_si128(upper, lower), _mm_or_si128(digit, plus)), slash);
+        if (_mm_movemask_epi8(valid) != 0xFFFF)
+            break;
+
+        __m128i shift = _mm_or_si128(_mm_or_si128(_mm_and_si128(upper, _mm_set1_epi8(-65)),
+                                                  _mm_and_si128(lower, _mm_set1_epi8(-71))),
+                                     _mm_or_si128(_mm_or_si128(_mm_and_si128(digit, _mm_set1_epi8(4)),
+                                                               _mm_and_si128(plus, _mm_set1_epi8(19))),
+                                                  _mm_and_si128(slash, _mm_set1_epi8(16))));
+        __m128i values = _mm_add_epi8(in, shift);
+
+        // [a b c d] -> a<<18 | b<<12 | c<<6 | d, then its 3 bytes big-end first
+        __m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+        merged = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+        __m128i packed = _mm_shuffle_epi8(merged, _mm_setr_epi8(2,1,0, 6,5,4, 10,9,8, 14,13,12, -1,-1,-1,-1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(result), packed);
+
+        it += 16;
+        result += 12;
+    }
+    return (it - start) / 4 * 3;
+}
+
+
+PWIZ_TARGET("avx2")
+size_t textToBinaryAVX2(const byte*& it, const byte* end, byte*& result)
+{
+    const byte* start = it;
+    while (end - it >= 48)
+    {
+        __m256i in = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(it));
+
+        __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(in, _mm256_set1_epi8('A'-1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('Z'+1), in));
+        __m256i lower = _mm256_and_si256(_mm256_cmpgt_epi8(in, _mm256_set1_epi8('a'-1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z'+1), in));
+        __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(in, _mm256_set1_epi8('0'-1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9'+1), in));
+        __m256i plus = _mm256_cmpeq_epi8(in, _mm256_set1_epi8('+'));
+        __m256i slash = _mm256_cmpeq_epi8(in, _mm256_set1_epi8('/'));
+
+        __m256i valid = _mm256_or_si256(_mm256_or_si256(_mm256_or_si256(upper, lower), _mm256_or_si256(digit, plus)), slash);
+        if (_mm256_movemask_epi8(valid) != -1)
+            break;
+
+        __m256i shift = _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(upper, _mm256_set1_epi8(-65)),
+                                                        _mm256_and_si256(lower, _mm256_set1_epi8(-71))),
+                                        _mm256_or_si256(_mm256_or_si256(_mm256_and_si256(digit, _mm256_set1_epi8(4)),
+                                                                        _mm256_and_si256(plus, _mm256_set1_epi8(19))),
+                                                        _mm256_and_si256(slash, _mm256_set1_epi8(16))));
+        __m256i values = _mm256_add_epi8(in, shift);
+
+        // as above within each 128-bit lane, then the two 12-byte halves are made contiguous
+        __m256i merged = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+        merged = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+        __m256i packed = _mm256_shuffle_epi8(merged, _mm256_setr_epi8(2,1,0, 6,5,4, 10,9,8, 14,13,12, -1,-1,-1,-1,
+                                                                      2,1,0, 6,5,4, 10,9,8, 14,13,12, -1,-1,-1,-1));
+        packed = _mm256_permutevar8x32_epi32(packed, _mm256_setr_epi32(0,1,2, 4,5,6, 7,7));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(result), packed);
+
+        it += 32;
+        result += 24;
+    }
+    size_t written = (it - start) / 4 * 3;
+    if (end - it < 48)
+        written += textToBinarySSSE3(it, end, result);
+    return written;
+}
+
+
+typedef size_t (*TextToBinaryKernel)(const byte*& it, const byte* end, byte*& result);
+
+TextToBinaryKernel textToBinaryKernel()
+{
+    static const SimdLevel level = detectSimdLevel();
+    switch (level)
+    {
+        case SimdLevel_AVX2: return &textToBinaryAVX2;
+        case SimdLevel_SSSE3: return &textToBinarySSSE3;
+        default: return 0;
+    }
+}
+
+#endif // PWIZ_BASE64_SIMD
+
+
 } // namespace
 
 
@@ -123,11 +266,17 @@ PWIZ_API_DECL size_t Base64::textToBinary(const char* from, size_t charCount, vo
     if (!byteTableInitialized)
         initializeByteTable();
 
-    byte* it = (byte*)from;
-    byte* end = it + charCount;
+    const byte* it = (const byte*)from;
+    const byte* end = it + charCount;
     byte* result = (byte*)to;
     size_t written = 0;
 
+#ifdef PWIZ_BASE64_SIMD
+    static const TextToBinaryKernel kernel = textToBinaryKernel();
+    if (kernel)
+        written = kernel(it, end, result);
+#endif
+
     while (it!=end)
     {
         int int24bit = 0;
@@ -49,7 +49,7 @@ namespace Base64
     PWIZ_API_DECL size_t textToBinarySize(size_t charCount);
 
     /// text -> binary conversion 
-    /// - Caller must allocate buffer
+    /// - Caller must allocate buffer (of at least textToBinarySize(charCount) bytes)
     /// - Buffer will not be null-terminated
     /// - Returns the actual number of bytes written
     PWIZ_API_DECL size_t textToBinary(const char* from, size_t charCount, void* to);
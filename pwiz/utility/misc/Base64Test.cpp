@@ -119,10 +119,35 @@ void test256()
 }
 
 
+void testLengths()
+{
+    if (os_) *os_ << "testLengths()\n" << flush;
+
+    // long enough for the vectorized decoding, with every possible tail
+    for (size_t length=0; length<400; ++length)
+    {
+        vector<char> from(length);
+        for (size_t i=0; i<length; i++)
+            from[i] = (char)(i*37 + length*11);
+
+        vector<char> textBuffer(Base64::binaryToTextSize(length));
+        size_t textCount = Base64::binaryToText(from.empty() ? 0 : &from[0], length, textBuffer.empty() ? 0 : &textBuffer[0]);
+        unit_assert(textCount == textBuffer.size());
+
+        vector<char> binaryBuffer(Base64::textToBinarySize(textCount));
+        size_t binaryCount = Base64::textToBinary(textBuffer.empty() ? 0 : &textBuffer[0], textCount, binaryBuffer.empty() ? 0 : &binaryBuffer[0]);
+        unit_assert(binaryCount == length);
+        binaryBuffer.resize(binaryCount);
+        unit_assert(binaryBuffer == from);
+    }
+}
+
+
 void test()
 {
     for_each(testPairs_, testPairs_+testPairCount_, checkTestPair);
     test256();
+    testLengths();
 }
 
 
@@ -0,0 +1,63 @@
+//
+// $Id$
+//
+//
+// Original author: agent <agent@local>
+//
+// Copyright 2026
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#define PWIZ_SOURCE
+
+#include "FileStamp.hpp"
+#include "pwiz/utility/misc/Filesystem.hpp"
+#include "pwiz/utility/misc/SHA1Calculator.hpp"
+#include "pwiz/utility/misc/Std.hpp"
+
+
+namespace pwiz {
+namespace util {
+
+
+PWIZ_API_DECL FileStamp::FileStamp(const string& filename, size_t sampleSize)
+:   size(bfs::file_size(filename)),
+    modificationTime(static_cast<boost::uint64_t>(bfs::last_write_time(filename)))
+{
+    ifstream is(filename.c_str(), ios::binary);
+    string sample(static_cast<size_t>(min<boost::uint64_t>(size, 2 * (boost::uint64_t) sampleSize)), '\0');
+    size_t headSize = min(sample.size(), sampleSize);
+    is.read(&sample[0], headSize);
+    if (sample.size() > headSize)
+    {
+        is.seekg(-static_cast<streamoff>(sample.size() - headSize), ios::end);
+        is.read(&sample[headSize], sample.size() - headSize);
+    }
+    if (!is)
+        throw runtime_error("[FileStamp] Error reading " + filename);
+    fingerprint = SHA1Calculator::hash(sample);
+}
+
+
+PWIZ_API_DECL bool FileStamp::operator==(const FileStamp& that) const
+{
+    return size == that.size &&
+           modificationTime == that.modificationTime &&
+           fingerprint == that.fingerprint;
+}
+
+
+} // namespace util
+} // namespace pwiz
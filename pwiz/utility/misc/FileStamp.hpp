@@ -0,0 +1,60 @@
+//
+// $Id$
+//
+//
+// Original author: agent <agent@local>
+//
+// Copyright 2026
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+
+#ifndef _FILESTAMP_HPP_
+#define _FILESTAMP_HPP_
+
+
+#include "pwiz/utility/misc/Export.hpp"
+#include "boost/cstdint.hpp"
+#include <string>
+
+
+namespace pwiz {
+namespace util {
+
+
+/// identifies a version of a file, e.g. the one an index persisted next to it was made from:
+/// size and modification time, plus a SHA-1 of its head and tail to catch rewrites that preserve
+/// both (e.g. copies with -p)
+struct PWIZ_API_DECL FileStamp
+{
+    boost::uint64_t size;
+    boost::uint64_t modificationTime;
+
+    /// SHA-1 (40 hex digits) of the first and last sampleSize bytes of the file
+    std::string fingerprint;
+
+    /// reads the stamp of filename; throws if it cannot be read
+    explicit FileStamp(const std::string& filename, size_t sampleSize = 65536);
+
+    bool operator==(const FileStamp& that) const;
+    bool operator!=(const FileStamp& that) const {return !(*this == that);}
+};
+
+
+} // namespace util
+} // namespace pwiz
+
+
+#endif // _FILESTAMP_HPP_
@@ -0,0 +1,99 @@
+//
+// $Id$
+//
+//
+// Original author: agent <agent@local>
+//
+// Copyright 2026
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+
+#include "Std.hpp"
+#include "FileStamp.hpp"
+#include "Filesystem.hpp"
+#include "pwiz/utility/misc/unit.hpp"
+
+using namespace pwiz::util;
+
+
+const string filename_ = "temp.FileStampTest.txt";
+
+
+void writeFile(const string& text)
+{
+    ofstream os(filename_.c_str(), ios::binary);
+    os << text;
+}
+
+
+void test()
+{
+    writeFile("head" + string(100, 'x') + "tail");
+    FileStamp stamp(filename_, 16);
+    unit_assert_operator_equal(108, stamp.size);
+    unit_assert_operator_equal(40, stamp.fingerprint.length());
+    unit_assert(stamp == FileStamp(filename_, 16));
+
+    // a rewrite that keeps the size and modification time is caught by the fingerprint of the head or tail
+    time_t modificationTime = bfs::last_write_time(filename_);
+    writeFile("HEAD" + string(100, 'x') + "tail");
+    bfs::last_write_time(filename_, modificationTime);
+    FileStamp headStamp(filename_, 16);
+    unit_assert_operator_equal(stamp.size, headStamp.size);
+    unit_assert_operator_equal(stamp.modificationTime, headStamp.modificationTime);
+    unit_assert(stamp != headStamp);
+
+    writeFile("head" + string(100, 'x') + "TAIL");
+    bfs::last_write_time(filename_, modificationTime);
+    unit_assert(stamp != FileStamp(filename_, 16));
+
+    // the middle is not sampled
+    writeFile("head" + string(50, 'x') + "y" + string(49, 'x') + "tail");
+    bfs::last_write_time(filename_, modificationTime);
+    unit_assert(stamp == FileStamp(filename_, 16));
+
+    // small and empty files are sampled whole
+    writeFile("abc");
+    FileStamp smallStamp(filename_, 16);
+    unit_assert_operator_equal(3, smallStamp.size);
+    writeFile("");
+    unit_assert_operator_equal(0, FileStamp(filename_, 16).size);
+    unit_assert(smallStamp != FileStamp(filename_, 16));
+
+    bfs::remove(filename_);
+    unit_assert_throws(FileStamp(filename_, 16), exception);
+}
+
+
+int main(int argc, char* argv[])
+{
+    TEST_PROLOG(argc, argv)
+
+    try
+    {
+        test();
+    }
+    catch (exception& e)
+    {
+        TEST_FAILED(e.what())
+    }
+    catch (...)
+    {
+        TEST_FAILED("Caught unknown exception.")
+    }
+
+    TEST_EPILOG
+}
@@ -0,0 +1,256 @@
+//
+// $Id$
+//
+//
+// Original author: agent <agent@local>
+//
+// Copyright 2026
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#define PWIZ_SOURCE
+
+#include "WorkerPool.hpp"
+#include "pwiz/utility/misc/Std.hpp"
+#include <boost/thread.hpp>
+#include <deque>
+#include <atomic>
+
+
+namespace pwiz {
+namespace util {
+
+
+namespace {
+std::atomic<size_t> defaultThreadCount_(0); // 0 means hardware_concurrency()
+std::atomic<size_t> poolThreadCount_(0); // 0 means hardware_concurrency()
+} // namespace
+
+
+class WorkerPool::Impl
+{
+    public:
+
+    Impl() : threadCount_(0), idleThreadCount_(0) {}
+
+    void submit(Job* job)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        jobs_.push_back(job);
+
+        // wake an idle thread if there is one for this job, otherwise start another unless the pool is full
+        if (idleThreadCount_ < jobs_.size() && threadCount_ < WorkerPool::poolThreadCount())
+        {
+            ++threadCount_;
+            boost::thread(boost::bind(&Impl::work, this)).detach();
+        }
+        else
+            jobQueuedCondition_.notify_one();
+    }
+
+    size_t cancel(Job* job)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        size_t count = std::count(jobs_.begin(), jobs_.end(), job);
+        jobs_.erase(std::remove(jobs_.begin(), jobs_.end(), job), jobs_.end());
+        return count;
+    }
+
+    private:
+
+    void work()
+    {
+        boost::unique_lock<boost::mutex> lock(mutex_);
+        while (true)
+        {
+            ++idleThreadCount_;
+            bool timedOut = false;
+            while (jobs_.empty() && !timedOut)
+                timedOut = !jobQueuedCondition_.timed_wait(lock, boost::posix_time::seconds(idleSeconds));
+            --idleThreadCount_;
+
+            // leave the pool when idle too long (or when it has shrunk); the thread ends with its state
+            if (jobs_.empty() || threadCount_ > WorkerPool::poolThreadCount())
+            {
+                --threadCount_;
+                if (!jobs_.empty())
+                    jobQueuedCondition_.notify_one();
+                return;
+            }
+
+            Job* job = jobs_.front();
+            jobs_.pop_front();
+            lock.unlock();
+            job->runJob();
+            lock.lock();
+        }
+    }
+
+    static const int idleSeconds = 5;
+
+    boost::mutex mutex_;
+    boost::condition_variable jobQueuedCondition_;
+    std::deque<Job*> jobs_;
+    size_t threadCount_; // started threads that have not exited
+    size_t idleThreadCount_; // threads waiting for a job
+};
+
+
+WorkerPool::WorkerPool() : impl_(new Impl) {}
+
+WorkerPool& WorkerPool::instance()
+{
+    static WorkerPool* pool = new WorkerPool;
+    return *pool;
+}
+
+void WorkerPool::submit(Job* job) {impl_->submit(job);}
+
+size_t WorkerPool::cancel(Job* job) {return impl_->cancel(job);}
+
+size_t WorkerPool::defaultThreadCount()
+{
+    size_t threadCount = defaultThreadCount_;
+    return threadCount > 0 ? threadCount : max(1u, boost::thread::hardware_concurrency());
+}
+
+void WorkerPool::setDefaultThreadCount(size_t threadCount)
+{
+    defaultThreadCount_ = threadCount;
+}
+
+size_t WorkerPool::poolThreadCount()
+{
+    size_t threadCount = poolThreadCount_;
+    return threadCount > 0 ? threadCount : max(1u, boost::thread::hardware_concurrency());
+}
+
+void WorkerPool::setPoolThreadCount(size_t threadCount)
+{
+    poolThreadCount_ = threadCount;
+}
+
+
+namespace {
+
+// one parallelFor call; the calling thread works on it while the pool runs the other workers
+class ParallelForJob : public WorkerPool::Job
+{
+    public:
+
+    ParallelForJob(size_t itemCount, const boost::function<void (size_t, size_t)>& task)
+        : itemCount_(itemCount), task_(task), nextItem_(0), failed_(false),
+          nextWorker_(1), queuedJobCount_(0), runningJobCount_(0)
+    {}
+
+    void run(size_t threadCount)
+    {
+        WorkerPool& pool = WorkerPool::instance();
+        {
+            boost::lock_guard<boost::mutex> lock(mutex_);
+            queuedJobCount_ = threadCount - 1;
+        }
+        for (size_t i = 1; i < threadCount; ++i)
+            pool.submit(this);
+
+        work(0);
+
+        // the items are all handed out, so drop the workers the pool has not started and wait for the rest
+        boost::unique_lock<boost::mutex> lock(mutex_);
+        queuedJobCount_ -= pool.cancel(this);
+        while (queuedJobCount_ > 0 || runningJobCount_ > 0)
+            doneCondition_.wait(lock);
+
+        if (failed_)
+            throw runtime_error(error_);
+    }
+
+    virtual void runJob()
+    {
+        size_t worker;
+        {
+            boost::lock_guard<boost::mutex> lock(mutex_);
+            --queuedJobCount_;
+            ++runningJobCount_;
+            worker = nextWorker_++;
+        }
+
+        work(worker);
+
+        // notify while holding the lock: the caller may destroy this job as soon as it sees the count drop
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        --runningJobCount_;
+        doneCondition_.notify_all();
+    }
+
+    private:
+
+    void work(size_t worker)
+    {
+        for (size_t item; !failed_ && (item = nextItem_++) < itemCount_;)
+        {
+            try
+            {
+                task_(item, worker);
+            }
+            catch (exception& e)
+            {
+                fail(e.what());
+            }
+            catch (...)
+            {
+                fail("unknown exception");
+            }
+        }
+    }
+
+    void fail(const string& error)
+    {
+        boost::lock_guard<boost::mutex> lock(mutex_);
+        if (!failed_)
+            error_ = error;
+        failed_ = true;
+    }
+
+    const size_t itemCount_;
+    const boost::function<void (size_t, size_t)>& task_;
+    std::atomic<size_t> nextItem_;
+    std::atomic<bool> failed_;
+
+    boost::mutex mutex_;
+    boost::condition_variable doneCondition_;
+    size_t nextWorker_;
+    size_t queuedJobCount_; // workers submitted to the pool but not started
+    size_t runningJobCount_;
+    string error_; // the first error
+};
+
+} // namespace
+
+
+PWIZ_API_DECL void parallelFor(size_t itemCount,
+                               const boost::function<void (size_t item, size_t worker)>& task,
+                               size_t threadCount)
+{
+    if (threadCount == 0)
+        threadCount = WorkerPool::defaultThreadCount();
+    threadCount = min(threadCount, itemCount);
+
+    ParallelForJob job(itemCount, task);
+    job.run(max((size_t) 1, threadCount));
+}
+
+
+} // namespace util
+} // namespace pwiz
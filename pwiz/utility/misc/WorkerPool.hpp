@@ -0,0 +1,98 @@
+//
+// $Id$
+//
+//
+// Original author: agent <agent@local>
+//
+// Copyright 2026
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#ifndef _WORKERPOOL_HPP_
+#define _WORKERPOOL_HPP_
+
+
+#include "pwiz/utility/misc/Export.hpp"
+#include <boost/function.hpp>
+#include <boost/smart_ptr.hpp>
+#include <cstddef>
+
+
+namespace pwiz {
+namespace util {
+
+
+/// a process-wide set of threads shared by everything that works concurrently (e.g. SpectrumWorkerThreads,
+/// parallelFor), so that the whole process stays within one thread budget; threads are started on demand
+/// up to poolThreadCount() and exit after idling for a while, so their thread-specific state is freed
+class PWIZ_API_DECL WorkerPool
+{
+    public:
+
+    /// work submitted to the pool; runJob() is called once per submit on a pool thread,
+    /// and must not wait for other pool jobs to start
+    struct PWIZ_API_DECL Job
+    {
+        virtual ~Job() {}
+        virtual void runJob() = 0;
+    };
+
+    /// returns the pool; it is never destroyed, so that threads still waiting at exit do not outlive it
+    static WorkerPool& instance();
+
+    /// queues one run of job, starting a thread for it unless the pool is full
+    void submit(Job* job);
+
+    /// removes the runs of job that have not been started and returns how many there were
+    size_t cancel(Job* job);
+
+    /// returns the most threads one user of the pool should occupy at once (e.g. per SpectrumWorkerThreads
+    /// instance or parallelFor call); defaults to boost::thread::hardware_concurrency()
+    static size_t defaultThreadCount();
+
+    /// sets the process-wide per-user limit, e.g. to divide the cores among several
+    /// concurrent conversions; 0 restores the default
+    static void setDefaultThreadCount(size_t threadCount);
+
+    /// returns the most threads in the pool; defaults to boost::thread::hardware_concurrency()
+    static size_t poolThreadCount();
+
+    /// sets the size limit of the pool, i.e. the thread budget of the whole process; 0 restores the default
+    static void setPoolThreadCount(size_t threadCount);
+
+    private:
+    WorkerPool();
+    class Impl;
+    boost::scoped_ptr<Impl> impl_;
+    WorkerPool(const WorkerPool&);
+    WorkerPool& operator=(const WorkerPool&);
+};
+
+
+/// calls task(item, worker) for every item in [0, itemCount); items are handed out in increasing order to
+/// at most threadCount workers (0 means WorkerPool::defaultThreadCount()), numbered from 0 so that each can
+/// keep its own state; the calling thread is worker 0 and the others run on the WorkerPool;
+/// once a task throws no more items are handed out, and the first error is rethrown as a runtime_error
+/// after all workers have finished
+PWIZ_API_DECL void parallelFor(size_t itemCount,
+                               const boost::function<void (size_t item, size_t worker)>& task,
+                               size_t threadCount = 0);
+
+
+} // namespace util
+} // namespace pwiz
+
+
+#endif // _WORKERPOOL_HPP_
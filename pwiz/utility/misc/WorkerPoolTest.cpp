@@ -0,0 +1,145 @@
+//
+// $Id$
+//
+//
+// Original author: agent <agent@local>
+//
+// Copyright 2026
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+
+#include "Std.hpp"
+#include "WorkerPool.hpp"
+#include "pwiz/utility/misc/unit.hpp"
+#include <boost/thread.hpp>
+#include <atomic>
+
+using namespace pwiz::util;
+
+
+void testParallelFor(size_t threadCount)
+{
+    const size_t itemCount = 1000;
+    vector<std::atomic<int> > visits(itemCount);
+    for (size_t i=0; i < itemCount; ++i)
+        visits[i] = 0;
+
+    std::atomic<size_t> active(0), maxActive(0), maxWorker(0);
+    parallelFor(itemCount, [&](size_t item, size_t worker)
+    {
+        size_t nowActive = ++active;
+        for (size_t m = maxActive; nowActive > m && !maxActive.compare_exchange_weak(m, nowActive);) {}
+        for (size_t m = maxWorker; worker > m && !maxWorker.compare_exchange_weak(m, worker);) {}
+
+        ++visits[item];
+        if (item % 100 == 0)
+            boost::this_thread::sleep(boost::posix_time::milliseconds(1));
+        --active;
+    }, threadCount);
+
+    // every item is visited once, by at most threadCount workers numbered from 0
+    for (size_t i=0; i < itemCount; ++i)
+        unit_assert_operator_equal(1, visits[i]);
+    unit_assert(maxActive <= threadCount);
+    unit_assert(maxWorker < threadCount);
+}
+
+
+void testError()
+{
+    try
+    {
+        parallelFor(1000, [&](size_t item, size_t worker)
+        {
+            if (item == 10)
+                throw runtime_error("bad item");
+        }, 4);
+        throw logic_error("parallelFor did not rethrow");
+    }
+    catch (runtime_error& e)
+    {
+        unit_assert_operator_equal("bad item", string(e.what()));
+    }
+
+    // the serial case reports errors the same way
+    try
+    {
+        parallelFor(3, [&](size_t item, size_t worker) {throw runtime_error("bad item");}, 1);
+        throw logic_error("parallelFor did not rethrow");
+    }
+    catch (runtime_error& e)
+    {
+        unit_assert_operator_equal("bad item", string(e.what()));
+    }
+}
+
+
+void testDefaultThreadCount()
+{
+    WorkerPool::setDefaultThreadCount(3);
+    unit_assert_operator_equal(3, WorkerPool::defaultThreadCount());
+
+    std::atomic<size_t> maxWorker(0);
+    parallelFor(100, [&](size_t item, size_t worker)
+    {
+        for (size_t m = maxWorker; worker > m && !maxWorker.compare_exchange_weak(m, worker);) {}
+    });
+    unit_assert(maxWorker < 3);
+
+    WorkerPool::setDefaultThreadCount(0);
+    unit_assert(WorkerPool::defaultThreadCount() > 0);
+}
+
+
+void testNested()
+{
+    // a worker may call parallelFor itself, even when the pool is full
+    WorkerPool::setPoolThreadCount(2);
+
+    std::atomic<size_t> count(0);
+    parallelFor(8, [&](size_t, size_t)
+    {
+        parallelFor(8, [&](size_t, size_t) {++count;}, 4);
+    }, 4);
+    unit_assert_operator_equal(64, count);
+
+    WorkerPool::setPoolThreadCount(0);
+}
+
+
+int main(int argc, char* argv[])
+{
+    TEST_PROLOG(argc, argv)
+
+    try
+    {
+        testParallelFor(1);
+        testParallelFor(2);
+        testParallelFor(8);
+        testError();
+        testDefaultThreadCount();
+        testNested();
+    }
+    catch (exception& e)
+    {
+        TEST_FAILED(e.what())
+    }
+    catch (...)
+    {
+        TEST_FAILED("Caught unknown exception.")
+    }
+
+    TEST_EPILOG
+}
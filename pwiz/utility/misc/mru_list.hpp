@@ -82,6 +82,17 @@ public:
     return true;                       /* new item inserted */
   }
 
+  /* like inserting an existing item, but looked up by its key, so no item has to be made for it */
+  bool touch(const typename KeyExtractor::result_type& key)
+  {
+    typename item_list::template nth_index<1>::type& keyIndex=il.template get<1>();
+    typename item_list::template nth_index<1>::type::iterator it=keyIndex.find(key);
+    if(it==keyIndex.end())return false; /* not in the list */
+
+    il.relocate(il.begin(),il.template project<0>(it)); /* put in front */
+    return true;
+  }
+
   template<typename Modifier>
   bool modify(iterator position, Modifier modifier)
   {
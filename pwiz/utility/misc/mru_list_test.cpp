@@ -23,6 +23,7 @@
 #include "Std.hpp"
 #include "mru_list.hpp"
 #include "pwiz/utility/misc/unit.hpp"
+#include <boost/shared_ptr.hpp>
 
 using namespace pwiz::util;
 
@@ -60,6 +61,43 @@ void test()
     unit_assert(mru.size() == 5);
     unit_assert(*mru.begin() == "Wax on, wax off");
     unit_assert(*mru.rbegin() == "Kung");
+
+    // set "Kung" as MRU item by key
+    unit_assert(mru.touch("Kung"));
+
+    unit_assert(mru.size() == 5);
+    unit_assert(*mru.begin() == "Kung");
+    unit_assert(*mru.rbegin() == "Was");
+
+    // touching a missing key inserts nothing
+    unit_assert(!mru.touch("Fu"));
+
+    unit_assert(mru.size() == 5);
+    unit_assert(*mru.begin() == "Kung");
+}
+
+
+struct Entry
+{
+    explicit Entry(size_t key) : key(key) {}
+    size_t key;
+};
+
+void testKeyExtractor()
+{
+    typedef boost::shared_ptr<Entry> EntryPtr;
+    mru_list<EntryPtr, BOOST_MULTI_INDEX_MEMBER(Entry, size_t, key)> mru(2);
+
+    mru.insert(EntryPtr(new Entry(1)));
+    mru.insert(EntryPtr(new Entry(2)));
+    unit_assert(mru.mru()->key == 2);
+
+    // items are found by key, through the pointer
+    unit_assert(mru.touch(1));
+    unit_assert(mru.mru()->key == 1);
+    unit_assert(mru.lru()->key == 2);
+    unit_assert(!mru.touch(3));
+    unit_assert(mru.size() == 2);
 }
 
 
@@ -70,6 +108,7 @@ int main(int argc, char* argv[])
     try
     {
         test();
+        testKeyExtractor();
     }
     catch (exception& e)
     {
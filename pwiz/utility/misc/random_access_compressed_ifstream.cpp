@@ -81,6 +81,7 @@ Version 1.0  29 May 2005  Mark Adler */
 #include <cstring>
 #include "pwiz/utility/misc/Std.hpp"
 #include <boost/thread.hpp>
+#include <boost/cstdint.hpp>
 #include <boost/filesystem/path.hpp>
 #include <boost/filesystem/detail/utf8_codecvt_facet.hpp>
 
@@ -122,7 +123,8 @@ class synchpoint {
 public:
     random_access_compressed_ifstream_off_t out;          /* corresponding offset in uncompressed data */
     random_access_compressed_ifstream_off_t in;           /* offset in input file of first full byte */
-    z_stream *state; // stream state
+    int bits;                                             /* number of bits (1-7) from byte at in - 1, or 0 */
+    unsigned char window[WINSIZE];                        /* preceding 32K of uncompressed data */
 };
 //
 // here's where the real customization of the stream happens
@@ -158,7 +160,10 @@ private:
     std::streamoff	outbuf_len; /* length of outbuf last time we populated it */
     std::vector<synchpoint *> index; // index for random access
     /* Add an entry to the access point list. */
-   synchpoint *addIndexEntry(random_access_compressed_ifstream_off_t in, random_access_compressed_ifstream_off_t out);
+   synchpoint *addIndexEntry(random_access_compressed_ifstream_off_t in, random_access_compressed_ifstream_off_t out,
+                             int bits, unsigned left, const unsigned char *window);
+   bool save_index(std::ostream &os); // write the access point list, building it first if need be
+   bool load_index(std::istream &is); // replace the access point list with one written by save_index()
 
     // gzip stuff
     int do_flush(int flush);
@@ -448,6 +453,22 @@ void random_access_compressed_ifstream::close() {
     }
 }
 
+PWIZ_API_DECL
+bool random_access_compressed_ifstream::save_index(std::ostream &os) {
+    if (GZIP != compressionType) {
+        return false;
+    }
+    return ((random_access_compressed_streambuf *)rdbuf())->save_index(os);
+}
+
+PWIZ_API_DECL
+bool random_access_compressed_ifstream::load_index(std::istream &is) {
+    if (GZIP != compressionType) {
+        return false;
+    }
+    return ((random_access_compressed_streambuf *)rdbuf())->load_index(is);
+}
+
 PWIZ_API_DECL
 random_access_compressed_ifstream::~random_access_compressed_ifstream()
 {
@@ -645,8 +666,6 @@ int random_access_compressed_streambuf::destroy ()
     }
     // clean up the seek index list if any
     for (int i=(int)this->index.size();i--;) {
-        inflateEnd(this->index[i]->state);
-        delete this->index[i]->state;
         delete this->index[i];
     }
     this->index.clear(); // set length 0
@@ -696,16 +715,25 @@ random_access_compressed_streambuf::int_type random_access_compressed_streambuf:
         while (--ind && this->index[ind]->out > offset);
         // and prepare to decompress
         synchpoint *synch = this->index[ind];
-        inflateEnd(&this->stream); // tidy up old ptrs
-        inflateCopy(&this->stream,synch->state);
         z_stream &strm = this->stream;
-      assert(strm.total_in == synch->in-this->start);
+        (void)inflateReset(&strm); // still raw inflate, as set up in ctor
+        strm.avail_in = 0;
         this->infile->clear(); // clear eof flag if any
-        this->infile->seekg(boost::iostreams::offset_to_position(synch->in));
+        this->infile->seekg(boost::iostreams::offset_to_position(synch->in - (synch->bits ? 1 : 0)));
+        if (synch->bits) { // access point is mid-byte
+            ret = this->infile->get();
+            if (ret == EOF) {
+                ret = Z_DATA_ERROR;
+                goto perform_seek_ret;
+            }
+            (void)inflatePrime(&strm, synch->bits, ret >> (8 - synch->bits));
+        }
+        if (synch->out) {
+            (void)inflateSetDictionary(&strm, synch->window, WINSIZE);
+        }
 
         /* skip uncompressed bytes until offset reached */
         offset -= synch->out;  // now offset is the number of uncompressed bytes we need to skip
-        strm.avail_in = 0; // inflateCopy doesn't retain the input buffer
         skip = 1;                               /* while skipping to offset */
         do {
             /* define where to put uncompressed data, and how much */
@@ -911,20 +939,109 @@ uLong random_access_compressed_streambuf::getLong ()
 //
 
 /* Add an entry to the access point list. */
-synchpoint *random_access_compressed_streambuf::addIndexEntry(random_access_compressed_ifstream_off_t in, random_access_compressed_ifstream_off_t out)
+synchpoint *random_access_compressed_streambuf::addIndexEntry(random_access_compressed_ifstream_off_t in, random_access_compressed_ifstream_off_t out,
+                                                              int bits, unsigned left, const unsigned char *window)
 {
     /* fill in entry and increment how many we have */
     synchpoint *next = new synchpoint();
     if (next) {
         next->in = in;
         next->out = out;
-        next->state = new z_stream;
-        inflateCopy(next->state,&this->stream);
+        next->bits = bits;
+        /* window is circular: unroll it so the oldest byte comes first */
+        if (left)
+            memcpy(next->window, window + WINSIZE - left, left);
+        if (left < WINSIZE)
+            memcpy(next->window + left, window, WINSIZE - left);
         this->index.push_back(next);
     }
     return next;
 }
 
+// on-disk layout of a saved access point list; all integers little endian
+// "pwizgzix" | format version | compressed start | uncompressed length | count | count * (in, out, bits, window)
+static const char seek_index_magic[8] = {'p','w','i','z','g','z','i','x'};
+static const int seek_index_version = 1;
+
+static void write_le64(std::ostream &os, random_access_compressed_ifstream_off_t value) {
+    unsigned char bytes[8];
+    for (int i=0;i<8;i++)
+        bytes[i] = (unsigned char)((boost::uint64_t)value >> (8*i));
+    os.write((const char *)bytes, 8);
+}
+
+static bool read_le64(std::istream &is, random_access_compressed_ifstream_off_t &value) {
+    unsigned char bytes[8];
+    if (!is.read((char *)bytes, 8))
+        return false;
+    boost::uint64_t result = 0;
+    for (int i=8;i--;)
+        result = (result << 8) | bytes[i];
+    value = (random_access_compressed_ifstream_off_t)result;
+    return true;
+}
+
+bool random_access_compressed_streambuf::save_index(std::ostream &os)
+{
+    if (!this->index.size()) {
+        // building the index runs the inflater to the end, so reposition on next read
+        if (this->last_seek_pos < 0) {
+            this->last_seek_pos = this->get_next_read_pos();
+        }
+        update_istream_ptrs(outbuf_headpos,0); // blow the cache
+        if (this->build_index() != Z_STREAM_END) {
+            return false;
+        }
+    }
+    os.write(seek_index_magic, sizeof(seek_index_magic));
+    write_le64(os, seek_index_version);
+    write_le64(os, this->start);
+    write_le64(os, this->uncompressedLength);
+    write_le64(os, (random_access_compressed_ifstream_off_t)this->index.size());
+    for (size_t i=0;i<this->index.size();i++) {
+        const synchpoint *synch = this->index[i];
+        write_le64(os, synch->in);
+        write_le64(os, synch->out);
+        write_le64(os, synch->bits);
+        os.write((const char *)synch->window, WINSIZE);
+    }
+    return os.good();
+}
+
+bool random_access_compressed_streambuf::load_index(std::istream &is)
+{
+    char magic[sizeof(seek_index_magic)];
+    random_access_compressed_ifstream_off_t version, start, length, count;
+    if (!is.read(magic, sizeof(magic)) || memcmp(magic, seek_index_magic, sizeof(magic)) ||
+        !read_le64(is, version) || (version != seek_index_version) ||
+        !read_le64(is, start) || (start != this->start) || // not the same file
+        !read_le64(is, length) || !read_le64(is, count) || (count <= 0)) {
+        return false;
+    }
+    std::vector<synchpoint *> loaded;
+    bool ok = true;
+    random_access_compressed_ifstream_off_t bits;
+    while (ok && count--) {
+        synchpoint *synch = new synchpoint();
+        loaded.push_back(synch);
+        ok = read_le64(is, synch->in) && read_le64(is, synch->out) && read_le64(is, bits) &&
+             (bits >= 0) && (bits < 8) && (synch->in >= start) && (synch->out <= length) &&
+             is.read((char *)synch->window, WINSIZE);
+        synch->bits = (int)bits;
+        ok = ok && ((loaded.size() == 1) ? (synch->out == 0) : (synch->out > loaded[loaded.size()-2]->out));
+    }
+    if (!ok) {
+        for (size_t i=0;i<loaded.size();i++)
+            delete loaded[i];
+        return false;
+    }
+    for (size_t i=0;i<this->index.size();i++)
+        delete this->index[i];
+    this->index.swap(loaded);
+    this->uncompressedLength = length;
+    return true;
+}
+
 /* Make one entire pass through the compressed stream and build an index, with
 access points about every span bytes of uncompressed output -- span is
 chosen to balance the speed of random access against the memory requirements
@@ -940,7 +1057,7 @@ int random_access_compressed_streambuf::build_index()
     random_access_compressed_ifstream_off_t totin, totout;        /* our own total counters to avoid 4GB limit */
     random_access_compressed_ifstream_off_t last;                 /* totout value of last access point */
     unsigned char *input = new unsigned char[CHUNK];
-    unsigned char *window = new unsigned char[WINSIZE];
+    unsigned char *window = new unsigned char[WINSIZE](); // zeroed: the head of the file has no history
     z_stream &strm = this->stream;
 
     /* initialize inflate */
@@ -962,7 +1079,7 @@ int random_access_compressed_streambuf::build_index()
     information at the end of the gzip or zlib stream */
    totout = last = 0;
    totin = this->start;
-   this->addIndexEntry(totin,totout); // note head of file
+   this->addIndexEntry(totin,totout,0,0,window); // note head of file
 
     do {
         /* get some compressed data from input file */
@@ -1003,9 +1120,12 @@ int random_access_compressed_streambuf::build_index()
                 break;
             }
 
-         /* add an index entry every 'span' bytes   */
-         if (( totout - last) > span) {
-            if (!this->addIndexEntry(totin,totout)) {
+         /* add an index entry every 'span' bytes, at a block boundary
+            (other than after the last block) so that it can be restarted
+            from just the bit offset and the preceding window */
+         if ((strm.data_type & 128) && !(strm.data_type & 64) &&
+             (( totout - last) > span)) {
+            if (!this->addIndexEntry(totin,totout,strm.data_type & 7,strm.avail_out,window)) {
                             ret = Z_MEM_ERROR;
                             goto build_index_error;
                     }
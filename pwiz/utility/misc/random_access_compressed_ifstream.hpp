@@ -90,6 +90,10 @@ public:
 	eCompressionType getCompressionType() const {
 		return compressionType;
 	}
+	// the seek index of a GZIP stream is built by decompressing the whole file once;
+	// these let callers persist it so that later opens of the same file can skip that pass
+	bool save_index(std::ostream &os); // builds the index if need be; false if not GZIP or on error
+	bool load_index(std::istream &is); // false (index unchanged) if not GZIP or not a valid index for this file
 private:
 	eCompressionType compressionType;
 };
@@ -455,7 +455,9 @@ template<class Archive>
 void save(Archive& ar, const Peptide& p, const unsigned int version)
 {
     ar << p.sequence();
-    ar << static_cast< map<int, vector<Modification> > >(p.modifications());
+    const ModificationMap& modifications = p.modifications();
+    map<int, vector<Modification> > modificationsByOffset(modifications.begin(), modifications.end());
+    ar << modificationsByOffset;
 }
 
 template<class Archive>
@@ -464,7 +466,10 @@ void load(Archive& ar, Peptide& p, const unsigned int version)
     string sequence;
     ar >> sequence;
     p = Peptide(sequence);
-    ar >> static_cast< map<int, vector<Modification> > >(p.modifications());
+    map<int, vector<Modification> > modificationsByOffset;
+    ar >> modificationsByOffset;
+    for (map<int, vector<Modification> >::const_iterator itr = modificationsByOffset.begin(); itr != modificationsByOffset.end(); ++itr)
+        p.modifications()[itr->first] = ModificationList(itr->second);
 }
 
 template<class Archive>
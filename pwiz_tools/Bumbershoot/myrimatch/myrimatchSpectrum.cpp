@@ -127,6 +127,8 @@ namespace myrimatch
 
         peakCount = (int) peakData.size();
 
+        IndexPeakBins(); // for fragment lookup
+
         // Divide the spectrum peak space into equal m/z bins
         //cout << mzUpperBound << "," << mzLowerBound << endl;
         double spectrumMedianMass = totalPeakSpace/2.0;
@@ -213,6 +215,67 @@ namespace myrimatch
         intenSortedPeakPreData.clear();
     }
 
+    void Spectrum::IndexPeakBins()
+    {
+        peakBinStarts.clear();
+        if( peakData.empty() )
+            return;
+
+        // Bins narrower than the fragment tolerance window don't save any comparisons, and more than
+        // two bins per peak only use memory
+        double firstMz = peakData.begin()->first;
+        double peakSpace = peakData.rbegin()->first - firstMz;
+        double windowWidth = (firstMz + g_rtConfig->FragmentMzTolerance) - (firstMz - g_rtConfig->FragmentMzTolerance);
+        double peakBinWidth = max( windowWidth, peakSpace / (2.0 * peakData.size()) );
+
+        // with a zero tolerance and a single peak (or peaks at the same m/z) the width is 0;
+        // then everything is in bin 0
+        peakBinOrigin = firstMz;
+        peakBinsPerMz = peakBinWidth > 0 ? 1.0 / peakBinWidth : 0.0;
+        peakBinStarts.resize( (size_t) (peakSpace * peakBinsPerMz) + 2 );
+
+        // PeakBin() is monotonic, so the first peak at or above any m/z is at or after the start of its bin
+        int peakIndex = 0;
+        PeakData::iterator itr = peakData.begin();
+        for( int i=0; i < (int) peakBinStarts.size(); ++i )
+        {
+            for( ; itr != peakData.end() && PeakBin( itr->first ) < i; ++itr, ++peakIndex ) {}
+            peakBinStarts[i] = peakIndex;
+        }
+    }
+
+    PeakData::iterator Spectrum::FindFragmentPeak( double mz )
+    {
+        if( peakBinStarts.empty() || peakData.empty() )
+            return peakData.end();
+
+        double minMz = mz - g_rtConfig->FragmentMzTolerance;
+        double maxMz = mz + g_rtConfig->FragmentMzTolerance;
+
+        // the peaks in [minMz, maxMz), as found by lower_bound in BasePeakData::findNear()
+        PeakData::iterator min = peakData.begin() + peakBinStarts[PeakBin( minMz )];
+        for( ; min != peakData.end() && min->first < minMz; ++min ) {}
+        PeakData::iterator max = min;
+        for( ; max != peakData.end() && max->first < maxMz; ++max ) {}
+
+        if( min == max )
+            return peakData.end(); // no peaks
+
+        // find the peak closest to the desired mz
+        PeakData::iterator best = min;
+        double minDiff = fabs( mz - best->first );
+        for( PeakData::iterator cur = min; cur != max; ++cur )
+        {
+            double curDiff = fabs( mz - cur->first );
+            if( curDiff < minDiff )
+            {
+                minDiff = curDiff;
+                best = cur;
+            }
+        }
+        return best;
+    }
+
     // the m/z width for xcorr bins
     const double binWidth = Proton;
 
@@ -580,7 +643,7 @@ namespace myrimatch
             START_PROFILER(7);
             // Find the fragment ion peak. Consider the fragment ion charge state while setting the
             // mass window for the fragment ion lookup.
-            peakItr = peakData.findNear( seqIons[j], g_rtConfig->FragmentMzTolerance );
+            peakItr = FindFragmentPeak( seqIons[j] );
             
             STOP_PROFILER(7);
 
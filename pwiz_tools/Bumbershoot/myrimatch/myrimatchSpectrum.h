@@ -181,6 +181,14 @@ namespace myrimatch
         // for MVH scoring
         void ClassifyPeakIntensities();
 
+        // for fragment lookup while scoring
+        void IndexPeakBins();
+
+        /* Returns the same peak as peakData.findNear( mz, FragmentMzTolerance ), but starts from the
+            bin of the lower end of the tolerance window instead of binary searching for it
+        */
+        PeakData::iterator FindFragmentPeak( double mz );
+
         // for XCorr scoring
         void NormalizePeakIntensities();
 
@@ -206,6 +214,10 @@ namespace myrimatch
 
             ar & mvhScoreDistribution;
             ar & mzFidelityDistribution;
+
+            // the bins are derived from the peaks, so they are rebuilt instead of sent
+            if( Archive::is_loading::value )
+                IndexPeakBins();
         }
 
         vector<int>          intenClassCounts;
@@ -219,6 +231,19 @@ namespace myrimatch
         flat_map<int, int> mvhScoreDistribution;
         flat_map<int, int> mzFidelityDistribution;
 
+        // Divide the peak space into equal m/z bins; peakBinStarts[i] is the index of the first peak
+        // in bin i or a later bin
+        vector<int>          peakBinStarts;
+        double               peakBinOrigin;
+        double               peakBinsPerMz;
+
+        int PeakBin( double mz ) const
+        {
+            double bin = (mz - peakBinOrigin) * peakBinsPerMz;
+            int lastBin = (int) peakBinStarts.size() - 1;
+            return bin <= 0 ? 0 : bin >= lastBin ? lastBin : (int) bin;
+        }
+
         boost::mutex mutex;
     };
 
@@ -0,0 +1,121 @@
+//
+// $Id$
+//
+// Licensed under the Apache License, Version 2.0 (the "License"); 
+// you may not use this file except in compliance with the License. 
+// You may obtain a copy of the License at 
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software 
+// distributed under the License is distributed on an "AS IS" BASIS, 
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. 
+// See the License for the specific language governing permissions and 
+// limitations under the License.
+//
+// The Original Code is the MyriMatch search engine.
+//
+// The Initial Developer of the Original Code is agent <agent@local>.
+//
+// Copyright 2026
+//
+// Contributor(s):
+//
+
+#include "pwiz/utility/misc/unit.hpp"
+#include "pwiz/utility/misc/Std.hpp"
+#include "myrimatchSpectrum.h"
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
+#include <boost/math/special_functions/next.hpp>
+
+
+namespace freicore {
+namespace myrimatch {
+    RunTimeConfig* g_rtConfig;
+}
+}
+
+using namespace pwiz::util;
+using namespace freicore;
+using namespace freicore::myrimatch;
+
+
+ostream* os_ = 0;
+
+
+// FindFragmentPeak must return the same peak as findNear for any m/z, including the edges of the window
+void testFindFragmentPeak(const MZTolerance& tolerance)
+{
+    if (os_) *os_ << "testFindFragmentPeak: " << tolerance << endl;
+
+    g_rtConfig->FragmentMzTolerance = tolerance;
+
+    boost::random::mt19937 rng(42);
+    boost::random::uniform_real_distribution<double> peakMz(150, 2000), queryMz(100, 2100);
+
+    for (int trial=0; trial < 100; ++trial)
+    {
+        Spectrum s;
+        int peakCount = trial < 3 ? trial : 50 + trial * 2; // includes no peaks and a single peak
+        for (int i=0; i < peakCount; ++i)
+            s.peakData[peakMz(rng)].intenClass = 1;
+
+        // peaks closer together than any bin
+        if (peakCount > 2 && trial % 5 == 0)
+        {
+            double mz = s.peakData.begin()->first;
+            s.peakData[mz + 1e-9].intenClass = 1;
+            s.peakData[boost::math::float_next(mz + 1e-9)].intenClass = 1;
+        }
+
+        s.IndexPeakBins();
+
+        vector<double> queries;
+        for (int i=0; i < 1000; ++i)
+            queries.push_back(queryMz(rng));
+        for (PeakData::iterator itr = s.peakData.begin(); itr != s.peakData.end(); ++itr)
+        {
+            queries.push_back(itr->first);
+            queries.push_back(itr->first - tolerance);
+            queries.push_back(itr->first + tolerance);
+            queries.push_back(boost::math::float_prior(itr->first + tolerance));
+        }
+
+        for (size_t i=0; i < queries.size(); ++i)
+            unit_assert(s.FindFragmentPeak(queries[i]) == s.peakData.findNear(queries[i], tolerance));
+    }
+}
+
+
+void test()
+{
+    testFindFragmentPeak(MZTolerance(0.5));
+    testFindFragmentPeak(MZTolerance(0.01));
+    testFindFragmentPeak(MZTolerance(20, MZTolerance::PPM));
+    testFindFragmentPeak(MZTolerance(0)); // a single peak has bins of no width
+}
+
+
+int main(int argc, char* argv[])
+{
+    TEST_PROLOG(argc, argv)
+
+    try
+    {
+        if (argc>1 && !strcmp(argv[1],"-v")) os_ = &cout;
+        g_rtConfig = new RunTimeConfig;
+        test();
+        delete g_rtConfig;
+    }
+    catch (exception& e)
+    {
+        TEST_FAILED(e.what())
+    }
+    catch (...)
+    {
+        TEST_FAILED("Caught unknown exception.")
+    }
+
+    TEST_EPILOG
+}
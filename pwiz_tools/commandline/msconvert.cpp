@@ -26,6 +26,7 @@
 #include "pwiz/data/msdata/MSDataMerger.hpp"
 #include "pwiz/data/msdata/IO.hpp"
 #include "pwiz/data/msdata/SpectrumInfo.hpp"
+#include "pwiz/data/msdata/SpectrumWorkerThreads.hpp"
 #include "pwiz/utility/misc/IterationListener.hpp"
 #include "pwiz/analysis/spectrum_processing/SpectrumListFactory.hpp"
 #include "pwiz/analysis/chromatogram_processing/ChromatogramListFactory.hpp"
@@ -37,6 +38,7 @@
 #include "pwiz/utility/misc/Filesystem.hpp"
 #include "pwiz/utility/misc/Std.hpp"
 #include <boost/filesystem/detail/utf8_codecvt_facet.hpp>
+#include <boost/thread.hpp>
 
 using namespace pwiz::cv;
 using namespace pwiz::data;
@@ -45,6 +47,45 @@ using namespace pwiz::analysis;
 using namespace pwiz::util;
 
 ostream* os_ = &cout;
+boost::mutex consoleMutex_; // serializes console output when converting files concurrently
+
+
+/// an output file written by this conversion, and the input its last run came from
+struct OutputFileClaim
+{
+    string inputFilename;
+    boost::shared_ptr<boost::mutex> writeMutex; // held while the file is written
+};
+
+map<string, OutputFileClaim> outputFileClaims_;
+boost::mutex outputFileClaimsMutex_;
+
+
+/// claims outputFilename for a run of inputFilename; different inputs (or runs) can map to the same
+/// output filename, so this warns when it is claimed again and returns the mutex that keeps concurrent
+/// jobs from writing it at the same time
+boost::shared_ptr<boost::mutex> claimOutputFile(const string& outputFilename, const string& inputFilename)
+{
+    string key = bfs::absolute(outputFilename).string();
+
+    boost::lock_guard<boost::mutex> lock(outputFileClaimsMutex_);
+    map<string, OutputFileClaim>::iterator itr = outputFileClaims_.find(key);
+    if (itr == outputFileClaims_.end())
+    {
+        OutputFileClaim& claim = outputFileClaims_[key];
+        claim.inputFilename = inputFilename;
+        claim.writeMutex.reset(new boost::mutex);
+        return claim.writeMutex;
+    }
+
+    {
+        boost::lock_guard<boost::mutex> consoleLock(consoleMutex_);
+        cerr << "Warning: runs from " << itr->second.inputFilename << " and " << inputFilename
+             << " are both written to " << outputFilename << "; the one written last overwrites the other" << endl;
+    }
+    itr->second.inputFilename = inputFilename;
+    return itr->second.writeMutex;
+}
 
 
 /// Holds the results of the parseCommandLine function. 
@@ -60,9 +101,11 @@ struct Config : public Reader::Config
     MSDataFile::WriteConfig writeConfig;
     string contactFilename;
     bool merge;
+    size_t jobs;
+    size_t threads;
 
     Config()
-        : outputPath("."), verbose(false), merge(false)
+        : outputPath("."), verbose(false), merge(false), jobs(1), threads(0)
     {
         simAsSpectra = false;
         srmAsSpectra = false;
@@ -118,6 +161,10 @@ ostream& operator<<(ostream& os, const Config& config)
     os << "outputPath: " << config.outputPath << endl;
     os << "extension: " << config.extension << endl; 
     os << "contactFilename: " << config.contactFilename << endl;
+    if (config.jobs > 1)
+        os << "jobs: " << config.jobs << endl;
+    if (config.threads > 0)
+        os << "threads: " << config.threads << endl;
     os << endl;
 
     os << "spectrum list filters:\n  ";
@@ -189,6 +236,7 @@ Config parseCommandLine(int argc, char** argv)
     bool noindex = false;
     bool zlib = false;
     bool gzip = false;
+    string mz5AccessPolicy = "balanced";
     bool ms_numpress_all = false; // if true, use this numpress compression with default tolerance
     double ms_numpress_linear = -1; // if >= 0, use this numpress linear compression with this tolerance
 	std::string ms_numpress_linear_str; // input as text, to help with the "msconvert --numpresslinear foo.raw" case
@@ -315,6 +363,12 @@ Config parseCommandLine(int argc, char** argv)
         ("merge",
             po::value<bool>(&config.merge)->zero_tokens(),
             ": create a single output file from multiple input files by merging file-level metadata and concatenating spectrum lists")
+        ("jobs,j",
+            po::value<size_t>(&config.jobs)->default_value(config.jobs),
+            ": convert up to this many input files concurrently; the processor cores are divided among the concurrent conversions (ignored with --merge or when writing to stdout)")
+        ("threads",
+            po::value<size_t>(&config.threads)->default_value(config.threads),
+            ": use at most this many worker threads, shared by all --jobs, for reading, filtering and encoding spectra; each conversion's own thread also helps, so up to this many plus --jobs threads are busy (0 means one per processor core)")
         ("simAsSpectra",
             po::value<bool>(&config.simAsSpectra)->zero_tokens(),
             ": write selected ion monitoring as spectra, not chromatograms")
@@ -327,6 +381,15 @@ Config parseCommandLine(int argc, char** argv)
         ("acceptZeroLengthSpectra",
             po::value<bool>(&config.acceptZeroLengthSpectra)->zero_tokens(),
             ": some vendor readers have an efficient way of filtering out empty spectra, but it takes more time to open the file")
+        ("persistIndex",
+            po::value<bool>(&config.persistIndex)->zero_tokens(),
+            ": keep the index of unindexed or gzipped mzML inputs in a .pwizidx file next to them, so later conversions don't have to rescan them")
+        ("memoryMap",
+            po::value<bool>(&config.memoryMap)->zero_tokens(),
+            ": read spectra of uncompressed mzML inputs from a memory mapping of the file instead of through buffered file reads")
+        ("mz5AccessPolicy",
+            po::value<string>(&mz5AccessPolicy)->default_value(mz5AccessPolicy),
+            ": balanced|random|sequential: size mz5 output chunks, and buffer mz5 input reads, for the order spectra will be read in")
         ("ignoreUnknownInstrumentError",
             po::value<bool>(&config.unknownInstrumentIsError)->zero_tokens()->default_value(!config.unknownInstrumentIsError),
             ": if true, if an instrument cannot be determined from a vendor file, it will not be an error ")
@@ -524,6 +587,9 @@ Config parseCommandLine(int argc, char** argv)
     if (config.filenames.empty())
         throw user_error("[msconvert] No files specified.");
 
+    if (config.jobs < 1)
+        throw user_error("[msconvert] --jobs must be at least 1.");
+
     int count = format_text + format_mzML + format_mzXML + format_MGF + format_MS2 + format_CMS2 + format_mz5;
     if (count > 1) throw user_error("[msconvert] Multiple format flags specified.");
     if (format_text) config.writeConfig.format = MSDataFile::Format_Text;
@@ -626,6 +692,17 @@ Config parseCommandLine(int argc, char** argv)
     if (zlib)
         config.writeConfig.binaryDataEncoderConfig.compression = BinaryDataEncoder::Compression_Zlib;
 
+    bal::to_lower(mz5AccessPolicy);
+    if (mz5AccessPolicy == "balanced")
+        config.binaryDataAccessPolicy = BinaryDataAccessPolicy_Balanced;
+    else if (mz5AccessPolicy == "random")
+        config.binaryDataAccessPolicy = BinaryDataAccessPolicy_RandomAccess;
+    else if (mz5AccessPolicy == "sequential")
+        config.binaryDataAccessPolicy = BinaryDataAccessPolicy_Sequential;
+    else
+        throw user_error("[msconvert] Unknown mz5AccessPolicy \"" + mz5AccessPolicy + "\" (expected balanced, random or sequential).");
+    config.writeConfig.binaryDataAccessPolicy = config.binaryDataAccessPolicy;
+
     if ((ms_numpress_slof>=0) && ms_numpress_pic)
         throw user_error("[msconvert] Incompatible compression flags 'numpressPic' and 'numpressSlof'.");
 
@@ -685,17 +762,29 @@ void addContactInfo(MSData& msd, const string& contactFilename)
 class UserFeedbackIterationListener : public IterationListener
 {
     std::streamoff longestMessage;
+    string prefix;
 
     public:
 
-    UserFeedbackIterationListener()
+    /// when a prefix is given (concurrent conversions), each update is written on its own line starting with the prefix
+    UserFeedbackIterationListener(const string& prefix = string())
+        : prefix(prefix)
     {
         longestMessage = 0;
     }
 
     virtual Status update(const UpdateMessage& updateMessage)
     {
-        
+        if (!prefix.empty())
+        {
+            boost::lock_guard<boost::mutex> lock(consoleMutex_);
+            *os_ << prefix << ": ";
+            if (!updateMessage.message.empty())
+                *os_ << updateMessage.message << ": ";
+            *os_ << updateMessage.iterationIndex + 1 << "/" << updateMessage.iterationCount << endl;
+            return Status_Ok;
+        }
+
         stringstream updateString;
         if (updateMessage.message.empty())
             updateString << updateMessage.iterationIndex + 1 << "/" << updateMessage.iterationCount;
@@ -789,14 +878,18 @@ void processFile(const string& filename, const Config& config, const ReaderList&
 {
     // read in data file
 
-    *os_ << "processing file: " << filename << endl;
+    {
+        boost::lock_guard<boost::mutex> lock(consoleMutex_);
+        *os_ << "processing file: " << filename << endl;
+    }
 
     // handle progress updates if requested
 
     IterationListenerRegistry iterationListenerRegistry;
     // update on the first spectrum, the last spectrum, the 100th spectrum, the 200th spectrum, etc.
     const size_t iterationPeriod = 100;
-    iterationListenerRegistry.addListener(IterationListenerPtr(new UserFeedbackIterationListener), iterationPeriod);
+    string progressPrefix = config.jobs > 1 ? bfs::path(filename).filename().string() : string();
+    iterationListenerRegistry.addListener(IterationListenerPtr(new UserFeedbackIterationListener(progressPrefix)), iterationPeriod);
     IterationListenerRegistry* pILR = config.verbose ? &iterationListenerRegistry : 0;
 
     ReaderList::Config readerConfig(config);
@@ -824,7 +917,10 @@ void processFile(const string& filename, const Config& config, const ReaderList&
 
             // write out the new data file
             string outputFilename = config.outputFilename(filename, msd);
-            *os_ << "writing output file: " << outputFilename << endl;
+            {
+                boost::lock_guard<boost::mutex> lock(consoleMutex_);
+                *os_ << "writing output file: " << outputFilename << endl;
+            }
 
             if (config.outputPath == "-")
                 MSDataFile::write(msd, cout, config.writeConfig, pILR);
@@ -835,18 +931,99 @@ void processFile(const string& filename, const Config& config, const ReaderList&
                 {
                     throw user_error("Output filepath is the same as input filepath");
                 }
+                boost::shared_ptr<boost::mutex> writeMutex = claimOutputFile(outputFilename, filename);
+                boost::lock_guard<boost::mutex> writeLock(*writeMutex);
                 MSDataFile::write(msd, outputFilename, config.writeConfig, pILR);
             }
         }
         catch (exception& e)
         {
+            boost::lock_guard<boost::mutex> lock(consoleMutex_);
             cerr << "Error writing run " << (i+1) << " in " << bfs::path(filename).leaf() << ":\n" << e.what() << endl;
         }
     }
-    *os_ << endl;
+
+    if (config.jobs == 1)
+        *os_ << endl;
 }
 
 
+/// Converts input files concurrently when --jobs is more than 1;
+/// each job thread takes the next unprocessed file until none are left.
+class FileConversionScheduler
+{
+    public:
+
+    FileConversionScheduler(const Config& config)
+        : config_(config), nextFile_(0), finishedFileCount_(0), failedFileCount_(0)
+    {}
+
+    int run()
+    {
+        size_t jobCount = min(config_.jobs, config_.filenames.size());
+
+        // the worker pool is sized to the whole thread budget; each file gets an even share of it
+        // so that one file does not starve the others
+        size_t defaultThreadCount = SpectrumWorkerThreads::defaultThreadCount();
+        SpectrumWorkerThreads::setDefaultThreadCount(max((size_t) 1, SpectrumWorkerThreads::poolThreadCount() / jobCount));
+
+        boost::thread_group jobThreads;
+        for (size_t i = 0; i < jobCount; ++i)
+            jobThreads.create_thread(boost::bind(&FileConversionScheduler::work, this));
+        jobThreads.join_all();
+
+        SpectrumWorkerThreads::setDefaultThreadCount(defaultThreadCount);
+        return failedFileCount_;
+    }
+
+    private:
+
+    void work()
+    {
+        // readers are not shared between jobs since some vendor readers keep state
+        FullReaderList readers;
+
+        while (true)
+        {
+            string filename;
+            {
+                boost::lock_guard<boost::mutex> lock(mutex_);
+                if (nextFile_ == config_.filenames.size())
+                    return;
+                filename = config_.filenames[nextFile_++];
+            }
+
+            bool failed = false;
+            try
+            {
+                processFile(filename, config_, readers);
+            }
+            catch (exception& e)
+            {
+                failed = true;
+                boost::lock_guard<boost::mutex> lock(consoleMutex_);
+                *os_ << e.what() << endl;
+                *os_ << "Error processing file " << filename << "\n\n";
+            }
+
+            boost::lock_guard<boost::mutex> lock(mutex_);
+            ++finishedFileCount_;
+            if (failed)
+                ++failedFileCount_;
+
+            boost::lock_guard<boost::mutex> consoleLock(consoleMutex_);
+            *os_ << "finished file " << finishedFileCount_ << "/" << config_.filenames.size() << ": " << filename << endl;
+        }
+    }
+
+    const Config& config_;
+    boost::mutex mutex_;
+    size_t nextFile_;
+    size_t finishedFileCount_;
+    int failedFileCount_;
+};
+
+
 /// Handles the high level logic of msconvert. Constructs the output
 /// directory, reads files into memory and writes them out consistent
 /// with the options in the supplied Config.
@@ -857,12 +1034,20 @@ int go(const Config& config)
     if (!bfs::exists(config.outputPath))
         boost::filesystem::create_directories(config.outputPath);
 
+    if (config.threads > 0)
+    {
+        SpectrumWorkerThreads::setPoolThreadCount(config.threads);
+        SpectrumWorkerThreads::setDefaultThreadCount(config.threads);
+    }
+
     FullReaderList readers;
 
     int failedFileCount = 0;
 
     if (config.merge)
         failedFileCount = mergeFiles(config.filenames, config, readers);
+    else if (config.jobs > 1 && config.filenames.size() > 1 && config.outputPath != "-")
+        failedFileCount = FileConversionScheduler(config).run();
     else
     {
 
@@ -45,7 +45,7 @@ using namespace pwiz::util;
 
 
 PWIZ_API_DECL MSDataAnalyzerApplication::MSDataAnalyzerApplication(int argc, const char* argv[])
-:   outputDirectory("."), verbose(false)
+:   outputDirectory("."), verbose(false), threads(1)
 {
     namespace po = boost::program_options;
 
@@ -73,6 +73,9 @@ PWIZ_API_DECL MSDataAnalyzerApplication::MSDataAnalyzerApplication(int argc, con
         ("verbose,v",
             po::value<bool>(&verbose)->zero_tokens(),
             ": print progress messages")
+        ("threads",
+            po::value<size_t>(&threads)->default_value(threads),
+            ": analyze spectra with this many threads (0 means one per processor core)")
         ("help",
             po::value<bool>(&detailedHelp)->zero_tokens(),
             ": show this message, with extra detail on filter options")
@@ -186,7 +189,7 @@ PWIZ_API_DECL void MSDataAnalyzerApplication::run(MSDataAnalyzer& analyzer, ostr
             dataInfo.outputDirectory = outputDirectory;
             dataInfo.log = log;
 
-            MSDataAnalyzerDriver driver(analyzer);
+            MSDataAnalyzerDriver driver(analyzer, threads);
             driver.analyze(dataInfo);
         }
         catch (exception& e)
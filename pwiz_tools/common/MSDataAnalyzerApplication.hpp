@@ -45,6 +45,7 @@ struct PWIZ_API_DECL MSDataAnalyzerApplication
     std::vector<std::string> filters;
     std::vector<std::string> commands;
     bool verbose;
+    size_t threads; // passed to MSDataAnalyzerDriver: 1 (the default) analyzes serially, 0 uses every core
 
     /// construct and parse command line, filling in the various structure fields
     MSDataAnalyzerApplication(int argc, const char* argv[]);